@@ -87,7 +87,7 @@ bool FVoxelAsyncWork::CancelAndAutodelete()
 	check(!bAutodelete);
 
 	bAutodelete = true;
-	CanceledCounter.Increment();
+	CanceledCounter->Increment();
 
 	if (IsDone())
 	{
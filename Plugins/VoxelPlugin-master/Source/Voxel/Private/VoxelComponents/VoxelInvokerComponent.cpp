@@ -34,6 +34,15 @@ FVoxelInvokerSettings UVoxelInvokerComponentBase::GetInvokerSettings_Implementat
 	return {};
 }
 
+FVector UVoxelInvokerComponentBase::GetInvokerViewDirection_Implementation() const
+{
+	if (auto* Owner = Cast<APawn>(GetOwner()))
+	{
+		return Owner->GetViewRotation().Vector();
+	}
+	return GetForwardVector();
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
@@ -125,15 +134,20 @@ FIntVector UVoxelSimpleInvokerComponent::GetInvokerVoxelPosition_Implementation(
 	return VoxelWorld->GlobalToLocal(GetInvokerGlobalPosition());
 }
 
+inline FVoxelIntBox GetInvokerVoxelBounds(const AVoxelWorldInterface* VoxelWorld, const FVector& GlobalPosition, float Distance)
+{
+	return FVoxelIntBox::SafeConstruct(
+		VoxelWorld->GlobalToLocal(GlobalPosition - Distance, EVoxelWorldCoordinatesRounding::RoundDown),
+		VoxelWorld->GlobalToLocal(GlobalPosition + Distance, EVoxelWorldCoordinatesRounding::RoundUp)
+	);
+}
+
 FVoxelInvokerSettings UVoxelSimpleInvokerComponent::GetInvokerSettings_Implementation(AVoxelWorldInterface* VoxelWorld) const
 {
 	const FVector InvokerGlobalPosition = GetInvokerGlobalPosition();
 	const auto GetVoxelBounds = [&](float Distance)
 	{
-		return FVoxelIntBox::SafeConstruct(
-			VoxelWorld->GlobalToLocal(InvokerGlobalPosition - Distance, EVoxelWorldCoordinatesRounding::RoundDown),
-			VoxelWorld->GlobalToLocal(InvokerGlobalPosition + Distance, EVoxelWorldCoordinatesRounding::RoundUp)
-		);
+		return GetInvokerVoxelBounds(VoxelWorld, InvokerGlobalPosition, Distance);
 	};
 
 	FVoxelInvokerSettings Settings;
@@ -160,20 +174,94 @@ FVector UVoxelSimpleInvokerComponent::GetInvokerGlobalPosition_Implementation()
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
+FVoxelInvokerSettings UVoxelInvokerWithPredictionComponent::GetInvokerSettings_Implementation(AVoxelWorldInterface* VoxelWorld) const
+{
+	// Uses the predicted position
+	FVoxelInvokerSettings Settings = Super::GetInvokerSettings_Implementation(VoxelWorld);
+	if (!bEnablePrediction || !bUseSweptPath)
+	{
+		return Settings;
+	}
+
+	const FVector CurrentGlobalPosition = GetComponentLocation();
+	const FVector PredictedGlobalPosition = GetInvokerGlobalPosition();
+
+	Settings.bUseSweptPath = true;
+	Settings.SweptPathStart = VoxelWorld->GlobalToLocal(CurrentGlobalPosition);
+	Settings.SweptPathEnd = VoxelWorld->GlobalToLocal(PredictedGlobalPosition);
+
+	// The bounds of the boxes at both ends contain the swept shape
+	Settings.LODBounds = Settings.LODBounds + GetInvokerVoxelBounds(VoxelWorld, CurrentGlobalPosition, LODRange);
+	Settings.CollisionsBounds = Settings.CollisionsBounds + GetInvokerVoxelBounds(VoxelWorld, CurrentGlobalPosition, CollisionsRange);
+	Settings.NavmeshBounds = Settings.NavmeshBounds + GetInvokerVoxelBounds(VoxelWorld, CurrentGlobalPosition, NavmeshRange);
+
+	const auto GetVoxelRange = [&](float Distance)
+	{
+		const FVoxelIntBox Bounds = GetInvokerVoxelBounds(VoxelWorld, CurrentGlobalPosition, Distance);
+		return FMath::Max3(
+			FMath::Max(Settings.SweptPathStart.X - Bounds.Min.X, Bounds.Max.X - Settings.SweptPathStart.X),
+			FMath::Max(Settings.SweptPathStart.Y - Bounds.Min.Y, Bounds.Max.Y - Settings.SweptPathStart.Y),
+			FMath::Max(Settings.SweptPathStart.Z - Bounds.Min.Z, Bounds.Max.Z - Settings.SweptPathStart.Z));
+	};
+	Settings.SweptPathLODRange = GetVoxelRange(LODRange);
+	Settings.SweptPathCollisionsRange = GetVoxelRange(CollisionsRange);
+	Settings.SweptPathNavmeshRange = GetVoxelRange(NavmeshRange);
+
+	return Settings;
+}
+
 FVector UVoxelInvokerWithPredictionComponent::GetInvokerGlobalPosition_Implementation() const
 {
 	FVector Position = GetComponentLocation();
 	if (bEnablePrediction)
 	{
-		Position += GetOwner()->GetVelocity() * PredictionTime;
+		Position += GetSmoothedVelocity() * PredictionTime;
 	}
 	return Position;
 }
 
+FVector UVoxelInvokerWithPredictionComponent::GetSmoothedVelocity() const
+{
+	const FVector Velocity = GetOwner()->GetVelocity();
+	const UWorld* World = GetWorld();
+	if (VelocitySmoothingTime <= 0 || !World)
+	{
+		return Velocity;
+	}
+
+	const float Time = World->GetTimeSeconds();
+	if (LastVelocitySmoothingTime < 0 || Time < LastVelocitySmoothingTime)
+	{
+		SmoothedVelocity = Velocity;
+	}
+	else
+	{
+		// Exponential moving average: framerate independent
+		const float Alpha = 1.f - FMath::Exp(-(Time - LastVelocitySmoothingTime) / VelocitySmoothingTime);
+		SmoothedVelocity = FMath::Lerp(SmoothedVelocity, Velocity, Alpha);
+	}
+	LastVelocitySmoothingTime = Time;
+
+	return SmoothedVelocity;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
+FVector UVoxelInvokerAutoCameraComponent::GetInvokerViewDirection_Implementation() const
+{
+	APlayerCameraManager* CameraManager = UGameplayStatics::GetPlayerCameraManager(GetWorld(), 0);
+	if (ensure(CameraManager))
+	{
+		return CameraManager->GetCameraRotation().Vector();
+	}
+	else
+	{
+		return FVector::ZeroVector;
+	}
+}
+
 FVector UVoxelInvokerAutoCameraComponent::GetInvokerGlobalPosition_Implementation() const
 {
 	APlayerCameraManager* CameraManager = UGameplayStatics::GetPlayerCameraManager(GetWorld(), 0);
@@ -298,6 +298,11 @@ static FAutoConsoleCommand CmdLogThreadPoolStats(
     TEXT(""),
 	FConsoleCommandDelegate::CreateLambda([](){ FVoxelQueuedThreadPoolStats::Get().LogTimes(); }));
 
+static FAutoConsoleCommand CmdResetThreadPoolStats(
+    TEXT("voxel.threading.ResetStats"),
+    TEXT("Reset the stats logged by voxel.threading.LogStats, eg to compare mesher throughput with different threading settings"),
+	FConsoleCommandDelegate::CreateLambda([](){ FVoxelQueuedThreadPoolStats::Get().Reset(); }));
+
 static FAutoConsoleCommand CmdLogMemoryStats(
     TEXT("voxel.LogMemoryStats"),
     TEXT(""),
@@ -5,6 +5,14 @@
 #include "VoxelQueuedWork.h"
 #include "Misc/QueuedThreadPool.h"
 #include "VoxelMinimal.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<int32> CVarNumAffinityGroups(
+	TEXT("voxel.threading.NumAffinityGroups"),
+	0,
+	TEXT("If > 0, the workers of new voxel pools are pinned to cores and split into that many groups of contiguous cores, eg the number of sockets or CCXs. ")
+	TEXT("Chunk tasks are then routed to a group by region, and only run on another group when it's idle. Applied when the pool is created"),
+	ECVF_Default);
 
 FVoxelDefaultPool::FVoxelDefaultPool(
 	int32 ThreadCount,
@@ -16,7 +24,8 @@ FVoxelDefaultPool::FVoxelDefaultPool(
 		ThreadCount,
 		1024 * 1024,
 		EThreadPriority::TPri_Normal,
-		bConstantPriorities)))
+		bConstantPriorities,
+		CVarNumAffinityGroups.GetValueOnGameThread())))
 {
 	for (int32 Index = 0; Index < 256; Index++)
 	{
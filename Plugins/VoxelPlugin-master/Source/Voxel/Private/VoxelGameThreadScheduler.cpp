@@ -0,0 +1,183 @@
+// Copyright 2020 Phyronnaz
+
+#include "VoxelGameThreadScheduler.h"
+#include "VoxelTickable.h"
+#include "VoxelMinimal.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Voxel Game Thread Time: LOD Manager (ms)"), STAT_VoxelGameThreadTime_LODManager, STATGROUP_VoxelCounters);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Voxel Game Thread Time: Renderer (ms)"), STAT_VoxelGameThreadTime_Renderer, STATGROUP_VoxelCounters);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Voxel Game Thread Time: Mesh Handler (ms, included in Renderer)"), STAT_VoxelGameThreadTime_MeshHandler, STATGROUP_VoxelCounters);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Voxel Game Thread Time: Events (ms)"), STAT_VoxelGameThreadTime_Events, STATGROUP_VoxelCounters);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Voxel Game Thread Time: Debug (ms)"), STAT_VoxelGameThreadTime_Debug, STATGROUP_VoxelCounters);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Voxel Game Thread Time: Other (ms)"), STAT_VoxelGameThreadTime_Other, STATGROUP_VoxelCounters);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Voxel Game Thread Skipped Ticks"), STAT_VoxelGameThreadSkippedTicks, STATGROUP_VoxelCounters);
+
+static TAutoConsoleVariable<float> CVarSchedulerFrameBudget(
+	TEXT("voxel.scheduler.FrameBudget"),
+	0.f,
+	TEXT("If > 0, all the voxel game thread work will be ticked by a single scheduler sharing this budget, in ms. ")
+	TEXT("Work that doesn't fit is continued next frame"),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarSchedulerMinTimePerTick(
+	TEXT("voxel.scheduler.MinTimePerTick"),
+	0.1f,
+	TEXT("Minimum time in ms given to a tickable when it is ticked by the scheduler, so that it always makes progress"),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarSchedulerMaxSkippedFrames(
+	TEXT("voxel.scheduler.MaxSkippedFrames"),
+	4,
+	TEXT("Number of consecutive frames a tickable can be skipped when the budget is exhausted before it is forced to tick"),
+	ECVF_Default);
+
+FVoxelGameThreadScheduler* FVoxelGameThreadScheduler::Singleton = nullptr;
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+inline float GetGameThreadWorkWeight(EVoxelGameThreadWork Work)
+{
+	switch (Work)
+	{
+	// The renderer is the only one really able to split its work, give it the largest share
+	case EVoxelGameThreadWork::Renderer: return 4.f;
+	case EVoxelGameThreadWork::LODManager:
+	case EVoxelGameThreadWork::MeshHandler:
+	case EVoxelGameThreadWork::Events:
+	case EVoxelGameThreadWork::Debug:
+	case EVoxelGameThreadWork::Other:
+	default: return 1.f;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+bool FVoxelGameThreadScheduler::IsEnabled()
+{
+	return CVarSchedulerFrameBudget.GetValueOnGameThread() > 0.f;
+}
+
+void FVoxelGameThreadScheduler::Shutdown()
+{
+	check(IsInGameThread());
+
+	if (Singleton)
+	{
+		ensure(Singleton->Tickables.Num() == 0);
+		delete Singleton;
+		Singleton = nullptr;
+	}
+}
+
+void FVoxelGameThreadScheduler::RegisterTickable(FVoxelTickable& Tickable)
+{
+	check(IsInGameThread());
+
+	if (!Singleton)
+	{
+		Singleton = new FVoxelGameThreadScheduler();
+	}
+	ensure(!Singleton->Tickables.Contains(&Tickable));
+	Singleton->Tickables.Add(&Tickable);
+}
+
+void FVoxelGameThreadScheduler::UnregisterTickable(FVoxelTickable& Tickable)
+{
+	check(IsInGameThread());
+
+	if (ensure(Singleton))
+	{
+		ensure(Singleton->Tickables.Remove(&Tickable) == 1);
+	}
+}
+
+void FVoxelGameThreadScheduler::ReportTime(EVoxelGameThreadWork Work, double Time)
+{
+	const float TimeInMs = Time * 1000;
+	switch (Work)
+	{
+	case EVoxelGameThreadWork::LODManager: INC_FLOAT_STAT_BY(STAT_VoxelGameThreadTime_LODManager, TimeInMs); break;
+	case EVoxelGameThreadWork::Renderer: INC_FLOAT_STAT_BY(STAT_VoxelGameThreadTime_Renderer, TimeInMs); break;
+	case EVoxelGameThreadWork::MeshHandler: INC_FLOAT_STAT_BY(STAT_VoxelGameThreadTime_MeshHandler, TimeInMs); break;
+	case EVoxelGameThreadWork::Events: INC_FLOAT_STAT_BY(STAT_VoxelGameThreadTime_Events, TimeInMs); break;
+	case EVoxelGameThreadWork::Debug: INC_FLOAT_STAT_BY(STAT_VoxelGameThreadTime_Debug, TimeInMs); break;
+	case EVoxelGameThreadWork::Other: INC_FLOAT_STAT_BY(STAT_VoxelGameThreadTime_Other, TimeInMs); break;
+	default: ensure(false);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+void FVoxelGameThreadScheduler::Tick(float DeltaTime)
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	const double FrameStartTime = FPlatformTime::Seconds();
+	const double FrameEndTime = FrameStartTime + CVarSchedulerFrameBudget.GetValueOnGameThread() * 0.001;
+	const double MinTimePerTick = FMath::Max(0.f, CVarSchedulerMinTimePerTick.GetValueOnGameThread()) * 0.001;
+	const int32 MaxSkippedFrames = FMath::Max(0, CVarSchedulerMaxSkippedFrames.GetValueOnGameThread());
+
+	// Copy: tickables can be created or destroyed by the ones we tick (eg world destroyed in an event callback)
+	TArray<FVoxelTickable*> TickablesToTick = Tickables;
+	TickablesToTick.RemoveAllSwap([](FVoxelTickable* Tickable) { return !Tickable->bShouldTick; });
+	TickablesToTick.StableSort([](const FVoxelTickable& A, const FVoxelTickable& B) { return A.GetGameThreadWork() < B.GetGameThreadWork(); });
+
+	float RemainingWeight = 0.f;
+	for (FVoxelTickable* Tickable : TickablesToTick)
+	{
+		RemainingWeight += GetGameThreadWorkWeight(Tickable->GetGameThreadWork());
+	}
+
+	for (FVoxelTickable* Tickable : TickablesToTick)
+	{
+		if (!Tickables.Contains(Tickable))
+		{
+			// Destroyed while ticking a previous one
+			continue;
+		}
+
+		const EVoxelGameThreadWork Work = Tickable->GetGameThreadWork();
+		const float Weight = GetGameThreadWorkWeight(Work);
+
+		const double StartTime = FPlatformTime::Seconds();
+		const double RemainingTime = FrameEndTime - StartTime;
+
+		if (RemainingTime <= 0 && Tickable->SchedulerSkippedFrames < MaxSkippedFrames)
+		{
+			// Out of budget: the work stays queued until next frame
+			Tickable->SchedulerSkippedFrames++;
+			RemainingWeight -= Weight;
+			INC_DWORD_STAT(STAT_VoxelGameThreadSkippedTicks);
+			continue;
+		}
+
+		// Give a share of the remaining time proportional to our weight. Time not used flows to the next tickables
+		const double Share = RemainingTime * Weight / FMath::Max(RemainingWeight, Weight);
+		RemainingWeight -= Weight;
+
+		Tickable->SchedulerSkippedFrames = 0;
+		if (Tickable->bShouldTick) // Might have changed while ticking a previous one
+		{
+			Tickable->TickWithBudget(DeltaTime, StartTime + FMath::Max(Share, MinTimePerTick));
+		}
+
+		ReportTime(Work, FPlatformTime::Seconds() - StartTime);
+	}
+}
+
+bool FVoxelGameThreadScheduler::IsTickable() const
+{
+	return IsEnabled() && Tickables.Num() > 0;
+}
+
+TStatId FVoxelGameThreadScheduler::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(FVoxelGameThreadScheduler, STATGROUP_Tickables);
+}
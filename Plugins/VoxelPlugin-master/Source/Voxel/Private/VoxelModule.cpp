@@ -6,6 +6,7 @@
 #include "VoxelMaterial.h"
 #include "VoxelMessages.h"
 #include "IVoxelPool.h"
+#include "VoxelGameThreadScheduler.h"
 #include "VoxelUtilities/VoxelSerializationUtilities.h"
 
 #include "Containers/Ticker.h"
@@ -181,6 +182,7 @@ void FVoxelModule::StartupModule()
 void FVoxelModule::ShutdownModule()
 {
 	IVoxelPool::Shutdown();
+	FVoxelGameThreadScheduler::Shutdown();
 }
 
 IMPLEMENT_MODULE(FVoxelModule, Voxel)
\ No newline at end of file
@@ -27,8 +27,8 @@ FVoxelLODSettings::FVoxelLODSettings(
 		? InWorld->bStaticWorld
 		: false)
 	, MinDelayBetweenLODUpdates(InWorld->MinDelayBetweenLODUpdates)
-	, bEnableTransitions(InWorld->bEnableTransitions)
-	, bInvertTransitions(InWorld->RenderType == EVoxelRenderType::SurfaceNets)
+	, bEnableTransitions(InWorld->bEnableTransitions && InWorld->RenderType != EVoxelRenderType::DualContouring)
+	, bInvertTransitions(FVoxelRendererSettingsBase::IsDualRenderType(InWorld->RenderType))
 
 	, World(InWorld->GetWorld())
 {
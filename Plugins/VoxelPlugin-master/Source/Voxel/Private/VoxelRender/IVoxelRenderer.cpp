@@ -53,6 +53,8 @@ FVoxelRendererSettingsBase::FVoxelRendererSettingsBase(
 	, ChunksDitheringDuration(InWorld->ChunksDitheringDuration)
 
 	, bOptimizeIndices(InWorld->bOptimizeIndices)
+	, IndicesOptimizer(InWorld->IndicesOptimizer)
+	, bOptimizeVertexFetch(InWorld->bOptimizeVertexFetch)
 
 	, MaxDistanceFieldLOD(InWorld->bGenerateDistanceFields ? InWorld->MaxDistanceFieldLOD : -1)
 	, DistanceFieldBoundsExtension(InWorld->DistanceFieldBoundsExtension)
@@ -61,6 +63,7 @@ FVoxelRendererSettingsBase::FVoxelRendererSettingsBase(
 
 	, bOneMaterialPerCubeSide(InWorld->MaterialConfig == EVoxelMaterialConfig::SingleIndex && InWorld->bOneMaterialPerCubeSide)
 	, bHalfPrecisionCoordinates(InWorld->bHalfPrecisionCoordinates)
+	, bHalfPrecisionPositions(InWorld->bHalfPrecisionPositions)
 	, bInterpolateColors(InWorld->bInterpolateColors)
 	, bInterpolateUVs(InWorld->bInterpolateUVs)
 	, bSRGBColors(InWorld->bSRGBColors)
@@ -111,7 +114,7 @@ IVoxelRenderer::IVoxelRenderer(const FVoxelRendererSettings& Settings)
 {
 }
 
-void IVoxelRenderer::SetInvokersPositionsForPriorities(const TArray<FIntVector>& NewInvokersPositionsForPriorities)
+void IVoxelRenderer::SetInvokersPositionsForPriorities(const TArray<FVoxelInvokerPriorityPath>& NewInvokersPositionsForPriorities)
 {
 	while (InvokersPositionsForPriorities->GetMax() < NewInvokersPositionsForPriorities.Num())
 	{
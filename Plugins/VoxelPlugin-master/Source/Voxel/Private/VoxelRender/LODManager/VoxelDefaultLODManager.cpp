@@ -4,6 +4,7 @@
 #include "VoxelRender/LODManager/VoxelRenderOctree.h"
 #include "VoxelRender/IVoxelRenderer.h"
 #include "VoxelIntBox.h"
+#include "VoxelPriorityHandler.h"
 #include "IVoxelPool.h"
 #include "VoxelWorldInterface.h"
 #include "VoxelComponents/VoxelInvokerComponent.h"
@@ -16,6 +17,12 @@ static TAutoConsoleVariable<int32> CVarFreezeLODs(
 	TEXT("Stops LOD manager tick"),
 	ECVF_Default);
 
+static TAutoConsoleVariable<float> CVarViewDirectionPriorityWeight(
+	TEXT("voxel.lod.ViewDirectionPriorityWeight"),
+	2.f,
+	TEXT("For invokers with bUseViewDirectionForPriorities, rendered chunks right behind them are meshed as if they were 1 + this times further away"),
+	ECVF_Default);
+
 TVoxelSharedRef<FVoxelDefaultLODManager> FVoxelDefaultLODManager::Create(
 	const FVoxelLODSettings& LODSettings,
 	TWeakObjectPtr<const AVoxelWorldInterface> VoxelWorldInterface,
@@ -111,19 +118,7 @@ bool FVoxelDefaultLODManager::AreCollisionsEnabled(const FIntVector& Position, u
 		return false;
 	}
 
-	OutLOD = 255;
-
-	auto* Ptr = Octree.Get();
-	while (Ptr->HasChildren())
-	{
-		Ptr = &Ptr->GetChild(Position);
-		if (Ptr->GetSettings().bEnableCollisions)
-		{
-			OutLOD = Ptr->Height;
-		}
-	}
-
-	return OutLOD != 255;
+	return Octree->AreCollisionsEnabled(Position, OutLOD);
 }
 
 void FVoxelDefaultLODManager::Destroy()
@@ -210,6 +205,8 @@ void FVoxelDefaultLODManager::UpdateInvokers()
 
 	TMap<TWeakObjectPtr<UVoxelInvokerComponentBase>, FVoxelInvokerInfo> NewInvokerComponentsInfos;
 	NewInvokerComponentsInfos.Reserve(NewSortedInvokerComponents.Num());
+
+	bool bUseViewDirections = false;
 	
 	const uint64 SquaredDistanceThreshold = FMath::Square(FMath::Max(DynamicSettings->InvokerDistanceThreshold / Settings.VoxelSize, 0.f)); // Truncate
 	for (const auto& InvokerComponent : NewSortedInvokerComponents)
@@ -223,6 +220,17 @@ void FVoxelDefaultLODManager::UpdateInvokers()
 		Info.LocalPosition = InvokerPosition;
 		Info.Settings = InvokerSettings;
 
+		if (InvokerComponent->bUseForPriorities && InvokerComponent->bUseViewDirectionForPriorities)
+		{
+			// Transform the direction to voxel space
+			const FVector GlobalPosition = VoxelWorldInterface->LocalToGlobal(InvokerPosition);
+			const FVector GlobalDirection = InvokerComponent->GetInvokerViewDirection().GetSafeNormal();
+			Info.ViewDirection = (
+				VoxelWorldInterface->GlobalToLocalFloat(GlobalPosition + GlobalDirection * 100.f) -
+				VoxelWorldInterface->GlobalToLocalFloat(GlobalPosition)).ToFloat().GetSafeNormal();
+			bUseViewDirections = true;
+		}
+
 		NewInvokerComponentsInfos.Add(InvokerComponent, Info);
 
 		if (!bNeedUpdate)
@@ -257,6 +265,19 @@ void FVoxelDefaultLODManager::UpdateInvokers()
 					LOG_VOXEL(Verbose, TEXT("Tiggering LOD Update: Invoker Component moved"));
 					bNeedUpdate = true;
 				}
+				else if (OldSettings.bUseSweptPath != NewSettings.bUseSweptPath)
+				{
+					LOG_VOXEL(Verbose, TEXT("Tiggering LOD Update: bUseSweptPath changed"));
+					bNeedUpdate = true;
+				}
+				else if (
+					NewSettings.bUseSweptPath &&
+					(FVoxelUtilities::SquaredSize(OldSettings.SweptPathStart - NewSettings.SweptPathStart) > SquaredDistanceThreshold ||
+					 FVoxelUtilities::SquaredSize(OldSettings.SweptPathEnd - NewSettings.SweptPathEnd) > SquaredDistanceThreshold))
+				{
+					LOG_VOXEL(Verbose, TEXT("Tiggering LOD Update: Invoker Component swept path moved"));
+					bNeedUpdate = true;
+				}
 			}
 		}
 	}
@@ -271,15 +292,19 @@ void FVoxelDefaultLODManager::UpdateInvokers()
 		SortedInvokerComponents = MoveTemp(NewSortedInvokerComponents);
 		InvokerComponentsInfos = MoveTemp(NewInvokerComponentsInfos);
 
-		TArray<FIntVector> InvokersPositionsForPriorities;
-		for (auto& It : InvokerComponentsInfos)
+		UpdateInvokersForPriorities();
+	}
+	else if (bUseViewDirections)
+	{
+		// Rotating doesn't trigger LOD updates, but the priorities need the new view directions
+		for (auto& It : NewInvokerComponentsInfos)
 		{
-			if (It.Key->bUseForPriorities)
+			if (auto* Info = InvokerComponentsInfos.Find(It.Key))
 			{
-				InvokersPositionsForPriorities.Add(It.Value.LocalPosition);
+				Info->ViewDirection = It.Value.ViewDirection;
 			}
 		}
-		Settings.Renderer->SetInvokersPositionsForPriorities(InvokersPositionsForPriorities);
+		UpdateInvokersForPriorities();
 	}
 
 	ensure(SortedInvokerComponents.Num() == InvokerComponentsInfos.Num());
@@ -293,6 +318,32 @@ void FVoxelDefaultLODManager::UpdateInvokers()
 	}
 }
 
+void FVoxelDefaultLODManager::UpdateInvokersForPriorities()
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	const float ViewDirectionWeight = FMath::Max(0.f, CVarViewDirectionPriorityWeight.GetValueOnGameThread());
+
+	TArray<FVoxelInvokerPriorityPath> InvokersPositionsForPriorities;
+	for (auto& It : InvokerComponentsInfos)
+	{
+		if (It.Key->bUseForPriorities)
+		{
+			const FVoxelInvokerSettings& InvokerSettings = It.Value.Settings;
+			FVoxelInvokerPriorityPath Path = InvokerSettings.bUseSweptPath
+				? FVoxelInvokerPriorityPath(InvokerSettings.SweptPathStart, InvokerSettings.SweptPathEnd)
+				: FVoxelInvokerPriorityPath(It.Value.LocalPosition);
+			if (!It.Value.ViewDirection.IsZero())
+			{
+				Path.ViewDirection = It.Value.ViewDirection;
+				Path.ViewDirectionWeight = ViewDirectionWeight;
+			}
+			InvokersPositionsForPriorities.Add(Path);
+		}
+	}
+	Settings.Renderer->SetInvokersPositionsForPriorities(InvokersPositionsForPriorities);
+}
+
 void FVoxelDefaultLODManager::UpdateLODs()
 {
 	VOXEL_FUNCTION_COUNTER();
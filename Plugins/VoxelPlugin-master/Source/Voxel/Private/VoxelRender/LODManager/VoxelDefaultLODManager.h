@@ -57,6 +57,7 @@ public:
 	//~ Begin FVoxelTickable Interface
 	virtual void Tick(float DeltaTime) override;
 	virtual bool IsTickableInEditor() const override { return true; }
+	virtual EVoxelGameThreadWork GetGameThreadWork() const override { return EVoxelGameThreadWork::LODManager; }
 	//~ End FVoxelTickable Interface
 
 private:
@@ -76,6 +77,8 @@ private:
 	{
 		FIntVector LocalPosition{ForceInit};
 		FVoxelInvokerSettings Settings;
+		// Normalized, in voxel space. Zero if not used for priorities
+		FVector ViewDirection{ForceInit};
 	};
 	TMap<TWeakObjectPtr<UVoxelInvokerComponentBase>, FVoxelInvokerInfo> InvokerComponentsInfos;
 	TArray<TWeakObjectPtr<UVoxelInvokerComponentBase>> SortedInvokerComponents;
@@ -86,6 +89,7 @@ private:
 	double LastInvokersUpdateTime = 0;
 
 	void UpdateInvokers();
+	void UpdateInvokersForPriorities();
 	void UpdateLODs();
 
 	void ClearInvokerComponents();
@@ -0,0 +1,88 @@
+// Copyright 2020 Phyronnaz
+
+#include "VoxelInvokersGrid.h"
+
+// Above that, an invoker is tested by every query instead of being added to the cells
+static constexpr int64 MaxCellsPerInvoker = 64;
+
+FVoxelInvokersGrid::FVoxelInvokersGrid(const TArray<FVoxelInvokerSettings>& Invokers)
+	: Invokers(Invokers)
+{
+	VOXEL_ASYNC_FUNCTION_COUNTER();
+
+	BuildGrid(EShape::LOD);
+	BuildGrid(EShape::Collisions);
+	BuildGrid(EShape::Navmesh);
+}
+
+void FVoxelInvokersGrid::BuildGrid(EShape Shape)
+{
+	VOXEL_ASYNC_FUNCTION_COUNTER();
+
+	FGrid& Grid = Grids[uint8(Shape)];
+
+	const auto GetBounds = [&](const FVoxelInvokerSettings& Invoker) -> const FVoxelIntBox*
+	{
+		switch (Shape)
+		{
+		case EShape::LOD: return Invoker.bUseForLOD ? &Invoker.LODBounds : nullptr;
+		case EShape::Collisions: return Invoker.bUseForCollisions ? &Invoker.CollisionsBounds : nullptr;
+		case EShape::Navmesh: return Invoker.bUseForNavmesh ? &Invoker.NavmeshBounds : nullptr;
+		default: check(false); return nullptr;
+		}
+	};
+
+	TArray<int64> Sizes;
+	for (int32 Index = 0; Index < Invokers.Num(); Index++)
+	{
+		const FVoxelIntBox* Bounds = GetBounds(Invokers[Index]);
+		// Invalid bounds can't intersect anything
+		if (Bounds && Bounds->IsValid())
+		{
+			Grid.Invokers.Add(Index);
+			Sizes.Add(FMath::Max3(
+				int64(Bounds->Max.X) - Bounds->Min.X,
+				int64(Bounds->Max.Y) - Bounds->Min.Y,
+				int64(Bounds->Max.Z) - Bounds->Min.Z));
+		}
+	}
+
+	if (Grid.Invokers.Num() == 0)
+	{
+		return;
+	}
+
+	// Median size, rounded up to a power of 2
+	Sizes.Sort();
+	const int64 MedianSize = FMath::Clamp<int64>(Sizes[Sizes.Num() / 2], RENDER_CHUNK_SIZE, 1 << 30);
+	Grid.CellSize = 1 << FMath::CeilLogTwo(uint32(MedianSize));
+
+	for (const int32 Index : Grid.Invokers)
+	{
+		const FVoxelIntBox& Bounds = *GetBounds(Invokers[Index]);
+
+		const FIntVector MinCell = GetCell(Grid, Bounds.Min);
+		const FIntVector MaxCell = GetCell(Grid, Bounds.Max - FIntVector(1));
+		const int64 NumCells =
+			int64(MaxCell.X - MinCell.X + 1) *
+			int64(MaxCell.Y - MinCell.Y + 1) *
+			int64(MaxCell.Z - MinCell.Z + 1);
+
+		if (NumCells > MaxCellsPerInvoker)
+		{
+			Grid.LargeInvokers.Add(Index);
+			continue;
+		}
+
+		for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+		{
+			for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+			{
+				for (int32 Z = MinCell.Z; Z <= MaxCell.Z; Z++)
+				{
+					Grid.Cells.FindOrAdd(FIntVector(X, Y, Z)).Add(Index);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,110 @@
+// Copyright 2020 Phyronnaz
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VoxelIntBox.h"
+#include "VoxelMinimal.h"
+#include "VoxelInvokerSettings.h"
+#include "VoxelUtilities/VoxelBaseUtilities.h"
+
+/**
+ * Sparse uniform grids over the invokers LOD, collisions & navmesh bounds, built once per render octree build
+ * Lets the octree nodes only test the invokers around them instead of all of them
+ *
+ * The cell size of each grid is the median size of the bounds it contains
+ * Bounds covering too many cells are kept aside and always tested, and queries covering more cells than there are invokers just test them all
+ */
+class FVoxelInvokersGrid
+{
+public:
+	enum class EShape : uint8
+	{
+		LOD,
+		Collisions,
+		Navmesh
+	};
+
+	explicit FVoxelInvokersGrid(const TArray<FVoxelInvokerSettings>& Invokers);
+
+	// Calls Lambda on the invokers using Shape whose bounds might intersect Bounds, until it returns true
+	// The same invoker can be given several times. Returns true if Lambda did
+	template<typename T>
+	bool AnyInvoker(EShape Shape, const FVoxelIntBox& Bounds, T Lambda) const
+	{
+		const FGrid& Grid = Grids[uint8(Shape)];
+
+		const FIntVector MinCell = GetCell(Grid, Bounds.Min);
+		const FIntVector MaxCell = GetCell(Grid, Bounds.Max - FIntVector(1));
+		const int64 NumCells =
+			int64(MaxCell.X - MinCell.X + 1) *
+			int64(MaxCell.Y - MinCell.Y + 1) *
+			int64(MaxCell.Z - MinCell.Z + 1);
+
+		if (NumCells > Grid.Invokers.Num())
+		{
+			for (const int32 Index : Grid.Invokers)
+			{
+				if (Lambda(Invokers[Index]))
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+		for (const int32 Index : Grid.LargeInvokers)
+		{
+			if (Lambda(Invokers[Index]))
+			{
+				return true;
+			}
+		}
+
+		for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+		{
+			for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+			{
+				for (int32 Z = MinCell.Z; Z <= MaxCell.Z; Z++)
+				{
+					if (const auto* Cell = Grid.Cells.Find(FIntVector(X, Y, Z)))
+					{
+						for (const int32 Index : *Cell)
+						{
+							if (Lambda(Invokers[Index]))
+							{
+								return true;
+							}
+						}
+					}
+				}
+			}
+		}
+
+		return false;
+	}
+
+private:
+	struct FGrid
+	{
+		int32 CellSize = 1;
+		// All the invokers using this shape
+		TArray<int32> Invokers;
+		// Invokers covering too many cells to be added to them
+		TArray<int32> LargeInvokers;
+		TMap<FIntVector, TArray<int32, TInlineAllocator<4>>> Cells;
+	};
+
+	const TArray<FVoxelInvokerSettings> Invokers;
+	FGrid Grids[3];
+
+	void BuildGrid(EShape Shape);
+
+	FORCEINLINE static FIntVector GetCell(const FGrid& Grid, const FIntVector& Position)
+	{
+		return FIntVector(
+			FVoxelUtilities::DivideFloor(Position.X, Grid.CellSize),
+			FVoxelUtilities::DivideFloor(Position.Y, Grid.CellSize),
+			FVoxelUtilities::DivideFloor(Position.Z, Grid.CellSize));
+	}
+};
@@ -1,6 +1,7 @@
 // Copyright 2020 Phyronnaz
 
 #include "VoxelRenderOctree.h"
+#include "VoxelUtilities/VoxelMathUtilities.h"
 #include "VoxelDebug/VoxelDebugManager.h"
 #include "VoxelMessages.h"
 #include "Async/Async.h"
@@ -20,6 +21,52 @@ static TAutoConsoleVariable<int32> CVarLogRenderOctreeBuildTime(
 	TEXT("If true, will log the render octree build times"),
 	ECVF_Default);
 
+static TAutoConsoleVariable<int32> CVarIncrementalRenderOctree(
+	TEXT("voxel.renderer.IncrementalRenderOctree"),
+	1,
+	TEXT("If true, render octree builds will only re-evaluate the invokers of the nodes overlapping the invokers that changed since the last build"),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarRenderOctreeInvokersGridMinInvokers(
+	TEXT("voxel.renderer.RenderOctreeInvokersGridMinInvokers"),
+	8,
+	TEXT("Render octree builds with at least this many invokers will index them in a grid, so that each node only tests the invokers around it. 0 to disable"),
+	ECVF_Default);
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Voxel Render Octree Invokers"), STAT_VoxelRenderOctreeInvokers, STATGROUP_VoxelCounters);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Voxel Render Octree Changed Invokers"), STAT_VoxelRenderOctreeChangedInvokers, STATGROUP_VoxelCounters);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Voxel Render Octree Re-evaluated Nodes"), STAT_VoxelRenderOctreeReevaluatedNodes, STATGROUP_VoxelCounters);
+
+struct FVoxelRenderOctreeBuildTimes
+{
+	int32 NumBuilds = 0;
+	int32 NumIncrementalBuilds = 0;
+	double TotalTime = 0;
+	double MaxTime = 0;
+};
+// Game thread only, keyed by the number of invokers
+static TMap<int32, FVoxelRenderOctreeBuildTimes> GVoxelRenderOctreeBuildTimes;
+
+static FAutoConsoleCommand LogRenderOctreeBuildTimesCmd(
+	TEXT("voxel.renderer.LogRenderOctreeBuildTimes"),
+	TEXT("Log the render octree build times by number of invokers since the last call"),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		GVoxelRenderOctreeBuildTimes.KeySort(TLess<int32>());
+		LOG_VOXEL(Log, TEXT("Render octree build times by number of invokers:"));
+		for (auto& It : GVoxelRenderOctreeBuildTimes)
+		{
+			const FVoxelRenderOctreeBuildTimes& Times = It.Value;
+			LOG_VOXEL(Log, TEXT("\t%d invokers: %d builds (%d incremental), average %.3fms, max %.3fms"),
+				It.Key,
+				Times.NumBuilds,
+				Times.NumIncrementalBuilds,
+				Times.NumBuilds > 0 ? 1000. * Times.TotalTime / Times.NumBuilds : 0.,
+				1000. * Times.MaxTime);
+		}
+		GVoxelRenderOctreeBuildTimes.Reset();
+	}));
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
@@ -39,6 +86,12 @@ void FVoxelRenderOctreeAsyncBuilder::Init(const FVoxelRenderOctreeSettings& InOc
 	OctreeSettings = InOctreeSettings;
 	OldOctree = InOctree;
 
+	// The invokers cache of the old octree nodes is only valid if we built it
+	bIncremental =
+		CVarIncrementalRenderOctree.GetValueOnGameThread() &&
+		OldOctree.IsValid() &&
+		LastBuiltOctree.Pin() == OldOctree;
+
 	SetIsDone(false);
 	Counter = FPlatformTime::Seconds();
 	Log = "Render octree build stats:";
@@ -58,6 +111,14 @@ void FVoxelRenderOctreeAsyncBuilder::ReportBuildTime()
 		LOG_VOXEL(Log, TEXT("%s"), *Log);
 	}
 
+	{
+		FVoxelRenderOctreeBuildTimes& Times = GVoxelRenderOctreeBuildTimes.FindOrAdd(OctreeSettings.Invokers.Num());
+		Times.NumBuilds++;
+		Times.NumIncrementalBuilds += bIncremental ? 1 : 0;
+		Times.TotalTime += WorkTime;
+		Times.MaxTime = FMath::Max(Times.MaxTime, WorkTime);
+	}
+
 	if (bTooManyChunks)
 	{
 		FVoxelMessages::Error(FString::Printf(TEXT(
@@ -94,14 +155,46 @@ void FVoxelRenderOctreeAsyncBuilder::DoWork()
 	
 	{
 		VOXEL_ASYNC_SCOPE_COUNTER("Cloning octree");
-		NewOctree = OldOctree.IsValid() ? MakeVoxelShared<FVoxelRenderOctree>(&*OldOctree) : MakeVoxelShared<FVoxelRenderOctree>(OctreeDepth);
+		NewOctree = OldOctree.IsValid() ? MakeVoxelShared<FVoxelRenderOctree>(*OldOctree) : MakeVoxelShared<FVoxelRenderOctree>(OctreeDepth);
 		LOG_TIME("Cloning octree");
 	}
 	
+	{
+		VOXEL_ASYNC_SCOPE_COUNTER("Diffing invokers");
+		InvokersDirtyBounds.Reset();
+		NumChangedInvokers = OctreeSettings.Invokers.Num();
+		if (bIncremental)
+		{
+			GetInvokersDirtyBounds(LastBuiltOctreeInvokers, OctreeSettings.Invokers, InvokersDirtyBounds, NumChangedInvokers);
+		}
+		LOG_TIME("Diffing invokers");
+		Log += "; Incremental: " + FString(bIncremental ? "true" : "false");
+		Log += "; Invokers: " + FString::FromInt(OctreeSettings.Invokers.Num());
+		Log += "; Changed invokers: " + FString::FromInt(NumChangedInvokers);
+		Log += "; Dirty bounds: " + FString::FromInt(InvokersDirtyBounds.Num());
+	}
+
+	{
+		VOXEL_ASYNC_SCOPE_COUNTER("Building invokers grid");
+		const int32 MinInvokers = CVarRenderOctreeInvokersGridMinInvokers.GetValueOnAnyThread();
+		OctreeSettings.InvokersGrid.Reset();
+		if (MinInvokers > 0 && OctreeSettings.Invokers.Num() >= MinInvokers)
+		{
+			OctreeSettings.InvokersGrid = MakeVoxelShared<FVoxelInvokersGrid>(OctreeSettings.Invokers);
+		}
+		LOG_TIME("Building invokers grid");
+		Log += "; Invokers grid: " + FString(OctreeSettings.InvokersGrid.IsValid() ? "true" : "false");
+	}
+
 	{
 		VOXEL_ASYNC_SCOPE_COUNTER("ResetDivisionType");
-		NewOctree->ResetDivisionType();
+		const int32 NumReevaluatedNodes = NewOctree->ResetDivisionType(bIncremental, InvokersDirtyBounds);
 		LOG_TIME("ResetDivisionType");
+		Log += "; Re-evaluated nodes: " + FString::FromInt(NumReevaluatedNodes) + "/" + FString::FromInt(NewOctree->CurrentChunksCount);
+
+		SET_DWORD_STAT(STAT_VoxelRenderOctreeInvokers, OctreeSettings.Invokers.Num());
+		SET_DWORD_STAT(STAT_VoxelRenderOctreeChangedInvokers, NumChangedInvokers);
+		SET_DWORD_STAT(STAT_VoxelRenderOctreeReevaluatedNodes, NumReevaluatedNodes);
 	}
 
 	bool bChanged;
@@ -175,9 +268,16 @@ void FVoxelRenderOctreeAsyncBuilder::DoWork()
 
 	if (bTooManyChunks)
 	{
+		// The old octree is kept: so are the invokers it was built with
 		NewOctree.Reset();
 	}
+	else
+	{
+		LastBuiltOctree = NewOctree;
+		LastBuiltOctreeInvokers = OctreeSettings.Invokers;
+	}
 
+	WorkTime = FPlatformTime::Seconds() - WorkStartTime;
 	LOG_TIME_IMPL("Total time working", WorkStartTime);
 }
 
@@ -186,419 +286,571 @@ uint32 FVoxelRenderOctreeAsyncBuilder::GetPriority() const
 	return 0;
 }
 
-#undef LOG_TIME
-
-///////////////////////////////////////////////////////////////////////////////
-///////////////////////////////////////////////////////////////////////////////
-///////////////////////////////////////////////////////////////////////////////
-
-#define CHECK_MAX_CHUNKS_COUNT_IMPL(ReturnValue) if (IsCanceled()) { return ReturnValue; }
-#define CHECK_MAX_CHUNKS_COUNT() CHECK_MAX_CHUNKS_COUNT_IMPL(;)
-#define CHECK_MAX_CHUNKS_COUNT_BOOL() CHECK_MAX_CHUNKS_COUNT_IMPL(false)
-
-FVoxelRenderOctree::FVoxelRenderOctree(uint8 LOD)
-	: TSimpleVoxelOctree(LOD)
-	, Root(this)
-	, ChunkId(GetId())
-	, OctreeBounds(GetBounds())
+void FVoxelRenderOctreeAsyncBuilder::GetInvokersDirtyBounds(
+	const TArray<FVoxelInvokerSettings>& InvokersA,
+	const TArray<FVoxelInvokerSettings>& InvokersB,
+	TArray<FVoxelIntBox>& OutDirtyBounds,
+	int32& OutNumChangedInvokers)
 {
-	check(LOD > 0);
-	check(ChunkId <= Root->RootIdCounter);
-	Root->CurrentChunksCount++;
+	VOXEL_ASYNC_FUNCTION_COUNTER();
 
-	INC_DWORD_STAT_BY(STAT_VoxelRenderOctreesCount, 1);
-	INC_VOXEL_MEMORY_STAT_BY(STAT_VoxelRenderOctreesMemory, sizeof(FVoxelRenderOctree));
-}
+	const auto AreEqual = [](const FVoxelInvokerSettings& A, const FVoxelInvokerSettings& B)
+	{
+		return
+			A.bUseForLOD == B.bUseForLOD &&
+			A.LODToSet == B.LODToSet &&
+			A.LODBounds == B.LODBounds &&
+			A.bUseForCollisions == B.bUseForCollisions &&
+			A.CollisionsBounds == B.CollisionsBounds &&
+			A.bUseForNavmesh == B.bUseForNavmesh &&
+			A.NavmeshBounds == B.NavmeshBounds &&
+			A.bUseSweptPath == B.bUseSweptPath &&
+			A.SweptPathStart == B.SweptPathStart &&
+			A.SweptPathEnd == B.SweptPathEnd &&
+			A.SweptPathLODRange == B.SweptPathLODRange &&
+			A.SweptPathCollisionsRange == B.SweptPathCollisionsRange &&
+			A.SweptPathNavmeshRange == B.SweptPathNavmeshRange;
+	};
+	const auto AddBounds = [&](const FVoxelInvokerSettings& Invoker)
+	{
+		if (Invoker.bUseForLOD)
+		{
+			OutDirtyBounds.Add(Invoker.LODBounds);
+		}
+		if (Invoker.bUseForCollisions)
+		{
+			OutDirtyBounds.Add(Invoker.CollisionsBounds);
+		}
+		if (Invoker.bUseForNavmesh)
+		{
+			OutDirtyBounds.Add(Invoker.NavmeshBounds);
+		}
+	};
 
-FVoxelRenderOctree::FVoxelRenderOctree(const FVoxelRenderOctree* Source)
-	: TSimpleVoxelOctree(Source->Height)
-	, RootIdCounter(Source->RootIdCounter)
-	, Root(this)
-	, ChunkId(Source->ChunkId)
-	, OctreeBounds(GetBounds())
-	, UpdateIndex(Source->UpdateIndex)
-{
-	check(ChunkId <= Root->RootIdCounter);
-	Root->CurrentChunksCount++;
-	ChunkSettings = Source->ChunkSettings;
-	if (Source->HasChildren())
+	// The classification of a node is an OR over all the invokers: the order of the invokers doesn't matter,
+	// and replacing invoker A by invoker B can only change the nodes overlapping the bounds of A or B
+	OutNumChangedInvokers = 0;
+	for (int32 Index = 0; Index < FMath::Max(InvokersA.Num(), InvokersB.Num()); Index++)
 	{
-		CreateChildren(Source->GetChildren());
-	}
+		const FVoxelInvokerSettings* InvokerA = InvokersA.IsValidIndex(Index) ? &InvokersA[Index] : nullptr;
+		const FVoxelInvokerSettings* InvokerB = InvokersB.IsValidIndex(Index) ? &InvokersB[Index] : nullptr;
+		if (InvokerA && InvokerB && AreEqual(*InvokerA, *InvokerB))
+		{
+			continue;
+		}
 
-	INC_DWORD_STAT_BY(STAT_VoxelRenderOctreesCount, 1);
-	INC_VOXEL_MEMORY_STAT_BY(STAT_VoxelRenderOctreesMemory, sizeof(FVoxelRenderOctree));
+		OutNumChangedInvokers++;
+		if (InvokerA)
+		{
+			AddBounds(*InvokerA);
+		}
+		if (InvokerB)
+		{
+			AddBounds(*InvokerB);
+		}
+	}
 }
 
+#undef LOG_TIME
 
-FVoxelRenderOctree::FVoxelRenderOctree(const FVoxelRenderOctree& Parent, uint8 ChildIndex)
-	: TSimpleVoxelOctree(Parent, ChildIndex)
-	, Root(Parent.Root)
-	, ChunkId(GetId())
-	, OctreeBounds(GetBounds())
-	, UpdateIndex(Parent.UpdateIndex)
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+FVoxelRenderOctree::FVoxelRenderOctree(uint8 Depth)
+	: Depth(Depth)
+	, OctreeBounds(FVoxelUtilities::GetBoundsFromDepth<RENDER_CHUNK_SIZE>(Depth))
 {
-	check(ChunkId <= Root->RootIdCounter);
-	Root->CurrentChunksCount++;
+	check(Depth > 0);
+
+	Levels.SetNum(Depth + 1);
+	FNode& RootNode = Levels[Depth].Add(FIntVector::ZeroValue);
+	RootNode.ChunkId = ++IdCounter;
+	CurrentChunksCount++;
 
 	INC_DWORD_STAT_BY(STAT_VoxelRenderOctreesCount, 1);
-	INC_VOXEL_MEMORY_STAT_BY(STAT_VoxelRenderOctreesMemory, sizeof(FVoxelRenderOctree));
+	UpdateAllocatedSize();
 }
 
-
-FVoxelRenderOctree::FVoxelRenderOctree(const FVoxelRenderOctree& Parent, uint8 ChildIndex, const ChildrenArray& SourceChildren)
-	: TSimpleVoxelOctree(Parent, ChildIndex)
-	, Root(Parent.Root)
-	, ChunkId(SourceChildren[ChildIndex].ChunkId)
-	, OctreeBounds(GetBounds())
-	, UpdateIndex(Parent.UpdateIndex)
+FVoxelRenderOctree::FVoxelRenderOctree(const FVoxelRenderOctree& Source)
+	: Depth(Source.Depth)
+	, OctreeBounds(Source.OctreeBounds)
+	, CurrentChunksCount(Source.CurrentChunksCount)
+	, UpdateIndex(Source.UpdateIndex)
+	, Levels(Source.Levels)
+	, IdCounter(Source.IdCounter)
 {
-	Root->CurrentChunksCount++;
-
-	auto& Source = SourceChildren[ChildIndex];
-	ChunkSettings = Source.ChunkSettings;
-	if (Source.HasChildren())
-	{
-		CreateChildren(Source.GetChildren());
-	}
-
-	INC_DWORD_STAT_BY(STAT_VoxelRenderOctreesCount, 1);
-	INC_VOXEL_MEMORY_STAT_BY(STAT_VoxelRenderOctreesMemory, sizeof(FVoxelRenderOctree));
+	INC_DWORD_STAT_BY(STAT_VoxelRenderOctreesCount, CurrentChunksCount);
+	UpdateAllocatedSize();
 }
 
 FVoxelRenderOctree::~FVoxelRenderOctree()
 {
-	Root->CurrentChunksCount--;
-	DEC_DWORD_STAT_BY(STAT_VoxelRenderOctreesCount, 1);
-	DEC_VOXEL_MEMORY_STAT_BY(STAT_VoxelRenderOctreesMemory, sizeof(FVoxelRenderOctree));
+	DEC_DWORD_STAT_BY(STAT_VoxelRenderOctreesCount, CurrentChunksCount);
+	DEC_VOXEL_MEMORY_STAT_BY(STAT_VoxelRenderOctreesMemory, AllocatedSize);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-void FVoxelRenderOctree::ResetDivisionType()
+int32 FVoxelRenderOctree::ResetDivisionType(bool bIncremental, TArrayView<const FVoxelIntBox> InvokersDirtyBounds)
 {
-	ChunkSettings.OldDivisionType = ChunkSettings.DivisionType;
-	ChunkSettings.DivisionType = EDivisionType::Uninitialized;
+	int32 NumInvalidated = 0;
+	for (auto& Level : Levels)
+	{
+		for (auto& It : Level)
+		{
+			FChunkSettings& ChunkSettings = It.Value.ChunkSettings;
+			ChunkSettings.OldDivisionType = ChunkSettings.DivisionType;
+			ChunkSettings.DivisionType = EDivisionType::Uninitialized;
 
-	if (!!HasChildren())
+			if (!bIncremental)
+			{
+				ChunkSettings.InvokersCache.bValid = false;
+				NumInvalidated++;
+			}
+		}
+	}
+
+	if (bIncremental)
 	{
-		for (auto& Child : GetChildren())
+		for (const FVoxelIntBox& Bounds : InvokersDirtyBounds)
 		{
-			Child.ResetDivisionType();
+			IterateNodesOverlappingBounds(Bounds, [&](int32 Height, const FIntVector& Key, const FNode& Node)
+			{
+				// Only the cache is modified, not the structure of the octree
+				FInvokersCache& Cache = const_cast<FNode&>(Node).ChunkSettings.InvokersCache;
+				if (Cache.bValid)
+				{
+					Cache.bValid = false;
+					NumInvalidated++;
+				}
+			});
 		}
 	}
+
+	return NumInvalidated;
 }
 
 bool FVoxelRenderOctree::UpdateSubdividedByDistance(const FVoxelRenderOctreeSettings& Settings)
 {
-	CHECK_MAX_CHUNKS_COUNT_BOOL();
-	
-	if (ShouldSubdivideByDistance(Settings))
+	bool bChanged = false;
+	TraverseTopDown([&](int32 Height, const FIntVector& Key, FNode& Node, const FNode* Parent)
 	{
-		ChunkSettings.DivisionType = EDivisionType::ByDistance;
-		
-		if (!HasChildren())
+		if (ShouldSubdivideByDistance(Height, Key, Node, Settings))
 		{
-			CreateChildren();
+			Node.ChunkSettings.DivisionType = EDivisionType::ByDistance;
+
+			if (!Node.bHasChildren)
+			{
+				CreateChildren(Height, Key, Node);
+			}
+
+			bChanged |= Node.ChunkSettings.OldDivisionType != EDivisionType::ByDistance;
+			return true;
 		}
-		
-		bool bChanged = ChunkSettings.OldDivisionType != EDivisionType::ByDistance;
-		for (auto& Child : GetChildren())
+		else
 		{
-			bChanged |= Child.UpdateSubdividedByDistance(Settings);
+			bChanged |= Node.ChunkSettings.OldDivisionType == EDivisionType::ByDistance;
+			return false;
 		}
-	
-		return bChanged;
-	}
-	else
-	{
-		return ChunkSettings.OldDivisionType == EDivisionType::ByDistance;
-	}
+	});
+	return bChanged && !IsCanceled();
 }
 
 bool FVoxelRenderOctree::UpdateSubdividedByNeighbors(const FVoxelRenderOctreeSettings& Settings)
 {
-	CHECK_MAX_CHUNKS_COUNT_BOOL();
-
 	bool bShouldContinue = false;
-
-	if (ChunkSettings.DivisionType == EDivisionType::Uninitialized && ShouldSubdivideByNeighbors(Settings))
+	TraverseTopDown([&](int32 Height, const FIntVector& Key, FNode& Node, const FNode* Parent)
 	{
-		ChunkSettings.DivisionType = EDivisionType::ByNeighbors;
-		
-		if (!HasChildren())
+		if (Node.ChunkSettings.DivisionType == EDivisionType::Uninitialized && ShouldSubdivideByNeighbors(Height, Key, Settings))
 		{
-			CreateChildren();
-		}
+			Node.ChunkSettings.DivisionType = EDivisionType::ByNeighbors;
 
-		bShouldContinue = true;
-	}
+			if (!Node.bHasChildren)
+			{
+				CreateChildren(Height, Key, Node);
+			}
 
-	if (ChunkSettings.DivisionType != EDivisionType::Uninitialized)
-	{
-		for (auto& Child : GetChildren())
-		{
-			bShouldContinue |= Child.UpdateSubdividedByNeighbors(Settings);
+			bShouldContinue = true;
 		}
-	}
 
-	return bShouldContinue;
+		return Node.ChunkSettings.DivisionType != EDivisionType::Uninitialized;
+	});
+	return bShouldContinue && !IsCanceled();
 }
 
 void FVoxelRenderOctree::ReuseOldNeighbors()
 {
-	if (ChunkSettings.OldDivisionType == EDivisionType::ByNeighbors)
+	for (auto& Level : Levels)
 	{
-		ChunkSettings.DivisionType = EDivisionType::ByNeighbors;
-	}
-
-	if (!!HasChildren())
-	{
-		for (auto& Child : GetChildren())
+		for (auto& It : Level)
 		{
-			Child.ReuseOldNeighbors();
+			FChunkSettings& ChunkSettings = It.Value.ChunkSettings;
+			if (ChunkSettings.OldDivisionType == EDivisionType::ByNeighbors)
+			{
+				ChunkSettings.DivisionType = EDivisionType::ByNeighbors;
+			}
 		}
 	}
 }
 
 void FVoxelRenderOctree::UpdateSubdividedByOthers(const FVoxelRenderOctreeSettings& Settings)
 {
-	CHECK_MAX_CHUNKS_COUNT();
-
-	if (ChunkSettings.DivisionType == EDivisionType::Uninitialized && ShouldSubdivideByOthers(Settings))
+	TraverseTopDown([&](int32 Height, const FIntVector& Key, FNode& Node, const FNode* Parent)
 	{
-		ChunkSettings.DivisionType = EDivisionType::ByOthers;
-
-		if (!HasChildren())
+		if (Node.ChunkSettings.DivisionType == EDivisionType::Uninitialized && ShouldSubdivideByOthers(Height, Key, Node, Settings))
 		{
-			CreateChildren();
-		}
-	}
+			Node.ChunkSettings.DivisionType = EDivisionType::ByOthers;
 
-	if (ChunkSettings.DivisionType != EDivisionType::Uninitialized)
-	{
-		for (auto& Child : GetChildren())
-		{
-			Child.UpdateSubdividedByOthers(Settings);
+			if (!Node.bHasChildren)
+			{
+				CreateChildren(Height, Key, Node);
+			}
 		}
-	}
+
+		return Node.ChunkSettings.DivisionType != EDivisionType::Uninitialized;
+	});
 }
 
 void FVoxelRenderOctree::DeleteChunks(TArray<FVoxelChunkUpdate>& ChunkUpdates)
 {
-	CHECK_MAX_CHUNKS_COUNT();
-
-	if (ChunkSettings.DivisionType == EDivisionType::Uninitialized)
-	{		
-		if (HasChildren())
+	TraverseTopDown([&](int32 Height, const FIntVector& Key, FNode& Node, const FNode* Parent)
+	{
+		if (Node.ChunkSettings.DivisionType != EDivisionType::Uninitialized)
 		{
-			for (auto& Child : GetChildren())
-			{
-				ensure(Child.ChunkSettings.DivisionType == EDivisionType::Uninitialized);
-				
-				Child.DeleteChunks(ChunkUpdates);
-				
-				if (Child.ChunkSettings.Settings.HasRenderChunk())
-				{
-					//ensureVoxelSlowNoSideEffects(!ChunkUpdates.FindByPredicate([&](const FVoxelChunkUpdate& ChunkUpdate) { return ChunkUpdate.Id == Child.ChunkId; }));
-					ChunkUpdates.Emplace(
-						FVoxelChunkUpdate
-						{
-							Child.ChunkId,
-							Child.Height,
-							Child.OctreeBounds,
-							Child.ChunkSettings.Settings,
-							{},
-							{}
-						});
-				}
-			}
-			DestroyChildren();
+			return true;
 		}
-	}
-	else
-	{
-		for (auto& Child : GetChildren())
+
+		if (Node.bHasChildren)
 		{
-			Child.DeleteChunks(ChunkUpdates);
+			DestroyChildren(Height, Key, Node, ChunkUpdates);
 		}
-	}
+		return false;
+	});
+
+	UpdateAllocatedSize();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
 void FVoxelRenderOctree::GetUpdates(
-	uint32 InUpdateIndex,
+	uint64 InUpdateIndex,
 	bool bRecomputeTransitionMasks,
 	const FVoxelRenderOctreeSettings& Settings,
-	TArray<FVoxelChunkUpdate>& ChunkUpdates,
-	bool bInVisible)
+	TArray<FVoxelChunkUpdate>& ChunkUpdates)
 {
-	CHECK_MAX_CHUNKS_COUNT();
-
 	UpdateIndex++;
 	check(UpdateIndex == InUpdateIndex);
 
-	if (!OctreeBounds.Intersect(Settings.WorldBounds))
+	TraverseTopDown([&](int32 Height, const FIntVector& Key, FNode& Node, const FNode* Parent)
 	{
-		return;
-	}
+		const FVoxelIntBox Bounds = GetNodeBounds(Height, Key);
+		if (!Bounds.Intersect(Settings.WorldBounds))
+		{
+			return false;
+		}
 
-	FVoxelChunkSettings NewSettings{};
-	
-	// NOTE: we DO want bEnableRender = false to disable VisibleChunks settings
-	NewSettings.bVisible = Settings.bEnableRender && Height <= Settings.ChunksCullingLOD && bInVisible;
+		FChunkSettings& ChunkSettings = Node.ChunkSettings;
+		FVoxelChunkSettings NewSettings{};
 
-	if (!HasChildren())
-	{
-		check(ChunkSettings.DivisionType == EDivisionType::Uninitialized);
-	}
-	else
-	{
-		check(ChunkSettings.DivisionType != EDivisionType::Uninitialized);
-		bool bChildrenVisible;
-		if (ChunkSettings.DivisionType == EDivisionType::ByDistance || ChunkSettings.DivisionType == EDivisionType::ByNeighbors)
+		// The root is always in a visible parent
+		// If the parent is subdivided for collisions/navmesh only, its children aren't visible
+		const bool bInVisible = !Parent || IsVisibleParent(*Parent);
+
+		// NOTE: we DO want bEnableRender = false to disable VisibleChunks settings
+		NewSettings.bVisible = Settings.bEnableRender && Height <= Settings.ChunksCullingLOD && bInVisible;
+
+		if (!Node.bHasChildren)
 		{
-			// There are visible children
-			NewSettings.bVisible = false;
-			bChildrenVisible = true;
+			check(ChunkSettings.DivisionType == EDivisionType::Uninitialized);
 		}
 		else
 		{
-			check(ChunkSettings.DivisionType == EDivisionType::ByOthers);
-			bChildrenVisible = false;
-		}
-
-		for (auto& Child : GetChildren())
-		{
-			Child.GetUpdates(UpdateIndex, bRecomputeTransitionMasks, Settings, ChunkUpdates, bChildrenVisible);
+			check(ChunkSettings.DivisionType != EDivisionType::Uninitialized);
+			if (IsVisibleParent(Node))
+			{
+				// There are visible children
+				NewSettings.bVisible = false;
+			}
+			else
+			{
+				check(ChunkSettings.DivisionType == EDivisionType::ByOthers);
+			}
 		}
-	}
-
-	NewSettings.bEnableCollisions =
-		Settings.bEnableCollisions &&
-		((Height == 0 &&
-			IsInvokerInRange(Settings.Invokers,
-				[](const FVoxelInvokerSettings& Invoker) { return Invoker.bUseForCollisions; },
-				[](const FVoxelInvokerSettings& Invoker) { return Invoker.CollisionsBounds; })
-		 )
-		 ||
-		 (NewSettings.bVisible && Settings.bComputeVisibleChunksCollisions && Height <= Settings.VisibleChunksCollisionsMaxLOD)
-	    );
-		
-	NewSettings.bEnableNavmesh = 
-		Settings.bEnableNavmesh &&
-		((Height == 0 &&
-			IsInvokerInRange(Settings.Invokers,
-				[](const FVoxelInvokerSettings& Invoker) { return Invoker.bUseForNavmesh; },
-				[](const FVoxelInvokerSettings& Invoker) { return Invoker.NavmeshBounds; })
-		)
-		||
-		(NewSettings.bVisible && Settings.bComputeVisibleChunksNavmesh && Height <= Settings.VisibleChunksNavmeshMaxLOD)
-		);
 
-	check(NewSettings.TransitionsMask == 0);
-	if (NewSettings.HasRenderChunk())
-	{
-		if (NewSettings.bVisible && Settings.bEnableTransitions)
+		NewSettings.bEnableCollisions =
+			Settings.bEnableCollisions &&
+			((Height == 0 && GetInvokersCache(Height, Key, Node, Settings).bCollisionsInvokerInRange)
+			 ||
+			 (NewSettings.bVisible && Settings.bComputeVisibleChunksCollisions && Height <= Settings.VisibleChunksCollisionsMaxLOD)
+			);
+
+		NewSettings.bEnableNavmesh =
+			Settings.bEnableNavmesh &&
+			((Height == 0 && GetInvokersCache(Height, Key, Node, Settings).bNavmeshInvokerInRange)
+			||
+			(NewSettings.bVisible && Settings.bComputeVisibleChunksNavmesh && Height <= Settings.VisibleChunksNavmeshMaxLOD)
+			);
+
+		check(NewSettings.TransitionsMask == 0);
+		if (NewSettings.HasRenderChunk())
 		{
-			if (bRecomputeTransitionMasks)
+			if (NewSettings.bVisible && Settings.bEnableTransitions)
 			{
-				for (int32 DirectionIndex = 0; DirectionIndex < 6; DirectionIndex++)
+				if (bRecomputeTransitionMasks)
 				{
-					const auto Direction = EVoxelDirectionFlag::Type(1 << DirectionIndex);
-					const FVoxelRenderOctree* AdjacentChunk = GetVisibleAdjacentChunk(Direction, 0);
-					if (AdjacentChunk && AdjacentChunk->OctreeBounds.Intersect(Settings.WorldBounds))
+					for (int32 DirectionIndex = 0; DirectionIndex < 6; DirectionIndex++)
 					{
-						check(
-							(AdjacentChunk->Height == Height - 1) ||
-							(AdjacentChunk->Height == Height) ||
-							(AdjacentChunk->Height == Height + 1)
-						);
-						if (Settings.bInvertTransitions ? (AdjacentChunk->Height > Height) : (AdjacentChunk->Height < Height))
+						const auto Direction = EVoxelDirectionFlag::Type(1 << DirectionIndex);
+						int32 AdjacentHeight;
+						FIntVector AdjacentKey;
+						if (GetVisibleAdjacentChunk(Height, Key, Direction, 0, AdjacentHeight, AdjacentKey) &&
+							GetNodeBounds(AdjacentHeight, AdjacentKey).Intersect(Settings.WorldBounds))
 						{
-							NewSettings.TransitionsMask |= Direction;
+							check(
+								(AdjacentHeight == Height - 1) ||
+								(AdjacentHeight == Height) ||
+								(AdjacentHeight == Height + 1)
+							);
+							if (Settings.bInvertTransitions ? (AdjacentHeight > Height) : (AdjacentHeight < Height))
+							{
+								NewSettings.TransitionsMask |= Direction;
+							}
 						}
 					}
 				}
-			}
-			else
-			{
-				NewSettings.TransitionsMask = ChunkSettings.Settings.TransitionsMask;
+				else
+				{
+					NewSettings.TransitionsMask = ChunkSettings.Settings.TransitionsMask;
+				}
 			}
 		}
-	}
-	
-	if (ChunkSettings.Settings != NewSettings && (ChunkSettings.Settings.HasRenderChunk() || NewSettings.HasRenderChunk()))
-	{
-		// Too slow ensureVoxelSlowNoSideEffects(!ChunkUpdates.FindByPredicate([&](const FVoxelChunkUpdate& ChunkUpdate) { return ChunkUpdate.Id == ChunkId; }));
-		ChunkUpdates.Emplace(
-			FVoxelChunkUpdate
-			{
-				ChunkId,
-				Height,
-				OctreeBounds,
-				ChunkSettings.Settings,
-				NewSettings,
-				{}
-			});
-	}
-	
-	ChunkSettings.Settings = NewSettings;
+
+		if (ChunkSettings.Settings != NewSettings && (ChunkSettings.Settings.HasRenderChunk() || NewSettings.HasRenderChunk()))
+		{
+			ChunkUpdates.Emplace(
+				FVoxelChunkUpdate
+				{
+					Node.ChunkId,
+					Height,
+					Bounds,
+					ChunkSettings.Settings,
+					NewSettings,
+					{}
+				});
+		}
+
+		ChunkSettings.Settings = NewSettings;
+
+		return Node.bHasChildren;
+	});
 }
 
 void FVoxelRenderOctree::GetChunksToUpdateForBounds(const FVoxelIntBox& Bounds, TArray<uint64>& ChunksToUpdate, const FVoxelOnChunkUpdate& OnChunkUpdate) const
 {
-	if (!OctreeBounds.Intersect(Bounds))
+	IterateNodesOverlappingBounds(Bounds, [&](int32 Height, const FIntVector& Key, const FNode& Node)
 	{
-		return;
-	}
+		if (Node.ChunkSettings.Settings.HasRenderChunk())
+		{
+			OnChunkUpdate.Broadcast(GetNodeBounds(Height, Key));
+			ChunksToUpdate.Add(Node.ChunkId);
+		}
+	});
+}
 
-	if (ChunkSettings.Settings.HasRenderChunk())
+void FVoxelRenderOctree::GetVisibleChunksOverlappingBounds(const FVoxelIntBox& Bounds, TArray<uint64, TInlineAllocator<8>>& VisibleChunks) const
+{
+	IterateNodesOverlappingBounds(Bounds, [&](int32 Height, const FIntVector& Key, const FNode& Node)
 	{
-		OnChunkUpdate.Broadcast(OctreeBounds);
-		ChunksToUpdate.Add(ChunkId);
-	}
+		if (Node.ChunkSettings.Settings.bVisible)
+		{
+			VisibleChunks.Add(Node.ChunkId);
+		}
+	});
+}
+
+bool FVoxelRenderOctree::AreCollisionsEnabled(const FIntVector& Position, uint8& OutLOD) const
+{
+	// Positions outside of the octree use the nodes on its border
+	const FIntVector ClampedPosition(
+		FMath::Clamp(Position.X, OctreeBounds.Min.X, OctreeBounds.Max.X - 1),
+		FMath::Clamp(Position.Y, OctreeBounds.Min.Y, OctreeBounds.Max.Y - 1),
+		FMath::Clamp(Position.Z, OctreeBounds.Min.Z, OctreeBounds.Max.Z - 1));
+
+	OutLOD = 255;
 
-	if (!!HasChildren())
+	// The root is never checked
+	for (int32 Height = Depth - 1; Height >= 0; Height--)
 	{
-		for (auto& Child : GetChildren())
+		const FNode* Node = Levels[Height].Find(GetNodeKey(Height, ClampedPosition));
+		if (!Node)
 		{
-			Child.GetChunksToUpdateForBounds(Bounds, ChunksToUpdate, OnChunkUpdate);
+			break;
+		}
+		if (Node->ChunkSettings.Settings.bEnableCollisions)
+		{
+			OutLOD = Height;
 		}
 	}
+
+	return OutLOD != 255;
+}
+
+FORCEINLINE bool FVoxelRenderOctree::IsCanceled() const
+{
+	return CurrentChunksCount >= CVarMaxRenderOctreeChunks.GetValueOnAnyThread();
 }
 
+///////////////////////////////////////////////////////////////////////////////
 
-void FVoxelRenderOctree::GetVisibleChunksOverlappingBounds(const FVoxelIntBox& Bounds, TArray<uint64, TInlineAllocator<8>>& VisibleChunks) const
+void FVoxelRenderOctree::CreateChildren(int32 Height, const FIntVector& Key, FNode& Node)
 {
-	if (!OctreeBounds.Intersect(Bounds))
+	check(!Node.bHasChildren && Height > 0);
+	Node.bHasChildren = true;
+
+	// Node is in another level: the reference stays valid
+	auto& ChildrenLevel = Levels[Height - 1];
+	for (int32 ChildIndex = 0; ChildIndex < 8; ChildIndex++)
 	{
-		return;
+		checkVoxelSlow(!ChildrenLevel.Contains(GetChildKey(Key, ChildIndex)));
+		FNode& Child = ChildrenLevel.Add(GetChildKey(Key, ChildIndex));
+		Child.ChunkId = ++IdCounter;
 	}
+	CurrentChunksCount += 8;
+
+	INC_DWORD_STAT_BY(STAT_VoxelRenderOctreesCount, 8);
+}
+
+void FVoxelRenderOctree::DestroyChildren(int32 Height, const FIntVector& Key, FNode& Node, TArray<FVoxelChunkUpdate>& ChunkUpdates)
+{
+	check(Node.bHasChildren && Height > 0);
+	Node.bHasChildren = false;
 
-	if (ChunkSettings.Settings.bVisible)
+	auto& ChildrenLevel = Levels[Height - 1];
+	for (int32 ChildIndex = 0; ChildIndex < 8; ChildIndex++)
 	{
-		VisibleChunks.Add(ChunkId);
+		const FIntVector ChildKey = GetChildKey(Key, ChildIndex);
+
+		FNode Child;
+		verify(ChildrenLevel.RemoveAndCopyValue(ChildKey, Child));
+		ensure(Child.ChunkSettings.DivisionType == EDivisionType::Uninitialized);
+
+		if (Child.bHasChildren)
+		{
+			DestroyChildren(Height - 1, ChildKey, Child, ChunkUpdates);
+		}
+
+		if (Child.ChunkSettings.Settings.HasRenderChunk())
+		{
+			ChunkUpdates.Emplace(
+				FVoxelChunkUpdate
+				{
+					Child.ChunkId,
+					Height - 1,
+					GetNodeBounds(Height - 1, ChildKey),
+					Child.ChunkSettings.Settings,
+					{},
+					{}
+				});
+		}
 	}
+	CurrentChunksCount -= 8;
 
-	if (!!HasChildren())
+	DEC_DWORD_STAT_BY(STAT_VoxelRenderOctreesCount, 8);
+}
+
+void FVoxelRenderOctree::UpdateAllocatedSize()
+{
+	DEC_VOXEL_MEMORY_STAT_BY(STAT_VoxelRenderOctreesMemory, AllocatedSize);
+	AllocatedSize = Levels.GetAllocatedSize();
+	for (auto& Level : Levels)
 	{
-		for (auto& Child : GetChildren())
+		AllocatedSize += Level.GetAllocatedSize();
+	}
+	INC_VOXEL_MEMORY_STAT_BY(STAT_VoxelRenderOctreesMemory, AllocatedSize);
+}
+
+template<typename T>
+void FVoxelRenderOctree::TraverseTopDown(T Lambda)
+{
+	struct FNodeToVisit
+	{
+		FIntVector Key;
+		// Parents are in the level above, which isn't modified while visiting a level
+		const FNode* Parent;
+	};
+	TArray<FNodeToVisit> NodesToVisit;
+	TArray<FNodeToVisit> NextNodesToVisit;
+
+	NodesToVisit.Add({ FIntVector::ZeroValue, nullptr });
+
+	for (int32 Height = Depth; Height >= 0 && NodesToVisit.Num() > 0; Height--)
+	{
+		auto& Level = Levels[Height];
+
+		NextNodesToVisit.Reset();
+		for (const FNodeToVisit& NodeToVisit : NodesToVisit)
 		{
-			Child.GetVisibleChunksOverlappingBounds(Bounds, VisibleChunks);
+			if (IsCanceled())
+			{
+				return;
+			}
+
+			FNode& Node = Level.FindChecked(NodeToVisit.Key);
+			if (Lambda(Height, NodeToVisit.Key, Node, NodeToVisit.Parent))
+			{
+				check(Node.bHasChildren);
+				for (int32 ChildIndex = 0; ChildIndex < 8; ChildIndex++)
+				{
+					NextNodesToVisit.Add({ GetChildKey(NodeToVisit.Key, ChildIndex), &Node });
+				}
+			}
 		}
+		Swap(NodesToVisit, NextNodesToVisit);
 	}
 }
 
-FORCEINLINE bool FVoxelRenderOctree::IsCanceled() const
+template<typename T>
+void FVoxelRenderOctree::IterateNodesOverlappingBounds(const FVoxelIntBox& Bounds, T Lambda) const
 {
-	return Root->CurrentChunksCount >= CVarMaxRenderOctreeChunks.GetValueOnAnyThread();
+	if (!OctreeBounds.Intersect(Bounds))
+	{
+		return;
+	}
+
+	TArray<FIntVector, TInlineAllocator<64>> Stack;
+	TArray<int32, TInlineAllocator<64>> StackHeights;
+	Stack.Add(FIntVector::ZeroValue);
+	StackHeights.Add(Depth);
+
+	while (Stack.Num() > 0)
+	{
+		const FIntVector Key = Stack.Pop(false);
+		const int32 Height = StackHeights.Pop(false);
+
+		const FNode& Node = Levels[Height].FindChecked(Key);
+		Lambda(Height, Key, Node);
+
+		if (Node.bHasChildren)
+		{
+			// Reverse order to visit the children in order
+			for (int32 ChildIndex = 7; ChildIndex >= 0; ChildIndex--)
+			{
+				const FIntVector ChildKey = GetChildKey(Key, ChildIndex);
+				// Test the bounds before doing any lookup
+				if (GetNodeBounds(Height - 1, ChildKey).Intersect(Bounds))
+				{
+					Stack.Add(ChildKey);
+					StackHeights.Add(Height - 1);
+				}
+			}
+		}
+	}
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 
-bool FVoxelRenderOctree::ShouldSubdivideByDistance(const FVoxelRenderOctreeSettings& Settings) const
+bool FVoxelRenderOctree::ShouldSubdivideByDistance(int32 Height, const FIntVector& Key, FNode& Node, const FVoxelRenderOctreeSettings& Settings)
 {
 	if (!Settings.bEnableRender)
 	{
@@ -608,7 +860,7 @@ bool FVoxelRenderOctree::ShouldSubdivideByDistance(const FVoxelRenderOctreeSetti
 	{
 		return false;
 	}
-	if (!OctreeBounds.Intersect(Settings.WorldBounds))
+	if (!GetNodeBounds(Height, Key).Intersect(Settings.WorldBounds))
 	{
 		return false;
 	}
@@ -621,25 +873,16 @@ bool FVoxelRenderOctree::ShouldSubdivideByDistance(const FVoxelRenderOctreeSetti
 		return true;
 	}
 
-	for (auto& Invoker : Settings.Invokers)
-	{
-		if (Invoker.bUseForLOD && OctreeBounds.Intersect(Invoker.LODBounds) && Height > Invoker.LODToSet)
-		{
-			return true;
-		}
-	}
-
-	return false;
+	return GetInvokersCache(Height, Key, Node, Settings).bSubdivideByDistance;
 }
 
-
-bool FVoxelRenderOctree::ShouldSubdivideByNeighbors(const FVoxelRenderOctreeSettings& Settings) const
+bool FVoxelRenderOctree::ShouldSubdivideByNeighbors(int32 Height, const FIntVector& Key, const FVoxelRenderOctreeSettings& Settings) const
 {
 	if (Height == 0)
 	{
 		return false;
 	}
-	if (!OctreeBounds.Intersect(Settings.WorldBounds))
+	if (!GetNodeBounds(Height, Key).Intersect(Settings.WorldBounds))
 	{
 		return false;
 	}
@@ -648,17 +891,18 @@ bool FVoxelRenderOctree::ShouldSubdivideByNeighbors(const FVoxelRenderOctreeSett
 		const auto Direction = EVoxelDirectionFlag::Type(1 << DirectionIndex);
 		for (int32 Index = 0; Index < 4; Index++) // Iterate the 4 adjacent subdivided chunks
 		{
-			const FVoxelRenderOctree* AdjacentChunk = GetVisibleAdjacentChunk(Direction, Index);
-			if (!AdjacentChunk)
+			int32 AdjacentHeight;
+			FIntVector AdjacentKey;
+			if (!GetVisibleAdjacentChunk(Height, Key, Direction, Index, AdjacentHeight, AdjacentKey))
 			{
 				continue;
 			}
 
-			if (AdjacentChunk->Height + 1 < Height)
+			if (AdjacentHeight + 1 < Height)
 			{
 				return true;
 			}
-			if (AdjacentChunk->Height >= Height)
+			if (AdjacentHeight >= Height)
 			{
 				check(Index == 0);
 				break; // No need to continue, 4 indices are the same chunk
@@ -668,8 +912,7 @@ bool FVoxelRenderOctree::ShouldSubdivideByNeighbors(const FVoxelRenderOctreeSett
 	return false;
 }
 
-
-bool FVoxelRenderOctree::ShouldSubdivideByOthers(const FVoxelRenderOctreeSettings& Settings) const
+bool FVoxelRenderOctree::ShouldSubdivideByOthers(int32 Height, const FIntVector& Key, FNode& Node, const FVoxelRenderOctreeSettings& Settings)
 {
 	if (!Settings.bEnableCollisions && !Settings.bEnableNavmesh)
 	{
@@ -679,20 +922,16 @@ bool FVoxelRenderOctree::ShouldSubdivideByOthers(const FVoxelRenderOctreeSetting
 	{
 		return false;
 	}
-	if (!OctreeBounds.Intersect(Settings.WorldBounds))
+	if (!GetNodeBounds(Height, Key).Intersect(Settings.WorldBounds))
 	{
 		return false;
 	}
 
-	if (Settings.bEnableCollisions && IsInvokerInRange(Settings.Invokers,
-		[](const FVoxelInvokerSettings& Invoker) { return Invoker.bUseForCollisions; },
-		[](const FVoxelInvokerSettings& Invoker) { return Invoker.CollisionsBounds; }))
+	if (Settings.bEnableCollisions && GetInvokersCache(Height, Key, Node, Settings).bCollisionsInvokerInRange)
 	{
 		return true;
 	}
-	if (Settings.bEnableNavmesh && IsInvokerInRange(Settings.Invokers,
-		[](const FVoxelInvokerSettings& Invoker) { return Invoker.bUseForNavmesh; },
-		[](const FVoxelInvokerSettings& Invoker) { return Invoker.NavmeshBounds; }))
+	if (Settings.bEnableNavmesh && GetInvokersCache(Height, Key, Node, Settings).bNavmeshInvokerInRange)
 	{
 		return true;
 	}
@@ -700,17 +939,37 @@ bool FVoxelRenderOctree::ShouldSubdivideByOthers(const FVoxelRenderOctreeSetting
 	return false;
 }
 
-///////////////////////////////////////////////////////////////////////////////
-
-inline bool IsVisibleParent(const FVoxelRenderOctree* Chunk)
+const FVoxelRenderOctree::FInvokersCache& FVoxelRenderOctree::GetInvokersCache(int32 Height, const FIntVector& Key, FNode& Node, const FVoxelRenderOctreeSettings& Settings)
 {
-	return Chunk->ChunkSettings.DivisionType == FVoxelRenderOctree::EDivisionType::ByDistance || Chunk->ChunkSettings.DivisionType == FVoxelRenderOctree::EDivisionType::ByNeighbors;
+	FInvokersCache& Cache = Node.ChunkSettings.InvokersCache;
+	if (Cache.bValid)
+	{
+		return Cache;
+	}
+
+	const FVoxelIntBox Bounds = GetNodeBounds(Height, Key);
+
+	Cache.bValid = true;
+	Cache.bSubdivideByDistance = IsInvokerInRange(Settings, FVoxelInvokersGrid::EShape::LOD, Bounds,
+		[&](const FVoxelInvokerSettings& Invoker) { return Invoker.bUseForLOD && Height > Invoker.LODToSet; },
+		[](const FVoxelInvokerSettings& Invoker, const FVoxelIntBox& InBounds) { return Invoker.IsLODShapeIntersecting(InBounds); });
+	Cache.bCollisionsInvokerInRange = IsInvokerInRange(Settings, FVoxelInvokersGrid::EShape::Collisions, Bounds,
+		[](const FVoxelInvokerSettings& Invoker) { return Invoker.bUseForCollisions; },
+		[](const FVoxelInvokerSettings& Invoker, const FVoxelIntBox& InBounds) { return Invoker.IsCollisionsShapeIntersecting(InBounds); });
+	Cache.bNavmeshInvokerInRange = IsInvokerInRange(Settings, FVoxelInvokersGrid::EShape::Navmesh, Bounds,
+		[](const FVoxelInvokerSettings& Invoker) { return Invoker.bUseForNavmesh; },
+		[](const FVoxelInvokerSettings& Invoker, const FVoxelIntBox& InBounds) { return Invoker.IsNavmeshShapeIntersecting(InBounds); });
+	return Cache;
 }
 
-const FVoxelRenderOctree* FVoxelRenderOctree::GetVisibleAdjacentChunk(EVoxelDirectionFlag::Type Direction, int32 Index) const
+///////////////////////////////////////////////////////////////////////////////
+
+bool FVoxelRenderOctree::GetVisibleAdjacentChunk(int32 Height, const FIntVector& Key, EVoxelDirectionFlag::Type Direction, int32 Index, int32& OutHeight, FIntVector& OutKey) const
 {
-	const int32 HalfSize = Size() / 2;
-	const int32 HalfHalfSize = Size() / 4;
+	const int32 Size = GetNodeSize(Height);
+	const int32 HalfSize = Size / 2;
+	const int32 HalfHalfSize = Size / 4;
+	const FIntVector Position = OctreeBounds.Min + Key * Size + HalfSize;
 
 	int32 S = HalfSize + HalfHalfSize; // Size / 2: on the border; Size / 4: center of child chunk
 	int32 X, Y;
@@ -757,33 +1016,53 @@ const FVoxelRenderOctree* FVoxelRenderOctree::GetVisibleAdjacentChunk(EVoxelDire
 		P = FIntVector::ZeroValue;
 	}
 
-	if (Root->OctreeBounds.Contains(P))
+	if (!OctreeBounds.Contains(P))
 	{
-		const FVoxelRenderOctree* Ptr = Root;
-
-		while (IsVisibleParent(Ptr))
-		{
-			Ptr = &Ptr->GetChild(P);
-		}
-
-		check(Ptr->OctreeBounds.Contains(P));
+		return false;
+	}
 
-		return Ptr;
+	// Start from the lowest common ancestor of the node and P instead of the root:
+	// when the node is visible, all its ancestors are visible parents
+	int32 CurrentHeight = Height + 1;
+	while (GetNodeKey(CurrentHeight, P) != FIntVector(Key.X >> (CurrentHeight - Height), Key.Y >> (CurrentHeight - Height), Key.Z >> (CurrentHeight - Height)))
+	{
+		CurrentHeight++;
+		checkVoxelSlow(CurrentHeight <= Depth);
 	}
-	else
+	if (!IsVisibleParent(Levels[CurrentHeight].FindChecked(GetNodeKey(CurrentHeight, P))))
 	{
-		return nullptr;
+		// Shouldn't happen, but stay correct by starting from the root
+		CurrentHeight = Depth;
 	}
+
+	FIntVector CurrentKey = GetNodeKey(CurrentHeight, P);
+	while (IsVisibleParent(Levels[CurrentHeight].FindChecked(CurrentKey)))
+	{
+		CurrentHeight--;
+		CurrentKey = GetNodeKey(CurrentHeight, P);
+	}
+
+	OutHeight = CurrentHeight;
+	OutKey = CurrentKey;
+	return true;
 }
 
 template<typename T1, typename T2>
-bool FVoxelRenderOctree::IsInvokerInRange(const TArray<FVoxelInvokerSettings>& Invokers, T1 SelectInvoker, T2 GetInvokerBounds) const
+bool FVoxelRenderOctree::IsInvokerInRange(const FVoxelRenderOctreeSettings& Settings, FVoxelInvokersGrid::EShape Shape, const FVoxelIntBox& Bounds, T1 SelectInvoker, T2 IsInvokerShapeIntersecting)
 {
-	for (auto& Invoker : Invokers)
+	if (Settings.InvokersGrid.IsValid())
+	{
+		return Settings.InvokersGrid->AnyInvoker(Shape, Bounds, [&](const FVoxelInvokerSettings& Invoker)
+		{
+			return SelectInvoker(Invoker) && IsInvokerShapeIntersecting(Invoker, Bounds);
+		});
+	}
+
+	for (auto& Invoker : Settings.Invokers)
 	{
 		if (SelectInvoker(Invoker))
 		{
-			if (OctreeBounds.Intersect(GetInvokerBounds(Invoker)))
+			if (IsInvokerShapeIntersecting(Invoker, Bounds))
 			{
 				return true;
 			}
@@ -791,10 +1070,3 @@ bool FVoxelRenderOctree::IsInvokerInRange(const TArray<FVoxelInvokerSettings>& I
 	}
 	return false;
 }
-
-///////////////////////////////////////////////////////////////////////////////
-
-uint64 FVoxelRenderOctree::GetId()
-{
-	return ++Root->RootIdCounter;
-}
\ No newline at end of file
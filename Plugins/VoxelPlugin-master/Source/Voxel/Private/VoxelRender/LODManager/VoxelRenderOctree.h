@@ -6,9 +6,10 @@
 #include "VoxelIntBox.h"
 #include "VoxelMinimal.h"
 #include "VoxelDirection.h"
-#include "VoxelSimpleOctree.h"
+#include "VoxelUtilities/VoxelBaseUtilities.h"
 #include "VoxelAsyncWork.h"
 #include "VoxelInvokerSettings.h"
+#include "VoxelInvokersGrid.h"
 #include "VoxelRender/VoxelChunkToUpdate.h"
 
 #include "HAL/ThreadSafeBool.h"
@@ -27,6 +28,8 @@ struct FVoxelRenderOctreeSettings
 	FVoxelIntBox WorldBounds;
 
 	TArray<FVoxelInvokerSettings> Invokers;
+	// Built from Invokers by the async builder if there are enough of them
+	TVoxelSharedPtr<const FVoxelInvokersGrid> InvokersGrid;
 
 	int32 ChunksCullingLOD;
 
@@ -66,6 +69,13 @@ public:
 	void Init(const FVoxelRenderOctreeSettings& OctreeSettings, TVoxelSharedPtr<FVoxelRenderOctree> Octree);
 	void ReportBuildTime();
 
+	// Bounds that can change the invoker classification of a node between InvokersA and InvokersB
+	static void GetInvokersDirtyBounds(
+		const TArray<FVoxelInvokerSettings>& InvokersA,
+		const TArray<FVoxelInvokerSettings>& InvokersB,
+		TArray<FVoxelIntBox>& OutDirtyBounds,
+		int32& OutNumChangedInvokers);
+
 private:
 	//~ Begin FVoxelAsyncWork Interface
 	virtual void DoWork() override;
@@ -78,23 +88,30 @@ private:
 
 	FVoxelRenderOctreeSettings OctreeSettings{};
 
+	// Last octree built by this builder, and the invokers it was built with
+	// If the next build starts from it, only the nodes overlapping the invokers that changed need to be re-evaluated
+	TVoxelWeakPtr<FVoxelRenderOctree> LastBuiltOctree;
+	TArray<FVoxelInvokerSettings> LastBuiltOctreeInvokers;
+
+	bool bIncremental = false;
+	TArray<FVoxelIntBox> InvokersDirtyBounds;
+	int32 NumChangedInvokers = 0;
+
 	bool bTooManyChunks = false;
 	double Counter = 0;
+	double WorkTime = 0;
 	FString Log;
 	int32 NumberOfChunks = 0;
 };
 
-class FVoxelRenderOctree : public TSimpleVoxelOctree<RENDER_CHUNK_SIZE, FVoxelRenderOctree>
+/**
+ * Linear render octree: the nodes are stored by height in hash maps keyed by their coordinates, in units of their size, relative to OctreeBounds.Min
+ * There are no pointers between nodes: children, parents & neighbors are found by key arithmetic, and cloning the octree is a copy of the maps
+ * A node exists if its parent has children, so a node with children always has all 8 of them
+ */
+class FVoxelRenderOctree
 {
-private:
-	// Important: must be the first variable to be initialized, else GetId does the wrong thing for the root!
-	uint64 RootIdCounter = 0;
-	
 public:
-	FVoxelRenderOctree* const Root;
-	const uint64 ChunkId;
-	const FVoxelIntBox OctreeBounds;
-
 	enum class EDivisionType : uint8
 	{
 		Uninitialized = 0,
@@ -103,27 +120,38 @@ public:
 		ByOthers      = 3
 	};
 
+	// Result of the invoker loops of a node. Only depends on the node bounds and on the invokers,
+	// so it's kept across builds and only invalidated on nodes overlapping invokers that changed
+	struct FInvokersCache
+	{
+		bool bValid = false;
+		bool bSubdivideByDistance = false;
+		bool bCollisionsInvokerInRange = false;
+		bool bNavmeshInvokerInRange = false;
+	};
+
 	struct FChunkSettings
 	{
 		FVoxelChunkSettings Settings{};
 		EDivisionType DivisionType = EDivisionType::Uninitialized;
 		EDivisionType OldDivisionType = EDivisionType::Uninitialized;
-	}; 
-	FChunkSettings ChunkSettings;
-	int32 CurrentChunksCount = 0;
-	uint64 UpdateIndex = 0;
-
-	inline const FVoxelChunkSettings& GetSettings() const { return ChunkSettings.Settings; }
+		FInvokersCache InvokersCache;
+	};
 
-	FVoxelRenderOctree(uint8 LOD);
-	FVoxelRenderOctree(const FVoxelRenderOctree* Source);
+	// Height of the root
+	const uint8 Depth;
+	const FVoxelIntBox OctreeBounds;
 
-	FVoxelRenderOctree(const FVoxelRenderOctree& Parent, uint8 ChildIndex);
-	FVoxelRenderOctree(const FVoxelRenderOctree& Parent, uint8 ChildIndex, const ChildrenArray& SourceChildren);
+	int32 CurrentChunksCount = 0;
+	uint64 UpdateIndex = 0;
 
+	explicit FVoxelRenderOctree(uint8 Depth);
+	FVoxelRenderOctree(const FVoxelRenderOctree& Source);
 	~FVoxelRenderOctree();
 
-	void ResetDivisionType();
+	// If bIncremental is false, the invokers cache of all the nodes is invalidated
+	// Else only the one of the nodes overlapping InvokersDirtyBounds is. Returns the number of invalidated nodes
+	int32 ResetDivisionType(bool bIncremental, TArrayView<const FVoxelIntBox> InvokersDirtyBounds);
 	bool UpdateSubdividedByDistance(const FVoxelRenderOctreeSettings& Settings);
 	bool UpdateSubdividedByNeighbors(const FVoxelRenderOctreeSettings& Settings);
 	void ReuseOldNeighbors();
@@ -131,26 +159,84 @@ public:
 	void DeleteChunks(TArray<FVoxelChunkUpdate>& ChunkUpdates);
 
 	void GetUpdates(
-		uint32 InUpdateIndex,
+		uint64 InUpdateIndex,
 		bool bRecomputeTransitionMasks,
 		const FVoxelRenderOctreeSettings& Settings, 
-		TArray<FVoxelChunkUpdate>& ChunkUpdates, 
-		bool bVisible = true);
+		TArray<FVoxelChunkUpdate>& ChunkUpdates);
 
 	void GetChunksToUpdateForBounds(const FVoxelIntBox& Bounds, TArray<uint64>& ChunksToUpdate, const FVoxelOnChunkUpdate& OnChunkUpdate) const;
 	void GetVisibleChunksOverlappingBounds(const FVoxelIntBox& Bounds, TArray<uint64, TInlineAllocator<8>>& VisibleChunks) const;
+	// OutLOD is the lowest LOD with collisions containing Position
+	bool AreCollisionsEnabled(const FIntVector& Position, uint8& OutLOD) const;
 
 	bool IsCanceled() const;
 
 private:
-	bool ShouldSubdivideByDistance(const FVoxelRenderOctreeSettings& Settings) const;
-	bool ShouldSubdivideByNeighbors(const FVoxelRenderOctreeSettings& Settings) const;
-	bool ShouldSubdivideByOthers(const FVoxelRenderOctreeSettings& Settings) const;
-	
-	const FVoxelRenderOctree* GetVisibleAdjacentChunk(EVoxelDirectionFlag::Type Direction, int32 Index) const;
+	struct FNode
+	{
+		uint64 ChunkId = 0;
+		FChunkSettings ChunkSettings;
+		bool bHasChildren = false;
+	};
+	// Levels[Height]
+	TArray<TMap<FIntVector, FNode>> Levels;
+	uint64 IdCounter = 0;
+	int64 AllocatedSize = 0;
 
-	template<typename T1, typename T2>
-	bool IsInvokerInRange(const TArray<FVoxelInvokerSettings>& Invokers, T1 SelectInvoker, T2 GetInvokerBounds) const;
+	static constexpr int32 ChunkSizeLog2 = FVoxelUtilities::IntLog2(RENDER_CHUNK_SIZE);
+
+	FORCEINLINE static int32 GetNodeSize(int32 Height)
+	{
+		return RENDER_CHUNK_SIZE << Height;
+	}
+	FORCEINLINE FVoxelIntBox GetNodeBounds(int32 Height, const FIntVector& Key) const
+	{
+		const int32 Size = GetNodeSize(Height);
+		const FIntVector Min = OctreeBounds.Min + Key * Size;
+		return FVoxelIntBox(Min, Min + Size);
+	}
+	// Key of the node of this height containing Position. Position must be inside OctreeBounds
+	FORCEINLINE FIntVector GetNodeKey(int32 Height, const FIntVector& Position) const
+	{
+		checkVoxelSlow(OctreeBounds.Contains(Position));
+		const FIntVector Offset = Position - OctreeBounds.Min;
+		const int32 Shift = Height + ChunkSizeLog2;
+		return FIntVector(Offset.X >> Shift, Offset.Y >> Shift, Offset.Z >> Shift);
+	}
+	FORCEINLINE static FIntVector GetChildKey(const FIntVector& Key, int32 ChildIndex)
+	{
+		return FIntVector(
+			2 * Key.X + ((ChildIndex & 0x1) ? 1 : 0),
+			2 * Key.Y + ((ChildIndex & 0x2) ? 1 : 0),
+			2 * Key.Z + ((ChildIndex & 0x4) ? 1 : 0));
+	}
+	FORCEINLINE static bool IsVisibleParent(const FNode& Node)
+	{
+		return Node.ChunkSettings.DivisionType == EDivisionType::ByDistance || Node.ChunkSettings.DivisionType == EDivisionType::ByNeighbors;
+	}
+
+	void CreateChildren(int32 Height, const FIntVector& Key, FNode& Node);
+	// Recursively removes the children of the node, adding a removal update for the ones with a render chunk
+	void DestroyChildren(int32 Height, const FIntVector& Key, FNode& Node, TArray<FVoxelChunkUpdate>& ChunkUpdates);
+	void UpdateAllocatedSize();
 
-	uint64 GetId();
-};
\ No newline at end of file
+	// Visits the nodes level by level, starting from the root. Lambda(Height, Key, Node, Parent) returns whether to visit the children of Node
+	// Parent is null for the root
+	template<typename T>
+	void TraverseTopDown(T Lambda);
+	// Visits the nodes overlapping Bounds, parents first
+	template<typename T>
+	void IterateNodesOverlappingBounds(const FVoxelIntBox& Bounds, T Lambda) const;
+
+	bool ShouldSubdivideByDistance(int32 Height, const FIntVector& Key, FNode& Node, const FVoxelRenderOctreeSettings& Settings);
+	bool ShouldSubdivideByNeighbors(int32 Height, const FIntVector& Key, const FVoxelRenderOctreeSettings& Settings) const;
+	bool ShouldSubdivideByOthers(int32 Height, const FIntVector& Key, FNode& Node, const FVoxelRenderOctreeSettings& Settings);
+
+	const FInvokersCache& GetInvokersCache(int32 Height, const FIntVector& Key, FNode& Node, const FVoxelRenderOctreeSettings& Settings);
+
+	// Finds the visible chunk adjacent to the node in Direction. Index selects one of the 4 child-sized cells of the face
+	bool GetVisibleAdjacentChunk(int32 Height, const FIntVector& Key, EVoxelDirectionFlag::Type Direction, int32 Index, int32& OutHeight, FIntVector& OutKey) const;
+
+	template<typename T1, typename T2>
+	static bool IsInvokerInRange(const FVoxelRenderOctreeSettings& Settings, FVoxelInvokersGrid::EShape Shape, const FVoxelIntBox& Bounds, T1 SelectInvoker, T2 IsInvokerShapeIntersecting);
+};
@@ -2,8 +2,20 @@
 
 #include "VoxelRender/Meshers/VoxelCubicMesher.h"
 #include "VoxelRender/Meshers/VoxelMesherUtilities.h"
+#include "VoxelRender/Meshers/VoxelMesherScratch.h"
 #include "VoxelRender/IVoxelRenderer.h"
 #include "VoxelData/VoxelDataIncludes.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<int32> CVarCubicGreedyMeshing(
+	TEXT("voxel.mesher.CubicGreedyMeshing"),
+	0,
+	TEXT("If true, the cubic mesher merges adjacent coplanar faces with the same material into bigger quads. ")
+	TEXT("Not used for render meshes with PackWorldUpInUVs, as these UVs are per voxel. With PerVoxelUVs, the UVs of merged quads span several voxels: textures need to tile"),
+	ECVF_Default);
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Voxel Cubic Greedy Merged Faces"), STAT_VoxelCubicGreedyMergedFaces, STATGROUP_VoxelCounters);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Voxel Cubic Greedy Quads"), STAT_VoxelCubicGreedyQuads, STATGROUP_VoxelCounters);
 
 struct FVoxelCubicFullVertex : FVoxelMesherVertex
 {
@@ -69,7 +81,9 @@ template<EVoxelDirectionFlag::Type Direction, typename TVertex, typename TMesher
 FORCEINLINE void AddFace(
 	TMesher& Mesher, int32 Step, FVoxelMaterial Material, 
 	int32 X, int32 Y, int32 Z, 
-	TArray<uint32>& Indices, TArray<TVertex>& Vertices)
+	TArray<uint32>& Indices, TArray<TVertex>& Vertices,
+	// Size of the quad in voxels, when merging faces. The component along the face normal must be 1
+	const FIntVector& Size = FIntVector(1, 1, 1))
 {
 	if (TVertex::bComputeMaterial && Mesher.Settings.bOneMaterialPerCubeSide)
 	{
@@ -163,7 +177,7 @@ FORCEINLINE void AddFace(
 	for (int32 Index = 0; Index < 4; Index++)
 	{
 		const FVector VertexPositionInCube = Positions[Index];
-		const FVector VertexPosition = (VertexPositionInCube + FVector(X, Y, Z)) * Step;
+		const FVector VertexPosition = (VertexPositionInCube * FVector(Size) + FVector(X, Y, Z)) * Step;
 		
 		TVertex Vertex;
 		Vertex.SetPosition(VertexPosition);
@@ -209,30 +223,38 @@ FORCEINLINE void AddFace(
 			else
 			{
 				check(Mesher.Settings.UVConfig == EVoxelUVConfig::PerVoxelUVs);
-				const auto& V = VertexPositionInCube;
+				// Merged quads repeat the 0-1 range once per voxel
+				const FVector V = VertexPositionInCube * FVector(Size);
+				float SizeV;
 				switch (Direction)
 				{
 				case EVoxelDirectionFlag::XMin:
 					TextureCoordinate = { V.Y, V.Z };
+					SizeV = Size.Z;
 					break;
 				case EVoxelDirectionFlag::XMax:
-					TextureCoordinate = { 1 - V.Y, V.Z };
+					TextureCoordinate = { Size.Y - V.Y, V.Z };
+					SizeV = Size.Z;
 					break;
 				case EVoxelDirectionFlag::YMin:
-					TextureCoordinate = { 1 - V.X, V.Z };
+					TextureCoordinate = { Size.X - V.X, V.Z };
+					SizeV = Size.Z;
 					break;
 				case EVoxelDirectionFlag::YMax:
 					TextureCoordinate = { V.X, V.Z };
+					SizeV = Size.Z;
 					break;
 				case EVoxelDirectionFlag::ZMin:
 					TextureCoordinate = { V.X, V.Y };
+					SizeV = Size.Y;
 					break;
 				default:
 					check(Direction == EVoxelDirectionFlag::ZMax);
-					TextureCoordinate = { V.X, 1 - V.Y };
+					TextureCoordinate = { V.X, Size.Y - V.Y };
+					SizeV = Size.Y;
 					break;
 				}
-				TextureCoordinate.Y = 1 - TextureCoordinate.Y; // Y is down
+				TextureCoordinate.Y = SizeV - TextureCoordinate.Y; // Y is down
 			}
 			Vertex.SetTextureCoordinate(TextureCoordinate);
 		}
@@ -254,6 +276,72 @@ FORCEINLINE void AddFace(
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
+// PackWorldUpInUVs stores a value per voxel in the UVs, which can't be merged
+inline bool CanUseGreedyMeshing(const FVoxelRendererSettings& Settings, bool bComputeTextureCoordinate)
+{
+	return
+		CVarCubicGreedyMeshing.GetValueOnAnyThread() != 0 &&
+		(!bComputeTextureCoordinate || Settings.UVConfig != EVoxelUVConfig::PackWorldUpInUVs);
+}
+
+// Merges the faces of a Size * Size grid into rectangles of faces with the same material, in a single pass
+// HasFace is cleared as faces are merged. AddQuad(X, Y, SizeX, SizeY, Material) is called for each rectangle
+template<bool bCompareMaterials, typename TLambda>
+void GreedyMerge2D(int32 Size, uint8* RESTRICT HasFace, const FVoxelMaterial* RESTRICT Materials, TLambda AddQuad)
+{
+	const auto CanMerge = [&](int32 Index, const FVoxelMaterial& Material)
+	{
+		// Compare the raw materials: with bOneMaterialPerCubeSide, same materials on the same side have the same final index
+		return HasFace[Index] && (!bCompareMaterials || FMemory::Memcmp(&Materials[Index], &Material, sizeof(FVoxelMaterial)) == 0);
+	};
+
+	for (int32 Y = 0; Y < Size; Y++)
+	{
+		for (int32 X = 0; X < Size; X++)
+		{
+			const int32 Index = X + Y * Size;
+			if (!HasFace[Index]) continue;
+
+			FVoxelMaterial Material;
+			if (bCompareMaterials)
+			{
+				Material = Materials[Index];
+			}
+
+			int32 SizeX = 1;
+			while (X + SizeX < Size && CanMerge(Index + SizeX, Material))
+			{
+				SizeX++;
+			}
+
+			int32 SizeY = 1;
+			for (; Y + SizeY < Size; SizeY++)
+			{
+				bool bCanMergeRow = true;
+				for (int32 DX = 0; DX < SizeX && bCanMergeRow; DX++)
+				{
+					bCanMergeRow = CanMerge(X + DX + (Y + SizeY) * Size, Material);
+				}
+				if (!bCanMergeRow) break;
+			}
+
+			for (int32 DY = 0; DY < SizeY; DY++)
+			{
+				FMemory::Memzero(&HasFace[X + (Y + DY) * Size], SizeX * sizeof(uint8));
+			}
+
+			INC_DWORD_STAT_BY(STAT_VoxelCubicGreedyMergedFaces, SizeX * SizeY);
+			INC_DWORD_STAT(STAT_VoxelCubicGreedyQuads);
+
+			AddQuad(X, Y, SizeX, SizeY, Material);
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
 FVoxelIntBox FVoxelCubicMesher::GetBoundsToCheckIsEmptyOn() const
 {
 	return FVoxelIntBox(ChunkPosition - FIntVector(Step), ChunkPosition - FIntVector(Step) + CUBIC_CHUNK_SIZE_WITH_NEIGHBORS * Step);
@@ -277,7 +365,7 @@ TVoxelSharedPtr<FVoxelChunkMesh> FVoxelCubicMesher::CreateFullChunkImpl(FVoxelMe
 		Settings,
 		LOD,
 		MoveTemp(Indices),
-		MoveTemp(reinterpret_cast<TArray<FVoxelMesherVertex>&>(Vertices))));
+		reinterpret_cast<TArray<FVoxelMesherVertex>&>(Vertices)));
 }
 
 
@@ -299,8 +387,16 @@ void FVoxelCubicMesher::CreateGeometryTemplate(FVoxelMesherTimes& Times, TArray<
 		Accelerator = MakeUnique<FVoxelConstDataAccelerator>(Data, GetBoundsToLock());
 	}
 
-	TVoxelQueryZone<FVoxelValue> QueryZone(GetBoundsToCheckIsEmptyOn(), FIntVector(CUBIC_CHUNK_SIZE_WITH_NEIGHBORS), LOD, CachedValues);
-	MESHER_TIME_VALUES(CUBIC_CHUNK_SIZE_WITH_NEIGHBORS * CUBIC_CHUNK_SIZE_WITH_NEIGHBORS * CUBIC_CHUNK_SIZE_WITH_NEIGHBORS, Data.Get<FVoxelValue>(QueryZone, LOD));
+	QueryValues(Times, GetBoundsToCheckIsEmptyOn(), CachedValues.GetData());
+
+	// When merging faces, the faces of all the voxels are gathered first and merged slice by slice
+	const bool bGreedy = CanUseGreedyMeshing(Settings, T::bComputeTextureCoordinate);
+	TVoxelMesherScratchArray<uint8> Flags(bGreedy ? RENDER_CHUNK_SIZE * RENDER_CHUNK_SIZE * RENDER_CHUNK_SIZE : 0);
+	TVoxelMesherScratchArray<FVoxelMaterial> Materials(bGreedy && T::bComputeMaterial ? RENDER_CHUNK_SIZE * RENDER_CHUNK_SIZE * RENDER_CHUNK_SIZE : 0);
+	if (bGreedy)
+	{
+		FMemory::Memzero(Flags->GetData(), Flags->Num() * sizeof(uint8));
+	}
 	
 	{
 		VOXEL_ASYNC_SCOPE_COUNTER("Iteration");
@@ -333,6 +429,17 @@ void FVoxelCubicMesher::CreateGeometryTemplate(FVoxelMesherTimes& Times, TArray<
 							LOD));
 					}
 
+					if (bGreedy)
+					{
+						const int32 Index = X + Y * RENDER_CHUNK_SIZE + Z * RENDER_CHUNK_SIZE * RENDER_CHUNK_SIZE;
+						Flags.Get()[Index] = Flag;
+						if (T::bComputeMaterial)
+						{
+							Materials.Get()[Index] = Material;
+						}
+						continue;
+					}
+
 #define CHECK_SIDE(Direction) if (Flag & Direction) AddFace<Direction>(*this, Step, Material, X, Y, Z, Indices, Vertices)
 					CHECK_SIDE(EVoxelDirectionFlag::XMin);
 					CHECK_SIDE(EVoxelDirectionFlag::XMax);
@@ -345,6 +452,72 @@ void FVoxelCubicMesher::CreateGeometryTemplate(FVoxelMesherTimes& Times, TArray<
 			}
 		}
 	}
+
+	if (bGreedy)
+	{
+		VOXEL_ASYNC_SCOPE_COUNTER("Greedy Merge");
+		const uint8* FlagsPtr = Flags->GetData();
+		const FVoxelMaterial* MaterialsPtr = T::bComputeMaterial ? Materials->GetData() : nullptr;
+		AddGreedyFaces<EVoxelDirectionFlag::XMin>(FlagsPtr, MaterialsPtr, Indices, Vertices);
+		AddGreedyFaces<EVoxelDirectionFlag::XMax>(FlagsPtr, MaterialsPtr, Indices, Vertices);
+		AddGreedyFaces<EVoxelDirectionFlag::YMin>(FlagsPtr, MaterialsPtr, Indices, Vertices);
+		AddGreedyFaces<EVoxelDirectionFlag::YMax>(FlagsPtr, MaterialsPtr, Indices, Vertices);
+		AddGreedyFaces<EVoxelDirectionFlag::ZMin>(FlagsPtr, MaterialsPtr, Indices, Vertices);
+		AddGreedyFaces<EVoxelDirectionFlag::ZMax>(FlagsPtr, MaterialsPtr, Indices, Vertices);
+	}
+}
+
+template<EVoxelDirectionFlag::Type Direction, typename T>
+void FVoxelCubicMesher::AddGreedyFaces(const uint8* RESTRICT Flags, const FVoxelMaterial* RESTRICT Materials, TArray<uint32>& Indices, TArray<T>& Vertices)
+{
+	constexpr int32 Size = RENDER_CHUNK_SIZE;
+	constexpr int32 NormalAxis =
+		Direction == EVoxelDirectionFlag::XMin || Direction == EVoxelDirectionFlag::XMax
+		? 0
+		: Direction == EVoxelDirectionFlag::YMin || Direction == EVoxelDirectionFlag::YMax
+		? 1
+		: 2;
+	constexpr int32 AxisU = (NormalAxis + 1) % 3;
+	constexpr int32 AxisV = (NormalAxis + 2) % 3;
+
+	TVoxelMesherScratchArray<uint8> SliceHasFace(Size * Size);
+	TVoxelMesherScratchArray<FVoxelMaterial> SliceMaterials(T::bComputeMaterial ? Size * Size : 0);
+
+	for (int32 N = 0; N < Size; N++)
+	{
+		for (int32 V = 0; V < Size; V++)
+		{
+			for (int32 U = 0; U < Size; U++)
+			{
+				FIntVector Position;
+				Position[NormalAxis] = N;
+				Position[AxisU] = U;
+				Position[AxisV] = V;
+
+				const int32 Index = Position.X + Position.Y * Size + Position.Z * Size * Size;
+				const bool bHasFace = (Flags[Index] & Direction) != 0;
+				SliceHasFace.Get()[U + V * Size] = bHasFace;
+				if (T::bComputeMaterial && bHasFace)
+				{
+					SliceMaterials.Get()[U + V * Size] = Materials[Index];
+				}
+			}
+		}
+
+		GreedyMerge2D<T::bComputeMaterial>(Size, SliceHasFace->GetData(), SliceMaterials->GetData(), [&](int32 U, int32 V, int32 SizeU, int32 SizeV, const FVoxelMaterial& Material)
+		{
+			FIntVector Position;
+			Position[NormalAxis] = N;
+			Position[AxisU] = U;
+			Position[AxisV] = V;
+
+			FIntVector QuadSize(1, 1, 1);
+			QuadSize[AxisU] = SizeU;
+			QuadSize[AxisV] = SizeV;
+
+			AddFace<Direction>(*this, Step, Material, Position.X, Position.Y, Position.Z, Indices, Vertices, QuadSize);
+		});
+	}
 }
 
 FORCEINLINE FVoxelValue FVoxelCubicMesher::GetValue(int32 X, int32 Y, int32 Z) const
@@ -397,7 +570,7 @@ TVoxelSharedPtr<FVoxelChunkMesh> FVoxelCubicTransitionsMesher::CreateFullChunkIm
 		Settings,
 		LOD,
 		MoveTemp(Indices),
-		MoveTemp(reinterpret_cast<TArray<FVoxelMesherVertex>&>(Vertices))));
+		reinterpret_cast<TArray<FVoxelMesherVertex>&>(Vertices)));
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -430,6 +603,52 @@ void FVoxelCubicTransitionsMesher::CreateTransitionsForDirection(FVoxelMesherTim
 {
 	if (!(TransitionsMask & Direction)) return;
 
+	// The big faces are on a RENDER_CHUNK_SIZE grid, the small ones on a 2 * RENDER_CHUNK_SIZE one
+	// When merging faces, they are gathered first and merged once the whole side is done
+	const bool bGreedy = CanUseGreedyMeshing(Settings, TVertex::bComputeTextureCoordinate);
+	const int32 BigGridSize = RENDER_CHUNK_SIZE;
+	const int32 SmallGridSize = 2 * RENDER_CHUNK_SIZE;
+	TVoxelMesherScratchArray<uint8> BigHasFace(bGreedy ? BigGridSize * BigGridSize : 0);
+	TVoxelMesherScratchArray<uint8> SmallHasFace(bGreedy ? SmallGridSize * SmallGridSize : 0);
+	TVoxelMesherScratchArray<FVoxelMaterial> BigMaterials(bGreedy ? BigGridSize * BigGridSize : 0);
+	TVoxelMesherScratchArray<FVoxelMaterial> SmallMaterials(bGreedy ? SmallGridSize * SmallGridSize : 0);
+	if (bGreedy)
+	{
+		FMemory::Memzero(BigHasFace->GetData(), BigHasFace->Num() * sizeof(uint8));
+		FMemory::Memzero(SmallHasFace->GetData(), SmallHasFace->Num() * sizeof(uint8));
+	}
+
+	// The new faces are facing outwards, same direction as the transitions
+	constexpr EVoxelDirectionFlag::Type BigFaceDirection = Direction;
+	// The face direction is from the high res to the low res: the opposite of the transition direction,
+	// which is low res to high res (ie us to other)
+	constexpr EVoxelDirectionFlag::Type SmallFaceDirection = InverseVoxelDirection<Direction>();
+
+	const auto AddBigFace = [&](const FVoxelMaterial& Material, int32 FaceX, int32 FaceY)
+	{
+		if (bGreedy)
+		{
+			BigHasFace.Get()[FaceX + FaceY * BigGridSize] = true;
+			BigMaterials.Get()[FaceX + FaceY * BigGridSize] = Material;
+		}
+		else
+		{
+			Add2DFace<Direction, BigFaceDirection>(Step, Material, FaceX, FaceY, Vertices, Indices);
+		}
+	};
+	const auto AddSmallFace = [&](const FVoxelMaterial& Material, int32 FaceX, int32 FaceY)
+	{
+		if (bGreedy)
+		{
+			SmallHasFace.Get()[FaceX + FaceY * SmallGridSize] = true;
+			SmallMaterials.Get()[FaceX + FaceY * SmallGridSize] = Material;
+		}
+		else
+		{
+			Add2DFace<Direction, SmallFaceDirection>(HalfStep, Material, FaceX, FaceY, Vertices, Indices);
+		}
+	};
+
 	for (int32 LX = 0; LX < RENDER_CHUNK_SIZE; LX++)
 	{
 		for (int32 LY = 0; LY < RENDER_CHUNK_SIZE; LY++)
@@ -473,12 +692,9 @@ void FVoxelCubicTransitionsMesher::CreateTransitionsForDirection(FVoxelMesherTim
 				}
 
 				// Need to do some stitching
-
-				// The new faces are facing outwards, same direction as the transitions
-				constexpr EVoxelDirectionFlag::Type FaceDirection = Direction;
 				
 				const auto Material = MESHER_TIME_RETURN_MATERIALS(1, GetMaterial<Direction>(Step, LX * Step, LY * Step, 0));
-				Add2DFace<Direction, FaceDirection>(Step, Material, LX, LY, Vertices, Indices);
+				AddBigFace(Material, LX, LY);
 			}
 			else
 			{
@@ -520,31 +736,40 @@ void FVoxelCubicTransitionsMesher::CreateTransitionsForDirection(FVoxelMesherTim
 				if (!AreBothFull) continue;
 
 				// When AreBothFull is true, the high res mesher did not create a face, and we need to add one ourselves
-
-				// The face direction is from the high res to the low res: the opposite of the transition direction,
-				// which is low res to high res (ie us to other)
-				constexpr EVoxelDirectionFlag::Type FaceDirection = InverseVoxelDirection<Direction>();
 				
 				const auto Material = MESHER_TIME_RETURN_MATERIALS(1, GetMaterial<Direction>(Step, LX * Step, LY * Step, -HalfStep));
 				if (AreBothFull & 0x1)
 				{
-					Add2DFace<Direction, FaceDirection>(HalfStep, Material, 2 * LX + 0, 2 * LY + 0, Vertices, Indices);
+					AddSmallFace(Material, 2 * LX + 0, 2 * LY + 0);
 				}
 				if (AreBothFull & 0x2)
 				{
-					Add2DFace<Direction, FaceDirection>(HalfStep, Material, 2 * LX + 1, 2 * LY + 0, Vertices, Indices);
+					AddSmallFace(Material, 2 * LX + 1, 2 * LY + 0);
 				}
 				if (AreBothFull & 0x4)
 				{
-					Add2DFace<Direction, FaceDirection>(HalfStep, Material, 2 * LX + 0, 2 * LY + 1, Vertices, Indices);
+					AddSmallFace(Material, 2 * LX + 0, 2 * LY + 1);
 				}
 				if (AreBothFull & 0x8)
 				{
-					Add2DFace<Direction, FaceDirection>(HalfStep, Material, 2 * LX + 1, 2 * LY + 1, Vertices, Indices);
+					AddSmallFace(Material, 2 * LX + 1, 2 * LY + 1);
 				}
 			}
 		}
 	}
+
+	if (bGreedy)
+	{
+		VOXEL_ASYNC_SCOPE_COUNTER("Greedy Merge");
+		GreedyMerge2D<true>(BigGridSize, BigHasFace->GetData(), BigMaterials->GetData(), [&](int32 FaceX, int32 FaceY, int32 SizeX, int32 SizeY, const FVoxelMaterial& Material)
+		{
+			Add2DFace<Direction, BigFaceDirection>(Step, Material, FaceX, FaceY, Vertices, Indices, SizeX, SizeY);
+		});
+		GreedyMerge2D<true>(SmallGridSize, SmallHasFace->GetData(), SmallMaterials->GetData(), [&](int32 FaceX, int32 FaceY, int32 SizeX, int32 SizeY, const FVoxelMaterial& Material)
+		{
+			Add2DFace<Direction, SmallFaceDirection>(HalfStep, Material, FaceX, FaceY, Vertices, Indices, SizeX, SizeY);
+		});
+	}
 }
 
 template<EVoxelDirectionFlag::Type Direction>
@@ -572,14 +797,22 @@ void FVoxelCubicTransitionsMesher::Add2DFace(
 	int32 InStep, 
 	const FVoxelMaterial& Material, 
 	int32 LX, int32 LY, 
-	TArray<TVertex>& Vertices, TArray<uint32>& Indices)
+	TArray<TVertex>& Vertices, TArray<uint32>& Indices,
+	int32 SizeX, int32 SizeY)
 {
 	const int32 LZ = IsDirectionMax<FaceDirection>()
 		? IsDirectionMax<Direction>() ? 1 : -1
 		: 0;
 
 	const FIntVector P = Local2DToGlobal<Direction>(Step / InStep * RENDER_CHUNK_SIZE, LX, LY, LZ);
-	AddFace<FaceDirection>(*this, InStep, Material, P.X, P.Y, P.Z, Indices, Vertices);
+
+	// LX and LY always map to increasing global coordinates: only need to swap the axes. The normal axis is 0 here
+	FIntVector Size = Local2DToGlobal<Direction>(0, SizeX, SizeY, 0);
+	Size.X = FMath::Max(Size.X, 1);
+	Size.Y = FMath::Max(Size.Y, 1);
+	Size.Z = FMath::Max(Size.Z, 1);
+
+	AddFace<FaceDirection>(*this, InStep, Material, P.X, P.Y, P.Z, Indices, Vertices, Size);
 }
 
 template<EVoxelDirectionFlag::Type Direction>
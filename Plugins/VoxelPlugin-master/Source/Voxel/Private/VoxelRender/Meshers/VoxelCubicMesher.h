@@ -28,6 +28,9 @@ private:
 private:
 	template<typename T>
 	void CreateGeometryTemplate(FVoxelMesherTimes& Times, TArray<uint32>& Indices, TArray<T>& Vertices);
+	// Merges the Direction faces in Flags slice by slice. Flags & Materials are RENDER_CHUNK_SIZE^3, Materials is null if T has no material
+	template<EVoxelDirectionFlag::Type Direction, typename T>
+	void AddGreedyFaces(const uint8* RESTRICT Flags, const FVoxelMaterial* RESTRICT Materials, TArray<uint32>& Indices, TArray<T>& Vertices);
 
 private:
 	FVoxelValue GetValue(int32 X, int32 Y, int32 Z) const;
@@ -57,12 +60,14 @@ private:
 	FVoxelMaterial GetMaterial(int32 InStep, int32 X, int32 Y, int32 Z) const;
 
 	// LX * HalfStep = GX
+	// SizeX and SizeY are the size of the quad in InStep voxels, when merging faces
 	template<EVoxelDirectionFlag::Type Direction, EVoxelDirectionFlag::Type FaceDirection, typename TVertex>
 	void Add2DFace(
 		int32 InStep, 
 		const FVoxelMaterial& Material, 
 		int32 LX, int32 LY, 
-		TArray<TVertex>& Vertices, TArray<uint32>& Indices);
+		TArray<TVertex>& Vertices, TArray<uint32>& Indices,
+		int32 SizeX = 1, int32 SizeY = 1);
 	
 	template<EVoxelDirectionFlag::Type Direction>
 	static FIntVector Local2DToGlobal(int32 InSize, int32 LX, int32 LY, int32 LZ);
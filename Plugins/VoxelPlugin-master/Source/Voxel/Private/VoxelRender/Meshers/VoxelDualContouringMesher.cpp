@@ -0,0 +1,443 @@
+// Copyright 2020 Phyronnaz
+
+#include "VoxelRender/Meshers/VoxelDualContouringMesher.h"
+#include "VoxelRender/Meshers/VoxelMesherUtilities.h"
+#include "VoxelRender/IVoxelRenderer.h"
+#include "VoxelData/VoxelDataIncludes.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<float> CVarDualContouringRegularization(
+	TEXT("voxel.mesher.DualContouringRegularization"),
+	0.05f,
+	TEXT("Weight pulling the dual contouring vertices towards the average of their cell intersections. Higher values smooth sharp features but are more robust to noisy normals"),
+	ECVF_Default);
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Voxel Dual Contouring Vertices"), STAT_VoxelDualContouringVertices, STATGROUP_VoxelCounters);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Voxel Dual Contouring Clamped Vertices"), STAT_VoxelDualContouringClampedVertices, STATGROUP_VoxelCounters);
+
+struct FVoxelDualContouringFullVertex : FVoxelMesherVertex
+{
+	static constexpr bool bComputeParentPosition = true;
+	static constexpr bool bComputeNormal = true;
+	static constexpr bool bComputeTextureCoordinate = true;
+	static constexpr bool bComputeMaterial = true;
+
+	FORCEINLINE void SetPosition(const FVector& InPosition)
+	{
+		Position = InPosition;
+	}
+	FORCEINLINE void SetParentPosition(const FVector& InParentPosition)
+	{
+		Tangent = FVoxelProcMeshTangent(InParentPosition, false);
+	}
+	FORCEINLINE void SetNormal(const FVector& InNormal)
+	{
+		Normal = InNormal;
+	}
+	FORCEINLINE void SetTextureCoordinate(const FVector2D& InTextureCoordinate)
+	{
+		TextureCoordinate = InTextureCoordinate;
+	}
+	FORCEINLINE void SetMaterial(const FVoxelMaterial& InMaterial)
+	{
+		Material = InMaterial;
+	}
+};
+static_assert(sizeof(FVoxelDualContouringFullVertex) == sizeof(FVoxelMesherVertex), "");
+
+struct FVoxelDualContouringGeometryVertex : FVector
+{
+	static constexpr bool bComputeParentPosition = false;
+	static constexpr bool bComputeNormal = false;
+	static constexpr bool bComputeTextureCoordinate = false;
+	static constexpr bool bComputeMaterial = false;
+
+	FORCEINLINE void SetPosition(const FVector& InPosition)
+	{
+		static_cast<FVector&>(*this) = InPosition;
+	}
+	FORCEINLINE void SetParentPosition(const FVector& InParentPosition)
+	{
+		checkVoxelSlow(false);
+	}
+	FORCEINLINE void SetNormal(const FVector& InNormal)
+	{
+		checkVoxelSlow(false);
+	}
+	FORCEINLINE void SetTextureCoordinate(const FVector2D& InTextureCoordinate)
+	{
+		checkVoxelSlow(false);
+	}
+	FORCEINLINE void SetMaterial(const FVoxelMaterial& InMaterial)
+	{
+		checkVoxelSlow(false);
+	}
+};
+static_assert(sizeof(FVoxelDualContouringGeometryVertex) == sizeof(FVector), "");
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+// Quadratic error function of a cell: sum of the squared distances to the tangent planes at the edges intersections
+// QEFs are additive, so the QEF of a parent cell is the sum of the QEFs of its 8 children
+struct FVoxelDualContouringQef
+{
+	// Symmetric: XX, XY, XZ, YY, YZ, ZZ
+	float AtA[6] = {};
+	FVector AtB = FVector::ZeroVector;
+	FVector MassPointSum = FVector::ZeroVector;
+	FVector NormalSum = FVector::ZeroVector;
+	int32 NumPoints = 0;
+
+	FORCEINLINE void Add(const FVector& Point, const FVector& Normal)
+	{
+		AtA[0] += Normal.X * Normal.X;
+		AtA[1] += Normal.X * Normal.Y;
+		AtA[2] += Normal.X * Normal.Z;
+		AtA[3] += Normal.Y * Normal.Y;
+		AtA[4] += Normal.Y * Normal.Z;
+		AtA[5] += Normal.Z * Normal.Z;
+		AtB += Normal * FVector::DotProduct(Normal, Point);
+		MassPointSum += Point;
+		NormalSum += Normal;
+		NumPoints++;
+	}
+	FORCEINLINE void Add(const FVoxelDualContouringQef& Other)
+	{
+		for (int32 Index = 0; Index < 6; Index++)
+		{
+			AtA[Index] += Other.AtA[Index];
+		}
+		AtB += Other.AtB;
+		MassPointSum += Other.MassPointSum;
+		NormalSum += Other.NormalSum;
+		NumPoints += Other.NumPoints;
+	}
+
+	// Minimizes the QEF, regularized towards the mass point so that flat & degenerate cases are stable, and clamps the result to the cell
+	FVector Solve(const FVector& CellMin, const FVector& CellMax, float Regularization, bool& bOutClamped) const
+	{
+		checkVoxelSlow(NumPoints > 0);
+		const FVector MassPoint = MassPointSum / NumPoints;
+
+		// Solve (AtA + Lambda I) Delta = AtB - AtA MassPoint
+		const float Lambda = Regularization * NumPoints;
+		const float A00 = AtA[0] + Lambda, A01 = AtA[1], A02 = AtA[2];
+		const float A11 = AtA[3] + Lambda, A12 = AtA[4];
+		const float A22 = AtA[5] + Lambda;
+
+		const FVector B = AtB - FVector(
+			AtA[0] * MassPoint.X + AtA[1] * MassPoint.Y + AtA[2] * MassPoint.Z,
+			AtA[1] * MassPoint.X + AtA[3] * MassPoint.Y + AtA[4] * MassPoint.Z,
+			AtA[2] * MassPoint.X + AtA[4] * MassPoint.Y + AtA[5] * MassPoint.Z);
+
+		// Cofactors of the symmetric matrix
+		const float C00 = A11 * A22 - A12 * A12;
+		const float C01 = A02 * A12 - A01 * A22;
+		const float C02 = A01 * A12 - A02 * A11;
+		const float C11 = A00 * A22 - A02 * A02;
+		const float C12 = A01 * A02 - A00 * A12;
+		const float C22 = A00 * A11 - A01 * A01;
+		const float Determinant = A00 * C00 + A01 * C01 + A02 * C02;
+
+		FVector Position = MassPoint;
+		if (FMath::Abs(Determinant) > KINDA_SMALL_NUMBER)
+		{
+			const FVector Delta = FVector(
+				C00 * B.X + C01 * B.Y + C02 * B.Z,
+				C01 * B.X + C11 * B.Y + C12 * B.Z,
+				C02 * B.X + C12 * B.Y + C22 * B.Z) / Determinant;
+			Position += Delta;
+		}
+
+		const FVector ClampedPosition = Position.BoundToBox(CellMin, CellMax);
+		bOutClamped = ClampedPosition != Position;
+		return ClampedPosition;
+	}
+};
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+FVoxelIntBox FVoxelDualContouringMesher::GetBoundsToCheckIsEmptyOn() const
+{
+	return FVoxelIntBox(ChunkPosition, ChunkPosition + DC_EXTENDED_CHUNK_SIZE * Step);
+}
+
+FVoxelIntBox FVoxelDualContouringMesher::GetBoundsToLock() const
+{
+	return GetBoundsToCheckIsEmptyOn();
+}
+
+template<typename TVertex>
+void FVoxelDualContouringMesher::CreateGeometryTemplate(FVoxelMesherTimes& Times, TArray<uint32>& Indices, TArray<TVertex>& Vertices)
+{
+	VOXEL_ASYNC_FUNCTION_COUNTER();
+
+	constexpr int32 E = DC_EXTENDED_CHUNK_SIZE;
+	constexpr int32 C = DC_CELLS_SIZE;
+
+	QueryValues(Times, GetBoundsToCheckIsEmptyOn(), CachedValues);
+
+	if (TVertex::bComputeMaterial)
+	{
+		Accelerator = MakeUnique<FVoxelConstDataAccelerator>(Data, GetBoundsToLock());
+	}
+
+	const auto GetValue = [&](int32 X, int32 Y, int32 Z)
+	{
+		checkVoxelSlow(0 <= X && X < E && 0 <= Y && Y < E && 0 <= Z && Z < E);
+		return CachedValues[X + Y * E + Z * E * E];
+	};
+
+	const float Regularization = FMath::Max(0.f, CVarDualContouringRegularization.GetValueOnAnyThread());
+
+	// Gradients of the density at each corner, interpolated along the edges to get the intersections normals
+	TVoxelMesherScratchArray<FVector> GradientsScratch(E * E * E);
+	TArray<FVector>& Gradients = *GradientsScratch;
+	{
+		VOXEL_ASYNC_SCOPE_COUNTER("Compute Gradients");
+
+		for (int32 Z = 0; Z < E; Z++)
+		{
+			for (int32 Y = 0; Y < E; Y++)
+			{
+				for (int32 X = 0; X < E; X++)
+				{
+					const auto Derivative = [&](int32 Min, int32 Max, FVoxelValue MinValue, FVoxelValue MaxValue)
+					{
+						return (MaxValue.ToFloat() - MinValue.ToFloat()) / (Max - Min);
+					};
+					const int32 MinX = FMath::Max(X - 1, 0), MaxX = FMath::Min(X + 1, E - 1);
+					const int32 MinY = FMath::Max(Y - 1, 0), MaxY = FMath::Min(Y + 1, E - 1);
+					const int32 MinZ = FMath::Max(Z - 1, 0), MaxZ = FMath::Min(Z + 1, E - 1);
+					Gradients[X + Y * E + Z * E * E] = FVector(
+						Derivative(MinX, MaxX, GetValue(MinX, Y, Z), GetValue(MaxX, Y, Z)),
+						Derivative(MinY, MaxY, GetValue(X, MinY, Z), GetValue(X, MaxY, Z)),
+						Derivative(MinZ, MaxZ, GetValue(X, Y, MinZ), GetValue(X, Y, MaxZ)));
+				}
+			}
+		}
+	}
+
+	// One QEF per cell, including the cells after the chunk that are needed for the parent positions
+	TVoxelMesherScratchArray<FVoxelDualContouringQef> QefsScratch;
+	TArray<FVoxelDualContouringQef>& Qefs = *QefsScratch;
+	Qefs.SetNum(C * C * C);
+	{
+		VOXEL_ASYNC_SCOPE_COUNTER("Find Intersections");
+
+		for (int32 Z = 0; Z < C; Z++)
+		{
+			for (int32 Y = 0; Y < C; Y++)
+			{
+				for (int32 X = 0; X < C; X++)
+				{
+					FVoxelDualContouringQef& Qef = Qefs[X + Y * C + Z * C * C];
+
+					for (int32 Direction = 0; Direction < 3; Direction++)
+					{
+						const int32 DirectionB = (Direction + 1) % 3;
+						const int32 DirectionC = (Direction + 2) % 3;
+						for (int32 Edge = 0; Edge < 4; Edge++)
+						{
+							FIntVector Start(X, Y, Z);
+							Start[DirectionB] += Edge & 0x1;
+							Start[DirectionC] += (Edge >> 1) & 0x1;
+							FIntVector End = Start;
+							End[Direction]++;
+
+							const FVoxelValue StartValue = GetValue(Start.X, Start.Y, Start.Z);
+							const FVoxelValue EndValue = GetValue(End.X, End.Y, End.Z);
+							if (StartValue.IsEmpty() == EndValue.IsEmpty())
+							{
+								continue;
+							}
+
+							const float Factor = StartValue.ToFloat() / (StartValue.ToFloat() - EndValue.ToFloat());
+							const FVector Point = FMath::Lerp(FVector(Start), FVector(End), Factor);
+
+							FVector Normal = FMath::Lerp(
+								Gradients[Start.X + Start.Y * E + Start.Z * E * E],
+								Gradients[End.X + End.Y * E + End.Z * E * E],
+								Factor).GetSafeNormal();
+							if (Normal.IsZero())
+							{
+								// Saturated values: fallback to the edge direction, pointing towards the empty side
+								Normal = FVector::ZeroVector;
+								Normal[Direction] = EndValue.IsEmpty() ? 1.f : -1.f;
+							}
+
+							Qef.Add(Point, Normal);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	{
+		VOXEL_ASYNC_SCOPE_COUNTER("Generate Vertices");
+
+		int32 NumClampedVertices = 0;
+		for (int32 LZ = 0; LZ < DC_CHUNK_SIZE; LZ++)
+		{
+			for (int32 LY = 0; LY < DC_CHUNK_SIZE; LY++)
+			{
+				for (int32 LX = 0; LX < DC_CHUNK_SIZE; LX++)
+				{
+					const int32 VertexIndex = LX + LY * DC_CHUNK_SIZE + LZ * DC_CHUNK_SIZE * DC_CHUNK_SIZE;
+					const FVoxelDualContouringQef& Qef = Qefs[LX + LY * C + LZ * C * C];
+					if (Qef.NumPoints == 0)
+					{
+						VertexIndices[VertexIndex] = -1;
+						continue;
+					}
+					VertexIndices[VertexIndex] = Vertices.Num();
+
+					const FIntVector CellPosition(LX, LY, LZ);
+
+					bool bClamped = false;
+					const FVector Position = Qef.Solve(FVector(CellPosition), FVector(CellPosition + FIntVector(1)), Regularization, bClamped);
+					NumClampedVertices += bClamped;
+
+					const FVector FinalPosition = Position * Step;
+
+					TVertex Vertex;
+					Vertex.SetPosition(FinalPosition);
+					if (TVertex::bComputeParentPosition)
+					{
+						constexpr int32 RemoveFirstBit = 0xFFFE;
+						const FIntVector ParentPosition(LX & RemoveFirstBit, LY & RemoveFirstBit, LZ & RemoveFirstBit);
+
+						FVoxelDualContouringQef ParentQef;
+						for (int32 Child = 0; Child < 8; Child++)
+						{
+							const FIntVector ChildPosition = ParentPosition + FIntVector(bool(Child & 0x1), bool(Child & 0x2), bool(Child & 0x4));
+							ParentQef.Add(Qefs[ChildPosition.X + ChildPosition.Y * C + ChildPosition.Z * C * C]);
+						}
+
+						bool bParentClamped = false;
+						const FVector ParentFinalPosition = ParentQef.Solve(FVector(ParentPosition), FVector(ParentPosition + FIntVector(2)), Regularization, bParentClamped) * Step;
+						Vertex.SetParentPosition((ParentFinalPosition - FinalPosition) / Step); // Divide by Step to avoid overflowing the tangent
+					}
+					if (TVertex::bComputeNormal)
+					{
+						Vertex.SetNormal(Qef.NormalSum.GetSafeNormal());
+					}
+					if (TVertex::bComputeMaterial)
+					{
+						// Use the material of the most full corner
+						FIntVector MaterialPosition = CellPosition;
+						FVoxelValue MinValue = FVoxelValue::Empty();
+						for (int32 Corner = 0; Corner < 8; Corner++)
+						{
+							const FIntVector CornerPosition = CellPosition + FIntVector(bool(Corner & 0x1), bool(Corner & 0x2), bool(Corner & 0x4));
+							const FVoxelValue Value = GetValue(CornerPosition.X, CornerPosition.Y, CornerPosition.Z);
+							if (!Value.IsEmpty() && Value <= MinValue)
+							{
+								MinValue = Value;
+								MaterialPosition = CornerPosition;
+							}
+						}
+						Vertex.SetMaterial(MESHER_TIME_RETURN_MATERIALS(1, Accelerator->GetMaterial(MaterialPosition * Step + ChunkPosition, LOD)));
+					}
+					if (TVertex::bComputeTextureCoordinate)
+					{
+						Vertex.SetTextureCoordinate(MESHER_TIME_RETURN(UVs, FVoxelMesherUtilities::GetUVs(*this, FinalPosition)));
+					}
+					Vertices.Add(Vertex);
+				}
+			}
+		}
+
+		INC_DWORD_STAT_BY(STAT_VoxelDualContouringVertices, Vertices.Num());
+		INC_DWORD_STAT_BY(STAT_VoxelDualContouringClampedVertices, NumClampedVertices);
+	}
+
+	UnlockData();
+
+	{
+		VOXEL_ASYNC_SCOPE_COUNTER("Generate Mesh");
+
+		const auto GetVertexIndex = [&](const FIntVector& Cell)
+		{
+			const uint32 Index = VertexIndices[Cell.X + Cell.Y * DC_CHUNK_SIZE + Cell.Z * DC_CHUNK_SIZE * DC_CHUNK_SIZE];
+			checkVoxelSlow(Index != uint32(-1));
+			return Index;
+		};
+
+		// Each cell of the chunk emits a quad for each of the 3 edges ending at its max corner that cross the surface
+		// The quad links the vertices of the 4 cells sharing that edge
+		for (int32 LZ = 0; LZ < RENDER_CHUNK_SIZE; LZ++)
+		{
+			for (int32 LY = 0; LY < RENDER_CHUNK_SIZE; LY++)
+			{
+				for (int32 LX = 0; LX < RENDER_CHUNK_SIZE; LX++)
+				{
+					const FIntVector Cell(LX, LY, LZ);
+					const FVoxelValue EndValue = GetValue(LX + 1, LY + 1, LZ + 1);
+
+					for (int32 Direction = 0; Direction < 3; Direction++)
+					{
+						FIntVector Start(LX + 1, LY + 1, LZ + 1);
+						Start[Direction]--;
+						const FVoxelValue StartValue = GetValue(Start.X, Start.Y, Start.Z);
+						if (StartValue.IsEmpty() == EndValue.IsEmpty())
+						{
+							continue;
+						}
+
+						FIntVector OffsetB(0, 0, 0);
+						FIntVector OffsetC(0, 0, 0);
+						OffsetB[(Direction + 1) % 3] = 1;
+						OffsetC[(Direction + 2) % 3] = 1;
+
+						uint32 Index0 = GetVertexIndex(Cell);
+						uint32 Index1 = GetVertexIndex(Cell + OffsetB);
+						const uint32 Index2 = GetVertexIndex(Cell + OffsetB + OffsetC);
+						uint32 Index3 = GetVertexIndex(Cell + OffsetC);
+						if (EndValue.IsEmpty())
+						{
+							// The surface faces Direction
+							Swap(Index1, Index3);
+						}
+
+						Indices.Add(Index0);
+						Indices.Add(Index1);
+						Indices.Add(Index2);
+
+						Indices.Add(Index2);
+						Indices.Add(Index3);
+						Indices.Add(Index0);
+					}
+				}
+			}
+		}
+	}
+}
+
+TVoxelSharedPtr<FVoxelChunkMesh> FVoxelDualContouringMesher::CreateFullChunkImpl(FVoxelMesherTimes& Times)
+{
+	TArray<uint32> Indices;
+	TVoxelMesherScratchArray<FVoxelDualContouringFullVertex> VerticesScratch;
+	TArray<FVoxelDualContouringFullVertex>& Vertices = *VerticesScratch;
+	CreateGeometryTemplate(Times, Indices, Vertices);
+
+	if (IsCanceled()) return {};
+
+	FVoxelMesherUtilities::SanitizeMesh(Indices, Vertices);
+
+	return MESHER_TIME_RETURN(CreateChunk, FVoxelMesherUtilities::CreateChunkFromVertices(
+		Settings,
+		LOD,
+		MoveTemp(Indices),
+		reinterpret_cast<TArray<FVoxelMesherVertex>&>(Vertices)));
+}
+
+void FVoxelDualContouringMesher::CreateGeometryImpl(FVoxelMesherTimes& Times, TArray<uint32>& Indices, TArray<FVector>& Vertices)
+{
+	CreateGeometryTemplate(Times, Indices, reinterpret_cast<TArray<FVoxelDualContouringGeometryVertex>&>(Vertices));
+}
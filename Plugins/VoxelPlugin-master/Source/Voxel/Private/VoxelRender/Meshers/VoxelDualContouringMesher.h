@@ -0,0 +1,41 @@
+// Copyright 2020 Phyronnaz
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VoxelData/VoxelDataAccelerator.h"
+#include "VoxelRender/Meshers/VoxelMesher.h"
+
+#define DC_CHUNK_SIZE (RENDER_CHUNK_SIZE + 1) /* +1 since DC vertices are within cells */
+#define DC_CELLS_SIZE (RENDER_CHUNK_SIZE + 2) /* +2 to get the parent cells of the last vertices */
+#define DC_EXTENDED_CHUNK_SIZE (RENDER_CHUNK_SIZE + 3) /* +3 to get the corners of the parent cells */
+
+/**
+ * Dual contouring: one vertex per cell crossing the surface, placed by minimizing the quadratic error
+ * to the planes of the cell edges intersections (the QEF). Unlike surface nets, the vertices snap to
+ * the corners and creases of the surface, so sharp features are kept
+ *
+ * Like surface nets, the vertices are on a dual grid: there are no transitions meshes. Each vertex still
+ * stores its position in the parent cell, solved from the sum of the 8 children QEFs
+ * Since the seams between LODs are not stitched, only LOD 0 chunks are rendered (see AVoxelWorld::UpdateDynamicLODSettings)
+ */
+class FVoxelDualContouringMesher : public FVoxelMesher
+{
+public:
+	using FVoxelMesher::FVoxelMesher;
+
+protected:
+	virtual FVoxelIntBox GetBoundsToCheckIsEmptyOn() const override final;
+	virtual FVoxelIntBox GetBoundsToLock() const override final;
+	virtual TVoxelSharedPtr<FVoxelChunkMesh> CreateFullChunkImpl(FVoxelMesherTimes& Times) override final;
+	virtual void CreateGeometryImpl(FVoxelMesherTimes& Times, TArray<uint32>& Indices, TArray<FVector>& Vertices) override final;
+
+private:
+	TUniquePtr<FVoxelConstDataAccelerator> Accelerator;
+
+	FVoxelValue CachedValues[DC_EXTENDED_CHUNK_SIZE * DC_EXTENDED_CHUNK_SIZE * DC_EXTENDED_CHUNK_SIZE];
+	uint32 VertexIndices[DC_CHUNK_SIZE * DC_CHUNK_SIZE * DC_CHUNK_SIZE]; // final vertex indices, per cell. -1 if no vertex
+
+	template<typename TVertex>
+	void CreateGeometryTemplate(FVoxelMesherTimes& Times, TArray<uint32>& Indices, TArray<TVertex>& Vertices);
+};
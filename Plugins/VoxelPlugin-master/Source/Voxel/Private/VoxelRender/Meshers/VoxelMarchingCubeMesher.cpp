@@ -2,12 +2,16 @@
 
 #include "VoxelRender/Meshers/VoxelMarchingCubeMesher.h"
 #include "VoxelRender/Meshers/VoxelMesherUtilities.h"
+#include "VoxelRender/Meshers/VoxelMarchingCubeSignBits.h"
 #include "VoxelRender/IVoxelRenderer.h"
+#include "VoxelRender/VoxelChunkMesh.h"
 #include "VoxelData/VoxelDataIncludes.h"
 #include "Transvoxel.h"
 #include "HAL/IConsoleManager.h"
 
 #define checkError(x) if(!(x)) { return false; }
+// Cooperative cancellation: the renderer might not need this chunk anymore
+#define checkCanceled() if (IsCanceled()) { UnlockData(); return {}; }
 
 static TAutoConsoleVariable<int32> CVarEnableUniqueUVs(
 	TEXT("voxel.mesher.UniqueUVs"),
@@ -15,29 +19,190 @@ static TAutoConsoleVariable<int32> CVarEnableUniqueUVs(
 	TEXT("If true, will duplicate the vertices to assign to each triangle in a chunk a unique part of the UV space"),
 	ECVF_Default);
 
+static TAutoConsoleVariable<int32> CVarUseRowSignBits(
+	TEXT("voxel.mesher.UseRowSignBits"),
+	1,
+	TEXT("If true, the marching cubes mesher will compute the corner signs of a whole row of cells at once (SSE2 when available) and skip the empty cells. ")
+	TEXT("Set to 0 to compare with the per cell path using voxel.mesher.PrintStats"),
+	ECVF_Default);
+
 static TAutoConsoleVariable<int32> CVarRandomizeTangents(
 	TEXT("voxel.mesher.RandomizeTangents"),
 	0,
 	TEXT("If true, will randomize voxel tangents to help debug materials that should not be using them"),
 	ECVF_Default);
 
+static TAutoConsoleVariable<int32> CVarBatchMaterialQueries(
+	TEXT("voxel.mesher.BatchMaterialQueries"),
+	1,
+	TEXT("If true, the marching cubes mesher will query the materials of all its vertices at once, one query per slice of cells, instead of one accelerator lookup per vertex. ")
+	TEXT("Compare the materials time with voxel.mesher.PrintStats"),
+	ECVF_Default);
+
+// Chunk-local grid of the materials at the corners used by the vertices
+// The materials are queried in batches, one per Z slice with the bounds of its requested corners (or one for the whole chunk
+// if the surface is dense), instead of going through the accelerator for each vertex
+class FMarchingCubeMaterialGrid
+{
+public:
+	static constexpr int32 GridSize = CHUNK_SIZE_WITH_END_EDGE;
+
+	FMarchingCubeMaterialGrid(const FVoxelData& Data, const FIntVector& ChunkPosition, int32 LOD)
+		: Data(Data)
+		, ChunkPosition(ChunkPosition)
+		, LOD(LOD)
+		, Step(1 << LOD)
+		, Requested(GridSize * GridSize * GridSize)
+		, Materials(GridSize * GridSize * GridSize)
+	{
+		FMemory::Memzero(Requested->GetData(), Requested->Num() * sizeof(uint8));
+	}
+
+	// Position is relative to the chunk. Positions that are not corners of the LOD grid are ignored
+	FORCEINLINE void Request(const FIntVector& Position)
+	{
+		int32 Index;
+		if (GetIndex(Position, Index))
+		{
+			(*Requested)[Index] = true;
+		}
+	}
+	// Must be called with the data locked
+	void Fetch()
+	{
+		VOXEL_ASYNC_FUNCTION_COUNTER();
+
+		FIntVector SliceMins[GridSize];
+		FIntVector SliceMaxs[GridSize];
+		FIntVector ChunkMin(GridSize);
+		FIntVector ChunkMax(-1);
+		int64 SlicesVolume = 0;
+		for (int32 Z = 0; Z < GridSize; Z++)
+		{
+			FIntVector& SliceMin = SliceMins[Z];
+			FIntVector& SliceMax = SliceMaxs[Z];
+			SliceMin = FIntVector(GridSize, GridSize, Z);
+			SliceMax = FIntVector(-1, -1, Z);
+
+			const uint8* RESTRICT SliceRequested = Requested->GetData() + GridSize * GridSize * Z;
+			for (int32 Y = 0; Y < GridSize; Y++)
+			{
+				for (int32 X = 0; X < GridSize; X++)
+				{
+					if (SliceRequested[X + GridSize * Y])
+					{
+						SliceMin.X = FMath::Min(SliceMin.X, X);
+						SliceMin.Y = FMath::Min(SliceMin.Y, Y);
+						SliceMax.X = FMath::Max(SliceMax.X, X);
+						SliceMax.Y = FMath::Max(SliceMax.Y, Y);
+					}
+				}
+			}
+			if (SliceMax.X < SliceMin.X)
+			{
+				continue;
+			}
+
+			ChunkMin = FVoxelUtilities::ComponentMin(ChunkMin, SliceMin);
+			ChunkMax = FVoxelUtilities::ComponentMax(ChunkMax, SliceMax);
+			SlicesVolume += int64(SliceMax.X - SliceMin.X + 1) * (SliceMax.Y - SliceMin.Y + 1);
+		}
+		if (ChunkMax.X < ChunkMin.X)
+		{
+			return;
+		}
+
+		// The query zone covers the whole grid: the queries are shrunk to the bounds of the requested corners
+		const TVoxelQueryZone<FVoxelMaterial> GridQueryZone(
+			FVoxelIntBox(ChunkPosition, ChunkPosition + GridSize * Step),
+			FIntVector(GridSize),
+			LOD,
+			Materials->GetData());
+
+		const auto Query = [&](const FIntVector& Min, const FIntVector& Max)
+		{
+			TVoxelQueryZone<FVoxelMaterial> QueryZone = GridQueryZone.ShrinkTo(FVoxelIntBox(ChunkPosition + Min * Step, ChunkPosition + (Max + 1) * Step));
+			Data.Get<FVoxelMaterial>(QueryZone, LOD);
+
+			for (int32 Z = Min.Z; Z <= Max.Z; Z++)
+			{
+				for (int32 Y = Min.Y; Y <= Max.Y; Y++)
+				{
+					// Everything in the bounds is valid now
+					FMemory::Memset(Requested->GetData() + Min.X + GridSize * Y + GridSize * GridSize * Z, 1, Max.X - Min.X + 1);
+				}
+			}
+		};
+
+		const FIntVector ChunkSize = ChunkMax - ChunkMin + 1;
+		// Dense surface: the slices bounds cover most of the chunk bounds, a single query is cheaper than one per slice
+		if (2 * SlicesVolume >= int64(ChunkSize.X) * ChunkSize.Y * ChunkSize.Z)
+		{
+			Query(ChunkMin, ChunkMax);
+			return;
+		}
+
+		for (int32 Z = ChunkMin.Z; Z <= ChunkMax.Z; Z++)
+		{
+			if (SliceMaxs[Z].X >= SliceMins[Z].X)
+			{
+				Query(SliceMins[Z], SliceMaxs[Z]);
+			}
+		}
+	}
+	FORCEINLINE bool TryGet(const FIntVector& Position, FVoxelMaterial& OutMaterial) const
+	{
+		int32 Index;
+		if (GetIndex(Position, Index) && (*Requested)[Index])
+		{
+			OutMaterial = (*Materials)[Index];
+			return true;
+		}
+		return false;
+	}
+
+private:
+	const FVoxelData& Data;
+	const FIntVector ChunkPosition;
+	const int32 LOD;
+	const int32 Step;
+
+	// Whether the material of a corner is needed, and then whether it was fetched
+	TVoxelMesherScratchArray<uint8> Requested;
+	TVoxelMesherScratchArray<FVoxelMaterial> Materials;
+
+	FORCEINLINE bool GetIndex(const FIntVector& Position, int32& OutIndex) const
+	{
+		if (Position.X % Step != 0 || Position.Y % Step != 0 || Position.Z % Step != 0)
+		{
+			return false;
+		}
+		const FIntVector GridPosition = Position / Step;
+		if (GridPosition.X < 0 || GridPosition.Y < 0 || GridPosition.Z < 0 ||
+			GridPosition.X >= GridSize || GridPosition.Y >= GridSize || GridPosition.Z >= GridSize)
+		{
+			return false;
+		}
+		OutIndex = GridPosition.X + GridSize * GridPosition.Y + GridSize * GridSize * GridPosition.Z;
+		return true;
+	}
+};
+
 class FMarchingCubeHelpers
 {
 public:
 	template<typename T>
-	static TArray<FVoxelMesherVertex> CreateMesherVertices(TArray<T>& Vertices)
+	static void CreateMesherVertices(TArray<T>& Vertices, TArray<FVoxelMesherVertex>& MesherVertices)
 	{
 		VOXEL_ASYNC_FUNCTION_COUNTER();
 
-		TArray<FVoxelMesherVertex> MesherVertices;
-		MesherVertices.SetNumUninitialized(Vertices.Num());
+		MesherVertices.SetNumUninitialized(Vertices.Num(), false);
 		for (int32 Index = 0; Index < Vertices.Num(); Index++)
 		{
 			auto& Vertex = Vertices[Index];
 			auto& MesherVertex = MesherVertices[Index];
 			MesherVertex.Position = Vertex.Position;
 		}
-		return MesherVertices;
 	}
 	
 	template<typename T, typename TMesher>
@@ -45,15 +210,42 @@ public:
 	{
 		VOXEL_ASYNC_FUNCTION_COUNTER();
 	
+		const bool bInterpolate = Mesher.Settings.bInterpolateColors || Mesher.Settings.bInterpolateUVs;
+
+		// Transitions vertices are on the half LOD grid: only batch the main chunks
+		TOptional<FMarchingCubeMaterialGrid> MaterialGrid;
+		if (!Mesher.bIsTransitions && CVarBatchMaterialQueries.GetValueOnAnyThread() != 0)
+		{
+			MaterialGrid.Emplace(Mesher.Data, Mesher.ChunkPosition, Mesher.LOD);
+			for (int32 Index = 0; Index < Vertices.Num(); Index++)
+			{
+				if (bInterpolate)
+				{
+					MaterialGrid->Request(FVoxelUtilities::FloorToInt(MesherVertices[Index].Position));
+					MaterialGrid->Request(FVoxelUtilities::CeilToInt(MesherVertices[Index].Position));
+				}
+				else
+				{
+					MaterialGrid->Request(Vertices[Index].MaterialPosition);
+				}
+			}
+			MaterialGrid->Fetch();
+		}
+
 		const auto GetMaterial = [&](const FIntVector& P)
 		{
+			FVoxelMaterial Material;
+			if (MaterialGrid.IsSet() && MaterialGrid->TryGet(P, Material))
+			{
+				return Material;
+			}
 			return Mesher.Accelerator->GetMaterial(
 				P.X + Mesher.ChunkPosition.X,
 				P.Y + Mesher.ChunkPosition.Y, 
 				P.Z + Mesher.ChunkPosition.Z, 
 				Mesher.LOD);
 		};
-		if (Mesher.Settings.bInterpolateColors || Mesher.Settings.bInterpolateUVs)
+		if (bInterpolate)
 		{
 			for (int32 Index = 0; Index < Vertices.Num(); Index++)
 			{
@@ -138,7 +330,9 @@ public:
 	{
 		VOXEL_ASYNC_FUNCTION_COUNTER();
 
-		TArray<FVoxelMesherVertex> NewVertices;
+		TVoxelMesherScratchArray<FVoxelMesherVertex> NewVerticesScratch;
+		TArray<FVoxelMesherVertex>& NewVertices = *NewVerticesScratch;
+		NewVertices.Reserve(Indices.Num());
 		for (int32 I = 0; I < Indices.Num(); I += 3)
 		{
 			uint32& IndexA = Indices[I + 0];
@@ -158,7 +352,8 @@ public:
 			IndexB = NewVertices.Add(VertexB);
 			IndexC = NewVertices.Add(VertexC);
 		}
-		Vertices = MoveTemp(NewVertices);
+		// Swap: the old vertices allocation goes back to the scratch pool
+		Swap(Vertices, NewVertices);
 	}
 	static void ComputeNormals(FVoxelMarchingCubeMesher& Mesher, TArray<FVoxelMesherVertex>& MesherVertices, TArray<uint32>& Indices)
 	{
@@ -299,6 +494,151 @@ public:
 	}
 };
 
+inline FVoxelIntBox GetMarchingCubeBoundsToQuery(const FVoxelIntBox& ChunksBounds, int32 LOD)
+{
+	// + 1 for the end edge
+	FVoxelIntBox BoundsToQuery(ChunksBounds.Min, ChunksBounds.Max + FIntVector(1 << LOD));
+	if (LOD == 0)
+	{
+		// Account for normals
+		BoundsToQuery = BoundsToQuery.Extend(1);
+	}
+	return BoundsToQuery;
+}
+
+inline FVoxelIntBox GetMarchingCubeBatchBoundsToQuery(const FVoxelRendererSettings& Settings, const FVoxelIntBox& ChunksBounds, int32 LOD, bool bHasDistanceFieldValues)
+{
+	FVoxelIntBox BoundsToQuery = GetMarchingCubeBoundsToQuery(ChunksBounds, LOD);
+	if (bHasDistanceFieldValues)
+	{
+		// The distance field bounds are the same for all the chunks, up to a translation: the first and last chunks give the union
+		const FIntVector LastChunkPosition = ChunksBounds.Max - FIntVector(RENDER_CHUNK_SIZE << LOD);
+		BoundsToQuery = BoundsToQuery + FVoxelChunkMesh::GetDistanceFieldValuesBounds(LOD, ChunksBounds.Min, Settings);
+		BoundsToQuery = BoundsToQuery + FVoxelChunkMesh::GetDistanceFieldValuesBounds(LOD, LastChunkPosition, Settings);
+	}
+	return BoundsToQuery;
+}
+
+FVoxelMarchingCubeMesherBatch::FVoxelMarchingCubeMesherBatch(const FVoxelData& Data, const FVoxelRendererSettings& Settings, int32 LOD, const FVoxelIntBox& ChunksBounds)
+	: Data(Data)
+	, LOD(LOD)
+	, Step(1 << LOD)
+	, ChunksBounds(ChunksBounds)
+	, bHasDistanceFieldValues(Settings.bRenderWorld && LOD <= Settings.MaxDistanceFieldLOD)
+	, Settings(Settings)
+	, BoundsToQuery(GetMarchingCubeBatchBoundsToQuery(Settings, ChunksBounds, LOD, bHasDistanceFieldValues))
+	, QuerySize(BoundsToQuery.Size() / Step)
+{
+}
+
+FVoxelMarchingCubeMesherBatch::~FVoxelMarchingCubeMesherBatch()
+{
+	ensure(!LockInfo.IsValid());
+}
+
+void FVoxelMarchingCubeMesherBatch::LockAndQueryValues()
+{
+	VOXEL_ASYNC_FUNCTION_COUNTER();
+	check(!LockInfo.IsValid());
+
+	{
+		VOXEL_ASYNC_SCOPE_COUNTER("InitArea");
+		Data.WorldGenerator->InitArea(ChunksBounds, LOD);
+	}
+	
+	// Union of the chunks FVoxelMarchingCubeMesher::GetBoundsToLock, and of their distance field values
+	const FVoxelIntBox BoundsToLock = FVoxelIntBox(ChunksBounds.Min - FIntVector(Step), ChunksBounds.Max + FIntVector(2 * Step)) + BoundsToQuery;
+	LockInfo = Data.Lock(EVoxelLockType::Read, BoundsToLock, "Mesher Batch");
+
+	Values.SetNumUninitialized(QuerySize.X * QuerySize.Y * QuerySize.Z);
+	TVoxelQueryZone<FVoxelValue> QueryZone(BoundsToQuery, QuerySize, LOD, Values);
+	Data.Get<FVoxelValue>(QueryZone, LOD);
+
+	Accelerator = MakeUnique<FVoxelConstDataAccelerator>(Data, BoundsToLock);
+}
+
+void FVoxelMarchingCubeMesherBatch::Unlock()
+{
+	VOXEL_ASYNC_FUNCTION_COUNTER();
+
+	Accelerator.Reset();
+	Data.Unlock(MoveTemp(LockInfo));
+}
+
+void FVoxelMarchingCubeMesherBatch::CopyValues(const FIntVector& QueryMin, int32 DataSize, FVoxelValue* RESTRICT OutValues) const
+{
+	VOXEL_ASYNC_FUNCTION_COUNTER();
+	check(Values.Num() > 0);
+	
+	const FIntVector Offset = (QueryMin - BoundsToQuery.Min) / Step;
+	checkVoxelSlow(Offset * Step == QueryMin - BoundsToQuery.Min);
+	check(Offset.GetMin() >= 0);
+	check(Offset.X + DataSize <= QuerySize.X && Offset.Y + DataSize <= QuerySize.Y && Offset.Z + DataSize <= QuerySize.Z);
+
+	for (int32 Z = 0; Z < DataSize; Z++)
+	{
+		for (int32 Y = 0; Y < DataSize; Y++)
+		{
+			FMemory::Memcpy(
+				OutValues + Y * DataSize + Z * DataSize * DataSize,
+				Values.GetData() + Offset.X + (Offset.Y + Y) * QuerySize.X + (Offset.Z + Z) * QuerySize.X * QuerySize.Y,
+				DataSize * sizeof(FVoxelValue));
+		}
+	}
+}
+
+void FVoxelMarchingCubeMesherBatch::CopyDistanceFieldValues(const FIntVector& ChunkPosition, TArray<FVoxelValue>& OutValues) const
+{
+	check(bHasDistanceFieldValues);
+	
+	const FVoxelIntBox Bounds = FVoxelChunkMesh::GetDistanceFieldValuesBounds(LOD, ChunkPosition, Settings);
+	const FIntVector Size = Bounds.Size() / Step;
+	check(Size.X == Size.Y && Size.Y == Size.Z);
+
+	OutValues.SetNumUninitialized(Size.X * Size.Y * Size.Z);
+	CopyValues(Bounds.Min, Size.X, OutValues.GetData());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+void FVoxelMarchingCubeMesher::SetIncrementalUpdate(const FVoxelIntBox& DirtyBounds, const TVoxelSharedRef<const FVoxelChunkMesh>& InPreviousChunk)
+{
+	check(!Batch);
+	check(CanUpdateIncrementally(Settings));
+	
+	// A value at Z is a corner of the cells Z - 1 and Z, and is used by the normals of the cells Z - 2 to Z + 1
+	// One more cell on each side ensures the vertices on the slab boundaries are the same in the previous and the new mesh
+	constexpr int32 Border = 3;
+	const int32 DirtyMin = FVoxelUtilities::DivideFloor(DirtyBounds.Min.Z - ChunkPosition.Z, Step);
+	const int32 DirtyMax = FVoxelUtilities::DivideFloor(DirtyBounds.Max.Z - 1 - ChunkPosition.Z, Step);
+	
+	SlabMin = FMath::Clamp(DirtyMin - Border, 0, RENDER_CHUNK_SIZE);
+	SlabMax = FMath::Clamp(DirtyMax + Border + 1, SlabMin, RENDER_CHUNK_SIZE);
+	PreviousChunk = InPreviousChunk;
+}
+
+void FVoxelMarchingCubeMesher::GetSlabZBounds(float& OutMinZ, float& OutMaxZ) const
+{
+	OutMinZ = SlabMin == 0 ? -MAX_flt : SlabMin * Step;
+	OutMaxZ = SlabMax == RENDER_CHUNK_SIZE ? MAX_flt : SlabMax * Step;
+}
+
+bool FVoxelMarchingCubeMesher::CanUpdateIncrementally(const FVoxelRendererSettings& Settings)
+{
+	// Multi index buffers depend on the materials of the whole chunk, mesh normals on the neighbor triangles
+	// and unique UVs on the triangles order: these need a full remesh
+	return
+		Settings.MaterialConfig != EVoxelMaterialConfig::MultiIndex &&
+		Settings.NormalConfig != EVoxelNormalConfig::MeshNormal &&
+		CVarEnableUniqueUVs.GetValueOnAnyThread() == 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
 FVoxelIntBox FVoxelMarchingCubeMesher::GetBoundsToCheckIsEmptyOn() const
 {
 	return FVoxelIntBox(ChunkPosition, ChunkPosition + CHUNK_SIZE_WITH_END_EDGE * Step);
@@ -331,37 +671,53 @@ TVoxelSharedPtr<FVoxelChunkMesh> FVoxelMarchingCubeMesher::CreateFullChunkImpl(F
 		}
 	};
 	
+	// Indices are moved into the chunk, but the vertices are only temporaries
 	TArray<uint32> Indices;
-	TArray<FLocalVertex> Vertices;
+	TVoxelMesherScratchArray<FLocalVertex> VerticesScratch;
+	TArray<FLocalVertex>& Vertices = *VerticesScratch;
 	CreateGeometryTemplate(Times, Indices, Vertices);
+	checkCanceled();
 
 	FVoxelMesherUtilities::SanitizeMesh(Indices, Vertices);
 
-	TArray<FVoxelMesherVertex> MesherVertices = FMarchingCubeHelpers::CreateMesherVertices(Vertices);
+	float SlabMinZ;
+	float SlabMaxZ;
+	GetSlabZBounds(SlabMinZ, SlabMaxZ);
+	if (PreviousChunk.IsValid())
+	{
+		// The cell below the slab was meshed too: only keep its triangles owned by the slab
+		FVoxelMesherUtilities::RemoveTrianglesOutsideSlab(Indices, Vertices, SlabMinZ, SlabMaxZ);
+		FVoxelMesherUtilities::RemoveUnusedVertices(Indices, Vertices);
+	}
+
+	TVoxelMesherScratchArray<FVoxelMesherVertex> MesherVerticesScratch;
+	TArray<FVoxelMesherVertex>& MesherVertices = *MesherVerticesScratch;
+	FMarchingCubeHelpers::CreateMesherVertices(Vertices, MesherVertices);
 
 	MESHER_TIME_MATERIALS(MesherVertices.Num(), FMarchingCubeHelpers::ComputeMaterials(*this, MesherVertices, Vertices));
+	checkCanceled();
 	MESHER_TIME(Normals, FMarchingCubeHelpers::ComputeNormals(*this, MesherVertices, Indices));
 
 	UnlockData();
 
+	if (IsCanceled()) return {};
+
 	MESHER_TIME(UVs, FMarchingCubeHelpers::ComputeUVs(*this, MesherVertices));
 
 	if (CVarEnableUniqueUVs.GetValueOnAnyThread() != 0)
 	{
 		{
-			TArray<FVoxelMesherVertex> NewVertices;
+			TVoxelMesherScratchArray<FVoxelMesherVertex> NewVerticesScratch;
+			TArray<FVoxelMesherVertex>& NewVertices = *NewVerticesScratch;
 			NewVertices.Reserve(Indices.Num());
-			TArray<uint32> NewIndices;
-			NewIndices.Reserve(Indices.Num());
 
-			for (uint32 Index : Indices)
+			for (uint32& Index : Indices)
 			{
-				NewIndices.Add(NewVertices.Num());
-				NewVertices.Add(MesherVertices[Index]);
+				const uint32 NewIndex = NewVertices.Add(MesherVertices[Index]);
+				Index = NewIndex;
 			}
 
-			MesherVertices = MoveTemp(NewVertices);
-			Indices = MoveTemp(NewIndices);
+			Swap(MesherVertices, NewVertices);
 		}
 		
 		const int32 NumTriangles = Indices.Num() / 3;
@@ -411,11 +767,19 @@ TVoxelSharedPtr<FVoxelChunkMesh> FVoxelMarchingCubeMesher::CreateFullChunkImpl(F
 		}
 	}
 
-	return MESHER_TIME_RETURN(CreateChunk, FVoxelMesherUtilities::CreateChunkFromVertices(
+	const auto Chunk = MESHER_TIME_RETURN(CreateChunk, FVoxelMesherUtilities::CreateChunkFromVertices(
 		Settings,
 		LOD,
 		MoveTemp(Indices),
-		MoveTemp(MesherVertices)));
+		MesherVertices));
+
+	if (PreviousChunk.IsValid())
+	{
+		// Keep the previous triangles outside of the slab. No need to clip on the chunk borders
+		MESHER_TIME(CreateChunk, FVoxelMesherUtilities::SpliceChunk(*PreviousChunk, SlabMinZ, SlabMaxZ, *Chunk));
+	}
+
+	return Chunk;
 }
 
 void FVoxelMarchingCubeMesher::CreateGeometryImpl(FVoxelMesherTimes& Times, TArray<uint32>& Indices, TArray<FVector>& Vertices)
@@ -445,30 +809,79 @@ bool FVoxelMarchingCubeMesher::CreateGeometryTemplate(FVoxelMesherTimes& Times,
 
 	const int32 DataSize = LOD == 0 ? CHUNK_SIZE_WITH_NORMALS : CHUNK_SIZE_WITH_END_EDGE;
 
-	FVoxelIntBox BoundsToQuery(ChunkPosition, ChunkPosition + CHUNK_SIZE_WITH_END_EDGE * Step);
-	if (LOD == 0)
+	const FVoxelIntBox BoundsToQuery = GetMarchingCubeBoundsToQuery(FVoxelIntBox(ChunkPosition, ChunkPosition + Size), LOD);
+	
+	// When updating a slab, the cell below it is meshed too: its triangles lying on the slab lower plane belong to the slab
+	const int32 FirstLZ = FMath::Max(SlabMin - 1, 0);
+	
+	if (Batch)
 	{
-		// Account for normals
-		BoundsToQuery = BoundsToQuery.Extend(1);
+		// Already queried by the batch
+		MESHER_TIME_VALUES(DataSize * DataSize * DataSize, Batch->CopyValues(BoundsToQuery.Min, DataSize, CachedValues));
+		if (ShouldQueryDistanceFieldValues())
+		{
+			Batch->CopyDistanceFieldValues(ChunkPosition, GetDistanceFieldValues());
+		}
+		Accelerator = MakeUnique<FVoxelConstDataAccelerator>(Data, GetBoundsToLock(), &Batch->GetAccelerator());
 	}
-	TVoxelQueryZone<FVoxelValue> QueryZone(BoundsToQuery, FIntVector(DataSize), LOD, CachedValues);
-	MESHER_TIME_VALUES(DataSize * DataSize * DataSize, Data.Get<FVoxelValue>(QueryZone, LOD));
-	
-	Accelerator = MakeUnique<FVoxelConstDataAccelerator>(Data, GetBoundsToLock());
+	else
+	{
+		if (SlabMin == 0 && SlabMax == RENDER_CHUNK_SIZE)
+		{
+			QueryValues(Times, BoundsToQuery, CachedValues);
+		}
+		else
+		{
+			TVoxelQueryZone<FVoxelValue> QueryZone(BoundsToQuery, FIntVector(DataSize), LOD, CachedValues);
+
+			// Only query the layers used by the slab: its cells corners, and one more layer on each side for the normals
+			// The other values are left uninitialized and must not be read
+			FVoxelIntBox SlabBounds = BoundsToQuery;
+			SlabBounds.Min.Z = ChunkPosition.Z + (FirstLZ - 1) * Step;
+			SlabBounds.Max.Z = ChunkPosition.Z + (SlabMax + 2) * Step;
+			const TVoxelQueryZone<FVoxelValue> SlabQueryZone = QueryZone.ShrinkTo(SlabBounds);
+			MESHER_TIME_VALUES(DataSize * DataSize * (SlabQueryZone.Bounds.Size().Z / Step), Data.Get<FVoxelValue>(SlabQueryZone, LOD));
+		}
+
+		Accelerator = MakeUnique<FVoxelConstDataAccelerator>(Data, GetBoundsToLock());
+	}
+
+	const bool bUseSignBits = CVarUseRowSignBits.GetValueOnAnyThread() != 0;
 
-	uint32 VoxelIndex = 0;
+	uint32 VoxelIndex = FirstLZ * DataSize * DataSize;
 	if (LOD == 0) VoxelIndex += DataSize * DataSize; // Additional voxel for normals
-	for (int32 LZ = 0; LZ < RENDER_CHUNK_SIZE; LZ++)
+	for (int32 LZ = FirstLZ; LZ < SlabMax; LZ++)
 	{
+		// Check once per slice: cheap enough, and a slice is fast enough to not delay the exit too much
+		if (IsCanceled()) return false;
+		
 		if (LOD == 0) VoxelIndex += DataSize; // Additional voxel for normals
 		for (int32 LY = 0; LY < RENDER_CHUNK_SIZE; LY++)
 		{
 			if (LOD == 0) VoxelIndex += 1; // Additional voxel for normals
+
+			const uint32 RowVoxelIndex = VoxelIndex;
 			for (int32 LX = 0; LX < RENDER_CHUNK_SIZE; LX++)
 			{
-				{
-					CurrentCache[GetCacheIndex(0, LX, LY)] = -1; // Set EdgeIndex 0 to -1 if the cell isn't voxelized, eg all corners = 0
+				CurrentCache[GetCacheIndex(0, LX, LY)] = -1; // Set EdgeIndex 0 to -1 if the cell isn't voxelized, eg all corners = 0
+			}
 
+			// Compute the sign bits of the whole row at once, and only visit the cells with a nontrivial triangulation
+			// Cells must still be visited in increasing X order, as they reuse the vertices of the previous ones
+			FVoxelMarchingCubeSignBits::FRowMasks RowMasks;
+			uint64 CellsToVisit = (uint64(1) << RENDER_CHUNK_SIZE) - 1;
+			if (bUseSignBits)
+			{
+				RowMasks = FVoxelMarchingCubeSignBits::FRowMasks(CachedValues + RowVoxelIndex, DataSize, RENDER_CHUNK_SIZE);
+				CellsToVisit = RowMasks.GetActiveCells(RENDER_CHUNK_SIZE);
+			}
+			
+			while (CellsToVisit != 0)
+			{
+				const int32 LX = FMath::CountTrailingZeros64(CellsToVisit);
+				CellsToVisit &= CellsToVisit - 1;
+				VoxelIndex = RowVoxelIndex + LX;
+				{
 					uint32 CubeIndices[8];
 					CubeIndices[0] = VoxelIndex;
 					CubeIndices[1] = VoxelIndex + 1;
@@ -488,7 +901,7 @@ bool FVoxelMarchingCubeMesher::CreateGeometryTemplate(FVoxelMesherTimes& Times,
 					checkVoxelSlow(CubeIndices[6] < uint32(DataSize * DataSize * DataSize));
 					checkVoxelSlow(CubeIndices[7] < uint32(DataSize * DataSize * DataSize));
 
-					const uint32 CaseCode =
+					const uint32 CaseCode = bUseSignBits ? RowMasks.GetCaseCode(LX) :
 						(CachedValues[CubeIndices[0]].IsEmpty() << 0) |
 						(CachedValues[CubeIndices[1]].IsEmpty() << 1) |
 						(CachedValues[CubeIndices[2]].IsEmpty() << 2) |
@@ -497,12 +910,13 @@ bool FVoxelMarchingCubeMesher::CreateGeometryTemplate(FVoxelMesherTimes& Times,
 						(CachedValues[CubeIndices[5]].IsEmpty() << 5) |
 						(CachedValues[CubeIndices[6]].IsEmpty() << 6) |
 						(CachedValues[CubeIndices[7]].IsEmpty() << 7);
+					checkVoxelSlow(!bUseSignBits || (CaseCode != 0 && CaseCode != 255));
 
 					if (CaseCode != 0 && CaseCode != 255)
 					{
 						// Cell has a nontrivial triangulation
 
-						const uint8 ValidityMask = (LX != 0) + 2 * (LY != 0) + 4 * (LZ != 0);
+						const uint8 ValidityMask = (LX != 0) + 2 * (LY != 0) + 4 * (LZ != FirstLZ);
 
 						checkVoxelSlow(0 <= CaseCode && CaseCode < 256);
 						const uint8 CellClass = Transvoxel::regularCellClass[CaseCode];
@@ -722,9 +1136,8 @@ bool FVoxelMarchingCubeMesher::CreateGeometryTemplate(FVoxelMesherTimes& Times,
 						}
 					}
 				}
-
-				VoxelIndex++;
 			}
+			VoxelIndex = RowVoxelIndex + RENDER_CHUNK_SIZE;
 			VoxelIndex += 1; // End edge voxel
 			if (LOD == 0) VoxelIndex += 1; // Additional voxel for normals
 		}
@@ -776,12 +1189,12 @@ bool FVoxelMarchingCubeTransitionsMesher::CreateGeometryTemplate(FVoxelMesherTim
 	Accelerator = MakeUnique<FVoxelConstDataAccelerator>(Data, GetBoundsToLock());
 
 	bool bSuccess = true;
-	bSuccess &= CreateGeometryForDirection<EVoxelDirectionFlag::XMin>(Times, Indices, Vertices);
-	bSuccess &= CreateGeometryForDirection<EVoxelDirectionFlag::XMax>(Times, Indices, Vertices);
-	bSuccess &= CreateGeometryForDirection<EVoxelDirectionFlag::YMin>(Times, Indices, Vertices);
-	bSuccess &= CreateGeometryForDirection<EVoxelDirectionFlag::YMax>(Times, Indices, Vertices);
-	bSuccess &= CreateGeometryForDirection<EVoxelDirectionFlag::ZMin>(Times, Indices, Vertices);
-	bSuccess &= CreateGeometryForDirection<EVoxelDirectionFlag::ZMax>(Times, Indices, Vertices);
+	bSuccess &= !IsCanceled() && CreateGeometryForDirection<EVoxelDirectionFlag::XMin>(Times, Indices, Vertices);
+	bSuccess &= !IsCanceled() && CreateGeometryForDirection<EVoxelDirectionFlag::XMax>(Times, Indices, Vertices);
+	bSuccess &= !IsCanceled() && CreateGeometryForDirection<EVoxelDirectionFlag::YMin>(Times, Indices, Vertices);
+	bSuccess &= !IsCanceled() && CreateGeometryForDirection<EVoxelDirectionFlag::YMax>(Times, Indices, Vertices);
+	bSuccess &= !IsCanceled() && CreateGeometryForDirection<EVoxelDirectionFlag::ZMin>(Times, Indices, Vertices);
+	bSuccess &= !IsCanceled() && CreateGeometryForDirection<EVoxelDirectionFlag::ZMax>(Times, Indices, Vertices);
 	return bSuccess;
 }
 
@@ -791,9 +1204,9 @@ bool FVoxelMarchingCubeTransitionsMesher::CreateGeometryForDirection(FVoxelMeshe
 	if (!(TransitionsMask & Direction)) return true;
 	
 #if VOXEL_DEBUG
-	for (auto& Value : Cache2D)
+	for (int32 Index = 0; Index < Cache2DSize; Index++)
 	{
-		Value = -100;
+		Cache2D[Index] = -100;
 	}
 #endif
 
@@ -1094,20 +1507,27 @@ TVoxelSharedPtr<FVoxelChunkMesh> FVoxelMarchingCubeTransitionsMesher::CreateFull
 	};
 
 	TArray<uint32> Indices;
-	TArray<FLocalVertex> Vertices;
+	TVoxelMesherScratchArray<FLocalVertex> VerticesScratch;
+	TArray<FLocalVertex>& Vertices = *VerticesScratch;
 
 	if (!CreateGeometryTemplate(Times, Indices, Vertices))
 	{
+		UnlockData();
 		return {};
 	}
 
-	TArray<FVoxelMesherVertex> MesherVertices = FMarchingCubeHelpers::CreateMesherVertices(Vertices);
+	TVoxelMesherScratchArray<FVoxelMesherVertex> MesherVerticesScratch;
+	TArray<FVoxelMesherVertex>& MesherVertices = *MesherVerticesScratch;
+	FMarchingCubeHelpers::CreateMesherVertices(Vertices, MesherVertices);
 
 	MESHER_TIME_MATERIALS(MesherVertices.Num(), FMarchingCubeHelpers::ComputeMaterials(*this, MesherVertices, Vertices));
+	checkCanceled();
 	MESHER_TIME(Normals, FMarchingCubeHelpers::ComputeNormals(*this, MesherVertices, Indices));
 
 	UnlockData();
 
+	if (IsCanceled()) return {};
+
 	MESHER_TIME(UVs, FMarchingCubeHelpers::ComputeUVs(*this, MesherVertices));
 
 	// Can't translate if we don't have valid normals
@@ -1128,7 +1548,7 @@ TVoxelSharedPtr<FVoxelChunkMesh> FVoxelMarchingCubeTransitionsMesher::CreateFull
 	// Important: sanitize AFTER translating!
 	FVoxelMesherUtilities::SanitizeMesh(Indices, MesherVertices);
 
-	return MESHER_TIME_RETURN(CreateChunk, FVoxelMesherUtilities::CreateChunkFromVertices(Settings, LOD, MoveTemp(Indices), MoveTemp(MesherVertices)));
+	return MESHER_TIME_RETURN(CreateChunk, FVoxelMesherUtilities::CreateChunkFromVertices(Settings, LOD, MoveTemp(Indices), MesherVertices));
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -1173,4 +1593,5 @@ FORCEINLINE FIntVector FVoxelMarchingCubeTransitionsMesher::Local2DToGlobal(int3
 	}
 }
 
-#undef checkError
\ No newline at end of file
+#undef checkError
+#undef checkCanceled
\ No newline at end of file
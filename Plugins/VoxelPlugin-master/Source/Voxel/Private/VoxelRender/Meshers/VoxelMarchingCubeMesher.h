@@ -6,17 +6,75 @@
 #include "VoxelContainers/VoxelStaticArray.h"
 #include "VoxelData/VoxelDataAccelerator.h"
 #include "VoxelRender/Meshers/VoxelMesher.h"
+#include "VoxelRender/Meshers/VoxelMesherScratch.h"
 
 #define CHUNK_SIZE_WITH_END_EDGE (RENDER_CHUNK_SIZE + 1)
 #define CHUNK_SIZE_WITH_NORMALS (RENDER_CHUNK_SIZE + 3)
 
 #define EDGE_INDEX_COUNT 4
 
+class FVoxelDataLockInfo;
+struct FVoxelRendererSettings;
+
+// Data shared by adjacent chunks of the same LOD meshed in a single task (see FVoxelMesherBatchAsyncWork)
+// Takes one lock and does one padded value query for all of them, instead of one per chunk with overlapping borders
+class FVoxelMarchingCubeMesherBatch
+{
+public:
+	const FVoxelData& Data;
+	const int32 LOD;
+	const int32 Step;
+	// Union of the chunks bounds
+	const FVoxelIntBox ChunksBounds;
+	// If true, the values of the chunks distance fields are queried too
+	// The chunks can't query them themselves: the read lock is already held by this thread
+	const bool bHasDistanceFieldValues;
+
+	FVoxelMarchingCubeMesherBatch(const FVoxelData& Data, const FVoxelRendererSettings& Settings, int32 LOD, const FVoxelIntBox& ChunksBounds);
+	~FVoxelMarchingCubeMesherBatch();
+
+	void LockAndQueryValues();
+	void Unlock();
+
+	// Copy the values of a chunk query zone (DataSize^3 starting at QueryMin) to OutValues
+	void CopyValues(const FIntVector& QueryMin, int32 DataSize, FVoxelValue* RESTRICT OutValues) const;
+	// Copy the values of FVoxelChunkMesh::GetDistanceFieldValuesBounds to OutValues. Requires bHasDistanceFieldValues
+	void CopyDistanceFieldValues(const FIntVector& ChunkPosition, TArray<FVoxelValue>& OutValues) const;
+
+	const FVoxelConstDataAccelerator& GetAccelerator() const
+	{
+		return *Accelerator;
+	}
+
+private:
+	const FVoxelRendererSettings& Settings;
+	const FVoxelIntBox BoundsToQuery;
+	const FIntVector QuerySize;
+	
+	TArray<FVoxelValue> Values;
+	TUniquePtr<FVoxelDataLockInfo> LockInfo;
+	TUniquePtr<FVoxelConstDataAccelerator> Accelerator;
+};
+
 class FVoxelMarchingCubeMesher : public FVoxelMesher
 {
 public:
 	using FVoxelMesher::FVoxelMesher;
 
+	// Batch must be locked & queried, and must outlive the mesher
+	void SetBatch(const FVoxelMarchingCubeMesherBatch& InBatch)
+	{
+		check(InBatch.LOD == LOD);
+		check(InBatch.ChunksBounds.Contains(FVoxelIntBox(ChunkPosition, ChunkPosition + Size)));
+		Batch = &InBatch;
+		SetDataLockedExternally();
+	}
+	
+	// Only remesh the cells around DirtyBounds, and keep the other triangles of InPreviousChunk
+	void SetIncrementalUpdate(const FVoxelIntBox& DirtyBounds, const TVoxelSharedRef<const FVoxelChunkMesh>& InPreviousChunk);
+	
+	static bool CanUpdateIncrementally(const FVoxelRendererSettings& Settings);
+
 protected:
 	virtual FVoxelIntBox GetBoundsToCheckIsEmptyOn() const override final;
 	virtual FVoxelIntBox GetBoundsToLock() const override final;
@@ -38,14 +96,24 @@ public:
 
 private:
 	// Use LOD0 size as it's bigger
-	using FCachedValues = TVoxelStaticArray<FVoxelValue, CHUNK_SIZE_WITH_NORMALS * CHUNK_SIZE_WITH_NORMALS * CHUNK_SIZE_WITH_NORMALS>;
-	using FCache = TVoxelStaticArray<int32, RENDER_CHUNK_SIZE * RENDER_CHUNK_SIZE * EDGE_INDEX_COUNT>;
+	static constexpr int32 CachedValuesSize = CHUNK_SIZE_WITH_NORMALS * CHUNK_SIZE_WITH_NORMALS * CHUNK_SIZE_WITH_NORMALS;
+	static constexpr int32 CacheSize = RENDER_CHUNK_SIZE * RENDER_CHUNK_SIZE * EDGE_INDEX_COUNT;
 
-	TUniquePtr<FCachedValues> CachedValuesStorage = MakeUnique<FCachedValues>();
-	TUniquePtr<FCache> CacheStorageA = MakeUnique<FCache>();
-	TUniquePtr<FCache> CacheStorageB = MakeUnique<FCache>();
+	// Borrowed from the thread scratch pool instead of being allocated for every chunk
+	TVoxelMesherScratchArray<FVoxelValue> CachedValuesStorage{ CachedValuesSize };
+	TVoxelMesherScratchArray<int32> CacheStorageA{ CacheSize };
+	TVoxelMesherScratchArray<int32> CacheStorageB{ CacheSize };
 	
 	TUniquePtr<FVoxelConstDataAccelerator> Accelerator;
+	const FVoxelMarchingCubeMesherBatch* Batch = nullptr;
+
+	// Only the cells with SlabMin <= LZ < SlabMax are meshed. The rest is copied from PreviousChunk
+	TVoxelSharedPtr<const FVoxelChunkMesh> PreviousChunk;
+	int32 SlabMin = 0;
+	int32 SlabMax = RENDER_CHUNK_SIZE;
+
+	// Local Z range of the triangles owned by the slab, see FVoxelMesherUtilities::IsTriangleInSlab
+	void GetSlabZBounds(float& OutMinZ, float& OutMaxZ) const;
 
 	FVoxelValue* RESTRICT const CachedValues = CachedValuesStorage->GetData();
 
@@ -78,7 +146,10 @@ protected:
 
 private:
 	TUniquePtr<FVoxelConstDataAccelerator> Accelerator;
-	TVoxelStaticArray<int32, RENDER_CHUNK_SIZE * RENDER_CHUNK_SIZE * TRANSITION_EDGE_INDEX_COUNT> Cache2D;
+	static constexpr int32 Cache2DSize = RENDER_CHUNK_SIZE * RENDER_CHUNK_SIZE * TRANSITION_EDGE_INDEX_COUNT;
+	
+	TVoxelMesherScratchArray<int32> Cache2DStorage{ Cache2DSize };
+	int32* RESTRICT const Cache2D = Cache2DStorage->GetData();
 
 private:
 	// T: will be created as T(IntersectionPoint, MaterialPosition, bNeedToTranslate)
@@ -0,0 +1,90 @@
+// Copyright 2020 Phyronnaz
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VoxelValue.h"
+
+#if PLATFORM_ENABLE_VECTORINTRINSICS && !PLATFORM_ENABLE_VECTORINTRINSICS_NEON
+#define VOXEL_SSE2_SIGN_BITS 1
+#include <emmintrin.h>
+#else
+#define VOXEL_SSE2_SIGN_BITS 0
+#endif
+
+// Computes the IsEmpty bits of whole rows of values at once, to get the marching cubes case codes of a row of cells without branching on each corner
+namespace FVoxelMarchingCubeSignBits
+{
+	using FStorage = decltype(DeclVal<const FVoxelValue&>().GetStorage());
+	static_assert(sizeof(FVoxelValue) == sizeof(FStorage), "");
+
+	// Bit X is set if Values[X] is empty. Num must be <= 64
+	FORCEINLINE uint64 GetEmptyMask(const FVoxelValue* RESTRICT Values, int32 Num)
+	{
+		checkVoxelSlow(Num <= 64);
+
+		const FStorage* RESTRICT Storage = reinterpret_cast<const FStorage*>(Values);
+
+		uint64 Mask = 0;
+		int32 Index = 0;
+#if VOXEL_SSE2_SIGN_BITS
+		const __m128i Zero = _mm_setzero_si128();
+		for (; Index + 16 <= Num; Index += 16)
+		{
+#if EIGHT_BITS_VOXEL_VALUE
+			const __m128i Bytes = _mm_cmpgt_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(Storage + Index)), Zero);
+#else
+			const __m128i Low = _mm_cmpgt_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(Storage + Index)), Zero);
+			const __m128i High = _mm_cmpgt_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(Storage + Index + 8)), Zero);
+			// 0xFFFF -> 0xFF, 0 -> 0
+			const __m128i Bytes = _mm_packs_epi16(Low, High);
+#endif
+			Mask |= uint64(uint32(_mm_movemask_epi8(Bytes))) << Index;
+		}
+#endif
+		for (; Index < Num; Index++)
+		{
+			Mask |= uint64(Storage[Index] > 0) << Index;
+		}
+		return Mask;
+	}
+
+	// The 4 rows of corners of a row of cells: (Y, Z), (Y + 1, Z), (Y, Z + 1), (Y + 1, Z + 1)
+	struct FRowMasks
+	{
+		uint64 Masks[4] = {};
+
+		FRowMasks() = default;
+		FORCEINLINE FRowMasks(const FVoxelValue* RESTRICT RowValues, int32 DataSize, int32 NumCells)
+		{
+			Masks[0] = GetEmptyMask(RowValues, NumCells + 1);
+			Masks[1] = GetEmptyMask(RowValues + DataSize, NumCells + 1);
+			Masks[2] = GetEmptyMask(RowValues + DataSize * DataSize, NumCells + 1);
+			Masks[3] = GetEmptyMask(RowValues + DataSize + DataSize * DataSize, NumCells + 1);
+		}
+
+		// Bit X is set if cell X has both empty and full corners
+		FORCEINLINE uint64 GetActiveCells(int32 NumCells) const
+		{
+			uint64 AnyEmpty = 0;
+			uint64 AllEmpty = ~uint64(0);
+			for (uint64 Mask : Masks)
+			{
+				AnyEmpty |= Mask | (Mask >> 1);
+				AllEmpty &= Mask & (Mask >> 1);
+			}
+			const uint64 CellsMask = (uint64(1) << NumCells) - 1;
+			return AnyEmpty & ~AllEmpty & CellsMask;
+		}
+
+		// Same bit order as the CubeIndices in the mesher
+		FORCEINLINE uint32 GetCaseCode(int32 X) const
+		{
+			return
+				(uint32((Masks[0] >> X) & 3) << 0) |
+				(uint32((Masks[1] >> X) & 3) << 2) |
+				(uint32((Masks[2] >> X) & 3) << 4) |
+				(uint32((Masks[3] >> X) & 3) << 6);
+		}
+	};
+}
@@ -0,0 +1,566 @@
+// Copyright 2020 Phyronnaz
+
+#include "VoxelRender/Meshers/VoxelMeshSimplifier.h"
+#include "VoxelRender/VoxelChunkMesh.h"
+#include "VoxelRender/IVoxelRenderer.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/ThreadSafeCounter64.h"
+
+static TAutoConsoleVariable<int32> CVarSimplifyMeshes(
+	TEXT("voxel.mesher.Simplify"),
+	0,
+	TEXT("If true, main chunks with LOD >= voxel.mesher.SimplifyMinLOD are decimated after being meshed. Does not apply to cubic meshes"),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarSimplifyMinLOD(
+	TEXT("voxel.mesher.SimplifyMinLOD"),
+	3,
+	TEXT("Chunks with a LOD below this are never simplified"),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarSimplifyMaxError(
+	TEXT("voxel.mesher.SimplifyMaxError"),
+	0.25f,
+	TEXT("Max distance a simplified surface can move, in voxels of the chunk LOD: the tolerance in world voxels doubles with each LOD"),
+	ECVF_Default);
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Voxel Simplified Triangles Before"), STAT_VoxelSimplifiedTrianglesBefore, STATGROUP_VoxelCounters);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Voxel Simplified Triangles After"), STAT_VoxelSimplifiedTrianglesAfter, STATGROUP_VoxelCounters);
+
+static FThreadSafeCounter64 GVoxelSimplifiedTrianglesBefore;
+static FThreadSafeCounter64 GVoxelSimplifiedTrianglesAfter;
+static FThreadSafeCounter64 GVoxelSimplifiedBytesSaved;
+
+static FAutoConsoleCommand LogSimplificationStatsCmd(
+	TEXT("voxel.mesher.LogSimplificationStats"),
+	TEXT("Log the triangles and the mesh memory (also the GPU upload size) saved by voxel.mesher.Simplify. Resets the counters"),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		const int64 Before = FVoxelMeshSimplifier::GetNumTrianglesBefore();
+		const int64 After = FVoxelMeshSimplifier::GetNumTrianglesAfter();
+		LOG_VOXEL(Log, TEXT("Mesh simplification: %lld triangles -> %lld (%.2f%% removed), %.2fMB saved"),
+			Before,
+			After,
+			Before > 0 ? 100. * (Before - After) / Before : 0.,
+			FVoxelMeshSimplifier::GetNumBytesSaved() / double(1 << 20));
+		FVoxelMeshSimplifier::ResetStats();
+	}));
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+namespace FVoxelMeshSimplifierImpl
+{
+	// Symmetric 4x4 matrix, sum of the squared distances to planes
+	struct FQuadric
+	{
+		double A[10] = {};
+
+		FQuadric() = default;
+		FQuadric(double X, double Y, double Z, double W)
+		{
+			A[0] = X * X; A[1] = X * Y; A[2] = X * Z; A[3] = X * W;
+			A[4] = Y * Y; A[5] = Y * Z; A[6] = Y * W;
+			A[7] = Z * Z; A[8] = Z * W;
+			A[9] = W * W;
+		}
+
+		FORCEINLINE FQuadric& operator+=(const FQuadric& Other)
+		{
+			for (int32 Index = 0; Index < 10; Index++)
+			{
+				A[Index] += Other.A[Index];
+			}
+			return *this;
+		}
+		FORCEINLINE FQuadric operator+(const FQuadric& Other) const
+		{
+			FQuadric Result = *this;
+			Result += Other;
+			return Result;
+		}
+
+		FORCEINLINE double Evaluate(const FVector& P) const
+		{
+			const double X = P.X;
+			const double Y = P.Y;
+			const double Z = P.Z;
+			return
+				A[0] * X * X + 2 * A[1] * X * Y + 2 * A[2] * X * Z + 2 * A[3] * X +
+				A[4] * Y * Y + 2 * A[5] * Y * Z + 2 * A[6] * Y +
+				A[7] * Z * Z + 2 * A[8] * Z +
+				A[9];
+		}
+	};
+
+	FORCEINLINE int32 GetDataSize(const FVoxelChunkMeshBuffers& Buffer)
+	{
+		int32 DataSize =
+			Buffer.Indices.Num() * sizeof(uint32) +
+			Buffer.Positions.Num() * sizeof(FVector) +
+			Buffer.Normals.Num() * sizeof(FVector) +
+			Buffer.Tangents.Num() * sizeof(FVoxelProcMeshTangent) +
+			Buffer.Colors.Num() * sizeof(FColor);
+		for (auto& TextureCoordinates : Buffer.TextureCoordinates)
+		{
+			DataSize += TextureCoordinates.Num() * sizeof(FVector2D);
+		}
+		return DataSize;
+	}
+
+	// Edge collapse candidate. Outdated once the version of one of its vertices changes
+	struct FCollapse
+	{
+		double Error;
+		uint32 Removed;
+		uint32 Kept;
+		uint32 RemovedVersion;
+		uint32 KeptVersion;
+
+		// Min heap on the error
+		FORCEINLINE bool operator<(const FCollapse& Other) const
+		{
+			return Error < Other.Error;
+		}
+	};
+
+	// Below this, the triangle normal is considered flipped: cos(~78 degrees)
+	constexpr float MinNormalDot = 0.2f;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+bool FVoxelMeshSimplifier::ShouldSimplify(const FVoxelRendererSettings& Settings, int32 LOD)
+{
+	return
+		CVarSimplifyMeshes.GetValueOnAnyThread() != 0 &&
+		LOD >= CVarSimplifyMinLOD.GetValueOnAnyThread() &&
+		Settings.RenderType != EVoxelRenderType::Cubic;
+}
+
+void FVoxelMeshSimplifier::SimplifyChunk(FVoxelChunkMesh& Chunk, int32 LOD)
+{
+	VOXEL_ASYNC_FUNCTION_COUNTER();
+
+	const int32 Step = 1 << LOD;
+	const float MaxError = FMath::Max(0.f, CVarSimplifyMaxError.GetValueOnAnyThread()) * Step;
+	// Transvoxel translates the vertices in the first cell of the chunk: lock them all
+	Chunk.IterateBuffers([&](FVoxelChunkMeshBuffers& Buffer)
+	{
+		SimplifyBuffer(Buffer, FMath::Square(MaxError), RENDER_CHUNK_SIZE * Step, Step);
+	});
+}
+
+void FVoxelMeshSimplifier::SimplifyBuffer(FVoxelChunkMeshBuffers& Buffer, float MaxSquaredError, float ChunkSize, float BorderSize)
+{
+	VOXEL_ASYNC_FUNCTION_COUNTER();
+	using namespace FVoxelMeshSimplifierImpl;
+
+	const int32 NumVertices = Buffer.GetNumVertices();
+	const int32 NumTriangles = Buffer.Indices.Num() / 3;
+	check(Buffer.Indices.Num() % 3 == 0);
+	if (NumTriangles == 0)
+	{
+		return;
+	}
+
+	const int32 DataSizeBefore = GetDataSize(Buffer);
+
+	uint32* RESTRICT Indices = Buffer.Indices.GetData();
+	const FVector* RESTRICT Positions = Buffer.Positions.GetData();
+
+	const auto ComputeNormal = [&](uint32 A, uint32 B, uint32 C)
+	{
+		return FVector::CrossProduct(Positions[B] - Positions[A], Positions[C] - Positions[A]);
+	};
+
+	TArray<FQuadric> Quadrics;
+	Quadrics.SetNum(NumVertices);
+	TArray<FVector> TriangleNormals;
+	TriangleNormals.SetNumUninitialized(NumTriangles);
+	{
+		VOXEL_ASYNC_SCOPE_COUNTER("Quadrics");
+		for (int32 Triangle = 0; Triangle < NumTriangles; Triangle++)
+		{
+			const uint32* Triangle3 = Indices + 3 * Triangle;
+			const FVector Normal = ComputeNormal(Triangle3[0], Triangle3[1], Triangle3[2]).GetSafeNormal();
+			TriangleNormals[Triangle] = Normal;
+
+			const FQuadric Quadric(Normal.X, Normal.Y, Normal.Z, -FVector::DotProduct(Normal, Positions[Triangle3[0]]));
+			for (int32 Corner = 0; Corner < 3; Corner++)
+			{
+				Quadrics[Triangle3[Corner]] += Quadric;
+			}
+		}
+	}
+
+	TBitArray<> LockedVertices(false, NumVertices);
+	{
+		VOXEL_ASYNC_SCOPE_COUNTER("Lock Vertices");
+		for (int32 Vertex = 0; Vertex < NumVertices; Vertex++)
+		{
+			const FVector& P = Positions[Vertex];
+			if (P.GetMin() <= BorderSize || P.GetMax() >= ChunkSize - BorderSize)
+			{
+				LockedVertices[Vertex] = true;
+			}
+		}
+
+		// Edges used by a single triangle are on a hole or on a seam with another buffer
+		TMap<uint64, int32> EdgeCounts;
+		EdgeCounts.Reserve(3 * NumTriangles);
+		for (int32 Index = 0; Index < 3 * NumTriangles; Index++)
+		{
+			const uint32 A = Indices[Index];
+			const uint32 B = Indices[Index - Index % 3 + (Index + 1) % 3];
+			EdgeCounts.FindOrAdd(uint64(FMath::Min(A, B)) << 32 | FMath::Max(A, B))++;
+		}
+		for (auto& It : EdgeCounts)
+		{
+			if (It.Value != 2)
+			{
+				LockedVertices[uint32(It.Key >> 32)] = true;
+				LockedVertices[uint32(It.Key)] = true;
+			}
+		}
+
+		// The materials are packed in the colors and in the UV channels after the first one
+		// A vertex can only be collapsed if all its neighbors have the same material, else it would bleed over them
+		const FColor* RESTRICT Colors = Buffer.Colors.Num() == NumVertices ? Buffer.Colors.GetData() : nullptr;
+		TArray<const FVector2D*, TInlineAllocator<4>> MaterialUVs;
+		for (int32 Channel = 1; Channel < Buffer.TextureCoordinates.Num(); Channel++)
+		{
+			if (Buffer.TextureCoordinates[Channel].Num() == NumVertices)
+			{
+				MaterialUVs.Add(Buffer.TextureCoordinates[Channel].GetData());
+			}
+		}
+		const auto HaveSameMaterial = [&](uint32 A, uint32 B)
+		{
+			if (Colors && Colors[A] != Colors[B])
+			{
+				return false;
+			}
+			for (const FVector2D* UVs : MaterialUVs)
+			{
+				if (UVs[A] != UVs[B])
+				{
+					return false;
+				}
+			}
+			return true;
+		};
+		if (Colors || MaterialUVs.Num() > 0)
+		{
+			for (auto& It : EdgeCounts)
+			{
+				const uint32 A = uint32(It.Key >> 32);
+				const uint32 B = uint32(It.Key);
+				if (!HaveSameMaterial(A, B))
+				{
+					LockedVertices[A] = true;
+					LockedVertices[B] = true;
+				}
+			}
+		}
+	}
+
+	// Vertex -> triangles. The lists of vertices receiving a collapse are appended at the end of Refs
+	TArray<int32> RefStarts;
+	TArray<int32> RefCounts;
+	TArray<int32> Refs;
+	RefStarts.SetNumZeroed(NumVertices);
+	RefCounts.SetNumZeroed(NumVertices);
+	{
+		VOXEL_ASYNC_SCOPE_COUNTER("Adjacency");
+		for (int32 Index = 0; Index < 3 * NumTriangles; Index++)
+		{
+			RefCounts[Indices[Index]]++;
+		}
+		int32 Start = 0;
+		for (int32 Vertex = 0; Vertex < NumVertices; Vertex++)
+		{
+			RefStarts[Vertex] = Start;
+			Start += RefCounts[Vertex];
+			RefCounts[Vertex] = 0;
+		}
+		Refs.SetNumUninitialized(Start);
+		for (int32 Index = 0; Index < 3 * NumTriangles; Index++)
+		{
+			const uint32 Vertex = Indices[Index];
+			Refs[RefStarts[Vertex] + RefCounts[Vertex]++] = Index / 3;
+		}
+	}
+
+	TBitArray<> DeletedTriangles(false, NumTriangles);
+	TBitArray<> RemovedVertices(false, NumVertices);
+
+	const auto HasVertex = [&](int32 Triangle, uint32 Vertex)
+	{
+		const uint32* Triangle3 = Indices + 3 * Triangle;
+		return Triangle3[0] == Vertex || Triangle3[1] == Vertex || Triangle3[2] == Vertex;
+	};
+
+	// Collapsing Removed onto Kept must not fold triangles, and Removed & Kept must share exactly 2 neighbors (link condition)
+	const auto CanCollapse = [&](uint32 Removed, uint32 Kept)
+	{
+		TArray<uint32, TInlineAllocator<16>> RemovedNeighbors;
+		for (int32 Ref = RefStarts[Removed]; Ref < RefStarts[Removed] + RefCounts[Removed]; Ref++)
+		{
+			const int32 Triangle = Refs[Ref];
+			if (DeletedTriangles[Triangle]) continue;
+
+			const uint32* Triangle3 = Indices + 3 * Triangle;
+			for (int32 Corner = 0; Corner < 3; Corner++)
+			{
+				if (Triangle3[Corner] != Removed)
+				{
+					RemovedNeighbors.AddUnique(Triangle3[Corner]);
+				}
+			}
+
+			if (HasVertex(Triangle, Kept)) continue;
+
+			const uint32 A = Triangle3[0] == Removed ? Kept : Triangle3[0];
+			const uint32 B = Triangle3[1] == Removed ? Kept : Triangle3[1];
+			const uint32 C = Triangle3[2] == Removed ? Kept : Triangle3[2];
+			const FVector NewNormal = ComputeNormal(A, B, C);
+			if (NewNormal.SizeSquared() < SMALL_NUMBER ||
+				FVector::DotProduct(NewNormal.GetUnsafeNormal(), TriangleNormals[Triangle]) < MinNormalDot)
+			{
+				return false;
+			}
+		}
+
+		int32 NumSharedNeighbors = 0;
+		TArray<uint32, TInlineAllocator<16>> KeptNeighbors;
+		for (int32 Ref = RefStarts[Kept]; Ref < RefStarts[Kept] + RefCounts[Kept]; Ref++)
+		{
+			const int32 Triangle = Refs[Ref];
+			if (DeletedTriangles[Triangle]) continue;
+
+			const uint32* Triangle3 = Indices + 3 * Triangle;
+			for (int32 Corner = 0; Corner < 3; Corner++)
+			{
+				const uint32 Neighbor = Triangle3[Corner];
+				if (Neighbor != Kept && !KeptNeighbors.Contains(Neighbor))
+				{
+					KeptNeighbors.Add(Neighbor);
+					NumSharedNeighbors += RemovedNeighbors.Contains(Neighbor);
+				}
+			}
+		}
+		return NumSharedNeighbors == 2;
+	};
+
+	const auto Collapse = [&](uint32 Removed, uint32 Kept)
+	{
+		const int32 NewStart = Refs.Num();
+		for (int32 Ref = RefStarts[Removed]; Ref < RefStarts[Removed] + RefCounts[Removed]; Ref++)
+		{
+			const int32 Triangle = Refs[Ref];
+			if (DeletedTriangles[Triangle]) continue;
+
+			if (HasVertex(Triangle, Kept))
+			{
+				DeletedTriangles[Triangle] = true;
+				continue;
+			}
+
+			uint32* Triangle3 = Indices + 3 * Triangle;
+			for (int32 Corner = 0; Corner < 3; Corner++)
+			{
+				if (Triangle3[Corner] == Removed)
+				{
+					Triangle3[Corner] = Kept;
+				}
+			}
+			TriangleNormals[Triangle] = ComputeNormal(Triangle3[0], Triangle3[1], Triangle3[2]).GetSafeNormal();
+			Refs.Add(Triangle);
+		}
+		for (int32 Ref = RefStarts[Kept]; Ref < RefStarts[Kept] + RefCounts[Kept]; Ref++)
+		{
+			const int32 Triangle = Refs[Ref];
+			if (DeletedTriangles[Triangle]) continue;
+			Refs.Add(Triangle);
+		}
+		RefStarts[Kept] = NewStart;
+		RefCounts[Kept] = Refs.Num() - NewStart;
+
+		Quadrics[Kept] += Quadrics[Removed];
+		RemovedVertices[Removed] = true;
+	};
+
+	// Incremented when the quadric or the triangles of a vertex change, to skip the outdated collapses in the heap
+	TArray<uint32> VertexVersions;
+	VertexVersions.SetNumZeroed(NumVertices);
+
+	TArray<FCollapse> Heap;
+	const auto PushCollapse = [&](uint32 A, uint32 B)
+	{
+		if (LockedVertices[A] && LockedVertices[B]) return;
+
+		const FQuadric Quadric = Quadrics[A] + Quadrics[B];
+		const double ErrorAToB = LockedVertices[A] ? MAX_dbl : Quadric.Evaluate(Positions[B]);
+		const double ErrorBToA = LockedVertices[B] ? MAX_dbl : Quadric.Evaluate(Positions[A]);
+
+		const double Error = FMath::Min(ErrorAToB, ErrorBToA);
+		if (Error > MaxSquaredError) return;
+
+		const uint32 Removed = ErrorAToB <= ErrorBToA ? A : B;
+		const uint32 Kept = ErrorAToB <= ErrorBToA ? B : A;
+		Heap.HeapPush({ Error, Removed, Kept, VertexVersions[Removed], VertexVersions[Kept] });
+	};
+
+	{
+		VOXEL_ASYNC_SCOPE_COUNTER("Build Heap");
+		Heap.Reserve(2 * NumTriangles);
+		for (int32 Index = 0; Index < 3 * NumTriangles; Index++)
+		{
+			const uint32 A = Indices[Index];
+			const uint32 B = Indices[Index - Index % 3 + (Index + 1) % 3];
+			// Each inner edge is used by 2 triangles with opposite windings: only add it once. Open edges are locked
+			if (A < B)
+			{
+				PushCollapse(A, B);
+			}
+		}
+	}
+
+	{
+		VOXEL_ASYNC_SCOPE_COUNTER("Collapse");
+		// Always collapse the edge with the lowest error first
+		while (Heap.Num() > 0)
+		{
+			FCollapse Candidate;
+			Heap.HeapPop(Candidate, false);
+
+			if (RemovedVertices[Candidate.Removed] ||
+				RemovedVertices[Candidate.Kept] ||
+				VertexVersions[Candidate.Removed] != Candidate.RemovedVersion ||
+				VertexVersions[Candidate.Kept] != Candidate.KeptVersion)
+			{
+				continue;
+			}
+			if (!CanCollapse(Candidate.Removed, Candidate.Kept)) continue;
+
+			Collapse(Candidate.Removed, Candidate.Kept);
+			VertexVersions[Candidate.Removed]++;
+			VertexVersions[Candidate.Kept]++;
+
+			// The quadric of Kept changed: update the errors of all its edges
+			TArray<uint32, TInlineAllocator<16>> Neighbors;
+			for (int32 Ref = RefStarts[Candidate.Kept]; Ref < RefStarts[Candidate.Kept] + RefCounts[Candidate.Kept]; Ref++)
+			{
+				const int32 Triangle = Refs[Ref];
+				if (DeletedTriangles[Triangle]) continue;
+
+				const uint32* Triangle3 = Indices + 3 * Triangle;
+				for (int32 Corner = 0; Corner < 3; Corner++)
+				{
+					if (Triangle3[Corner] != Candidate.Kept)
+					{
+						Neighbors.AddUnique(Triangle3[Corner]);
+					}
+				}
+			}
+			for (uint32 Neighbor : Neighbors)
+			{
+				PushCollapse(Candidate.Kept, Neighbor);
+			}
+		}
+	}
+
+	{
+		VOXEL_ASYNC_SCOPE_COUNTER("Compact");
+
+		TBitArray<> UsedVertices(false, NumVertices);
+		int32 WriteIndex = 0;
+		for (int32 Triangle = 0; Triangle < NumTriangles; Triangle++)
+		{
+			if (DeletedTriangles[Triangle]) continue;
+			for (int32 Corner = 0; Corner < 3; Corner++)
+			{
+				const uint32 Vertex = Indices[3 * Triangle + Corner];
+				checkVoxelSlow(!RemovedVertices[Vertex]);
+				UsedVertices[Vertex] = true;
+				Indices[WriteIndex++] = Vertex;
+			}
+		}
+		Buffer.Indices.SetNum(WriteIndex, false);
+
+		TArray<uint32> NewIndices;
+		NewIndices.SetNumUninitialized(NumVertices);
+
+		const bool bHasNormals = Buffer.Normals.Num() == NumVertices;
+		const bool bHasTangents = Buffer.Tangents.Num() == NumVertices;
+		const bool bHasColors = Buffer.Colors.Num() == NumVertices;
+
+		int32 NewNumVertices = 0;
+		for (int32 Vertex = 0; Vertex < NumVertices; Vertex++)
+		{
+			if (!UsedVertices[Vertex]) continue;
+
+			NewIndices[Vertex] = NewNumVertices;
+			Buffer.Positions[NewNumVertices] = Buffer.Positions[Vertex];
+			if (bHasNormals) Buffer.Normals[NewNumVertices] = Buffer.Normals[Vertex];
+			if (bHasTangents) Buffer.Tangents[NewNumVertices] = Buffer.Tangents[Vertex];
+			if (bHasColors) Buffer.Colors[NewNumVertices] = Buffer.Colors[Vertex];
+			for (auto& TextureCoordinates : Buffer.TextureCoordinates)
+			{
+				TextureCoordinates[NewNumVertices] = TextureCoordinates[Vertex];
+			}
+			NewNumVertices++;
+		}
+
+		Buffer.Positions.SetNum(NewNumVertices, false);
+		if (bHasNormals) Buffer.Normals.SetNum(NewNumVertices, false);
+		if (bHasTangents) Buffer.Tangents.SetNum(NewNumVertices, false);
+		if (bHasColors) Buffer.Colors.SetNum(NewNumVertices, false);
+		for (auto& TextureCoordinates : Buffer.TextureCoordinates)
+		{
+			TextureCoordinates.SetNum(NewNumVertices, false);
+		}
+
+		for (uint32& Index : Buffer.Indices)
+		{
+			Index = NewIndices[Index];
+		}
+	}
+
+	const int32 NewNumTriangles = Buffer.Indices.Num() / 3;
+	INC_DWORD_STAT_BY(STAT_VoxelSimplifiedTrianglesBefore, NumTriangles);
+	INC_DWORD_STAT_BY(STAT_VoxelSimplifiedTrianglesAfter, NewNumTriangles);
+	GVoxelSimplifiedTrianglesBefore.Add(NumTriangles);
+	GVoxelSimplifiedTrianglesAfter.Add(NewNumTriangles);
+	GVoxelSimplifiedBytesSaved.Add(DataSizeBefore - GetDataSize(Buffer));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+int64 FVoxelMeshSimplifier::GetNumTrianglesBefore()
+{
+	return GVoxelSimplifiedTrianglesBefore.GetValue();
+}
+
+int64 FVoxelMeshSimplifier::GetNumTrianglesAfter()
+{
+	return GVoxelSimplifiedTrianglesAfter.GetValue();
+}
+
+int64 FVoxelMeshSimplifier::GetNumBytesSaved()
+{
+	return GVoxelSimplifiedBytesSaved.GetValue();
+}
+
+void FVoxelMeshSimplifier::ResetStats()
+{
+	GVoxelSimplifiedTrianglesBefore.Reset();
+	GVoxelSimplifiedTrianglesAfter.Reset();
+	GVoxelSimplifiedBytesSaved.Reset();
+}
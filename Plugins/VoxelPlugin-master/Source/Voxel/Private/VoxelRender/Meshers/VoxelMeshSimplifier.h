@@ -0,0 +1,33 @@
+// Copyright 2020 Phyronnaz
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FVoxelRendererSettings;
+struct FVoxelChunkMesh;
+struct FVoxelChunkMeshBuffers;
+
+// Quadric error edge collapse decimation of distant chunks
+namespace FVoxelMeshSimplifier
+{
+	// Whether main chunks of this LOD are simplified once meshed
+	bool ShouldSimplify(const FVoxelRendererSettings& Settings, int32 LOD);
+
+	// The error tolerance scales with the voxel size of the LOD
+	void SimplifyChunk(FVoxelChunkMesh& Chunk, int32 LOD);
+
+	/**
+	 * Collapses edges onto one of their vertices while the quadric error (squared distance to the original planes) stays below MaxSquaredError
+	 * The edges are collapsed by increasing error, using a min heap whose outdated entries are skipped when popped
+	 * Vertices closer than BorderSize to the chunk bounds [0, ChunkSize] are locked, so that neighbors & transitions stay watertight
+	 * Vertices on open edges (eg material boundaries between buffers) are locked too, as are vertices with a neighbor of a different material (colors or UV channels > 0)
+	 * Collapses are then only between vertices of the same material, and collapsing onto an existing vertex keeps all its attributes valid
+	 */
+	void SimplifyBuffer(FVoxelChunkMeshBuffers& Buffer, float MaxSquaredError, float ChunkSize, float BorderSize);
+
+	int64 GetNumTrianglesBefore();
+	int64 GetNumTrianglesAfter();
+	int64 GetNumBytesSaved();
+	void ResetStats();
+}
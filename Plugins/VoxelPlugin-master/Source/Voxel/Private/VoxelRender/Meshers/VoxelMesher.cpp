@@ -1,6 +1,8 @@
 // Copyright 2020 Phyronnaz
 
 #include "VoxelRender/Meshers/VoxelMesher.h"
+#include "VoxelRender/Meshers/VoxelMeshSimplifier.h"
+#include "VoxelRender/Meshers/VoxelMesherScratch.h"
 #include "VoxelRender/VoxelMesherAsyncWork.h"
 #include "VoxelRender/VoxelChunkMesh.h"
 #include "VoxelRender/IVoxelRenderer.h"
@@ -17,6 +19,12 @@ static TAutoConsoleVariable<int32> CVarDoNotSkipEmptyChunks(
 	TEXT("If true, all chunks will be computed"),
 	ECVF_Default);
 
+static TAutoConsoleVariable<int32> CVarShareDistanceFieldValues(
+	TEXT("voxel.mesher.ShareDistanceFieldValues"),
+	1,
+	TEXT("If true, meshers will query the distance field values along their own values, instead of the distance field locking and querying them again"),
+	ECVF_Default);
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
@@ -122,7 +130,7 @@ struct FVoxelMesherStats
 
 			LODToMeans.KeySort(TLess<int32>());
 
-			LOG_VOXEL(Log, TEXT("\tLOD; Chunks (%%)     ; Total (%%)         ; Avg       ; Values (%%)        , Per Voxel ; Materials (%%)     , Per Voxel ; Normals (%%)       ; UVs (%%)           ; CreateChunk (%%)   ; FinishCreatingChunk (%%); DistanceFields (%%)"));
+			LOG_VOXEL(Log, TEXT("\tLOD; Chunks (%%)     ; Total (%%)         ; Avg       ; Chunks/s ; Values (%%)        , Per Voxel ; Materials (%%)     , Per Voxel ; Normals (%%)       ; UVs (%%)           ; CreateChunk (%%)   ; FinishCreatingChunk (%%); DistanceFields (%%)"));
 			for (auto& It : LODToMeans)
 			{
 				auto& V = It.Value;
@@ -134,13 +142,14 @@ struct FVoxelMesherStats
 
 				TotalDistanceFieldsTime += V.DistanceFieldTime;
 				
-				LOG_VOXEL(Log, TEXT("\t %2d: %6d (%5.2f%%); %8.3fs (%5.2f%%); %8.3fms; %8.3fs (%5.2f%%), %8.1fns; %8.3fs (%5.2f%%), %8.1fns; %8.3fs (%5.2f%%); %8.3fs (%5.2f%%); %8.3fs (%5.2f%%);      %8.3fs (%5.2f%%); %8.3fs (%5.2f%%)"),
+				LOG_VOXEL(Log, TEXT("\t %2d: %6d (%5.2f%%); %8.3fs (%5.2f%%); %8.3fms; %8.1f; %8.3fs (%5.2f%%), %8.1fns; %8.3fs (%5.2f%%), %8.1fns; %8.3fs (%5.2f%%); %8.3fs (%5.2f%%); %8.3fs (%5.2f%%);      %8.3fs (%5.2f%%); %8.3fs (%5.2f%%)"),
 					It.Key,
 					V.Count,
 					V.Count / double(Stats.Num()) * 100,
 					V.TotalTime,
 					V.TotalTime / GlobalTotalTime * 100,
 					V.TotalTime / It.Value.Count * 1000,
+					V.TotalTime > 0 ? V.Count / V.TotalTime : 0, // Single thread throughput
 					
 					V.ValuesTime,
 					V.ValuesTime / V.TotalTime * 100,
@@ -235,12 +244,68 @@ FVoxelMesherBase::~FVoxelMesherBase()
 
 void FVoxelMesherBase::UnlockData()
 {
+	if (bDataLockedExternally) return;
 	Data.Unlock(MoveTemp(LockInfo));
 }
 
 void FVoxelMesherBase::LockData()
 {
-	LockInfo = Data.Lock(EVoxelLockType::Read, GetBoundsToLock(), "Mesher");
+	if (bDataLockedExternally) return;
+
+	FVoxelIntBox BoundsToLock = GetBoundsToLock();
+	if (bQueryDistanceFieldValues)
+	{
+		BoundsToLock = BoundsToLock + FVoxelChunkMesh::GetDistanceFieldValuesBounds(LOD, ChunkPosition, Settings);
+	}
+	LockInfo = Data.Lock(EVoxelLockType::Read, BoundsToLock, "Mesher");
+}
+
+inline void CopyValuesBlock(
+	const FVoxelValue* RESTRICT Src, const FIntVector& SrcSize,
+	FVoxelValue* RESTRICT Dst, const FIntVector& DstSize,
+	const FIntVector& DstOffsetInSrc)
+{
+	for (int32 Z = 0; Z < DstSize.Z; Z++)
+	{
+		for (int32 Y = 0; Y < DstSize.Y; Y++)
+		{
+			const FIntVector SrcPosition = DstOffsetInSrc + FIntVector(0, Y, Z);
+			FMemory::Memcpy(
+				Dst + Y * DstSize.X + Z * DstSize.X * DstSize.Y,
+				Src + SrcPosition.X + SrcPosition.Y * SrcSize.X + SrcPosition.Z * SrcSize.X * SrcSize.Y,
+				DstSize.X * sizeof(FVoxelValue));
+		}
+	}
+}
+
+void FVoxelMesherBase::QueryValues(FVoxelMesherTimes& Times, const FVoxelIntBox& Bounds, FVoxelValue* RESTRICT Values)
+{
+	const FIntVector ValuesSize = Bounds.Size() / Step;
+	if (!bQueryDistanceFieldValues || bDataLockedExternally)
+	{
+		TVoxelQueryZone<FVoxelValue> QueryZone(Bounds, ValuesSize, LOD, Values);
+		MESHER_TIME_VALUES(ValuesSize.X * ValuesSize.Y * ValuesSize.Z, Data.Get<FVoxelValue>(QueryZone, LOD));
+		return;
+	}
+
+	VOXEL_ASYNC_FUNCTION_COUNTER();
+
+	// Both blocks are on the same LOD grid and overlap almost entirely: query their union once
+	const FVoxelIntBox DistanceFieldBounds = FVoxelChunkMesh::GetDistanceFieldValuesBounds(LOD, ChunkPosition, Settings);
+	const FVoxelIntBox UnionBounds = Bounds + DistanceFieldBounds;
+	const FIntVector UnionSize = UnionBounds.Size() / Step;
+	
+	TVoxelMesherScratchArray<FVoxelValue> UnionValues(UnionSize.X * UnionSize.Y * UnionSize.Z);
+	{
+		TVoxelQueryZone<FVoxelValue> QueryZone(UnionBounds, UnionSize, LOD, UnionValues->GetData());
+		MESHER_TIME_VALUES(UnionSize.X * UnionSize.Y * UnionSize.Z, Data.Get<FVoxelValue>(QueryZone, LOD));
+	}
+
+	CopyValuesBlock(UnionValues->GetData(), UnionSize, Values, ValuesSize, (Bounds.Min - UnionBounds.Min) / Step);
+
+	const FIntVector DistanceFieldSize = DistanceFieldBounds.Size() / Step;
+	DistanceFieldValues.SetNumUninitialized(DistanceFieldSize.X * DistanceFieldSize.Y * DistanceFieldSize.Z);
+	CopyValuesBlock(UnionValues->GetData(), UnionSize, DistanceFieldValues.GetData(), DistanceFieldSize, (DistanceFieldBounds.Min - UnionBounds.Min) / Step);
 }
 
 bool FVoxelMesherBase::IsEmpty() const
@@ -284,9 +349,18 @@ TVoxelSharedPtr<FVoxelChunkMesh> FVoxelMesherBase::CreateEmptyChunk() const
 
 void FVoxelMesherBase::FinishCreatingChunk(FVoxelChunkMesh& Chunk) const
 {
+	// Before optimizing the indices, as it changes them
+	if (!bIsTransitions && FVoxelMeshSimplifier::ShouldSimplify(Settings, LOD))
+	{
+		FVoxelMeshSimplifier::SimplifyChunk(Chunk, LOD);
+	}
 	if (Settings.bOptimizeIndices)
 	{
-		Chunk.IterateBuffers([](auto& Buffer) { Buffer.OptimizeIndices(); });
+		Chunk.IterateBuffers([&](FVoxelChunkMeshBuffers& Buffer) { Buffer.OptimizeIndices(Settings.IndicesOptimizer); });
+		if (Settings.bOptimizeVertexFetch)
+		{
+			Chunk.IterateBuffers([](FVoxelChunkMeshBuffers& Buffer) { Buffer.OptimizeVertexFetch(); });
+		}
 	}
 	Chunk.IterateBuffers([](FVoxelChunkMeshBuffers& Buffer) { Buffer.Shrink(); });
 	Chunk.IterateBuffers([](FVoxelChunkMeshBuffers& Buffer) { Buffer.ComputeBounds(); });
@@ -309,11 +383,17 @@ TVoxelSharedPtr<FVoxelChunkMesh> FVoxelMesher::CreateFullChunk()
 {
 	VOXEL_SCOPE_COUNTER_FORMAT("Creating Chunk LOD=%d", LOD);
 
+	if (IsCanceled()) return nullptr;
+
 	{
 		VOXEL_ASYNC_SCOPE_COUNTER("InitArea");
 		Data.WorldGenerator->InitArea(FVoxelIntBox(ChunkPosition, ChunkPosition + Step * RENDER_CHUNK_SIZE), LOD);
 	}
 
+	const bool bBuildDistanceField = LOD <= Settings.MaxDistanceFieldLOD;
+	// If the data is locked externally, the distance field can't lock it again: it must use values queried with the mesher ones
+	bQueryDistanceFieldValues = bBuildDistanceField && (bDataLockedExternally || CVarShareDistanceFieldValues.GetValueOnAnyThread() != 0);
+
 	LockData();
 
 	TVoxelSharedPtr<FVoxelChunkMesh> Chunk;
@@ -331,6 +411,9 @@ TVoxelSharedPtr<FVoxelChunkMesh> FVoxelMesher::CreateFullChunk()
 		Chunk = CreateFullChunkImpl(Times);
 		check(!LockInfo.IsValid());
 
+		// Don't bother finishing the chunk if we were canceled
+		if (IsCanceled()) return nullptr;
+
 		if (Chunk.IsValid())
 		{
 			{
@@ -338,10 +421,11 @@ TVoxelSharedPtr<FVoxelChunkMesh> FVoxelMesher::CreateFullChunk()
 				FinishCreatingChunk(*Chunk);
 			}
 
-			if (LOD <= Settings.MaxDistanceFieldLOD)
+			if (bBuildDistanceField && !IsCanceled() && ensure(!bDataLockedExternally || DistanceFieldValues.Num() > 0))
 			{
 				MESHER_TIME_SCOPE(DistanceField)
-				Chunk->BuildDistanceField(LOD, ChunkPosition, Data, Settings);
+				// DistanceFieldValues is empty if the mesher didn't use QueryValues: the distance field will query them
+				Chunk->BuildDistanceField(LOD, ChunkPosition, Data, Settings, DistanceFieldValues);
 			}
 		}
 
@@ -400,6 +484,8 @@ TVoxelSharedPtr<FVoxelChunkMesh> FVoxelTransitionsMesher::CreateFullChunk()
 
 	check(TransitionsMask);
 
+	if (IsCanceled()) return nullptr;
+
 	LockData();
 	
 	TVoxelSharedPtr<FVoxelChunkMesh> Chunk;
@@ -417,6 +503,8 @@ TVoxelSharedPtr<FVoxelChunkMesh> FVoxelTransitionsMesher::CreateFullChunk()
 		Chunk = CreateFullChunkImpl(Times);
 		check(!LockInfo.IsValid());
 
+		if (IsCanceled()) return nullptr;
+
 		if (Chunk.IsValid())
 		{
 			MESHER_TIME_SCOPE(FinishCreatingChunk)
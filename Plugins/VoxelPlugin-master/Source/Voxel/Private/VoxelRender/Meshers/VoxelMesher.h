@@ -4,7 +4,9 @@
 
 #include "CoreMinimal.h"
 #include "VoxelIntBox.h"
+#include "VoxelValue.h"
 #include "VoxelMinimal.h"
+#include "VoxelCancelCounter.h"
 
 struct FVoxelRendererSettings;
 struct FVoxelChunkMesh;
@@ -91,14 +93,48 @@ public:
 	
 	TVoxelSharedPtr<FVoxelChunkMesh> CreateEmptyChunk() const;
 
+	// If set, the mesher will check it regularly and exit early if canceled
+	// CreateFullChunk will then return null: use IsCanceled to tell it apart from a failure
+	void SetCancelCounter(const FVoxelCancelCounter& InCancelCounter)
+	{
+		CancelCounter.Emplace(InCancelCounter);
+	}
+	FORCEINLINE bool IsCanceled() const
+	{
+		return CancelCounter.IsSet() && CancelCounter->IsCanceled();
+	}
+
 protected:
 	virtual FVoxelIntBox GetBoundsToCheckIsEmptyOn() const = 0;
 	virtual FVoxelIntBox GetBoundsToLock() const = 0;
 
 	void UnlockData();
+	// Queries the values of Bounds into Values, which must be of size Bounds.Size() / Step
+	// If the chunk distance field is built, its values are queried in the same call instead of being queried again later
+	void QueryValues(FVoxelMesherTimes& Times, const FVoxelIntBox& Bounds, FVoxelValue* RESTRICT Values);
+	// The caller already holds a lock covering GetBoundsToLock: LockData and UnlockData will be no-ops
+	// The distance field values must then be given by the mesher if ShouldQueryDistanceFieldValues, as the distance field can't lock the data again
+	void SetDataLockedExternally()
+	{
+		bDataLockedExternally = true;
+	}
+	bool ShouldQueryDistanceFieldValues() const
+	{
+		return bQueryDistanceFieldValues;
+	}
+	// Must match FVoxelChunkMesh::GetDistanceFieldValuesBounds
+	TArray<FVoxelValue>& GetDistanceFieldValues()
+	{
+		return DistanceFieldValues;
+	}
 	
 private:
 	TUniquePtr<FVoxelDataLockInfo> LockInfo;
+	TOptional<FVoxelCancelCounter> CancelCounter;
+	bool bDataLockedExternally = false;
+	// Set if the distance field values should be queried along the mesher values
+	bool bQueryDistanceFieldValues = false;
+	TArray<FVoxelValue> DistanceFieldValues;
 
 	void LockData();
 	bool IsEmpty() const;
@@ -0,0 +1,85 @@
+// Copyright 2020 Phyronnaz
+
+#include "VoxelRender/Meshers/VoxelMesherScratch.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/ThreadSafeCounter64.h"
+
+DEFINE_VOXEL_MEMORY_STAT(STAT_VoxelMesherScratchMemory);
+DEFINE_VOXEL_MEMORY_STAT(STAT_VoxelMesherScratchPooledMemory);
+
+static TAutoConsoleVariable<int32> CVarScratchMaxPooledArraySizeKB(
+	TEXT("voxel.mesher.ScratchMaxPooledArraySizeKB"),
+	1024,
+	TEXT("Mesher scratch arrays bigger than this are freed instead of being returned to their thread pool"),
+	ECVF_Default);
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Voxel Mesher Scratch Allocations"), STAT_VoxelMesherScratchAllocations, STATGROUP_VoxelCounters);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Voxel Mesher Scratch Reuses"), STAT_VoxelMesherScratchReuses, STATGROUP_VoxelCounters);
+
+static FThreadSafeCounter64 GVoxelMesherScratchAllocations;
+static FThreadSafeCounter64 GVoxelMesherScratchReuses;
+
+void FVoxelMesherScratchStats::ReportUsage(SIZE_T AllocatedSizeBefore, SIZE_T AllocatedSizeAfter)
+{
+	if (AllocatedSizeAfter > AllocatedSizeBefore)
+	{
+		INC_VOXEL_MEMORY_STAT_BY(STAT_VoxelMesherScratchMemory, AllocatedSizeAfter - AllocatedSizeBefore);
+		INC_DWORD_STAT(STAT_VoxelMesherScratchAllocations);
+		GVoxelMesherScratchAllocations.Increment();
+	}
+	else
+	{
+		INC_DWORD_STAT(STAT_VoxelMesherScratchReuses);
+		GVoxelMesherScratchReuses.Increment();
+	}
+}
+
+void FVoxelMesherScratchStats::ReportDiscarded(SIZE_T AllocatedSize)
+{
+	DEC_VOXEL_MEMORY_STAT_BY(STAT_VoxelMesherScratchMemory, AllocatedSize);
+}
+
+void FVoxelMesherScratchStats::ReportPooled(SIZE_T AllocatedSize)
+{
+	INC_VOXEL_MEMORY_STAT_BY(STAT_VoxelMesherScratchPooledMemory, AllocatedSize);
+}
+
+void FVoxelMesherScratchStats::ReportUnpooled(SIZE_T AllocatedSize)
+{
+	DEC_VOXEL_MEMORY_STAT_BY(STAT_VoxelMesherScratchPooledMemory, AllocatedSize);
+}
+
+SIZE_T FVoxelMesherScratchStats::GetMaxPooledArraySize()
+{
+	return SIZE_T(FMath::Max(0, CVarScratchMaxPooledArraySizeKB.GetValueOnAnyThread())) << 10;
+}
+
+int64 FVoxelMesherScratchStats::GetNumAllocations()
+{
+	return GVoxelMesherScratchAllocations.GetValue();
+}
+
+int64 FVoxelMesherScratchStats::GetNumReuses()
+{
+	return GVoxelMesherScratchReuses.GetValue();
+}
+
+void FVoxelMesherScratchStats::Reset()
+{
+	GVoxelMesherScratchAllocations.Reset();
+	GVoxelMesherScratchReuses.Reset();
+}
+
+static FAutoConsoleCommand LogMesherScratchStatsCmd(
+	TEXT("voxel.mesher.LogScratchStats"),
+	TEXT("Log how many times the mesher scratch buffers had to allocate vs were reused. Resets the counters"),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		const int64 Allocations = FVoxelMesherScratchStats::GetNumAllocations();
+		const int64 Reuses = FVoxelMesherScratchStats::GetNumReuses();
+		LOG_VOXEL(Log, TEXT("Mesher scratch buffers: %lld allocations, %lld reuses (%.2f%% reused)"),
+			Allocations,
+			Reuses,
+			Allocations + Reuses > 0 ? 100. * Reuses / (Allocations + Reuses) : 0.);
+		FVoxelMesherScratchStats::Reset();
+	}));
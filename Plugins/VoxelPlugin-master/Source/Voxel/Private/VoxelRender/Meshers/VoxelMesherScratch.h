@@ -0,0 +1,88 @@
+// Copyright 2020 Phyronnaz
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VoxelMinimal.h"
+
+DECLARE_VOXEL_MEMORY_STAT(TEXT("Voxel Mesher Scratch Memory"), STAT_VoxelMesherScratchMemory, STATGROUP_VoxelMemory, VOXEL_API);
+DECLARE_VOXEL_MEMORY_STAT(TEXT("Voxel Mesher Scratch Pooled Memory"), STAT_VoxelMesherScratchPooledMemory, STATGROUP_VoxelMemory, VOXEL_API);
+
+namespace FVoxelMesherScratchStats
+{
+	// Called when a scratch buffer is returned: an allocation happened if it grew while borrowed
+	void ReportUsage(SIZE_T AllocatedSizeBefore, SIZE_T AllocatedSizeAfter);
+	void ReportDiscarded(SIZE_T AllocatedSize);
+	// Memory sitting in the pools, unused
+	void ReportPooled(SIZE_T AllocatedSize);
+	void ReportUnpooled(SIZE_T AllocatedSize);
+
+	// See voxel.mesher.ScratchMaxPooledArraySizeKB
+	SIZE_T GetMaxPooledArraySize();
+
+	int64 GetNumAllocations();
+	int64 GetNumReuses();
+	void Reset();
+}
+
+/**
+ * Borrows a TArray from a per thread pool, so that meshers reuse the same allocations across chunks
+ * The array is reset (keeping its allocation) and returned to the pool when this goes out of scope
+ * Arrays that grew above voxel.mesher.ScratchMaxPooledArraySizeKB are freed instead, so that a few huge chunks don't pin their memory forever
+ * Do not move the array out (eg into a chunk buffer): the allocation would be lost for the pool
+ */
+template<typename T>
+class TVoxelMesherScratchArray
+{
+public:
+	TVoxelMesherScratchArray()
+	{
+		auto& Pool = GetPool();
+		if (Pool.Num() > 0)
+		{
+			Array = Pool.Pop(false);
+			FVoxelMesherScratchStats::ReportUnpooled(Array.GetAllocatedSize());
+		}
+		AllocatedSizeBefore = Array.GetAllocatedSize();
+	}
+	explicit TVoxelMesherScratchArray(int32 Num)
+		: TVoxelMesherScratchArray()
+	{
+		Array.SetNumUninitialized(Num, false);
+	}
+	~TVoxelMesherScratchArray()
+	{
+		FVoxelMesherScratchStats::ReportUsage(AllocatedSizeBefore, Array.GetAllocatedSize());
+
+		Array.Reset();
+
+		auto& Pool = GetPool();
+		if (Pool.Num() < MaxPooledArrays && Array.GetAllocatedSize() <= FVoxelMesherScratchStats::GetMaxPooledArraySize())
+		{
+			FVoxelMesherScratchStats::ReportPooled(Array.GetAllocatedSize());
+			Pool.Add(MoveTemp(Array));
+		}
+		else
+		{
+			FVoxelMesherScratchStats::ReportDiscarded(Array.GetAllocatedSize());
+		}
+	}
+	UE_NONCOPYABLE(TVoxelMesherScratchArray);
+
+	FORCEINLINE TArray<T>& Get() { return Array; }
+	FORCEINLINE TArray<T>& operator*() { return Array; }
+	FORCEINLINE TArray<T>* operator->() { return &Array; }
+
+private:
+	TArray<T> Array;
+	SIZE_T AllocatedSizeBefore = 0;
+
+	// Enough for the arrays of the same type a mesher borrows at once
+	static constexpr int32 MaxPooledArrays = 4;
+
+	static TArray<TArray<T>>& GetPool()
+	{
+		thread_local TArray<TArray<T>> Pool;
+		return Pool;
+	}
+};
@@ -93,7 +93,7 @@ TVoxelSharedPtr<FVoxelChunkMesh> FVoxelMesherUtilities::CreateChunkFromVertices(
 	const FVoxelRendererSettings& Settings, 
 	int32 LOD,
 	TArray<uint32>&& Indices, 
-	TArray<FVoxelMesherVertex>&& Vertices)
+	TArray<FVoxelMesherVertex>& Vertices)
 {
 	VOXEL_ASYNC_FUNCTION_COUNTER();
 
@@ -193,7 +193,8 @@ TVoxelSharedPtr<FVoxelChunkMesh> FVoxelMesherUtilities::CreateChunkFromVertices(
 	{
 		Chunk->SetIsSingle(false);
 
-		TVoxelStaticArray<TMap<int32, int32>, 256> IndicesMaps{ ForceInit };
+		// Reused across chunks to keep the maps allocations. Only the used maps are reset below
+		thread_local TVoxelStaticArray<TMap<int32, int32>, 256> IndicesMaps{ ForceInit };
 		for (int32 I = 0; I < Indices.Num(); I += 3)
 		{
 			const int32 IndexA = Indices[I + 0];
@@ -242,6 +243,14 @@ TVoxelSharedPtr<FVoxelChunkMesh> FVoxelMesherUtilities::CreateChunkFromVertices(
 			AddVertex(IndexB, VertexB);
 			AddVertex(IndexC, VertexC);
 		}
+
+		for (auto& IndicesMap : IndicesMaps)
+		{
+			if (IndicesMap.Num() > 0)
+			{
+				IndicesMap.Reset();
+			}
+		}
 	}
 	else
 	{
@@ -379,4 +388,122 @@ TVoxelSharedPtr<FVoxelChunkMesh> FVoxelMesherUtilities::CreateChunkFromVertices(
 	}
 
 	return Chunk;
-}
\ No newline at end of file
+}
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+template<typename TGetDest>
+void AppendTrianglesOutsideSlab(const FVoxelChunkMeshBuffers& Source, float MinZ, float MaxZ, TGetDest GetDest)
+{
+	const int32 NumVertices = Source.GetNumVertices();
+	const bool bHasNormals = Source.Normals.Num() == NumVertices;
+	const bool bHasTangents = Source.Tangents.Num() == NumVertices;
+	const bool bHasColors = Source.Colors.Num() == NumVertices;
+
+	TVoxelMesherScratchArray<int32> NewIndicesScratch(NumVertices);
+	TArray<int32>& NewIndices = *NewIndicesScratch;
+	FMemory::Memset(NewIndices.GetData(), 0xFF, NumVertices * sizeof(int32));
+
+	// Only created once we find a triangle to keep, to not add empty buffers
+	FVoxelChunkMeshBuffers* Dest = nullptr;
+	
+	// New vertices on the slab planes. The previous vertices there were built from the same values, and are welded to them
+	TMap<FVector, int32> PlaneVertices;
+	const auto IsOnPlane = [&](const FVector& Position)
+	{
+		return Position.Z == MinZ || Position.Z == MaxZ;
+	};
+	
+	const auto CopyVertex = [&](uint32 Index)
+	{
+		int32& NewIndex = NewIndices[Index];
+		if (NewIndex == -1 && IsOnPlane(Source.Positions[Index]))
+		{
+			if (const int32* PlaneIndex = PlaneVertices.Find(Source.Positions[Index]))
+			{
+				NewIndex = *PlaneIndex;
+			}
+		}
+		if (NewIndex == -1)
+		{
+			NewIndex = Dest->Positions.Add(Source.Positions[Index]);
+			if (bHasNormals) Dest->Normals.Add(Source.Normals[Index]);
+			if (bHasTangents) Dest->Tangents.Add(Source.Tangents[Index]);
+			if (bHasColors) Dest->Colors.Add(Source.Colors[Index]);
+			for (int32 Channel = 0; Channel < Source.TextureCoordinates.Num(); Channel++)
+			{
+				if (Source.TextureCoordinates[Channel].Num() == NumVertices)
+				{
+					Dest->TextureCoordinates[Channel].Add(Source.TextureCoordinates[Channel][Index]);
+				}
+			}
+		}
+		Dest->Indices.Add(NewIndex);
+	};
+	
+	for (int32 Index = 0; Index + 2 < Source.Indices.Num(); Index += 3)
+	{
+		const uint32 IndexA = Source.Indices[Index + 0];
+		const uint32 IndexB = Source.Indices[Index + 1];
+		const uint32 IndexC = Source.Indices[Index + 2];
+
+		if (FVoxelMesherUtilities::IsTriangleInSlab(Source.Positions[IndexA], Source.Positions[IndexB], Source.Positions[IndexC], MinZ, MaxZ))
+		{
+			// Remeshed
+			continue;
+		}
+
+		if (!Dest)
+		{
+			Dest = &GetDest();
+			if (Dest->TextureCoordinates.Num() < Source.TextureCoordinates.Num())
+			{
+				Dest->TextureCoordinates.SetNum(Source.TextureCoordinates.Num());
+			}
+			for (int32 DestIndex = 0; DestIndex < Dest->Positions.Num(); DestIndex++)
+			{
+				if (IsOnPlane(Dest->Positions[DestIndex]))
+				{
+					PlaneVertices.Add(Dest->Positions[DestIndex], DestIndex);
+				}
+			}
+		}
+		
+		CopyVertex(IndexA);
+		CopyVertex(IndexB);
+		CopyVertex(IndexC);
+	}
+}
+
+void FVoxelMesherUtilities::SpliceChunk(
+	const FVoxelChunkMesh& PreviousChunk,
+	float MinZ,
+	float MaxZ,
+	FVoxelChunkMesh& Chunk)
+{
+	VOXEL_ASYNC_FUNCTION_COUNTER();
+
+	if (PreviousChunk.IsSingle())
+	{
+		if (!ensure(Chunk.IsSingle())) return;
+
+		Chunk.IterateBuffers([&](FVoxelChunkMeshBuffers& Buffers)
+		{
+			AppendTrianglesOutsideSlab(*PreviousChunk.GetSingleBuffers(), MinZ, MaxZ, [&]() -> auto& { return Buffers; });
+		});
+	}
+	else
+	{
+		if (!ensure(!Chunk.IsSingle())) return;
+
+		PreviousChunk.IterateMaterials([&](const FVoxelMaterialIndices& MaterialIndices)
+		{
+			AppendTrianglesOutsideSlab(*PreviousChunk.FindBuffer(MaterialIndices), MinZ, MaxZ, [&]() -> auto&
+			{
+				bool bAdded;
+				return Chunk.FindOrAddBuffer(MaterialIndices, bAdded);
+			});
+		});
+	}
+}
@@ -7,6 +7,7 @@
 #include "VoxelConfigEnums.h"
 #include "VoxelDirection.h"
 #include "VoxelRender/VoxelProcMeshTangent.h"
+#include "VoxelRender/Meshers/VoxelMesherScratch.h"
 
 struct FVoxelRendererSettings;
 struct FVoxelChunkMesh;
@@ -26,7 +27,25 @@ namespace FVoxelMesherUtilities
 		const FVoxelRendererSettings& Settings,
 		int32 LOD,
 		TArray<uint32>&& Indices,
-		TArray<FVoxelMesherVertex>&& Vertices);
+		// Only read or compacted in place, never moved out: can be a mesher scratch array
+		TArray<FVoxelMesherVertex>& Vertices);
+
+	// A cell triangle belongs to the slab MinZ <= Z < MaxZ its centroid is in
+	// The non flat triangles of a cell have their centroid strictly inside it. The flat ones lying on a cell face belong to the cell above,
+	// so that the previous and the new triangles on a slab plane are never both kept
+	FORCEINLINE bool IsTriangleInSlab(const FVector& A, const FVector& B, const FVector& C, float MinZ, float MaxZ)
+	{
+		const float Z = (A.Z + B.Z + C.Z) / 3;
+		return MinZ <= Z && Z < MaxZ;
+	}
+	
+	// Appends to Chunk the triangles of PreviousChunk that are not in the remeshed slab, see IsTriangleInSlab
+	// Chunk must have been built with the same settings. Previous vertices on the slab planes are welded to the new ones with the same position
+	void SpliceChunk(
+		const FVoxelChunkMesh& PreviousChunk,
+		float MinZ,
+		float MaxZ,
+		FVoxelChunkMesh& Chunk);
 
 	inline FVector GetTranslatedTransvoxel(const FVector& Vertex, const FVector& Normal, uint8 TransitionsMask, uint8 LOD)
 	{
@@ -121,8 +140,8 @@ namespace FVoxelMesherUtilities
 	{
 		VOXEL_ASYNC_FUNCTION_COUNTER();
 		
-		TArray<uint32> NewIndices;
-		NewIndices.Reserve(Indices.Num());
+		// Compact in place: the write index never gets ahead of the read index
+		int32 WriteIndex = 0;
 		check(Indices.Num() % 3 == 0);
 		for (int32 Index = 0; Index < Indices.Num(); Index += 3)
 		{
@@ -140,12 +159,36 @@ namespace FVoxelMesherUtilities
 				B.Position != C.Position)
 			{
 				// Else physx crashes
-				NewIndices.Emplace(IndexA);
-				NewIndices.Emplace(IndexB);
-				NewIndices.Emplace(IndexC);
+				Indices.GetData()[WriteIndex + 0] = IndexA;
+				Indices.GetData()[WriteIndex + 1] = IndexB;
+				Indices.GetData()[WriteIndex + 2] = IndexC;
+				WriteIndex += 3;
+			}
+		}
+		Indices.SetNum(WriteIndex, false);
+	}
+	
+	template<typename T>
+	inline static void RemoveTrianglesOutsideSlab(TArray<uint32>& Indices, const TArray<T>& Vertices, float MinZ, float MaxZ)
+	{
+		VOXEL_ASYNC_FUNCTION_COUNTER();
+		
+		int32 WriteIndex = 0;
+		check(Indices.Num() % 3 == 0);
+		for (int32 Index = 0; Index < Indices.Num(); Index += 3)
+		{
+			const uint32 IndexA = Indices.GetData()[Index + 0];
+			const uint32 IndexB = Indices.GetData()[Index + 1];
+			const uint32 IndexC = Indices.GetData()[Index + 2];
+			if (IsTriangleInSlab(Vertices[IndexA].Position, Vertices[IndexB].Position, Vertices[IndexC].Position, MinZ, MaxZ))
+			{
+				Indices.GetData()[WriteIndex + 0] = IndexA;
+				Indices.GetData()[WriteIndex + 1] = IndexB;
+				Indices.GetData()[WriteIndex + 2] = IndexC;
+				WriteIndex += 3;
 			}
 		}
-		Indices = MoveTemp(NewIndices);
+		Indices.SetNum(WriteIndex, false);
 	}
 	
 	template<typename T>
@@ -159,9 +202,8 @@ namespace FVoxelMesherUtilities
 			UsedVertices[Index] = true;
 		}
 		
-		TArray<uint32> NewIndices;
-		NewIndices.Empty(Vertices.Num());
-		NewIndices.SetNumUninitialized(Vertices.Num());
+		TVoxelMesherScratchArray<uint32> NewIndicesScratch(Vertices.Num());
+		TArray<uint32>& NewIndices = *NewIndicesScratch;
 		
 		int32 WriteIndex = 0;
 		for (int32 ReadIndex = 0; ReadIndex < Vertices.Num(); ReadIndex++)
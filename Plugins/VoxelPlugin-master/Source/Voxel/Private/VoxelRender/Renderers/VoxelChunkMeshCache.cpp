@@ -0,0 +1,160 @@
+// Copyright 2020 Phyronnaz
+
+#include "VoxelRender/Renderers/VoxelChunkMeshCache.h"
+#include "VoxelRender/VoxelChunkMesh.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<int32> CVarChunkMeshCacheSize(
+	TEXT("voxel.renderer.ChunkMeshCacheSize"),
+	0,
+	TEXT("Number of meshes of destroyed chunks to keep per renderer, to show them again without meshing them if the chunks are recreated with the same data. 0 to disable"),
+	ECVF_Default);
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Voxel Chunk Mesh Cache Entries"), STAT_VoxelChunkMeshCacheEntries, STATGROUP_VoxelCounters);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Voxel Chunk Mesh Cache Hits"), STAT_VoxelChunkMeshCacheHits, STATGROUP_VoxelCounters);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Voxel Chunk Mesh Cache Misses"), STAT_VoxelChunkMeshCacheMisses, STATGROUP_VoxelCounters);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Voxel Chunk Mesh Cache Hit Rate (%)"), STAT_VoxelChunkMeshCacheHitRate, STATGROUP_VoxelCounters);
+
+static int64 GVoxelChunkMeshCacheHits = 0;
+static int64 GVoxelChunkMeshCacheMisses = 0;
+
+static FAutoConsoleCommand LogChunkMeshCacheStatsCmd(
+	TEXT("voxel.renderer.LogChunkMeshCacheStats"),
+	TEXT("Log the hit rate of the chunk mesh cache since the last call"),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		const int64 Lookups = GVoxelChunkMeshCacheHits + GVoxelChunkMeshCacheMisses;
+		LOG_VOXEL(Log, TEXT("Chunk mesh cache: %lld hits, %lld misses (%.2f%% hit rate)"),
+			GVoxelChunkMeshCacheHits,
+			GVoxelChunkMeshCacheMisses,
+			Lookups > 0 ? 100. * GVoxelChunkMeshCacheHits / Lookups : 0.);
+		GVoxelChunkMeshCacheHits = 0;
+		GVoxelChunkMeshCacheMisses = 0;
+	}));
+
+FVoxelChunkMeshCache::~FVoxelChunkMeshCache()
+{
+	Reset();
+}
+
+int32 FVoxelChunkMeshCache::GetMaxNumEntries()
+{
+	return FMath::Max(0, CVarChunkMeshCacheSize.GetValueOnGameThread());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+void FVoxelChunkMeshCache::Add(int32 LOD, const FVoxelIntBox& Bounds, uint8 TransitionsMask, const FEntry& Entry)
+{
+	VOXEL_FUNCTION_COUNTER();
+	check(IsInGameThread());
+	check(Entry.Chunk.IsValid());
+
+	const int32 MaxNumEntries = GetMaxNumEntries();
+	if (MaxNumEntries == 0)
+	{
+		Reset();
+		return;
+	}
+
+	const FKey Key{ LOD, Bounds.Min, TransitionsMask };
+	Remove(Key);
+
+	while (Entries.Num() >= MaxNumEntries)
+	{
+		// Evict the least recently used. Copy the key: Remove deletes its node
+		const FKey LeastRecentlyUsed = LruList.GetTail()->GetValue();
+		Remove(LeastRecentlyUsed);
+	}
+
+	LruList.AddHead(Key);
+	Entries.Add(Key, { Entry, Bounds, LruList.GetHead() });
+
+	UpdateStats();
+}
+
+bool FVoxelChunkMeshCache::Take(int32 LOD, const FVoxelIntBox& Bounds, uint8 TransitionsMask, FEntry& OutEntry)
+{
+	VOXEL_FUNCTION_COUNTER();
+	check(IsInGameThread());
+
+	const FKey Key{ LOD, Bounds.Min, TransitionsMask };
+	FCachedChunk* CachedChunk = Entries.Find(Key);
+	if (!CachedChunk)
+	{
+		GVoxelChunkMeshCacheMisses++;
+		INC_DWORD_STAT(STAT_VoxelChunkMeshCacheMisses);
+		UpdateStats();
+		return false;
+	}
+
+	ensure(CachedChunk->Bounds == Bounds);
+	OutEntry = CachedChunk->Entry;
+	Remove(Key);
+
+	GVoxelChunkMeshCacheHits++;
+	INC_DWORD_STAT(STAT_VoxelChunkMeshCacheHits);
+	UpdateStats();
+	return true;
+}
+
+void FVoxelChunkMeshCache::Invalidate(const FVoxelIntBox& EditedBounds)
+{
+	VOXEL_FUNCTION_COUNTER();
+	check(IsInGameThread());
+
+	if (Entries.Num() == 0)
+	{
+		return;
+	}
+
+	// Same as the LOD manager when looking for the chunks to update
+	const FVoxelIntBox BoundsToUpdate = EditedBounds.Extend(2);
+
+	TArray<FKey> KeysToRemove;
+	for (auto& It : Entries)
+	{
+		// Meshers read one voxel before and two voxels after the chunk (end edge & normals)
+		const int32 Step = 1 << It.Key.LOD;
+		if (It.Value.Bounds.Extend(2 * Step).Intersect(BoundsToUpdate))
+		{
+			KeysToRemove.Add(It.Key);
+		}
+	}
+	for (const FKey& Key : KeysToRemove)
+	{
+		Remove(Key);
+	}
+
+	UpdateStats();
+}
+
+void FVoxelChunkMeshCache::Reset()
+{
+	Entries.Empty();
+	LruList.Empty();
+	UpdateStats();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+void FVoxelChunkMeshCache::Remove(const FKey& Key)
+{
+	FCachedChunk CachedChunk;
+	if (Entries.RemoveAndCopyValue(Key, CachedChunk))
+	{
+		LruList.RemoveNode(CachedChunk.LruNode);
+	}
+}
+
+void FVoxelChunkMeshCache::UpdateStats() const
+{
+	SET_DWORD_STAT(STAT_VoxelChunkMeshCacheEntries, Entries.Num());
+
+	const int64 Lookups = GVoxelChunkMeshCacheHits + GVoxelChunkMeshCacheMisses;
+	SET_FLOAT_STAT(STAT_VoxelChunkMeshCacheHitRate, Lookups > 0 ? 100.f * GVoxelChunkMeshCacheHits / Lookups : 0.f);
+}
@@ -0,0 +1,81 @@
+// Copyright 2020 Phyronnaz
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VoxelIntBox.h"
+#include "VoxelMinimal.h"
+#include "Containers/List.h"
+
+struct FVoxelChunkMesh;
+
+/**
+ * Bounded LRU cache of the meshes of destroyed chunks
+ * When invokers oscillate around a LOD boundary, the same chunks are destroyed and recreated over and over:
+ * if their data wasn't edited in between, their previous meshes can be shown again without meshing them
+ *
+ * Entries are keyed by LOD, position and transitions mask (0 for main chunks)
+ * Edits invalidate the entries they overlap, so a cached mesh is always up to date with the data
+ * The renderer settings are constant for a given renderer, so they're not part of the key
+ * Game thread only
+ */
+class FVoxelChunkMeshCache
+{
+public:
+	struct FEntry
+	{
+		TVoxelSharedPtr<const FVoxelChunkMesh> Chunk;
+		double CreationTime = 0;
+	};
+
+	FVoxelChunkMeshCache() = default;
+	~FVoxelChunkMeshCache();
+	UE_NONCOPYABLE(FVoxelChunkMeshCache);
+
+	static int32 GetMaxNumEntries();
+
+	void Add(int32 LOD, const FVoxelIntBox& Bounds, uint8 TransitionsMask, const FEntry& Entry);
+	// Removes the entry from the cache if found. Updates the hit rate stats
+	bool Take(int32 LOD, const FVoxelIntBox& Bounds, uint8 TransitionsMask, FEntry& OutEntry);
+
+	// Removes all the entries whose meshes depend on data in EditedBounds
+	void Invalidate(const FVoxelIntBox& EditedBounds);
+	void Reset();
+
+	int32 Num() const
+	{
+		return Entries.Num();
+	}
+
+private:
+	struct FKey
+	{
+		int32 LOD = 0;
+		FIntVector Position;
+		uint8 TransitionsMask = 0;
+
+		FORCEINLINE bool operator==(const FKey& Other) const
+		{
+			return LOD == Other.LOD && Position == Other.Position && TransitionsMask == Other.TransitionsMask;
+		}
+		FORCEINLINE friend uint32 GetTypeHash(const FKey& Key)
+		{
+			return HashCombine(GetTypeHash(Key.Position), Key.LOD | (Key.TransitionsMask << 8));
+		}
+	};
+	using FLruList = TDoubleLinkedList<FKey>;
+
+	struct FCachedChunk
+	{
+		FEntry Entry;
+		FVoxelIntBox Bounds;
+		// Head is the most recently used
+		FLruList::TDoubleLinkedListNode* LruNode = nullptr;
+	};
+
+	TMap<FKey, FCachedChunk> Entries;
+	FLruList LruList;
+
+	void Remove(const FKey& Key);
+	void UpdateStats() const;
+};
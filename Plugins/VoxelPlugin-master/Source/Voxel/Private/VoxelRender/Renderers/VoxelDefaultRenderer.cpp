@@ -4,6 +4,7 @@
 #include "VoxelMessages.h"
 #include "IVoxelPool.h"
 #include "VoxelRender/VoxelMesherAsyncWork.h"
+#include "VoxelRender/Meshers/VoxelMeshSimplifier.h"
 #include "VoxelRender/Renderers/VoxelRendererMeshHandler.h"
 #include "VoxelRender/Renderers/VoxelRendererBasicMeshHandler.h"
 #include "VoxelRender/Renderers/VoxelRendererClusteredMeshHandler.h"
@@ -14,6 +15,7 @@
 #include "VoxelDebug/VoxelDebugManager.h"
 #include "VoxelData/VoxelData.h"
 #include "VoxelWorldGenerators/VoxelWorldGeneratorInstance.h"
+#include "VoxelUtilities/VoxelIntVectorUtilities.h"
 
 DEFINE_VOXEL_MEMORY_STAT(STAT_VoxelRenderer);
 
@@ -23,6 +25,72 @@ static TAutoConsoleVariable<int32> CVarFreezeRenderer(
 	TEXT("Stops renderer tick"),
 	ECVF_Default);
 
+static TAutoConsoleVariable<int32> CVarBatchMeshingTasks(
+	TEXT("voxel.renderer.BatchMeshingTasks"),
+	0,
+	TEXT("If true, adjacent chunks of the same LOD queued together will be meshed by a single task, in 2x2x2 blocks. ")
+	TEXT("Saves data locks and queries, but holds the data lock longer. Marching cubes only"),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarIncrementalRemesh(
+	TEXT("voxel.renderer.IncrementalRemesh"),
+	0,
+	TEXT("If true, edits will only remesh the part of the chunks around the edited bounds, and keep the rest of the previous mesh. ")
+	TEXT("Marching cubes only, not supported with multi index materials, mesh normals or unique UVs"),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarMinDelayBetweenChunkMeshUpdates(
+	TEXT("voxel.renderer.MinDelayBetweenChunkMeshUpdates"),
+	30,
+	TEXT("In ms. Under continuous edits, a chunk mesh built less than this after the previous one was sent to the mesh handler is not sent if a newer one is already on its way. ")
+	TEXT("The latest mesh is always sent. 0 to send all of them"),
+	ECVF_Default);
+
+TAutoConsoleVariable<int32> CVarLogMeshingThroughput(
+	TEXT("voxel.renderer.LogMeshingThroughput"),
+	0,
+	TEXT("If true, will log the number of chunks meshed per second until the world is loaded"),
+	ECVF_Default);
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Voxel Meshing Batches"), STAT_VoxelMeshingBatches, STATGROUP_VoxelCounters);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Voxel Meshing Batched Chunks"), STAT_VoxelMeshingBatchedChunks, STATGROUP_VoxelCounters);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Voxel Edit Remeshes: Incremental"), STAT_VoxelIncrementalRemeshes, STATGROUP_VoxelCounters);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Voxel Edit Remeshes: Full"), STAT_VoxelFullRemeshes, STATGROUP_VoxelCounters);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Voxel Edit To Mesh Latency (ms)"), STAT_VoxelEditToMeshLatency, STATGROUP_VoxelCounters);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Voxel Edits Merged Into Queued Tasks"), STAT_VoxelEditsMergedIntoQueuedTasks, STATGROUP_VoxelCounters);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Voxel Outdated Chunk Meshes"), STAT_VoxelOutdatedChunkMeshes, STATGROUP_VoxelCounters);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Voxel Throttled Chunk Mesh Updates"), STAT_VoxelThrottledChunkMeshUpdates, STATGROUP_VoxelCounters);
+
+struct FVoxelChunkUpdatesStats
+{
+	int64 NumEdits = 0;
+	int64 NumMergedEdits = 0;
+	int64 NumMeshes = 0;
+	// Meshes that were already outdated when they were built: a newer edit is waiting for another task
+	int64 NumOutdatedMeshes = 0;
+	int64 NumThrottledMeshes = 0;
+	double MeshingTime = 0;
+	double OutdatedMeshingTime = 0;
+};
+// Game thread only, for all the renderers
+static FVoxelChunkUpdatesStats GVoxelChunkUpdatesStats;
+
+static FAutoConsoleCommand LogChunkUpdatesStatsCmd(
+	TEXT("voxel.renderer.LogChunkUpdatesStats"),
+	TEXT("Log how the chunk updates from edits were coalesced since the last call, and how much meshing was spent on outdated meshes"),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		const FVoxelChunkUpdatesStats& Stats = GVoxelChunkUpdatesStats;
+		LOG_VOXEL(Log, TEXT("Chunk updates: %lld edited chunks, %lld merged into queued tasks"), Stats.NumEdits, Stats.NumMergedEdits);
+		LOG_VOXEL(Log, TEXT("Chunk meshes: %lld built in %.3fms, %lld outdated (%.3fms of meshing), %lld not sent to the mesh handler"),
+			Stats.NumMeshes,
+			1000. * Stats.MeshingTime,
+			Stats.NumOutdatedMeshes,
+			1000. * Stats.OutdatedMeshingTime,
+			Stats.NumThrottledMeshes);
+		GVoxelChunkUpdatesStats = {};
+	}));
+
 FVoxelDefaultRenderer::FVoxelDefaultRenderer(const FVoxelRendererSettings& Settings)
 	: IVoxelRenderer(Settings)
 	, MeshHandler(Settings.bMergeChunks ? Settings.bDoNotMergeCollisionsAndNavmesh
@@ -73,6 +141,7 @@ void FVoxelDefaultRenderer::Destroy()
 
 	ChunksMap.Reset();
 	MeshHandler.Reset();
+	MeshCache.Reset();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -91,6 +160,9 @@ int32 FVoxelDefaultRenderer::UpdateChunks(
 		FVoxelMessages::Error("Can't update chunks with bStaticWorld = true!");
 		return 0;
 	}
+
+	// Even if no chunk is updated, cached meshes of destroyed chunks might be outdated
+	MeshCache.Invalidate(Bounds);
 	
 	if (ChunksToUpdate.Num() == 0)
 	{
@@ -102,6 +174,18 @@ int32 FVoxelDefaultRenderer::UpdateChunks(
 	{
 		auto& Chunk = ChunksMap.FindChecked(ChunkId);
 		Chunk.PendingUpdates.Add({ Time, FinishDelegate });
+		GVoxelChunkUpdatesStats.NumEdits++;
+		if (Chunk.Tasks.MainTask.IsValid() && Chunk.Tasks.MainTask->TryAddDirtyBounds(Bounds))
+		{
+			// The queued task will see this edit: no need for another one
+			// Its CreationTime will be after Time, so it will also finish this update
+			GVoxelChunkUpdatesStats.NumMergedEdits++;
+			INC_DWORD_STAT(STAT_VoxelEditsMergedIntoQueuedTasks);
+		}
+		else
+		{
+			Chunk.DirtyBounds += Bounds;
+		}
 		// Trigger tasks if not already triggered: if they are, they will trigger new ones when their callback will be processed in Tick
 		StartTask<EMainOrTransitions::Main, EIfTaskExists::DoNothing>(Chunk);
 		StartTask<EMainOrTransitions::Transitions, EIfTaskExists::DoNothing>(Chunk);
@@ -214,6 +298,11 @@ void FVoxelDefaultRenderer::UpdateLODs(const uint64 InUpdateIndex, const TArray<
 	UpdateIndex++;
 	if (!ensure(UpdateIndex == InUpdateIndex)) return;
 
+	if (UpdateIndex == 1)
+	{
+		FirstUpdateTime = FPlatformTime::Seconds();
+	}
+
 	// Map used to know which chunks to wait for before dithering out
 	TMap<uint64, TArray<uint64, TInlineAllocator<8>>> OldChunksToNewChunks;
 	// Need to do it after the main pass, else OldChunksToNewChunks wouldn't be filled
@@ -692,14 +781,19 @@ void FVoxelDefaultRenderer::CreateGeometry_AnyThread(
 	TArray<uint32>& OutIndices,
 	TArray<FVector>& OutVertices) const
 {
-	FVoxelMesherAsyncWork::CreateGeometry_AnyThread(*this, LOD, ChunkPosition, OutIndices, OutVertices);
+	FVoxelMesherAsyncWork::CreateGeometry_AnyThread(Settings, LOD, ChunkPosition, OutIndices, OutVertices);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
-void FVoxelDefaultRenderer::Tick(float)
+void FVoxelDefaultRenderer::Tick(float DeltaTime)
+{
+	TickWithBudget(DeltaTime, MAX_dbl);
+}
+
+void FVoxelDefaultRenderer::TickWithBudget(float DeltaTime, double SchedulerMaxTime)
 {
 	VOXEL_FUNCTION_COUNTER();
 
@@ -709,11 +803,13 @@ void FVoxelDefaultRenderer::Tick(float)
 	}
 
 	const double Time = FPlatformTime::Seconds();
-	const double MaxTime = Time + Settings.MeshUpdatesBudget * 0.001f;
+	// MeshUpdatesBudget still applies when ticked by the scheduler
+	const double MaxTime = FMath::Min(Time + Settings.MeshUpdatesBudget * 0.001f, SchedulerMaxTime);
 	
 	{
 		VOXEL_SCOPE_COUNTER("MeshHandler Tick");
 		MeshHandler->Tick(MaxTime);
+		FVoxelGameThreadScheduler::ReportTime(EVoxelGameThreadWork::MeshHandler, FPlatformTime::Seconds() - Time);
 	}
 	
 	ProcessChunksToRemoveOrShow();
@@ -722,6 +818,15 @@ void FVoxelDefaultRenderer::Tick(float)
 
 	if (!OnWorldLoadedFired && UpdateIndex > 0 && TaskCount.GetValue() == 0 && TasksCallbacksQueue.IsEmpty())
 	{
+		if (CVarLogMeshingThroughput.GetValueOnGameThread() != 0)
+		{
+			const double Duration = FPlatformTime::Seconds() - FirstUpdateTime;
+			LOG_VOXEL(Log, TEXT("Default renderer: world loaded in %.3fs, %d chunks meshed (%.1f chunks/s)"),
+				Duration,
+				NumMeshedChunks,
+				Duration > 0 ? NumMeshedChunks / Duration : 0.);
+		}
+
 		OnWorldLoaded.Broadcast();
 		OnWorldLoadedFired = true;
 	}
@@ -758,7 +863,7 @@ void FVoxelDefaultRenderer::StartTask(FChunk& Chunk)
 
 	if (MainOrTransitions == EMainOrTransitions::Transitions)
 	{
-		if (Settings.RenderType == EVoxelRenderType::SurfaceNets)
+		if (Settings.IsDualRenderType())
 		{
 			if (Chunk.MeshId.IsValid())
 			{
@@ -793,13 +898,63 @@ void FVoxelDefaultRenderer::StartTask(FChunk& Chunk)
 		}
 	}
 
+	FVoxelIntBox DirtyBounds;
+	TVoxelSharedPtr<const FVoxelChunkMesh> PreviousChunk;
+	if (MainOrTransitions == EMainOrTransitions::Main)
+	{
+		if (Chunk.DirtyBounds.IsValid())
+		{
+			// Only remesh the edited part if we have a previous mesh to splice it into
+			// Dirty bounds covering the whole chunk (eg after a cancel) are a full remesh
+			if (CVarIncrementalRemesh.GetValueOnGameThread() != 0 &&
+				Chunk.BuiltData.MainChunk.IsValid() &&
+				!Chunk.DirtyBounds.GetBox().Contains(Chunk.Bounds) &&
+				FVoxelMesherAsyncWork::CanUpdateIncrementally(Settings) &&
+				// Simplified triangles can span the slab boundaries
+				!FVoxelMeshSimplifier::ShouldSimplify(Settings, Chunk.LOD))
+			{
+				DirtyBounds = Chunk.DirtyBounds.GetBox();
+				PreviousChunk = Chunk.BuiltData.MainChunk;
+				INC_DWORD_STAT(STAT_VoxelIncrementalRemeshes);
+			}
+			else
+			{
+				INC_DWORD_STAT(STAT_VoxelFullRemeshes);
+			}
+		}
+		// The task will include all the edits so far
+		Chunk.DirtyBounds.Reset();
+	}
+
+	const uint8 TransitionsMask = MainOrTransitions == EMainOrTransitions::Transitions ? Chunk.Settings.TransitionsMask : 0;
+	
 	Task = TUniquePtr<FVoxelMesherAsyncWork, TVoxelAsyncWorkDelete<FVoxelMesherAsyncWork>>(new FVoxelMesherAsyncWork(
 		*this,
 		Chunk.Id,
 		Chunk.LOD,
 		Chunk.Bounds,
 		MainOrTransitions == EMainOrTransitions::Transitions,
-		MainOrTransitions == EMainOrTransitions::Transitions ? Chunk.Settings.TransitionsMask : 0));
+		TransitionsMask,
+		DirtyBounds,
+		PreviousChunk,
+		Chunk.Settings.bVisible));
+
+	// Only look for chunks that were never built: chunks with a mesh are being updated
+	const bool bIsBuilt = MainOrTransitions == EMainOrTransitions::Main ? Chunk.BuiltData.MainChunk.IsValid() : Chunk.BuiltData.TransitionsChunk.IsValid();
+	FVoxelChunkMeshCache::FEntry CachedEntry;
+	if (!bIsBuilt &&
+		Chunk.PendingUpdates.Num() == 0 &&
+		FVoxelChunkMeshCache::GetMaxNumEntries() > 0 &&
+		MeshCache.Take(Chunk.LOD, Chunk.Bounds, TransitionsMask, CachedEntry))
+	{
+		// Run it right away: it only outputs the cached chunk, and the callback will be processed like any other task
+		Task->CachedChunk = CachedEntry.Chunk;
+		Task->CachedChunkCreationTime = CachedEntry.CreationTime;
+		TaskCount.Increment();
+		Task->DoThreadedWork();
+		return;
+	}
+	
 	QueuedTasks[Chunk.Settings.bVisible][Chunk.Settings.bEnableCollisions].Emplace(Task.Get());
 }
 
@@ -810,6 +965,8 @@ void FVoxelDefaultRenderer::CancelTasks(FChunk& Chunk)
 	if (Chunk.Tasks.MainTask.IsValid())
 	{
 		CancelTask(Chunk.Tasks.MainTask);
+		// We don't know what was edited before that task was started: the next one will need to remesh everything
+		Chunk.DirtyBounds += Chunk.Bounds;
 	}
 	if (Chunk.Tasks.TransitionsTask.IsValid())
 	{
@@ -869,7 +1026,7 @@ void FVoxelDefaultRenderer::NewChunksFinished(FChunk& Chunk, const FChunk& NewCh
 
 	if (Settings.bDitherChunks && Chunk.MeshId.IsValid()) // Could be 0 if we were waiting for previous chunks
 	{
-		if (Settings.RenderType == EVoxelRenderType::SurfaceNets)
+		if (Settings.IsDualRenderType())
 		{
 			// For surface nets, the only chunk that can transition is the high res one
 			// So check if we're the high res one, and if not just delete self
@@ -957,7 +1114,7 @@ void FVoxelDefaultRenderer::DitherInChunk(FChunk& Chunk, const TArray<uint64, TI
 	ensureVoxelSlowNoSideEffects(!ChunksToRemove.FindByPredicate([&](const FChunkToRemove& ChunkToRemove) { return ChunkToRemove.Id == Chunk.Id; }));
 	ensureVoxelSlowNoSideEffects(!ChunksToShow.FindByPredicate([&](const FChunkToShow& ChunkToShow) { return ChunkToShow.Id == Chunk.Id; }));
 	
-	if (Settings.RenderType == EVoxelRenderType::SurfaceNets)
+	if (Settings.IsDualRenderType())
 	{
 		// For surface nets, the only chunk that can transition is the high res one
 		// So check if we're the high res one, and if not just hide self until previous one finished dithering
@@ -1073,7 +1230,7 @@ void FVoxelDefaultRenderer::ApplyPendingSettings(FChunk& Chunk, bool bApplyVisib
 	ensure(bApplyVisibility || bInitialHasMesh_Debug == Chunk.MeshId.IsValid());
 }
 
-void FVoxelDefaultRenderer::CheckPendingUpdates(FChunk& Chunk)
+void FVoxelDefaultRenderer::CheckPendingUpdates(FChunk& Chunk, bool bCanFinishUpdates)
 {
 	VOXEL_FUNCTION_COUNTER();
 	
@@ -1088,8 +1245,10 @@ void FVoxelDefaultRenderer::CheckPendingUpdates(FChunk& Chunk)
 		{
 			StartTask<EMainOrTransitions::Transitions, EIfTaskExists::DoNothing>(Chunk);
 		}
-		if (PendingUpdate.WantedUpdateTime < FMath::Min(Chunk.BuiltData.MainChunkCreationTime, Chunk.BuiltData.TransitionsChunkCreationTime))
+		if (bCanFinishUpdates &&
+			PendingUpdate.WantedUpdateTime < FMath::Min(Chunk.BuiltData.MainChunkCreationTime, Chunk.BuiltData.TransitionsChunkCreationTime))
 		{
+			SET_FLOAT_STAT(STAT_VoxelEditToMeshLatency, (FPlatformTime::Seconds() - PendingUpdate.WantedUpdateTime) * 1000);
 			PendingUpdate.OnUpdateFinished.Broadcast(Chunk.Bounds);
 			Chunk.PendingUpdates.RemoveAtSwap(Index);
 			Index--;
@@ -1121,7 +1280,7 @@ void FVoxelDefaultRenderer::ProcessChunksToRemoveOrShow()
 
 				if (Chunk.MeshId.IsValid())
 				{
-					if (Settings.RenderType == EVoxelRenderType::SurfaceNets)
+					if (Settings.IsDualRenderType())
 					{
 						// If we were the low res chunk we were hidden
 						MeshHandler->ShowChunk(Chunk.MeshId);
@@ -1178,6 +1337,27 @@ void FVoxelDefaultRenderer::ProcessMeshUpdates(double MaxTime)
 		if (!Task.IsValid() || Task->TaskId != Callback.TaskId) continue; // If task was canceled
 		if (!ensure(Task->IsDone())) continue; // Must be done if we're in the callback
 
+		NumMeshedChunks++;
+
+		const double TaskCreationTime = Task->CreationTime;
+		if (!Task->CachedChunk.IsValid())
+		{
+			GVoxelChunkUpdatesStats.NumMeshes++;
+			GVoxelChunkUpdatesStats.MeshingTime += Task->MeshingTime;
+
+			// Started before an edit that didn't make it into it: another task will have to remesh the chunk
+			const bool bIsOutdated = Chunk->PendingUpdates.ContainsByPredicate([&](const FChunk::FPendingUpdate& PendingUpdate)
+			{
+				return PendingUpdate.WantedUpdateTime > TaskCreationTime;
+			});
+			if (bIsOutdated)
+			{
+				GVoxelChunkUpdatesStats.NumOutdatedMeshes++;
+				GVoxelChunkUpdatesStats.OutdatedMeshingTime += Task->MeshingTime;
+				INC_DWORD_STAT(STAT_VoxelOutdatedChunkMeshes);
+			}
+		}
+
 		// Move built data
 		auto& BuiltData = Chunk->BuiltData;
 		const auto PreviousBuiltData = BuiltData;
@@ -1197,6 +1377,32 @@ void FVoxelDefaultRenderer::ProcessMeshUpdates(double MaxTime)
 		// Finally, delete the task
 		Task.Reset();
 
+		const double Time = FPlatformTime::Seconds();
+
+		// Under continuous edits, don't send every mesh of the chunk to the mesh handler: if a newer one is coming, wait for it
+		// The built data is still updated, so that the latest mesh is the one sent and the next incremental task splices into it
+		if (Chunk->MeshId.IsValid() &&
+			PreviousBuiltData.MainChunk.IsValid() &&
+			BuiltData.MainChunk.IsValid() &&
+			Chunk->PreviousChunks.Num() == 0 &&
+			Time - Chunk->LastMeshUpdateTime < CVarMinDelayBetweenChunkMeshUpdates.GetValueOnGameThread() / 1000.)
+		{
+			const double BuiltTime = FMath::Min(BuiltData.MainChunkCreationTime, BuiltData.TransitionsChunkCreationTime);
+			const bool bNewerMeshIsComing = Chunk->PendingUpdates.ContainsByPredicate([&](const FChunk::FPendingUpdate& PendingUpdate)
+			{
+				return PendingUpdate.WantedUpdateTime > BuiltTime;
+			});
+			if (bNewerMeshIsComing)
+			{
+				GVoxelChunkUpdatesStats.NumThrottledMeshes++;
+				INC_DWORD_STAT(STAT_VoxelThrottledChunkMeshUpdates);
+
+				// Start the newer tasks, but don't finish the updates: their mesh isn't shown yet
+				CheckPendingUpdates(*Chunk, false);
+				continue;
+			}
+		}
+
 		// Do nothing while the main chunk isn't valid - we don't want to have unneeded updates for transitions then main
 		if (BuiltData.MainChunk.IsValid())
 		{
@@ -1220,7 +1426,7 @@ void FVoxelDefaultRenderer::ProcessMeshUpdates(double MaxTime)
 			const bool bTransitionsChunkIsBuilt =
 				BuiltData.TransitionsChunk.IsValid() ||
 				Chunk->Settings.TransitionsMask == 0 ||
-				Settings.RenderType == EVoxelRenderType::SurfaceNets;
+				Settings.IsDualRenderType();
 
 			if (BuiltData.MainChunk->IsEmpty() && (!BuiltData.TransitionsChunk.IsValid() || BuiltData.TransitionsChunk->IsEmpty()))
 			{
@@ -1229,11 +1435,13 @@ void FVoxelDefaultRenderer::ProcessMeshUpdates(double MaxTime)
 				{
 					MeshHandler->RemoveChunk(MeshId);
 					MeshId = {};
+					Chunk->LastMeshUpdateTime = Time;
 				}
 			}
 			else
 			{
 				Update();
+				Chunk->LastMeshUpdateTime = Time;
 				
 				ensure(MeshId.IsValid());
 
@@ -1280,7 +1488,9 @@ void FVoxelDefaultRenderer::FlushQueuedTasks()
 		auto& Tasks = QueuedTasks[bVisible][bHasCollisions];
 		if (Tasks.Num() > 0)
 		{
+			// Each chunk task still reports individually, even when batched
 			TaskCount.Add(Tasks.Num());
+			BatchQueuedTasks(Tasks);
 			const auto TaskType =
 				bVisible
 				? bHasCollisions
@@ -1299,6 +1509,70 @@ void FVoxelDefaultRenderer::FlushQueuedTasks()
 	Flush(true, true);
 }
 
+void FVoxelDefaultRenderer::BatchQueuedTasks(TArray<IVoxelQueuedWork*>& Tasks)
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	if (CVarBatchMeshingTasks.GetValueOnGameThread() == 0 || !FVoxelMesherBatchAsyncWork::CanBatch(Settings))
+	{
+		return;
+	}
+
+	TArray<IVoxelQueuedWork*> NewTasks;
+	NewTasks.Reserve(Tasks.Num());
+
+	// Key: LOD, 2x2x2 block position
+	TMap<TPair<int32, FIntVector>, TArray<FVoxelMesherAsyncWork*>> Groups;
+	for (IVoxelQueuedWork* Work : Tasks)
+	{
+		// Only mesher tasks are queued in QueuedTasks
+		auto* Task = static_cast<FVoxelMesherAsyncWork*>(Work);
+		if (Task->bIsTransitionTask || Task->PreviousChunk.IsValid())
+		{
+			// Incremental tasks only query their slab
+			NewTasks.Add(Task);
+			continue;
+		}
+		
+		const int32 ChunkSize = RENDER_CHUNK_SIZE << Task->LOD;
+		const FIntVector Block = FVoxelUtilities::DivideFloor(Task->ChunkPosition, 2 * ChunkSize);
+		Groups.FindOrAdd({ Task->LOD, Block }).Add(Task);
+	}
+
+	for (auto& It : Groups)
+	{
+		const int32 LOD = It.Key.Key;
+		auto& GroupTasks = It.Value;
+		
+		if (GroupTasks.Num() < 2)
+		{
+			NewTasks.Append(GroupTasks);
+			continue;
+		}
+
+		const int32 ChunkSize = RENDER_CHUNK_SIZE << LOD;
+		FVoxelIntBox ChunksBounds(GroupTasks[0]->ChunkPosition, GroupTasks[0]->ChunkPosition + ChunkSize);
+		for (auto* Task : GroupTasks)
+		{
+			ChunksBounds = ChunksBounds.Union(FVoxelIntBox(Task->ChunkPosition, Task->ChunkPosition + ChunkSize));
+		}
+
+		// Don't query values for a block that is mostly made of chunks we're not meshing
+		const FIntVector NumChunks = ChunksBounds.Size() / ChunkSize;
+		if (2 * GroupTasks.Num() <= NumChunks.X * NumChunks.Y * NumChunks.Z)
+		{
+			NewTasks.Append(GroupTasks);
+			continue;
+		}
+
+		INC_DWORD_STAT(STAT_VoxelMeshingBatches);
+		INC_DWORD_STAT_BY(STAT_VoxelMeshingBatchedChunks, GroupTasks.Num());
+		NewTasks.Add(new FVoxelMesherBatchAsyncWork(*this, LOD, ChunksBounds, MoveTemp(GroupTasks)));
+	}
+
+	Tasks = MoveTemp(NewTasks);
+}
+
 void FVoxelDefaultRenderer::DestroyChunk(FChunk& Chunk)
 {
 	VOXEL_FUNCTION_COUNTER();
@@ -1313,6 +1587,22 @@ void FVoxelDefaultRenderer::DestroyChunk(FChunk& Chunk)
 	{
 		CancelTasks(Chunk);
 	}
+
+	// Only cache meshes that are up to date with the data
+	if (FVoxelChunkMeshCache::GetMaxNumEntries() > 0 &&
+		Chunk.PendingUpdates.Num() == 0 &&
+		!Chunk.DirtyBounds.IsValid())
+	{
+		const auto& BuiltData = Chunk.BuiltData;
+		if (BuiltData.MainChunk.IsValid())
+		{
+			MeshCache.Add(Chunk.LOD, Chunk.Bounds, 0, { BuiltData.MainChunk, BuiltData.MainChunkCreationTime });
+		}
+		if (BuiltData.TransitionsChunk.IsValid() && BuiltData.TransitionsMask != 0)
+		{
+			MeshCache.Add(Chunk.LOD, Chunk.Bounds, BuiltData.TransitionsMask, { BuiltData.TransitionsChunk, BuiltData.TransitionsChunkCreationTime });
+		}
+	}
 	
 	for (auto& PendingUpdate : Chunk.PendingUpdates)
 	{
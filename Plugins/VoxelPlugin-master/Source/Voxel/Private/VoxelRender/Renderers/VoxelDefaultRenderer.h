@@ -7,6 +7,7 @@
 #include "VoxelRender/VoxelMesherAsyncWork.h"
 #include "VoxelRender/VoxelChunkToUpdate.h"
 #include "VoxelRendererMeshHandler.h"
+#include "VoxelChunkMeshCache.h"
 #include "VoxelTickable.h"
 #include "VoxelQueueWithNum.h"
 
@@ -14,6 +15,12 @@ struct FVoxelChunkMesh;
 
 DECLARE_VOXEL_MEMORY_STAT(TEXT("Voxel Renderer"), STAT_VoxelRenderer, STATGROUP_VoxelMemory, VOXEL_API);
 
+template <class T>
+class TAutoConsoleVariable;
+
+// Shared with the headless renderer so that both can be compared
+extern TAutoConsoleVariable<int32> CVarLogMeshingThroughput;
+
 class FVoxelDefaultRenderer : public IVoxelRenderer, public FVoxelTickable, public TVoxelSharedFromThis<FVoxelDefaultRenderer>
 {
 public:
@@ -46,6 +53,8 @@ public:
 	//~ Begin FVoxelTickable Interface
 	virtual void Tick(float DeltaTime) override;
 	virtual bool IsTickableInEditor() const override { return true; }
+	virtual EVoxelGameThreadWork GetGameThreadWork() const override { return EVoxelGameThreadWork::Renderer; }
+	virtual void TickWithBudget(float DeltaTime, double MaxTime) override;
 	//~ End FVoxelTickable Interface
 
 private:
@@ -136,6 +145,13 @@ private:
 		};
 		TArray<FPendingUpdate, TInlineAllocator<2>> PendingUpdates;
 
+		// Edits since the last main task was started. Used to only remesh the edited part of the chunk
+		// Edits made while the main task is still queued are added to the task instead
+		FVoxelIntBoxWithValidity DirtyBounds;
+
+		// Last time a mesh built by a task was sent to the mesh handler. Used to throttle updates under continuous edits
+		double LastMeshUpdateTime = 0;
+
 		// Chunks that were shown at this position before this one was shown, and that need to be dithered out
 		// once this chunk is updated
 		TArray<uint64, TInlineAllocator<8>> PreviousChunks;
@@ -179,11 +195,14 @@ private:
 	void RemoveOrHideChunk(FChunk& Chunk);
 	void DitherInChunk(FChunk& Chunk, const TArray<uint64, TInlineAllocator<8>>& PreviousChunks);
 	void ApplyPendingSettings(FChunk& Chunk, bool bApplyVisibility);
-	void CheckPendingUpdates(FChunk& Chunk);
+	// If bCanFinishUpdates is false, only starts the tasks needed: used when the built data wasn't sent to the mesh handler yet
+	void CheckPendingUpdates(FChunk& Chunk, bool bCanFinishUpdates = true);
 	
 	void ProcessChunksToRemoveOrShow();
 	void ProcessMeshUpdates(double MaxTime);
 	void FlushQueuedTasks();
+	// Group adjacent main tasks of the same LOD into FVoxelMesherBatchAsyncWork
+	void BatchQueuedTasks(TArray<IVoxelQueuedWork*>& Tasks);
 
 	void DestroyChunk(FChunk& Chunk);
 	
@@ -193,8 +212,14 @@ private:
 	
 	FThreadSafeCounter TaskCount;
 	uint64 UpdateIndex = 0;
+	// Meshes of destroyed chunks, reused if they are recreated before being edited
+	FVoxelChunkMeshCache MeshCache;
 	bool OnWorldLoadedFired = false;
 
+	// Used to log the initial meshing throughput
+	double FirstUpdateTime = 0;
+	int32 NumMeshedChunks = 0;
+
 #if VOXEL_DEBUG
 	TMap<uint64, FVoxelChunkSettings> DebugChunks;
 #endif
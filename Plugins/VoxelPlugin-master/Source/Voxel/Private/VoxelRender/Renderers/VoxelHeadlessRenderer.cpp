@@ -0,0 +1,621 @@
+// Copyright 2020 Phyronnaz
+
+#include "VoxelHeadlessRenderer.h"
+#include "VoxelDefaultRenderer.h"
+#include "VoxelRendererCollisionMeshHandler.h"
+#include "VoxelMessages.h"
+#include "IVoxelPool.h"
+#include "VoxelRender/VoxelMesherAsyncWork.h"
+#include "VoxelRender/VoxelProcMeshBuffers.h"
+#include "VoxelDebug/VoxelDebugManager.h"
+#include "VoxelUtilities/VoxelThreadingUtilities.h"
+
+#include "Misc/App.h"
+#include "Engine/World.h"
+
+static TAutoConsoleVariable<int32> CVarHeadlessRenderer(
+	TEXT("voxel.renderer.HeadlessRenderer"),
+	1,
+	TEXT("0: voxel worlds always use the default renderer. ")
+	TEXT("1: voxel worlds use the headless renderer when nothing can be rendered (dedicated servers, commandlets, -nullrhi). ")
+	TEXT("2: voxel worlds always use the headless renderer. ")
+	TEXT("The headless renderer only builds the collisions & navmesh. Applied when the voxel world is created"),
+	ECVF_Default);
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Voxel Headless Renderer Chunks"), STAT_VoxelHeadlessRendererChunks, STATGROUP_VoxelCounters);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Voxel Headless Renderer Meshed Chunks"), STAT_VoxelHeadlessRendererMeshedChunks, STATGROUP_VoxelCounters);
+
+class FVoxelHeadlessMesherAsyncWork : public FVoxelAsyncWork
+{
+public:
+	const uint64 TaskId = UNIQUE_ID();
+
+	const uint64 ChunkId;
+	const int32 LOD;
+	const FIntVector ChunkPosition;
+
+	// Output. Null if the chunk is empty
+	TUniquePtr<FVoxelProcMeshBuffers> Buffers;
+	double CreationTime = 0;
+
+	FVoxelHeadlessMesherAsyncWork(
+		FVoxelHeadlessRenderer& Renderer,
+		uint64 ChunkId,
+		int32 LOD,
+		const FVoxelIntBox& Bounds)
+		: FVoxelAsyncWork(STATIC_FNAME("FVoxelHeadlessMesherAsyncWork"), Renderer.Settings.PriorityDuration)
+		, ChunkId(ChunkId)
+		, LOD(LOD)
+		, ChunkPosition(Bounds.Min)
+		, Renderer(Renderer.AsShared())
+		, PriorityHandler(Bounds, Renderer.GetInvokersPositionsForPriorities())
+	{
+	}
+
+private:
+	// Important: do not allow public delete
+	virtual ~FVoxelHeadlessMesherAsyncWork() override = default;
+
+	//~ Begin FVoxelAsyncWork Interface
+	virtual void DoWork() override
+	{
+		VOXEL_ASYNC_FUNCTION_COUNTER();
+
+		// Create the cancel counter before checking IsCanceled, else we could miss a cancel
+		const FVoxelCancelCounter CancelCounter = GetCancelCounter();
+
+		auto PinnedRenderer = Renderer.Pin();
+		if (IsCanceled()) return;
+		if (!ensure(PinnedRenderer.IsValid())) return; // Either we're canceled, or the renderer is valid
+
+		CreationTime = FPlatformTime::Seconds();
+
+		TArray<uint32> Indices;
+		TArray<FVector> Vertices;
+		if (FVoxelMesherAsyncWork::CreateGeometry_AnyThread(PinnedRenderer->Settings, LOD, ChunkPosition, Indices, Vertices, &CancelCounter) &&
+			Indices.Num() > 0)
+		{
+			Buffers = CreateBuffers(Indices, Vertices);
+		}
+
+		FVoxelUtilities::DeleteOnGameThread_AnyThread(PinnedRenderer);
+	}
+	virtual void PostDoWork() override
+	{
+		auto RendererPtr = Renderer.Pin();
+		if (ensure(RendererPtr.IsValid()))
+		{
+			RendererPtr->QueueChunkCallback_AnyThread(TaskId, ChunkId);
+			FVoxelUtilities::DeleteOnGameThread_AnyThread(RendererPtr);
+		}
+	}
+	virtual uint32 GetPriority() const override
+	{
+		return PriorityHandler.GetPriority();
+	}
+	//~ End FVoxelAsyncWork Interface
+
+	// Only the positions & indices: there is nothing to render
+	static TUniquePtr<FVoxelProcMeshBuffers> CreateBuffers(const TArray<uint32>& Indices, const TArray<FVector>& Vertices)
+	{
+		VOXEL_ASYNC_FUNCTION_COUNTER();
+
+		auto NewBuffers = MakeUnique<FVoxelProcMeshBuffers>();
+		NewBuffers->Guids.Add(FGuid::NewGuid());
+		NewBuffers->VertexBuffers.PositionVertexBuffer.Init(Vertices, FVoxelProcMeshBuffers::bNeedsCPUAccess);
+
+		auto& IndexBuffer = NewBuffers->IndexBuffer;
+		IndexBuffer.AllocateData(Indices.Num());
+		for (int32 Index = 0; Index < Indices.Num(); Index++)
+		{
+			IndexBuffer.SetIndex(Index, Indices[Index]);
+		}
+
+		NewBuffers->LocalBounds = FBox(Vertices);
+		return NewBuffers;
+	}
+
+	const TVoxelWeakPtr<FVoxelHeadlessRenderer> Renderer;
+	const FVoxelPriorityHandler PriorityHandler;
+
+	template<typename T>
+	friend struct TVoxelAsyncWorkDelete;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+FVoxelHeadlessRenderer::FVoxelHeadlessRenderer(const FVoxelRendererSettings& Settings)
+	: IVoxelRenderer(Settings)
+	, MeshHandler(MakeVoxelShared<FVoxelRendererCollisionMeshHandler>(*this))
+{
+	MeshHandler->Init();
+}
+
+TVoxelSharedRef<FVoxelHeadlessRenderer> FVoxelHeadlessRenderer::Create(const FVoxelRendererSettings& Settings)
+{
+	// No materials: OnMaterialInstanceCreated is never broadcast
+	return MakeShareable(new FVoxelHeadlessRenderer(Settings));
+}
+
+FVoxelHeadlessRenderer::~FVoxelHeadlessRenderer()
+{
+	check(IsInGameThread());
+	ensure(ChunksMap.Num() == 0);
+}
+
+bool FVoxelHeadlessRenderer::ShouldUseHeadlessRenderer(const UWorld* World)
+{
+	switch (CVarHeadlessRenderer.GetValueOnGameThread())
+	{
+	case 0: return false;
+	case 2: return true;
+	default: return !FApp::CanEverRender() || (World && World->GetNetMode() == NM_DedicatedServer);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+void FVoxelHeadlessRenderer::Destroy()
+{
+	// Needed because the async tasks can keep the renderer alive while the voxel world is destroyed
+	VOXEL_FUNCTION_COUNTER();
+
+	StopTicking();
+
+	MeshHandler->StartDestroying();
+
+	for (auto& It : ChunksMap)
+	{
+		CancelTask(It.Value);
+		if (It.Value.MeshId.IsValid())
+		{
+			MeshHandler->RemoveChunk(It.Value.MeshId);
+		}
+	}
+	DEC_DWORD_STAT_BY(STAT_VoxelHeadlessRendererChunks, ChunksMap.Num());
+
+	ChunksMap.Reset();
+	PendingRemovalChunks.Reset();
+	MeshHandler.Reset();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+int32 FVoxelHeadlessRenderer::UpdateChunks(
+	const FVoxelIntBox& Bounds,
+	const TArray<uint64>& ChunksToUpdate,
+	const FVoxelOnChunkUpdateFinished& FinishDelegate)
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	if (Settings.bStaticWorld)
+	{
+		FVoxelMessages::Error("Can't update chunks with bStaticWorld = true!");
+		return 0;
+	}
+
+	const double Time = FPlatformTime::Seconds();
+
+	// Chunks that are only visible are not tracked: their update is not reported
+	int32 NumUpdatedChunks = 0;
+	for (uint64 ChunkId : ChunksToUpdate)
+	{
+		FChunk* Chunk = ChunksMap.Find(ChunkId);
+		if (!Chunk || Chunk->bPendingRemoval) continue;
+
+		Chunk->PendingUpdates.Add({ Time, FinishDelegate });
+		// If a task is already running, a new one will be started in its callback if it was started too early
+		if (!Chunk->Task.IsValid())
+		{
+			StartTask(*Chunk);
+		}
+		NumUpdatedChunks++;
+	}
+
+	FlushQueuedTasks();
+
+	return NumUpdatedChunks;
+}
+
+void FVoxelHeadlessRenderer::UpdateLODs(const uint64 InUpdateIndex, const TArray<FVoxelChunkUpdate>& ChunkUpdates)
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	check(InUpdateIndex > 0);
+	if (Settings.bStaticWorld && InUpdateIndex != 1)
+	{
+		FVoxelMessages::Error("Can't update LODs with bStaticWorld = true!");
+		return;
+	}
+
+	UpdateIndex++;
+	if (!ensure(UpdateIndex == InUpdateIndex)) return;
+
+	if (UpdateIndex == 1)
+	{
+		FirstUpdateTime = FPlatformTime::Seconds();
+	}
+
+	// Chunks that just got collisions or navmesh, and might replace previous chunks
+	TArray<const FVoxelChunkUpdate*> NewChunkUpdates;
+
+	for (auto& ChunkUpdate : ChunkUpdates)
+	{
+		FChunk* Chunk = ChunksMap.Find(ChunkUpdate.Id);
+
+		if (!HasCollisionsOrNavmesh(ChunkUpdate.NewSettings))
+		{
+			if (Chunk && !Chunk->bPendingRemoval)
+			{
+				RemoveChunk(*Chunk);
+			}
+			continue;
+		}
+
+		if (!Chunk)
+		{
+			Chunk = &ChunksMap.Add(ChunkUpdate.Id, FChunk(ChunkUpdate.Id, ChunkUpdate.LOD, ChunkUpdate.Bounds));
+			INC_DWORD_STAT(STAT_VoxelHeadlessRendererChunks);
+			NewChunkUpdates.Add(&ChunkUpdate);
+		}
+		else if (Chunk->bPendingRemoval)
+		{
+			// Back before being replaced: references from the new chunks are now outdated
+			Chunk->bPendingRemoval = false;
+			PendingRemovalChunks.Remove(Chunk->Id);
+			Chunk->RemovalIndex++;
+			Chunk->NumNewChunksLeft = 0;
+			NewChunkUpdates.Add(&ChunkUpdate);
+		}
+		ensure(Chunk->LOD == ChunkUpdate.LOD && Chunk->Bounds == ChunkUpdate.Bounds);
+
+		FVoxelChunkSettings NewSettings{};
+		NewSettings.bEnableCollisions = ChunkUpdate.NewSettings.bEnableCollisions;
+		NewSettings.bEnableNavmesh = ChunkUpdate.NewSettings.bEnableNavmesh;
+
+		const FVoxelChunkSettings OldSettings = Chunk->Settings;
+		Chunk->Settings = NewSettings;
+
+		if (!Chunk->MeshId.IsValid())
+		{
+			Chunk->MeshId = MeshHandler->AddChunk(Chunk->LOD, Chunk->Bounds.Min);
+			StartTask(*Chunk);
+		}
+		else if (OldSettings != NewSettings)
+		{
+			MeshHandler->SetChunkSettings(Chunk->MeshId, NewSettings);
+		}
+	}
+
+	{
+		VOXEL_SCOPE_COUNTER("Previous Chunks");
+
+		// Done once all the chunks are processed, as the chunks they replace might come after them
+		for (const FVoxelChunkUpdate* ChunkUpdate : NewChunkUpdates)
+		{
+			FChunk& NewChunk = ChunksMap.FindChecked(ChunkUpdate->Id);
+			if (NewChunk.bIsBuilt) continue;
+
+			for (uint64 PreviousChunkId : ChunkUpdate->PreviousChunks)
+			{
+				FChunk* PreviousChunk = ChunksMap.Find(PreviousChunkId);
+				if (!PreviousChunk || !PreviousChunk->bPendingRemoval) continue;
+
+				if (!PreviousChunk->bIsBuilt)
+				{
+					// It has no collisions: wait for the chunks it was waiting for instead
+					for (const FChunk::FPreviousChunk& PreviousPreviousChunkRef : PreviousChunk->PreviousChunks)
+					{
+						FChunk* PreviousPreviousChunk = FindPreviousChunk(PreviousPreviousChunkRef);
+						if (!PreviousPreviousChunk) continue;
+
+						NewChunk.PreviousChunks.Add(PreviousPreviousChunkRef);
+						PreviousPreviousChunk->NumNewChunksLeft++;
+					}
+					continue;
+				}
+
+				NewChunk.PreviousChunks.Add({ PreviousChunkId, PreviousChunk->RemovalIndex });
+				PreviousChunk->NumNewChunksLeft++;
+			}
+		}
+
+		// Chunks not replaced by anything can be removed right away, as well as the ones that were never built:
+		// their previous chunks were moved to the chunks replacing them above
+		const TArray<uint64> PendingChunks = PendingRemovalChunks.Array();
+		for (uint64 ChunkId : PendingChunks)
+		{
+			// Might have been destroyed by a previous iteration
+			FChunk* Chunk = ChunksMap.Find(ChunkId);
+			if (Chunk && ensure(Chunk->bPendingRemoval) && (!Chunk->bIsBuilt || Chunk->NumNewChunksLeft == 0))
+			{
+				DestroyChunk(*Chunk);
+			}
+		}
+	}
+
+	FlushQueuedTasks();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+int32 FVoxelHeadlessRenderer::GetTaskCount() const
+{
+	return UpdateIndex > 0 ? TaskCount.GetValue() : -1;
+}
+
+void FVoxelHeadlessRenderer::RecomputeMeshPositions()
+{
+	VOXEL_FUNCTION_COUNTER();
+	MeshHandler->RecomputeMeshPositions();
+}
+
+void FVoxelHeadlessRenderer::ApplyNewMaterials()
+{
+	// Nothing is rendered
+}
+
+void FVoxelHeadlessRenderer::ApplyToAllMeshes(TFunctionRef<void(UVoxelProceduralMeshComponent&)> Lambda)
+{
+	VOXEL_FUNCTION_COUNTER();
+	MeshHandler->ApplyToAllMeshes(Lambda);
+}
+
+void FVoxelHeadlessRenderer::CreateGeometry_AnyThread(
+	int32 LOD,
+	const FIntVector& ChunkPosition,
+	TArray<uint32>& OutIndices,
+	TArray<FVector>& OutVertices) const
+{
+	FVoxelMesherAsyncWork::CreateGeometry_AnyThread(Settings, LOD, ChunkPosition, OutIndices, OutVertices);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+void FVoxelHeadlessRenderer::Tick(float DeltaTime)
+{
+	TickWithBudget(DeltaTime, MAX_dbl);
+}
+
+void FVoxelHeadlessRenderer::TickWithBudget(float DeltaTime, double SchedulerMaxTime)
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	const double Time = FPlatformTime::Seconds();
+	const double MaxTime = FMath::Min(Time + Settings.MeshUpdatesBudget * 0.001f, SchedulerMaxTime);
+
+	// Collision cooker callbacks
+	MeshHandler->Tick(MaxTime);
+
+	ProcessMeshUpdates(MaxTime);
+	FlushQueuedTasks();
+
+	if (!OnWorldLoadedFired && UpdateIndex > 0 && TaskCount.GetValue() == 0 && TasksCallbacksQueue.IsEmpty())
+	{
+		if (CVarLogMeshingThroughput.GetValueOnGameThread() != 0)
+		{
+			const double Duration = FPlatformTime::Seconds() - FirstUpdateTime;
+			LOG_VOXEL(Log, TEXT("Headless renderer: world loaded in %.3fs, %d chunks meshed (%.1f chunks/s)"),
+				Duration,
+				NumMeshedChunks,
+				Duration > 0 ? NumMeshedChunks / Duration : 0.);
+		}
+
+		OnWorldLoaded.Broadcast();
+		OnWorldLoadedFired = true;
+	}
+
+	Settings.DebugManager->ReportMeshTaskCount(TaskCount.GetValue());
+	Settings.DebugManager->ReportMeshTasksCallbacksQueueNum(TasksCallbacksQueue.Num());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+void FVoxelHeadlessRenderer::StartTask(FChunk& Chunk)
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	ensure(!Chunk.bPendingRemoval);
+
+	if (Chunk.Task.IsValid())
+	{
+		CancelTask(Chunk);
+	}
+
+	Chunk.Task = TUniquePtr<FVoxelHeadlessMesherAsyncWork, TVoxelAsyncWorkDelete<FVoxelHeadlessMesherAsyncWork>>(
+		new FVoxelHeadlessMesherAsyncWork(*this, Chunk.Id, Chunk.LOD, Chunk.Bounds));
+	QueuedTasks.Add(Chunk.Task.Get());
+}
+
+void FVoxelHeadlessRenderer::CancelTask(FChunk& Chunk)
+{
+	if (!Chunk.Task.IsValid()) return;
+
+	VOXEL_FUNCTION_COUNTER();
+
+	// Might not be flushed yet
+	if (QueuedTasks.RemoveSingleSwap(Chunk.Task.Get(), false))
+	{
+		// Never queued: safe to delete directly
+		Chunk.Task.Reset();
+		return;
+	}
+
+	const bool bIsDone = Chunk.Task->CancelAndAutodelete();
+	Chunk.Task.Release();
+	if (!bIsDone)
+	{
+		// If IsDone, QueueChunkCallback_AnyThread was called
+		ensure(TaskCount.Decrement() >= 0);
+	}
+}
+
+void FVoxelHeadlessRenderer::RemoveChunk(FChunk& Chunk)
+{
+	VOXEL_FUNCTION_COUNTER();
+	ensure(!Chunk.bPendingRemoval);
+
+	CancelTask(Chunk);
+	// Nothing to wait for: it won't be built anymore
+	Chunk.PendingUpdates.Reset();
+
+	if (!Chunk.bIsBuilt && Chunk.PreviousChunks.Num() == 0)
+	{
+		DestroyChunk(Chunk);
+		return;
+	}
+
+	// Keep the collisions until the new chunks are built. Destroyed at the end of UpdateLODs if there are none
+	// If it was never built, it's only kept until the chunks replacing it take over its previous chunks
+	Chunk.bPendingRemoval = true;
+	Chunk.RemovalIndex++;
+	Chunk.NumNewChunksLeft = 0;
+	PendingRemovalChunks.Add(Chunk.Id);
+
+	if (Chunk.bIsBuilt)
+	{
+		// Anything we were waiting for is replaced too
+		ReleasePreviousChunks(Chunk);
+	}
+}
+
+void FVoxelHeadlessRenderer::DestroyChunk(FChunk& Chunk)
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	CancelTask(Chunk);
+	ReleasePreviousChunks(Chunk);
+
+	if (Chunk.MeshId.IsValid())
+	{
+		MeshHandler->RemoveChunk(Chunk.MeshId);
+		Chunk.MeshId.Reset();
+	}
+
+	DEC_DWORD_STAT(STAT_VoxelHeadlessRendererChunks);
+	PendingRemovalChunks.Remove(Chunk.Id);
+	ChunksMap.Remove(Chunk.Id);
+}
+
+void FVoxelHeadlessRenderer::OnChunkBuilt(FChunk& Chunk)
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	check(Chunk.Task.IsValid() && Chunk.Task->IsDone());
+
+	const double CreationTime = Chunk.Task->CreationTime;
+	MeshHandler->SetChunkBuffers(Chunk.MeshId, Chunk.Settings, MoveTemp(Chunk.Task->Buffers));
+	Chunk.Task.Reset();
+
+	Chunk.bIsBuilt = true;
+	NumMeshedChunks++;
+	INC_DWORD_STAT(STAT_VoxelHeadlessRendererMeshedChunks);
+
+	bool bNeedsNewTask = false;
+	for (int32 Index = 0; Index < Chunk.PendingUpdates.Num(); Index++)
+	{
+		const auto& PendingUpdate = Chunk.PendingUpdates[Index];
+		if (PendingUpdate.WantedUpdateTime < CreationTime)
+		{
+			PendingUpdate.OnUpdateFinished.Broadcast(Chunk.Bounds);
+			Chunk.PendingUpdates.RemoveAtSwap(Index);
+			Index--;
+		}
+		else
+		{
+			// Edited after the task started
+			bNeedsNewTask = true;
+		}
+	}
+	if (bNeedsNewTask)
+	{
+		StartTask(Chunk);
+	}
+
+	ReleasePreviousChunks(Chunk);
+}
+
+void FVoxelHeadlessRenderer::ReleasePreviousChunks(FChunk& Chunk)
+{
+	if (Chunk.PreviousChunks.Num() == 0) return;
+
+	VOXEL_FUNCTION_COUNTER();
+
+	// Destroying the previous chunks doesn't invalidate Chunk, as the map is not compacted
+	const auto PreviousChunks = MoveTemp(Chunk.PreviousChunks);
+	Chunk.PreviousChunks.Reset();
+
+	for (auto& PreviousChunkRef : PreviousChunks)
+	{
+		FChunk* PreviousChunk = FindPreviousChunk(PreviousChunkRef);
+		if (!PreviousChunk) continue;
+
+		ensure(PreviousChunk->NumNewChunksLeft > 0);
+		if (--PreviousChunk->NumNewChunksLeft <= 0)
+		{
+			DestroyChunk(*PreviousChunk);
+		}
+	}
+}
+
+FVoxelHeadlessRenderer::FChunk* FVoxelHeadlessRenderer::FindPreviousChunk(const FChunk::FPreviousChunk& PreviousChunkRef)
+{
+	FChunk* PreviousChunk = ChunksMap.Find(PreviousChunkRef.Id);
+	if (!PreviousChunk ||
+		!PreviousChunk->bPendingRemoval ||
+		PreviousChunk->RemovalIndex != PreviousChunkRef.RemovalIndex)
+	{
+		return nullptr;
+	}
+	return PreviousChunk;
+}
+
+void FVoxelHeadlessRenderer::ProcessMeshUpdates(double MaxTime)
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	FTaskCallback Callback;
+	while ( // First check the time, else dequeued elements aren't processed!
+		FPlatformTime::Seconds() < MaxTime &&
+		TasksCallbacksQueue.Dequeue(Callback))
+	{
+		FChunk* Chunk = ChunksMap.Find(Callback.ChunkId);
+		if (!Chunk) continue;
+
+		auto& Task = Chunk->Task;
+		if (!Task.IsValid() || Task->TaskId != Callback.TaskId) continue; // If task was canceled
+		if (!ensure(Task->IsDone())) continue; // Must be done if we're in the callback
+
+		OnChunkBuilt(*Chunk);
+	}
+}
+
+void FVoxelHeadlessRenderer::FlushQueuedTasks()
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	if (QueuedTasks.Num() > 0)
+	{
+		TaskCount.Add(QueuedTasks.Num());
+		Settings.Pool->QueueTasks(EVoxelTaskType::CollisionsChunksMeshing, QueuedTasks);
+		QueuedTasks.Reset();
+	}
+}
+
+void FVoxelHeadlessRenderer::QueueChunkCallback_AnyThread(uint64 TaskId, uint64 ChunkId)
+{
+	ensure(TaskCount.Decrement() >= 0);
+	TasksCallbacksQueue.Enqueue({ TaskId, ChunkId });
+}
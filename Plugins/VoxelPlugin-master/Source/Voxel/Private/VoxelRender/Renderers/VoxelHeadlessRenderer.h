@@ -0,0 +1,151 @@
+// Copyright 2020 Phyronnaz
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VoxelRender/IVoxelRenderer.h"
+#include "VoxelRender/VoxelChunkToUpdate.h"
+#include "VoxelRendererMeshHandler.h"
+#include "VoxelTickable.h"
+#include "VoxelQueueWithNum.h"
+#include "VoxelAsyncWork.h"
+
+class FVoxelRendererCollisionMeshHandler;
+class FVoxelHeadlessMesherAsyncWork;
+
+/**
+ * Renderer used when nothing is drawn, eg on dedicated servers
+ *
+ * Only tracks the chunks with collisions or navmesh, and only meshes their positions & indices
+ * The meshing tasks directly build the proc mesh buffers, which are given to a hidden section:
+ * no material lookup, no merge task, no dithering, no transitions and no scene proxy
+ *
+ * Chunks being replaced by a LOD change are kept until their replacements are built, to not leave holes in the collisions
+ */
+class FVoxelHeadlessRenderer : public IVoxelRenderer, public FVoxelTickable, public TVoxelSharedFromThis<FVoxelHeadlessRenderer>
+{
+public:
+	static TVoxelSharedRef<FVoxelHeadlessRenderer> Create(const FVoxelRendererSettings& Settings);
+	virtual ~FVoxelHeadlessRenderer() override;
+
+	// See voxel.renderer.HeadlessRenderer. By default, true when nothing can be rendered (dedicated servers, commandlets, -nullrhi)
+	static bool ShouldUseHeadlessRenderer(const UWorld* World);
+
+private:
+	explicit FVoxelHeadlessRenderer(const FVoxelRendererSettings& Settings);
+
+public:
+	//~ Begin IVoxelRender Interface
+	virtual void Destroy() override;
+
+	virtual int32 UpdateChunks(const FVoxelIntBox& Bounds, const TArray<uint64>& ChunksToUpdate, const FVoxelOnChunkUpdateFinished& FinishDelegate) override;
+	virtual void UpdateLODs(uint64 InUpdateIndex, const TArray<FVoxelChunkUpdate>& ChunkUpdates) override;
+
+	virtual int32 GetTaskCount() const override;
+
+	virtual void RecomputeMeshPositions() override;
+	virtual void ApplyNewMaterials() override;
+	virtual void ApplyToAllMeshes(TFunctionRef<void(UVoxelProceduralMeshComponent&)> Lambda) override;
+
+	virtual void CreateGeometry_AnyThread(
+		int32 LOD,
+		const FIntVector& ChunkPosition,
+		TArray<uint32>& OutIndices,
+		TArray<FVector>& OutVertices) const override;
+	//~ End IVoxelRender Interface
+
+	//~ Begin FVoxelTickable Interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickableInEditor() const override { return true; }
+	virtual EVoxelGameThreadWork GetGameThreadWork() const override { return EVoxelGameThreadWork::Renderer; }
+	virtual void TickWithBudget(float DeltaTime, double MaxTime) override;
+	//~ End FVoxelTickable Interface
+
+private:
+	struct FChunk
+	{
+		const uint64 Id;
+		const uint8 LOD;
+		const FVoxelIntBox Bounds;
+
+		FChunk(uint64 Id, uint8 LOD, const FVoxelIntBox& Bounds)
+			: Id(Id)
+			, LOD(LOD)
+			, Bounds(Bounds)
+		{
+		}
+
+		// Only collisions & navmesh are relevant
+		FVoxelChunkSettings Settings{};
+		IVoxelRendererMeshHandler::FChunkId MeshId;
+
+		TUniquePtr<FVoxelHeadlessMesherAsyncWork, TVoxelAsyncWorkDelete<FVoxelHeadlessMesherAsyncWork>> Task;
+		// Whether a mesh was built once
+		bool bIsBuilt = false;
+
+		struct FPendingUpdate
+		{
+			// We want the mesh to be from a task that was built >= at this time
+			double WantedUpdateTime = 0;
+			FVoxelOnChunkUpdateFinished OnUpdateFinished;
+		};
+		TArray<FPendingUpdate, TInlineAllocator<2>> PendingUpdates;
+
+		// Removed by the LOD manager, but kept until the new chunks at its position are built
+		bool bPendingRemoval = false;
+		// Incremented every time the chunk is kept for removal, to detect outdated references in PreviousChunks
+		uint32 RemovalIndex = 0;
+		int32 NumNewChunksLeft = 0;
+
+		// Chunks waiting for us to be built before being removed
+		struct FPreviousChunk
+		{
+			uint64 Id = 0;
+			uint32 RemovalIndex = 0;
+		};
+		TArray<FPreviousChunk, TInlineAllocator<8>> PreviousChunks;
+	};
+	TMap<uint64, FChunk> ChunksMap;
+	// Chunks with bPendingRemoval, to not iterate ChunksMap on every LOD update
+	TSet<uint64> PendingRemovalChunks;
+
+	TVoxelSharedPtr<FVoxelRendererCollisionMeshHandler> MeshHandler;
+
+	TArray<IVoxelQueuedWork*> QueuedTasks;
+	FThreadSafeCounter TaskCount;
+	uint64 UpdateIndex = 0;
+	bool OnWorldLoadedFired = false;
+
+	// Used to log the initial meshing throughput
+	double FirstUpdateTime = 0;
+	int32 NumMeshedChunks = 0;
+
+	void StartTask(FChunk& Chunk);
+	void CancelTask(FChunk& Chunk);
+	// Keeps the chunk until its replacements are built if it has a mesh or is waiting for previous chunks, else destroys it
+	void RemoveChunk(FChunk& Chunk);
+	void DestroyChunk(FChunk& Chunk);
+	void OnChunkBuilt(FChunk& Chunk);
+	// Called once Chunk is built or destroyed
+	void ReleasePreviousChunks(FChunk& Chunk);
+	// Null if the previous chunk was destroyed or is not pending removal anymore
+	FChunk* FindPreviousChunk(const FChunk::FPreviousChunk& PreviousChunkRef);
+	void ProcessMeshUpdates(double MaxTime);
+	void FlushQueuedTasks();
+
+	static bool HasCollisionsOrNavmesh(const FVoxelChunkSettings& ChunkSettings)
+	{
+		return ChunkSettings.bEnableCollisions || ChunkSettings.bEnableNavmesh;
+	}
+
+public:
+	void QueueChunkCallback_AnyThread(uint64 TaskId, uint64 ChunkId);
+
+private:
+	struct FTaskCallback
+	{
+		uint64 TaskId;
+		uint64 ChunkId;
+	};
+	TVoxelQueueWithNum<FTaskCallback, EQueueMode::Mpsc> TasksCallbacksQueue;
+};
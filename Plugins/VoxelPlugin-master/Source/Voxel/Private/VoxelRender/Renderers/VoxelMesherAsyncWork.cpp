@@ -5,11 +5,22 @@
 #include "VoxelRender/Meshers/VoxelMarchingCubeMesher.h"
 #include "VoxelRender/Meshers/VoxelCubicMesher.h"
 #include "VoxelRender/Meshers/VoxelSurfaceNetMesher.h"
+#include "VoxelRender/Meshers/VoxelDualContouringMesher.h"
 #include "VoxelRender/VoxelChunkMesh.h"
 
 #include "Async/Async.h"
 #include "Misc/MessageDialog.h"
 #include "VoxelUtilities/VoxelThreadingUtilities.h"
+#include "VoxelUtilities/VoxelIntVectorUtilities.h"
+#include "VoxelThreadPool.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<int32> CVarAffinityRegionSize(
+	TEXT("voxel.threading.AffinityRegionSize"),
+	128,
+	TEXT("Size in voxels of the regions used to route meshing tasks to worker groups when voxel.threading.NumAffinityGroups is > 0. ")
+	TEXT("Chunks in the same region are meshed by the same group, which keeps the data they read in the same caches"),
+	ECVF_Default);
 
 FVoxelMesherAsyncWork::FVoxelMesherAsyncWork(
 	FVoxelDefaultRenderer& Renderer,
@@ -17,18 +28,25 @@ FVoxelMesherAsyncWork::FVoxelMesherAsyncWork(
 	const int32 LOD,
 	const FVoxelIntBox& Bounds,
 	const bool bIsTransitionTask,
-	const uint8 TransitionsMask)
+	const uint8 TransitionsMask,
+	const FVoxelIntBox& DirtyBounds,
+	const TVoxelSharedPtr<const FVoxelChunkMesh>& PreviousChunk,
+	const bool bIsVisible)
 	: FVoxelAsyncWork(STATIC_FNAME("FVoxelMesherAsyncWork"), Renderer.Settings.PriorityDuration)
 	, ChunkId(ChunkId)
 	, LOD(LOD)
 	, ChunkPosition(Bounds.Min)
 	, bIsTransitionTask(bIsTransitionTask)
 	, TransitionsMask(TransitionsMask)
+	, DirtyBounds(DirtyBounds)
+	, PreviousChunk(PreviousChunk)
 	, Renderer(Renderer.AsShared())
-	, PriorityHandler(Bounds, Renderer.GetInvokersPositionsForPriorities())
+	// Only the rendered chunks depend on the view
+	, PriorityHandler(Bounds, Renderer.GetInvokersPositionsForPriorities(), bIsVisible)
 {
 	check(IsInGameThread());
 	ensure(!bIsTransitionTask || TransitionsMask != 0);
+	ensure(!PreviousChunk.IsValid() || (!bIsTransitionTask && CanUpdateIncrementally(Renderer.Settings)));
 }
 
 FVoxelMesherAsyncWork::~FVoxelMesherAsyncWork()
@@ -59,6 +77,21 @@ void FVoxelMesherAsyncWork::DoWork()
 {
 	VOXEL_ASYNC_FUNCTION_COUNTER();
 
+	if (CachedChunk.IsValid())
+	{
+		{
+			FScopeLock Lock(&StartSection);
+			bStarted = true;
+		}
+		// Nothing to build
+		Chunk = CachedChunk;
+		CreationTime = CachedChunkCreationTime;
+		return;
+	}
+
+	// Create the cancel counter before checking IsCanceled, else we could miss a cancel
+	const FVoxelCancelCounter CancelCounter = GetCancelCounter();
+
 	auto PinnedRenderer = Renderer.Pin();
 	if (IsCanceled()) return;
 	if (!ensure(PinnedRenderer.IsValid())) return; // Either we're canceled, or the renderer is valid
@@ -69,12 +102,40 @@ void FVoxelMesherAsyncWork::DoWork()
 		ChunkPosition,
 		bIsTransitionTask,
 		TransitionsMask);
+	Mesher->SetCancelCounter(CancelCounter);
 
-	CreationTime = FPlatformTime::Seconds();
+	// Freeze DirtyBounds before giving them to the mesher
+	MarkStarted();
+
+	if (Batch)
+	{
+		check(!bIsTransitionTask && FVoxelMesherBatchAsyncWork::CanBatch(PinnedRenderer->Settings));
+		static_cast<FVoxelMarchingCubeMesher&>(*Mesher).SetBatch(*Batch);
+	}
+	if (PreviousChunk.IsValid())
+	{
+		check(!Batch && !bIsTransitionTask && CanUpdateIncrementally(PinnedRenderer->Settings));
+		static_cast<FVoxelMarchingCubeMesher&>(*Mesher).SetIncrementalUpdate(DirtyBounds, PreviousChunk.ToSharedRef());
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	const auto ReportEarlyExit = [&]()
+	{
+		FVoxelQueuedThreadPoolStats::Get().ReportEarlyExit(Name, FPlatformTime::Seconds() - StartTime);
+		FVoxelUtilities::DeleteOnGameThread_AnyThread(PinnedRenderer);
+	};
 
 	if (PinnedRenderer->Settings.bRenderWorld)
 	{
 		const auto MesherChunk = Mesher->CreateFullChunk();
+		if (Mesher->IsCanceled())
+		{
+			// The renderer discarded this task, no need to show an error
+			ReportEarlyExit();
+			return;
+		}
+		
 		if (MesherChunk.IsValid())
 		{
 			Chunk = MesherChunk.ToSharedRef();
@@ -92,14 +153,22 @@ void FVoxelMesherAsyncWork::DoWork()
 		TArray<uint32> Indices;
 		TArray<FVector> Vertices;
 		Mesher->CreateGeometry(Indices, Vertices);
+		if (Mesher->IsCanceled())
+		{
+			ReportEarlyExit();
+			return;
+		}
 		
-		Chunk = MakeVoxelShared<FVoxelChunkMesh>();
-		Chunk->SetIsSingle(true);
-		FVoxelChunkMeshBuffers& Buffers = Chunk->CreateSingleBuffers();
+		const auto GeometryChunk = MakeVoxelShared<FVoxelChunkMesh>();
+		GeometryChunk->SetIsSingle(true);
+		FVoxelChunkMeshBuffers& Buffers = GeometryChunk->CreateSingleBuffers();
 
 		Buffers.Indices = MoveTemp(Indices);
 		Buffers.Positions = MoveTemp(Vertices);
+		Chunk = GeometryChunk;
 	}
+
+	MeshingTime = FPlatformTime::Seconds() - StartTime;
 	
 	FVoxelUtilities::DeleteOnGameThread_AnyThread(PinnedRenderer);
 }
@@ -116,11 +185,54 @@ void FVoxelMesherAsyncWork::PostDoWork()
 	}
 }
 
+bool FVoxelMesherAsyncWork::TryAddDirtyBounds(const FVoxelIntBox& Bounds)
+{
+	check(IsInGameThread());
+	
+	FScopeLock Lock(&StartSection);
+	if (bStarted)
+	{
+		return false;
+	}
+	if (PreviousChunk.IsValid())
+	{
+		DirtyBounds = DirtyBounds.Union(Bounds);
+	}
+	// Else it's a full remesh, which will see the edit anyways
+	return true;
+}
+
+void FVoxelMesherAsyncWork::MarkStarted()
+{
+	FScopeLock Lock(&StartSection);
+	if (!bStarted)
+	{
+		bStarted = true;
+		CreationTime = FPlatformTime::Seconds();
+	}
+}
+
+bool FVoxelMesherAsyncWork::CanUpdateIncrementally(const FVoxelRendererSettings& Settings)
+{
+	return
+		Settings.bRenderWorld &&
+		Settings.RenderType == EVoxelRenderType::MarchingCubes &&
+		FVoxelMarchingCubeMesher::CanUpdateIncrementally(Settings);
+}
+
 uint32 FVoxelMesherAsyncWork::GetPriority() const
 {
 	return PriorityHandler.GetPriority();
 }
 
+uint32 FVoxelMesherAsyncWork::GetAffinityHash() const
+{
+	// Don't hash the LOD: all the LODs of a region read the same data octree leaves
+	const int32 RegionSize = FMath::Max(1, CVarAffinityRegionSize.GetValueOnAnyThread());
+	const FIntVector Region = FVoxelUtilities::DivideFloor(ChunkPosition, RegionSize);
+	return FMath::Max<uint32>(1, GetTypeHash(Region));
+}
+
 TUniquePtr<FVoxelMesherBase> FVoxelMesherAsyncWork::GetMesher(
 	const FVoxelRendererSettings& Settings,
 	int32 LOD,
@@ -167,16 +279,131 @@ TUniquePtr<FVoxelMesherBase> FVoxelMesherAsyncWork::GetMesher(
 			return MakeUnique<FVoxelSurfaceNetMesher>(LOD, ChunkPosition, Settings);
 		}
 	}
+	case EVoxelRenderType::DualContouring:
+	{
+		if (bIsTransitionTask)
+		{
+			check(false);
+			return nullptr;
+		}
+		else
+		{
+			return MakeUnique<FVoxelDualContouringMesher>(LOD, ChunkPosition, Settings);
+		}
+	}
 	}
 }
 
-void FVoxelMesherAsyncWork::CreateGeometry_AnyThread(
-	const FVoxelDefaultRenderer& Renderer, 
+bool FVoxelMesherAsyncWork::CreateGeometry_AnyThread(
+	const FVoxelRendererSettings& Settings, 
 	int32 LOD, 
 	const FIntVector& ChunkPosition, 
 	TArray<uint32>& OutIndices, 
-	TArray<FVector>& OutVertices)
+	TArray<FVector>& OutVertices,
+	const FVoxelCancelCounter* CancelCounter)
 {
-	const auto Mesher = GetMesher(Renderer.Settings, LOD, ChunkPosition, false, 0);
+	const auto Mesher = GetMesher(Settings, LOD, ChunkPosition, false, 0);
+	if (CancelCounter)
+	{
+		Mesher->SetCancelCounter(*CancelCounter);
+	}
 	Mesher->CreateGeometry(OutIndices, OutVertices);
-}
\ No newline at end of file
+	return !Mesher->IsCanceled();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+FVoxelMesherBatchAsyncWork::FVoxelMesherBatchAsyncWork(
+	FVoxelDefaultRenderer& Renderer,
+	int32 LOD,
+	const FVoxelIntBox& ChunksBounds,
+	TArray<FVoxelMesherAsyncWork*>&& InTasks)
+	: IVoxelQueuedWork(STATIC_FNAME("FVoxelMesherBatchAsyncWork"), Renderer.Settings.PriorityDuration)
+	, LOD(LOD)
+	, ChunksBounds(ChunksBounds)
+	, Renderer(Renderer.AsShared())
+	, Tasks(MoveTemp(InTasks))
+{
+	check(IsInGameThread());
+	check(CanBatch(Renderer.Settings));
+	ensure(Tasks.Num() > 1);
+	for (auto* Task : Tasks)
+	{
+		check(!Task->bIsTransitionTask && Task->LOD == LOD);
+	}
+}
+
+FVoxelMesherBatchAsyncWork::~FVoxelMesherBatchAsyncWork()
+{
+}
+
+bool FVoxelMesherBatchAsyncWork::CanBatch(const FVoxelRendererSettings& Settings)
+{
+	return Settings.RenderType == EVoxelRenderType::MarchingCubes;
+}
+
+void FVoxelMesherBatchAsyncWork::DoThreadedWork()
+{
+	VOXEL_ASYNC_FUNCTION_COUNTER();
+
+	TUniquePtr<FVoxelMarchingCubeMesherBatch> Batch;
+	
+	auto PinnedRenderer = Renderer.Pin();
+	if (PinnedRenderer.IsValid())
+	{
+		// If the renderer is gone, the tasks were all canceled and will just delete themselves
+		// The values are queried for all the tasks here: edits made after that must not be added to them
+		for (auto* Task : Tasks)
+		{
+			Task->MarkStarted();
+		}
+		
+		Batch = MakeUnique<FVoxelMarchingCubeMesherBatch>(*PinnedRenderer->Settings.Data, PinnedRenderer->Settings, LOD, ChunksBounds);
+		Batch->LockAndQueryValues();
+	}
+
+	for (auto* Task : Tasks)
+	{
+		Task->Batch = Batch.Get();
+		// Might delete the task if it was canceled
+		Task->DoThreadedWork();
+	}
+
+	if (Batch.IsValid())
+	{
+		Batch->Unlock();
+		Batch.Reset();
+		FVoxelUtilities::DeleteOnGameThread_AnyThread(PinnedRenderer);
+	}
+
+	delete this;
+}
+
+void FVoxelMesherBatchAsyncWork::Abandon()
+{
+	VOXEL_ASYNC_FUNCTION_COUNTER();
+
+	for (auto* Task : Tasks)
+	{
+		Task->Abandon();
+	}
+
+	delete this;
+}
+
+uint32 FVoxelMesherBatchAsyncWork::GetPriority() const
+{
+	uint32 Priority = 0;
+	for (auto* Task : Tasks)
+	{
+		Priority = FMath::Max(Priority, Task->GetPriority());
+	}
+	return Priority;
+}
+
+uint32 FVoxelMesherBatchAsyncWork::GetAffinityHash() const
+{
+	return Tasks.Num() > 0 ? Tasks[0]->GetAffinityHash() : 0;
+}
@@ -153,7 +153,7 @@ void FVoxelRendererBasicMeshHandler::ApplyAction(const FAction& Action)
 		NewAction.UpdateChunk().AfterCall.DistanceFieldVolumeData = Action.UpdateChunk().InitialCall.MainChunk->GetDistanceFieldVolumeData();
 		ActionQueue.Enqueue(NewAction);
 			
-		if (Renderer.Settings.RenderType == EVoxelRenderType::SurfaceNets)
+		if (Renderer.Settings.IsDualRenderType())
 		{
 			SetTransitionsMaskForSurfaceNets(Action.ChunkId, Action.UpdateChunk().InitialCall.ChunkSettings.TransitionsMask);
 		}
@@ -12,6 +12,32 @@
 #include "VoxelAsyncWork.h"
 
 #include "Async/Async.h"
+#include "Misc/ScopeLock.h"
+
+struct FVoxelClusterMergeTimes
+{
+	int32 NumMerges = 0;
+	double TotalTime = 0;
+	double MaxTime = 0;
+	uint64 NumVertices = 0;
+};
+static FCriticalSection GVoxelClusterMergeTimesSection;
+static FVoxelClusterMergeTimes GVoxelClusterMergeTimes;
+
+static FAutoConsoleCommand LogClusterMergeTimesCmd(
+	TEXT("voxel.renderer.LogClusterMergeTimes"),
+	TEXT("Log the clustered mesh merge times since the last call"),
+	FConsoleCommandDelegate::CreateLambda([]()
+	{
+		FScopeLock Lock(&GVoxelClusterMergeTimesSection);
+		const FVoxelClusterMergeTimes& Times = GVoxelClusterMergeTimes;
+		LOG_VOXEL(Log, TEXT("Cluster merges: %d, average %.3fms, max %.3fms. Vertices merged: %llu"),
+			Times.NumMerges,
+			Times.NumMerges > 0 ? 1000. * Times.TotalTime / Times.NumMerges : 0.,
+			1000. * Times.MaxTime,
+			Times.NumVertices);
+		GVoxelClusterMergeTimes = {};
+	}));
 
 class FVoxelClusteredMeshMergeWork : public FVoxelAsyncWork
 {
@@ -69,6 +95,8 @@ private:
 			// Canceled
 			return;
 		}
+		const double StartTime = FPlatformTime::Seconds();
+		
 		FVoxelChunkMeshesToBuild RealMap;
 		for (auto& ChunkIt : MeshesToBuild)
 		{
@@ -88,6 +116,27 @@ private:
 			// Canceled
 			return;
 		}
+		
+		{
+			const double Time = FPlatformTime::Seconds() - StartTime;
+			
+			uint64 NumVertices = 0;
+			for (auto& MeshIt : *BuiltMeshes)
+			{
+				for (auto& SectionIt : MeshIt.Value)
+				{
+					NumVertices += SectionIt.Value.IsValid() ? SectionIt.Value->GetNumVertices() : 0;
+				}
+			}
+			
+			FScopeLock Lock(&GVoxelClusterMergeTimesSection);
+			FVoxelClusterMergeTimes& Times = GVoxelClusterMergeTimes;
+			Times.NumMerges++;
+			Times.TotalTime += Time;
+			Times.MaxTime = FMath::Max(Times.MaxTime, Time);
+			Times.NumVertices += NumVertices;
+		}
+		
 		auto HandlerPinned = Handler.Pin();
 		if (HandlerPinned.IsValid())
 		{
@@ -0,0 +1,120 @@
+// Copyright 2020 Phyronnaz
+
+#include "VoxelRendererCollisionMeshHandler.h"
+#include "VoxelRender/IVoxelRenderer.h"
+#include "VoxelRender/VoxelProceduralMeshComponent.h"
+#include "VoxelRender/VoxelProcMeshBuffers.h"
+
+FVoxelRendererCollisionMeshHandler::~FVoxelRendererCollisionMeshHandler()
+{
+	ensure(ChunkInfos.Num() == 0);
+}
+
+void FVoxelRendererCollisionMeshHandler::SetChunkBuffers(FChunkId ChunkId, const FVoxelChunkSettings& ChunkSettings, TUniquePtr<FVoxelProcMeshBuffers> Buffers)
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	if (!ensure(ChunkInfos.IsValidIndex(ChunkId))) return;
+	ensure(ChunkSettings.bEnableCollisions || ChunkSettings.bEnableNavmesh);
+
+	auto& ChunkInfo = ChunkInfos[ChunkId];
+
+	if (!Buffers.IsValid() || Buffers->GetNumIndices() == 0)
+	{
+		// Keep the mesh: chunks going empty usually get geometry again on the next edit
+		if (ChunkInfo.Mesh.IsValid())
+		{
+			ChunkInfo.Mesh->ClearSections(EVoxelProcMeshSectionUpdate::UpdateNow);
+		}
+		return;
+	}
+
+	if (!ChunkInfo.Mesh.IsValid())
+	{
+		ChunkInfo.Mesh = GetNewMesh(ChunkId, ChunkInfo.Position, ChunkInfo.LOD);
+		if (!ensureVoxelSlow(ChunkInfo.Mesh.IsValid())) return;
+	}
+
+	auto& Mesh = *ChunkInfo.Mesh;
+	Mesh.ClearSections(EVoxelProcMeshSectionUpdate::DelayUpdate);
+	Mesh.AddProcMeshSection(
+		FVoxelProcMeshSectionSettings(nullptr, ChunkSettings.bEnableCollisions, ChunkSettings.bEnableNavmesh, false, false),
+		MoveTemp(Buffers),
+		EVoxelProcMeshSectionUpdate::DelayUpdate);
+	Mesh.FinishSectionsUpdates();
+}
+
+void FVoxelRendererCollisionMeshHandler::SetChunkSettings(FChunkId ChunkId, const FVoxelChunkSettings& ChunkSettings)
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	if (!ensure(ChunkInfos.IsValidIndex(ChunkId))) return;
+	ensure(ChunkSettings.bEnableCollisions || ChunkSettings.bEnableNavmesh);
+
+	auto& ChunkInfo = ChunkInfos[ChunkId];
+	if (!ChunkInfo.Mesh.IsValid())
+	{
+		// Not built yet, or empty
+		return;
+	}
+
+	auto& Mesh = *ChunkInfo.Mesh;
+	Mesh.IterateSectionsSettings([&](FVoxelProcMeshSectionSettings& SectionSettings)
+	{
+		SectionSettings.bEnableCollisions = ChunkSettings.bEnableCollisions;
+		SectionSettings.bEnableNavmesh = ChunkSettings.bEnableNavmesh;
+	});
+	// Only rebuilds what was toggled, as the buffers GUIDs didn't change
+	Mesh.FinishSectionsUpdates();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+IVoxelRendererMeshHandler::FChunkId FVoxelRendererCollisionMeshHandler::AddChunkImpl(int32 LOD, const FIntVector& Position)
+{
+	FChunkInfo ChunkInfo;
+	ChunkInfo.LOD = LOD;
+	ChunkInfo.Position = Position;
+	return ChunkInfos.Add(ChunkInfo);
+}
+
+void FVoxelRendererCollisionMeshHandler::ApplyAction(const FAction& Action)
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	switch (Action.Action)
+	{
+	case EAction::UpdateChunk:
+	{
+		ensureMsgf(false, TEXT("The collision mesh handler is updated through SetChunkBuffers"));
+		break;
+	}
+	case EAction::RemoveChunk:
+	{
+		auto& ChunkInfo = ChunkInfos[Action.ChunkId];
+		if (ChunkInfo.Mesh.IsValid())
+		{
+			RemoveMesh(*ChunkInfo.Mesh);
+		}
+		ChunkInfos.RemoveAt(Action.ChunkId);
+		break;
+	}
+	case EAction::DitherChunk:
+	case EAction::ResetDithering:
+	case EAction::SetTransitionsMaskForSurfaceNets:
+	case EAction::HideChunk:
+	case EAction::ShowChunk:
+	{
+		// Nothing is rendered
+		break;
+	}
+	default: ensure(false);
+	}
+
+	if (CVarLogActionQueue.GetValueOnGameThread() != 0)
+	{
+		LOG_VOXEL(Log, TEXT("ActionQueue: %s"), *Action.ToString());
+	}
+}
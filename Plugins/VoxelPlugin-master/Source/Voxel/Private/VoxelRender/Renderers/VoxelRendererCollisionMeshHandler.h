@@ -0,0 +1,39 @@
+// Copyright 2020 Phyronnaz
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VoxelMinimal.h"
+#include "VoxelRendererMeshHandler.h"
+
+struct FVoxelProcMeshBuffers;
+
+// Mesh handler of the headless renderer
+// One mesh per chunk, holding a single hidden section used by collisions & navmesh: no materials, no dithering, no transitions
+// The buffers are built by the meshing tasks, so there is no merge task nor action queue
+class FVoxelRendererCollisionMeshHandler : public IVoxelRendererMeshHandler
+{
+public:
+	using IVoxelRendererMeshHandler::IVoxelRendererMeshHandler;
+	virtual ~FVoxelRendererCollisionMeshHandler() override;
+
+	// Buffers are null if the chunk is empty
+	void SetChunkBuffers(FChunkId ChunkId, const FVoxelChunkSettings& ChunkSettings, TUniquePtr<FVoxelProcMeshBuffers> Buffers);
+	// Toggles collisions & navmesh without touching the buffers
+	void SetChunkSettings(FChunkId ChunkId, const FVoxelChunkSettings& ChunkSettings);
+
+	//~ Begin IVoxelRendererMeshHandler Interface
+	virtual FChunkId AddChunkImpl(int32 LOD, const FIntVector& Position) final override;
+	virtual void ApplyAction(const FAction& Action) final override;
+	virtual void ClearChunkMaterials() final override {}
+	//~ End IVoxelRendererMeshHandler Interface
+
+private:
+	struct FChunkInfo
+	{
+		int32 LOD = 0;
+		FIntVector Position;
+		TWeakObjectPtr<UVoxelProceduralMeshComponent> Mesh;
+	};
+	TVoxelTypedSparseArray<FChunkId, FChunkInfo> ChunkInfos;
+};
@@ -1,12 +1,14 @@
 // Copyright 2020 Phyronnaz
 
 #include "VoxelRender/VoxelAsyncPhysicsCooker.h"
+#include "VoxelRender/VoxelCollisionCookCache.h"
 #include "VoxelRender/VoxelProceduralMeshComponent.h"
 #include "VoxelRender/VoxelProcMeshBuffers.h"
 #include "VoxelRender/IVoxelProceduralMeshComponent_PhysicsCallbackHandler.h"
 #include "VoxelUtilities/VoxelThreadingUtilities.h"
 #include "VoxelPhysXHelpers.h"
 #include "VoxelMinimal.h"
+#include "VoxelThreadPool.h"
 
 #include "IPhysXCooking.h"
 #include "IPhysXCookingModule.h"
@@ -85,15 +87,30 @@ void FVoxelAsyncPhysicsCooker::DoWork()
 	VOXEL_ASYNC_FUNCTION_COUNTER();
 
 	const double CookStartTime = FPlatformTime::Seconds();
+
+	const FVoxelCancelCounter CancelCounter = GetCancelCounter();
+	// Cooking is split in a few long steps: check between each of them if the component still wants us
+	const auto CheckCanceled = [&]()
+	{
+		if (CancelCounter.IsCanceled())
+		{
+			FVoxelQueuedThreadPoolStats::Get().ReportEarlyExit(Name, FPlatformTime::Seconds() - CookStartTime);
+			return true;
+		}
+		return false;
+	};
 	
 	if (CollisionTraceFlag != ECollisionTraceFlag::CTF_UseComplexAsSimple)
 	{
 		DecomposeMeshToHulls();
-		CreateConvexMesh();
+		if (CheckCanceled()) return;
+		CreateConvexMesh(CancelCounter);
+		if (CheckCanceled()) return;
 	}
 	if (CollisionTraceFlag != ECollisionTraceFlag::CTF_UseSimpleAsComplex)
 	{
-		CreateTriMesh();
+		CreateTriMesh(CancelCounter);
+		if (CheckCanceled()) return;
 	}
 
 	if (CVarLogCollisionCookingTimes.GetValueOnAnyThread() != 0)
@@ -121,7 +138,7 @@ uint32 FVoxelAsyncPhysicsCooker::GetPriority() const
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
-void FVoxelAsyncPhysicsCooker::CreateTriMesh()
+void FVoxelAsyncPhysicsCooker::CreateTriMesh(const FVoxelCancelCounter& CancelCounter)
 {
 	VOXEL_ASYNC_FUNCTION_COUNTER();
 
@@ -233,17 +250,40 @@ void FVoxelAsyncPhysicsCooker::CreateTriMesh()
 		return;
 	}
 
+	// Last chance before the actual cooking, which is the expensive part
+	if (CancelCounter.IsCanceled())
+	{
+		return;
+	}
+
 	physx::PxTriangleMesh* TriangleMesh = nullptr;
 
 	constexpr bool bFlipNormals = true; // Always true due to the order of the vertices (clock wise vs not)
-	const bool bSuccess = PhysXCooking->CreateTriMesh(
-		PhysXFormat,
-		GetCookFlags(),
-		Vertices,
-		Indices,
-		MaterialIndices,
-		bFlipNormals,
-		TriangleMesh);
+	bool bSuccess;
+	if (FVoxelCollisionCookCache::IsEnabled())
+	{
+		// Chunks are often cooked again with the exact same geometry (LOD changes, edits in neighboring chunks, new sessions)
+		bSuccess = FVoxelCollisionCookCache::Get().CreateTriMesh(
+			*PhysXCooking,
+			PhysXFormat,
+			GetCookFlags(),
+			Vertices,
+			Indices,
+			MaterialIndices,
+			bFlipNormals,
+			TriangleMesh);
+	}
+	else
+	{
+		bSuccess = PhysXCooking->CreateTriMesh(
+			PhysXFormat,
+			GetCookFlags(),
+			Vertices,
+			Indices,
+			MaterialIndices,
+			bFlipNormals,
+			TriangleMesh);
+	}
 	
 	CookResult.TriangleMeshes.Add(TriangleMesh);
 
@@ -260,12 +300,17 @@ void FVoxelAsyncPhysicsCooker::CreateTriMesh()
 	}
 }
 
-void FVoxelAsyncPhysicsCooker::CreateConvexMesh()
+void FVoxelAsyncPhysicsCooker::CreateConvexMesh(const FVoxelCancelCounter& CancelCounter)
 {
 	VOXEL_ASYNC_FUNCTION_COUNTER();
 
 	for (auto& Element : CookResult.ConvexElems)
 	{
+		if (CancelCounter.IsCanceled())
+		{
+			return;
+		}
+		
 		CookResult.ConvexMeshes.AddZeroed();
 		const EPhysXCookingResult Result = PhysXCooking->CreateConvex(PhysXFormat, GetCookFlags(), Element.VertexData, CookResult.ConvexMeshes.Last());
 		switch (Result)
@@ -51,8 +51,8 @@ protected:
 	//~ End FVoxelAsyncWork Interface
 	
 private:
-	void CreateTriMesh();
-	void CreateConvexMesh();
+	void CreateTriMesh(const FVoxelCancelCounter& CancelCounter);
+	void CreateConvexMesh(const FVoxelCancelCounter& CancelCounter);
 	void DecomposeMeshToHulls();
 	EPhysXMeshCookFlags GetCookFlags() const;
 
@@ -2,6 +2,7 @@
 
 #include "VoxelRender/VoxelChunkMesh.h"
 #include "VoxelRender/IVoxelRenderer.h"
+#include "VoxelRender/VoxelIndicesOptimizer.h"
 #include "VoxelData/VoxelDataIncludes.h"
 #include "VoxelUtilities/VoxelDistanceFieldUtilities.h"
 
@@ -72,7 +73,7 @@ void FVoxelChunkMeshBuffers::BuildAdjacency(TArray<uint32>& OutAdjacencyIndices)
 		nv::IndexBuffer* PnAENIndexBuffer = nv::tess::buildTessellationBuffer(&StaticMeshRenderBuffer, nv::DBM_PnAenDominantCorner, true);
 		check(PnAENIndexBuffer);
 		const int32 IndexCount = int32(PnAENIndexBuffer->getLength());
-		OutAdjacencyIndices.Empty(IndexCount);
+		OutAdjacencyIndices.Reset(IndexCount);
 		OutAdjacencyIndices.AddUninitialized(IndexCount);
 		for (int32 Index = 0; Index < IndexCount; ++Index)
 		{
@@ -91,17 +92,72 @@ void FVoxelChunkMeshBuffers::BuildAdjacency(TArray<uint32>& OutAdjacencyIndices)
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
-void FVoxelChunkMeshBuffers::OptimizeIndices()
+void FVoxelChunkMeshBuffers::OptimizeIndices(EVoxelIndicesOptimizer Optimizer)
 {
-#if ENABLE_OPTIMIZE_INDICES
 	VOXEL_ASYNC_FUNCTION_COUNTER();
 	
-	TArray<uint32> OptimizedIndices;
-	OptimizedIndices.AddUninitialized(Indices.Num());
 	const uint16 CacheSize = 32;
-	Forsyth::OptimizeFaces(Indices.GetData(), Indices.Num(), GetNumVertices(), OptimizedIndices.GetData(), CacheSize);
-	Indices = MoveTemp(OptimizedIndices);
+	
+#if ENABLE_OPTIMIZE_INDICES
+	if (Optimizer == EVoxelIndicesOptimizer::Forsyth)
+	{
+		TArray<uint32> OptimizedIndices;
+		OptimizedIndices.AddUninitialized(Indices.Num());
+		Forsyth::OptimizeFaces(Indices.GetData(), Indices.Num(), GetNumVertices(), OptimizedIndices.GetData(), CacheSize);
+		Indices = MoveTemp(OptimizedIndices);
+		return;
+	}
 #endif
+
+	TArray<int32> Clusters;
+	FVoxelIndicesOptimizer::OptimizeVertexCache(Indices, GetNumVertices(), CacheSize, Clusters);
+	FVoxelIndicesOptimizer::OptimizeOverdraw(Indices, Positions, Clusters);
+}
+
+void FVoxelChunkMeshBuffers::OptimizeVertexFetch()
+{
+	VOXEL_ASYNC_FUNCTION_COUNTER();
+
+	const int32 NumVertices = GetNumVertices();
+
+	TArray<int32> NewIndices;
+	NewIndices.Init(-1, NumVertices);
+	int32 NewNumVertices = 0;
+	for (uint32& Index : Indices)
+	{
+		int32& NewIndex = NewIndices[Index];
+		if (NewIndex == -1)
+		{
+			NewIndex = NewNumVertices++;
+		}
+		Index = NewIndex;
+	}
+	// Keep unused vertices, at the end
+	for (int32& NewIndex : NewIndices)
+	{
+		if (NewIndex == -1)
+		{
+			NewIndex = NewNumVertices++;
+		}
+	}
+	check(NewNumVertices == NumVertices);
+
+	const auto Reorder = [&](auto& Array)
+	{
+		if (Array.Num() != NumVertices) return;
+
+		auto NewArray = Array;
+		for (int32 Vertex = 0; Vertex < NumVertices; Vertex++)
+		{
+			NewArray[NewIndices[Vertex]] = Array[Vertex];
+		}
+		Array = MoveTemp(NewArray);
+	};
+	Reorder(Positions);
+	Reorder(Normals);
+	Reorder(Tangents);
+	Reorder(Colors);
+	for (auto& T : TextureCoordinates) Reorder(T);
 }
 
 void FVoxelChunkMeshBuffers::Shrink()
@@ -140,7 +196,17 @@ void FVoxelChunkMeshBuffers::UpdateStats()
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
-void FVoxelChunkMesh::BuildDistanceField(int32 LOD, const FIntVector& Position, const FVoxelData& Data, const FVoxelRendererSettingsBase& Settings)
+FVoxelIntBox FVoxelChunkMesh::GetDistanceFieldValuesBounds(int32 LOD, const FIntVector& Position, const FVoxelRendererSettingsBase& Settings)
+{
+	const int32 Extension = Settings.DistanceFieldBoundsExtension;
+	const int32 HighResSize = RENDER_CHUNK_SIZE + 1 + 2 * Extension;
+	const int32 Step = 1 << LOD;
+
+	const FIntVector Start = Position - Extension * Step;
+	return FVoxelIntBox(Start, Start + HighResSize * Step).Extend(Step); // Extend: See GetSurfacePositionsFromDensities
+}
+
+void FVoxelChunkMesh::BuildDistanceField(int32 LOD, const FIntVector& Position, const FVoxelData& Data, const FVoxelRendererSettingsBase& Settings, TArrayView<const FVoxelValue> Values)
 {
 	VOXEL_ASYNC_FUNCTION_COUNTER();
 	
@@ -162,17 +228,21 @@ void FVoxelChunkMesh::BuildDistanceField(int32 LOD, const FIntVector& Position,
 		const int32 ValuesSize = HighResSize + 2;
 		const int32 NumValues = ValuesSize * ValuesSize * ValuesSize;
 
-		TArray<FVoxelValue> Values;
-		Values.Empty(NumValues);
-		Values.SetNumUninitialized(NumValues);
+		TArray<FVoxelValue> QueriedValues;
+		if (Values.Num() == 0)
 		{
-			const FIntVector Start = Position - Extension * Step;
-			const FVoxelIntBox Bounds = FVoxelIntBox(Start, Start + HighResSize * Step).Extend(Step); // Extend: See GetSurfacePositionsFromDensities
+			QueriedValues.Empty(NumValues);
+			QueriedValues.SetNumUninitialized(NumValues);
+
+			const FVoxelIntBox Bounds = GetDistanceFieldValuesBounds(LOD, Position, Settings);
 
 			FVoxelReadScopeLock Lock(Data, Bounds, FUNCTION_FNAME);
-			TVoxelQueryZone<FVoxelValue> QueryZone(Bounds, FIntVector(ValuesSize), LOD, Values);
+			TVoxelQueryZone<FVoxelValue> QueryZone(Bounds, FIntVector(ValuesSize), LOD, QueriedValues);
 			Data.Get<FVoxelValue>(QueryZone, LOD);
+
+			Values = QueriedValues;
 		}
+		check(Values.Num() == NumValues);
 		
 		TArray<float> Distances;
 		TArray<FVector> SurfacePositions;
@@ -0,0 +1,512 @@
+// Copyright 2020 Phyronnaz
+
+#include "VoxelRender/VoxelCollisionCookCache.h"
+
+#include "PhysicsPublic.h"
+#include "Hash/CityHash.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Interface_CollisionDataProvider.h"
+#include "Async/Async.h"
+
+THIRD_PARTY_INCLUDES_START
+#include "PxPhysicsVersion.h"
+#include "extensions/PxDefaultStreams.h"
+THIRD_PARTY_INCLUDES_END
+
+DEFINE_VOXEL_MEMORY_STAT(STAT_VoxelCollisionCookCacheMemory);
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Collision Cook Cache Hits"), STAT_VoxelCollisionCookCacheHits, STATGROUP_VoxelCounters);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Collision Cook Cache Misses"), STAT_VoxelCollisionCookCacheMisses, STATGROUP_VoxelCounters);
+
+static TAutoConsoleVariable<int32> CVarCollisionCookCache(
+	TEXT("voxel.renderer.CollisionCookCache"),
+	1,
+	TEXT("If true, cooked collision meshes will be cached by a hash of their geometry, and chunks with the same geometry will skip cooking"),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarCollisionCookCacheSizeMB(
+	TEXT("voxel.renderer.CollisionCookCacheSizeMB"),
+	64,
+	TEXT("Max size of the in-memory collision cook cache, in MB"),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarCollisionCookCacheOnDisk(
+	TEXT("voxel.renderer.CollisionCookCacheOnDisk"),
+	0,
+	TEXT("If true, the collision cook cache will also be saved to Saved/VoxelCollisionCache, to be reused by the next sessions"),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarCollisionCookCacheDiskSizeMB(
+	TEXT("voxel.renderer.CollisionCookCacheDiskSizeMB"),
+	512,
+	TEXT("Max size of Saved/VoxelCollisionCache, in MB. The oldest files are deleted first"),
+	ECVF_Default);
+
+static FAutoConsoleCommand CmdLogCollisionCookCacheStats(
+	TEXT("voxel.renderer.LogCollisionCookCacheStats"),
+	TEXT("Logs the hit rate of the collision cook cache and the cooking time it saved"),
+	FConsoleCommandDelegate::CreateLambda([]() { FVoxelCollisionCookCache::Get().LogStats(); }));
+
+static FAutoConsoleCommand CmdClearCollisionCookCache(
+	TEXT("voxel.renderer.ClearCollisionCookCache"),
+	TEXT("Clears the collision cook cache, both in memory and on disk"),
+	FConsoleCommandDelegate::CreateLambda([]() { FVoxelCollisionCookCache::Get().Clear(); }));
+
+// Bump when the key or the file layout changes
+static constexpr uint32 CollisionCookCacheVersion = 1;
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+FVoxelCollisionCookCache& FVoxelCollisionCookCache::Get()
+{
+	static FVoxelCollisionCookCache Cache;
+	return Cache;
+}
+
+bool FVoxelCollisionCookCache::IsEnabled()
+{
+	return CVarCollisionCookCache.GetValueOnAnyThread() != 0;
+}
+
+FVoxelCollisionCookCache::~FVoxelCollisionCookCache()
+{
+	DEC_VOXEL_MEMORY_STAT_BY(STAT_VoxelCollisionCookCacheMemory, AllocatedSize);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+bool FVoxelCollisionCookCache::CreateTriMesh(
+	IPhysXCooking& PhysXCooking,
+	FName Format,
+	EPhysXMeshCookFlags CookFlags,
+	const TArray<FVector>& Vertices,
+	const TArray<FTriIndices>& Indices,
+	const TArray<uint16>& MaterialIndices,
+	bool bFlipNormals,
+	physx::PxTriangleMesh*& OutTriangleMesh)
+{
+	VOXEL_ASYNC_FUNCTION_COUNTER();
+
+	const uint64 Key = GetKey(Format, CookFlags, Vertices, Indices, MaterialIndices, bFlipNormals);
+	const double StartTime = FPlatformTime::Seconds();
+
+	bool bFromDisk = false;
+	if (const auto Entry = FindEntry(Key, bFromDisk))
+	{
+		OutTriangleMesh = CreateTriMeshFromData(Entry->Data);
+		if (OutTriangleMesh)
+		{
+			const double LoadTime = FPlatformTime::Seconds() - StartTime;
+			CookTimeSaved.Add(FMath::Max<int64>(0, (Entry->CookTime - LoadTime) * 1e6));
+			(bFromDisk ? NumDiskHits : NumMemoryHits).Increment();
+			INC_DWORD_STAT(STAT_VoxelCollisionCookCacheHits);
+			return true;
+		}
+
+		// Corrupted file or different PhysX build: cook it again
+		LOG_VOXEL(Warning, TEXT("Collision cook cache: failed to load entry %016llx, discarding it"), Key);
+		RemoveEntry(Key);
+	}
+
+	NumMisses.Increment();
+	INC_DWORD_STAT(STAT_VoxelCollisionCookCacheMisses);
+
+	TArray<uint8> Data;
+	{
+		VOXEL_ASYNC_SCOPE_COUNTER("CookTriMesh");
+		if (!PhysXCooking.CookTriMesh(Format, CookFlags, Vertices, Indices, MaterialIndices, bFlipNormals, Data) || Data.Num() == 0)
+		{
+			return false;
+		}
+	}
+	const double CookTime = FPlatformTime::Seconds() - StartTime;
+	CookTimeSpent.Add(CookTime * 1e6);
+
+	OutTriangleMesh = CreateTriMeshFromData(Data);
+	if (!OutTriangleMesh)
+	{
+		return false;
+	}
+
+	const auto NewEntry = MakeVoxelShared<FEntry>();
+	NewEntry->Data = MoveTemp(Data);
+	NewEntry->CookTime = CookTime;
+	AddEntry(Key, NewEntry, CVarCollisionCookCacheOnDisk.GetValueOnAnyThread() != 0);
+
+	return true;
+}
+
+void FVoxelCollisionCookCache::Clear()
+{
+	VOXEL_FUNCTION_COUNTER();
+
+	{
+		FScopeLock Lock(&Section);
+		Entries.Empty();
+		InsertionOrder.Empty();
+		DEC_VOXEL_MEMORY_STAT_BY(STAT_VoxelCollisionCookCacheMemory, AllocatedSize);
+		AllocatedSize = 0;
+	}
+
+	{
+		FScopeLock Lock(&DiskSection);
+		IFileManager::Get().DeleteDirectory(*GetDiskDirectory(), false, true);
+		DiskFiles.Empty();
+		DiskInsertionOrder.Empty();
+		DiskSize = 0;
+		// Files being written will be added back when done
+		bDiskScanned = true;
+	}
+
+	NumMemoryHits.Reset();
+	NumDiskHits.Reset();
+	NumMisses.Reset();
+	CookTimeSaved.Reset();
+	CookTimeSpent.Reset();
+}
+
+void FVoxelCollisionCookCache::LogStats() const
+{
+	int32 NumEntries;
+	int64 Size;
+	{
+		FScopeLock Lock(&Section);
+		NumEntries = Entries.Num();
+		Size = AllocatedSize;
+	}
+	int32 NumFiles;
+	int64 FilesSize;
+	{
+		FScopeLock Lock(&DiskSection);
+		NumFiles = DiskFiles.Num();
+		FilesSize = DiskSize;
+	}
+
+	const int64 MemoryHits = NumMemoryHits.GetValue();
+	const int64 DiskHits = NumDiskHits.GetValue();
+	const int64 Misses = NumMisses.GetValue();
+	const int64 Total = MemoryHits + DiskHits + Misses;
+
+	LOG_VOXEL(Log, TEXT("Collision cook cache: %d entries, %fMB in memory"), NumEntries, Size / double(1 << 20));
+	LOG_VOXEL(Log, TEXT("Collision cook cache: %d files, %fMB on disk"), NumFiles, FilesSize / double(1 << 20));
+	LOG_VOXEL(Log, TEXT("Collision cook cache: %lld lookups; %lld memory hits, %lld disk hits, %lld misses; hit rate: %.1f%%"),
+		Total,
+		MemoryHits,
+		DiskHits,
+		Misses,
+		Total > 0 ? 100. * (MemoryHits + DiskHits) / Total : 0.);
+	LOG_VOXEL(Log, TEXT("Collision cook cache: %.3fs spent cooking misses, %.3fs of cooking saved by hits"),
+		CookTimeSpent.GetValue() / 1e6,
+		CookTimeSaved.GetValue() / 1e6);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+TVoxelSharedPtr<const FVoxelCollisionCookCache::FEntry> FVoxelCollisionCookCache::FindEntry(uint64 Key, bool& bOutFromDisk)
+{
+	VOXEL_ASYNC_FUNCTION_COUNTER();
+
+	{
+		FScopeLock Lock(&Section);
+		if (const FMemoryEntry* Entry = Entries.Find(Key))
+		{
+			bOutFromDisk = false;
+			return Entry->Entry;
+		}
+	}
+
+	if (CVarCollisionCookCacheOnDisk.GetValueOnAnyThread() == 0)
+	{
+		return nullptr;
+	}
+
+	{
+		// Lists the files of the previous sessions, so that they are evicted first
+		FScopeLock Lock(&DiskSection);
+		ScanDisk();
+	}
+
+	const auto Entry = LoadFromDisk(Key);
+	if (!Entry.IsValid())
+	{
+		return nullptr;
+	}
+
+	bOutFromDisk = true;
+	// Already on disk
+	AddEntry(Key, Entry.ToSharedRef(), false);
+	return Entry;
+}
+
+void FVoxelCollisionCookCache::AddEntry(uint64 Key, const TVoxelSharedRef<const FEntry>& Entry, bool bSaveToDisk)
+{
+	VOXEL_ASYNC_FUNCTION_COUNTER();
+
+	if (bSaveToDisk)
+	{
+		// Writing the file is slow: don't delay the collision update
+		AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [this, Key, Entry]()
+		{
+			const int64 FileSize = SaveToDisk(Key, *Entry);
+			if (FileSize >= 0)
+			{
+				FScopeLock Lock(&DiskSection);
+				AddDiskFile(Key, FileSize);
+			}
+		});
+	}
+
+	const int64 MaxSize = int64(FMath::Max(0, CVarCollisionCookCacheSizeMB.GetValueOnAnyThread())) << 20;
+
+	FScopeLock Lock(&Section);
+
+	if (Entries.Contains(Key))
+	{
+		// Another thread cooked the same geometry
+		return;
+	}
+
+	const uint64 Serial = NextSerial++;
+	Entries.Add(Key, { Entry, Serial });
+	InsertionOrder.Enqueue({ Key, Serial });
+
+	const int64 EntrySize = Entry->Data.GetAllocatedSize();
+	AllocatedSize += EntrySize;
+	INC_VOXEL_MEMORY_STAT_BY(STAT_VoxelCollisionCookCacheMemory, EntrySize);
+
+	FQueuedKey KeyToEvict;
+	while (AllocatedSize > MaxSize && InsertionOrder.Dequeue(KeyToEvict))
+	{
+		const FMemoryEntry* EvictedEntry = Entries.Find(KeyToEvict.Key);
+		if (!EvictedEntry || EvictedEntry->Serial != KeyToEvict.Serial)
+		{
+			// Removed, and maybe added again since
+			continue;
+		}
+
+		const int64 EvictedSize = EvictedEntry->Entry->Data.GetAllocatedSize();
+		AllocatedSize -= EvictedSize;
+		DEC_VOXEL_MEMORY_STAT_BY(STAT_VoxelCollisionCookCacheMemory, EvictedSize);
+		Entries.Remove(KeyToEvict.Key);
+	}
+}
+
+void FVoxelCollisionCookCache::RemoveEntry(uint64 Key)
+{
+	{
+		FScopeLock Lock(&Section);
+		FMemoryEntry Entry;
+		if (Entries.RemoveAndCopyValue(Key, Entry))
+		{
+			// The key stays in InsertionOrder, and is skipped when dequeued
+			const int64 EntrySize = Entry.Entry->Data.GetAllocatedSize();
+			AllocatedSize -= EntrySize;
+			DEC_VOXEL_MEMORY_STAT_BY(STAT_VoxelCollisionCookCacheMemory, EntrySize);
+		}
+	}
+
+	RemoveDiskFile(Key);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+void FVoxelCollisionCookCache::ScanDisk()
+{
+	VOXEL_ASYNC_FUNCTION_COUNTER();
+
+	if (bDiskScanned)
+	{
+		return;
+	}
+	bDiskScanned = true;
+
+	struct FFoundFile
+	{
+		uint64 Key;
+		int64 Size;
+		FDateTime ModificationTime;
+	};
+	TArray<FFoundFile> FoundFiles;
+	IFileManager::Get().IterateDirectoryStat(*GetDiskDirectory(), [&](const TCHAR* Path, const FFileStatData& StatData)
+	{
+		const FString Name = FPaths::GetBaseFilename(Path);
+		if (!StatData.bIsDirectory && FPaths::GetExtension(Path) == TEXT("bin") && Name.Len() == 16)
+		{
+			const uint64 Key = FCString::Strtoui64(*Name, nullptr, 16);
+			FoundFiles.Add({ Key, StatData.FileSize, StatData.ModificationTime });
+		}
+		return true;
+	});
+
+	FoundFiles.Sort([](const FFoundFile& A, const FFoundFile& B) { return A.ModificationTime < B.ModificationTime; });
+	for (const FFoundFile& File : FoundFiles)
+	{
+		AddDiskFile(File.Key, File.Size);
+	}
+}
+
+void FVoxelCollisionCookCache::AddDiskFile(uint64 Key, int64 Size)
+{
+	// Make sure the files of the previous sessions are evicted first
+	ScanDisk();
+
+	if (FDiskFile* ExistingFile = DiskFiles.Find(Key))
+	{
+		// Written again: it's now the newest one
+		DiskSize -= ExistingFile->Size;
+	}
+
+	const uint64 Serial = NextDiskSerial++;
+	DiskFiles.Add(Key, { Size, Serial });
+	DiskInsertionOrder.Enqueue({ Key, Serial });
+	DiskSize += Size;
+
+	EvictDiskFiles();
+}
+
+void FVoxelCollisionCookCache::RemoveDiskFile(uint64 Key)
+{
+	FScopeLock Lock(&DiskSection);
+
+	IFileManager::Get().Delete(*GetDiskPath(Key), false, false, true);
+
+	FDiskFile File;
+	if (DiskFiles.RemoveAndCopyValue(Key, File))
+	{
+		// The key stays in DiskInsertionOrder, and is skipped when dequeued
+		DiskSize -= File.Size;
+	}
+}
+
+void FVoxelCollisionCookCache::EvictDiskFiles()
+{
+	VOXEL_ASYNC_FUNCTION_COUNTER();
+
+	const int64 MaxSize = int64(FMath::Max(0, CVarCollisionCookCacheDiskSizeMB.GetValueOnAnyThread())) << 20;
+
+	FQueuedKey KeyToEvict;
+	while (DiskSize > MaxSize && DiskInsertionOrder.Dequeue(KeyToEvict))
+	{
+		const FDiskFile* File = DiskFiles.Find(KeyToEvict.Key);
+		if (!File || File->Serial != KeyToEvict.Serial)
+		{
+			continue;
+		}
+
+		DiskSize -= File->Size;
+		DiskFiles.Remove(KeyToEvict.Key);
+		IFileManager::Get().Delete(*GetDiskPath(KeyToEvict.Key), false, false, true);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+uint64 FVoxelCollisionCookCache::GetKey(
+	FName Format,
+	EPhysXMeshCookFlags CookFlags,
+	const TArray<FVector>& Vertices,
+	const TArray<FTriIndices>& Indices,
+	const TArray<uint16>& MaterialIndices,
+	bool bFlipNormals)
+{
+	VOXEL_ASYNC_FUNCTION_COUNTER();
+
+	const FString FormatString = Format.ToString();
+
+	uint64 Hash = CityHash64(reinterpret_cast<const char*>(*FormatString), FormatString.Len() * sizeof(TCHAR));
+	const uint32 Settings[] = { CollisionCookCacheVersion, PX_PHYSICS_VERSION, uint32(CookFlags), uint32(bFlipNormals), uint32(Vertices.Num()), uint32(Indices.Num()) };
+	Hash = CityHash64WithSeed(reinterpret_cast<const char*>(Settings), sizeof(Settings), Hash);
+	Hash = CityHash64WithSeed(reinterpret_cast<const char*>(Vertices.GetData()), Vertices.Num() * Vertices.GetTypeSize(), Hash);
+	Hash = CityHash64WithSeed(reinterpret_cast<const char*>(Indices.GetData()), Indices.Num() * Indices.GetTypeSize(), Hash);
+	Hash = CityHash64WithSeed(reinterpret_cast<const char*>(MaterialIndices.GetData()), MaterialIndices.Num() * MaterialIndices.GetTypeSize(), Hash);
+	return Hash;
+}
+
+FString FVoxelCollisionCookCache::GetDiskDirectory()
+{
+	return FPaths::ProjectSavedDir() / TEXT("VoxelCollisionCache");
+}
+
+FString FVoxelCollisionCookCache::GetDiskPath(uint64 Key)
+{
+	return GetDiskDirectory() / FString::Printf(TEXT("%016llx.bin"), Key);
+}
+
+TVoxelSharedPtr<const FVoxelCollisionCookCache::FEntry> FVoxelCollisionCookCache::LoadFromDisk(uint64 Key)
+{
+	VOXEL_ASYNC_FUNCTION_COUNTER();
+
+	const FString Path = GetDiskPath(Key);
+
+	TArray<uint8> FileData;
+	if (!IFileManager::Get().FileExists(*Path) || !FFileHelper::LoadFileToArray(FileData, *Path))
+	{
+		return nullptr;
+	}
+
+	FMemoryReader Reader(FileData);
+
+	uint32 Version = 0;
+	uint64 FileKey = 0;
+	const auto Entry = MakeVoxelShared<FEntry>();
+	Reader << Version;
+	Reader << FileKey;
+	Reader << Entry->CookTime;
+	Reader << Entry->Data;
+
+	if (Reader.IsError() || Version != CollisionCookCacheVersion || FileKey != Key)
+	{
+		LOG_VOXEL(Warning, TEXT("Collision cook cache: invalid file %s"), *Path);
+		return nullptr;
+	}
+
+	return Entry;
+}
+
+int64 FVoxelCollisionCookCache::SaveToDisk(uint64 Key, const FEntry& Entry)
+{
+	VOXEL_ASYNC_FUNCTION_COUNTER();
+
+	TArray<uint8> FileData;
+	FMemoryWriter Writer(FileData);
+
+	uint32 Version = CollisionCookCacheVersion;
+	Writer << Version;
+	Writer << Key;
+	Writer << const_cast<double&>(Entry.CookTime);
+	Writer << const_cast<TArray<uint8>&>(Entry.Data);
+
+	if (!FFileHelper::SaveArrayToFile(FileData, *GetDiskPath(Key)))
+	{
+		LOG_VOXEL(Warning, TEXT("Collision cook cache: failed to save %s"), *GetDiskPath(Key));
+		return -1;
+	}
+	return FileData.Num();
+}
+
+physx::PxTriangleMesh* FVoxelCollisionCookCache::CreateTriMeshFromData(const TArray<uint8>& Data)
+{
+	VOXEL_ASYNC_FUNCTION_COUNTER();
+
+	if (!ensure(GPhysXSDK))
+	{
+		return nullptr;
+	}
+
+	physx::PxDefaultMemoryInputData Input(const_cast<uint8*>(Data.GetData()), Data.Num());
+	return GPhysXSDK->createTriangleMesh(Input);
+}
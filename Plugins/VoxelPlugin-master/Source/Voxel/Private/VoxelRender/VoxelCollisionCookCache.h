@@ -0,0 +1,122 @@
+// Copyright 2020 Phyronnaz
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VoxelMinimal.h"
+#include "IPhysXCooking.h"
+#include "Containers/Queue.h"
+
+DECLARE_VOXEL_MEMORY_STAT(TEXT("Voxel Collision Cook Cache Memory"), STAT_VoxelCollisionCookCacheMemory, STATGROUP_VoxelMemory, VOXEL_API);
+
+struct FTriIndices;
+
+namespace physx
+{
+	class PxTriangleMesh;
+}
+
+/**
+ * Cache of the cooked PhysX triangle meshes, keyed by a hash of the cooking inputs
+ * Chunks that come back with the same geometry (LOD flips, unchanged chunks, new sessions if on disk) are deserialized instead of cooked
+ *
+ * In memory, entries are evicted first in first out once voxel.renderer.CollisionCookCacheSizeMB is reached
+ * If voxel.renderer.CollisionCookCacheOnDisk is set, entries are also written to Saved/VoxelCollisionCache and looked up there on memory misses
+ * Files are written on a background thread, and the oldest ones are deleted once voxel.renderer.CollisionCookCacheDiskSizeMB is reached
+ */
+class FVoxelCollisionCookCache
+{
+public:
+	static FVoxelCollisionCookCache& Get();
+	static bool IsEnabled();
+
+	// Same as IPhysXCooking::CreateTriMesh, but goes through the cache
+	bool CreateTriMesh(
+		IPhysXCooking& PhysXCooking,
+		FName Format,
+		EPhysXMeshCookFlags CookFlags,
+		const TArray<FVector>& Vertices,
+		const TArray<FTriIndices>& Indices,
+		const TArray<uint16>& MaterialIndices,
+		bool bFlipNormals,
+		physx::PxTriangleMesh*& OutTriangleMesh);
+
+	void Clear();
+	void LogStats() const;
+
+private:
+	FVoxelCollisionCookCache() = default;
+	~FVoxelCollisionCookCache();
+
+	struct FEntry
+	{
+		TArray<uint8> Data;
+		// Time it took to cook the data, used to report the time saved by hits
+		double CookTime = 0;
+	};
+
+	// Keys are re-added after being removed: the queues store the serial of the insertion, and skip the ones that are outdated
+	struct FQueuedKey
+	{
+		uint64 Key = 0;
+		uint64 Serial = 0;
+	};
+	struct FMemoryEntry
+	{
+		TVoxelSharedPtr<const FEntry> Entry;
+		uint64 Serial = 0;
+	};
+	struct FDiskFile
+	{
+		int64 Size = 0;
+		uint64 Serial = 0;
+	};
+
+	mutable FCriticalSection Section;
+	TMap<uint64, FMemoryEntry> Entries;
+	TQueue<FQueuedKey> InsertionOrder;
+	int64 AllocatedSize = 0;
+	uint64 NextSerial = 0;
+
+	// Files of the disk cache, oldest first
+	mutable FCriticalSection DiskSection;
+	bool bDiskScanned = false;
+	TMap<uint64, FDiskFile> DiskFiles;
+	TQueue<FQueuedKey> DiskInsertionOrder;
+	int64 DiskSize = 0;
+	uint64 NextDiskSerial = 0;
+
+	FThreadSafeCounter64 NumMemoryHits;
+	FThreadSafeCounter64 NumDiskHits;
+	FThreadSafeCounter64 NumMisses;
+	// In microseconds, as there are no atomic doubles
+	FThreadSafeCounter64 CookTimeSaved;
+	FThreadSafeCounter64 CookTimeSpent;
+
+	TVoxelSharedPtr<const FEntry> FindEntry(uint64 Key, bool& bOutFromDisk);
+	void AddEntry(uint64 Key, const TVoxelSharedRef<const FEntry>& Entry, bool bSaveToDisk);
+	void RemoveEntry(uint64 Key);
+
+	// Lists the files left by the previous sessions, if not done yet. Requires DiskSection
+	void ScanDisk();
+	// Requires DiskSection
+	void AddDiskFile(uint64 Key, int64 Size);
+	void RemoveDiskFile(uint64 Key);
+	void EvictDiskFiles();
+
+	static uint64 GetKey(
+		FName Format,
+		EPhysXMeshCookFlags CookFlags,
+		const TArray<FVector>& Vertices,
+		const TArray<FTriIndices>& Indices,
+		const TArray<uint16>& MaterialIndices,
+		bool bFlipNormals);
+
+	static FString GetDiskDirectory();
+	static FString GetDiskPath(uint64 Key);
+	static TVoxelSharedPtr<const FEntry> LoadFromDisk(uint64 Key);
+	// Returns the size of the file, or -1 on failure
+	static int64 SaveToDisk(uint64 Key, const FEntry& Entry);
+
+	static physx::PxTriangleMesh* CreateTriMeshFromData(const TArray<uint8>& Data);
+};
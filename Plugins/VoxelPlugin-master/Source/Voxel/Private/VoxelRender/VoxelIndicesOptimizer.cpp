@@ -0,0 +1,204 @@
+// Copyright 2020 Phyronnaz
+
+#include "VoxelRender/VoxelIndicesOptimizer.h"
+#include "VoxelMinimal.h"
+
+void FVoxelIndicesOptimizer::OptimizeVertexCache(TArray<uint32>& Indices, int32 NumVertices, int32 CacheSize, TArray<int32>& OutClusters)
+{
+	VOXEL_ASYNC_FUNCTION_COUNTER();
+
+	TArray<int32>& Clusters = OutClusters;
+	Clusters.Reset();
+
+	const int32 NumTriangles = Indices.Num() / 3;
+	check(Indices.Num() % 3 == 0);
+	if (NumTriangles == 0)
+	{
+		return;
+	}
+	
+	// Vertex -> triangles
+	TArray<int32> LiveTriangles;
+	TArray<int32> AdjacencyStarts;
+	TArray<int32> Adjacency;
+	LiveTriangles.SetNumZeroed(NumVertices);
+	AdjacencyStarts.SetNumUninitialized(NumVertices + 1);
+	for (uint32 Index : Indices)
+	{
+		LiveTriangles[Index]++;
+	}
+	{
+		int32 Start = 0;
+		for (int32 Vertex = 0; Vertex < NumVertices; Vertex++)
+		{
+			AdjacencyStarts[Vertex] = Start;
+			Start += LiveTriangles[Vertex];
+		}
+		AdjacencyStarts[NumVertices] = Start;
+	}
+	{
+		TArray<int32> Offsets = AdjacencyStarts;
+		Adjacency.SetNumUninitialized(Indices.Num());
+		for (int32 Index = 0; Index < Indices.Num(); Index++)
+		{
+			Adjacency[Offsets[Indices[Index]]++] = Index / 3;
+		}
+	}
+
+	TArray<uint32> OptimizedIndices;
+	OptimizedIndices.Reserve(Indices.Num());
+	
+	TArray<int32> CacheTimeStamps;
+	CacheTimeStamps.SetNumZeroed(NumVertices);
+	TBitArray<> EmittedTriangles(false, NumTriangles);
+	TArray<int32> DeadEndStack;
+	TArray<int32, TInlineAllocator<64>> Candidates;
+
+	int32 Time = CacheSize + 1;
+	int32 Cursor = 0;
+
+	const auto SkipDeadEnd = [&]() -> int32
+	{
+		while (DeadEndStack.Num() > 0)
+		{
+			const int32 Vertex = DeadEndStack.Pop(false);
+			if (LiveTriangles[Vertex] > 0)
+			{
+				return Vertex;
+			}
+		}
+		for (; Cursor < NumVertices; Cursor++)
+		{
+			if (LiveTriangles[Cursor] > 0)
+			{
+				return Cursor;
+			}
+		}
+		return -1;
+	};
+
+	int32 FanningVertex = SkipDeadEnd();
+	Clusters.Add(0);
+	while (FanningVertex != -1)
+	{
+		Candidates.Reset();
+		for (int32 Ref = AdjacencyStarts[FanningVertex]; Ref < AdjacencyStarts[FanningVertex + 1]; Ref++)
+		{
+			const int32 Triangle = Adjacency[Ref];
+			if (EmittedTriangles[Triangle]) continue;
+			EmittedTriangles[Triangle] = true;
+
+			for (int32 Corner = 0; Corner < 3; Corner++)
+			{
+				const uint32 Vertex = Indices[3 * Triangle + Corner];
+				OptimizedIndices.Add(Vertex);
+				DeadEndStack.Add(Vertex);
+				Candidates.Add(Vertex);
+				LiveTriangles[Vertex]--;
+				if (Time - CacheTimeStamps[Vertex] > CacheSize)
+				{
+					CacheTimeStamps[Vertex] = Time++;
+				}
+			}
+		}
+
+		// Pick the candidate that will still be in the cache once all its triangles are emitted, and that has been there the longest
+		int32 BestVertex = -1;
+		int32 BestPriority = -1;
+		for (int32 Vertex : Candidates)
+		{
+			if (LiveTriangles[Vertex] <= 0) continue;
+
+			int32 Priority = 0;
+			if (Time - CacheTimeStamps[Vertex] + 2 * LiveTriangles[Vertex] <= CacheSize)
+			{
+				Priority = Time - CacheTimeStamps[Vertex];
+			}
+			if (Priority > BestPriority)
+			{
+				BestPriority = Priority;
+				BestVertex = Vertex;
+			}
+		}
+
+		if (BestVertex == -1)
+		{
+			BestVertex = SkipDeadEnd();
+			if (BestVertex != -1)
+			{
+				// Dead end: the cache is likely cold here, so moving the following triangles doesn't hurt cache efficiency much
+				Clusters.Add(OptimizedIndices.Num() / 3);
+			}
+		}
+		FanningVertex = BestVertex;
+	}
+
+	check(OptimizedIndices.Num() == Indices.Num());
+	Indices = MoveTemp(OptimizedIndices);
+}
+
+void FVoxelIndicesOptimizer::OptimizeOverdraw(TArray<uint32>& Indices, const TArray<FVector>& Positions, const TArray<int32>& Clusters)
+{
+	VOXEL_ASYNC_FUNCTION_COUNTER();
+
+	const int32 NumTriangles = Indices.Num() / 3;
+	if (Clusters.Num() < 2 || Clusters[0] != 0 || Clusters.Last() >= NumTriangles)
+	{
+		return;
+	}
+
+	FVector MeshCentroid = FVector::ZeroVector;
+	for (uint32 Index : Indices)
+	{
+		MeshCentroid += Positions[Index];
+	}
+	MeshCentroid /= Indices.Num();
+
+	struct FCluster
+	{
+		int32 Start;
+		int32 End;
+		float SortKey;
+	};
+	TArray<FCluster> SortedClusters;
+	SortedClusters.Reserve(Clusters.Num());
+	for (int32 ClusterIndex = 0; ClusterIndex < Clusters.Num(); ClusterIndex++)
+	{
+		const int32 Start = Clusters[ClusterIndex];
+		const int32 End = ClusterIndex + 1 < Clusters.Num() ? Clusters[ClusterIndex + 1] : NumTriangles;
+
+		// Area weighted
+		FVector Centroid = FVector::ZeroVector;
+		FVector Normal = FVector::ZeroVector;
+		float Area = 0;
+		for (int32 Triangle = Start; Triangle < End; Triangle++)
+		{
+			const FVector& A = Positions[Indices[3 * Triangle + 0]];
+			const FVector& B = Positions[Indices[3 * Triangle + 1]];
+			const FVector& C = Positions[Indices[3 * Triangle + 2]];
+			const FVector Cross = FVector::CrossProduct(B - A, C - A);
+			const float TriangleArea = Cross.Size();
+			Centroid += (A + B + C) / 3 * TriangleArea;
+			Normal += Cross;
+			Area += TriangleArea;
+		}
+		if (Area > 0)
+		{
+			Centroid /= Area;
+		}
+
+		SortedClusters.Add({ Start, End, FVector::DotProduct(Centroid - MeshCentroid, Normal.GetSafeNormal()) });
+	}
+
+	// Stable to keep the cache order of clusters with the same key
+	SortedClusters.StableSort([](const FCluster& A, const FCluster& B) { return A.SortKey > B.SortKey; });
+
+	TArray<uint32> SortedIndices;
+	SortedIndices.Reserve(Indices.Num());
+	for (const FCluster& Cluster : SortedClusters)
+	{
+		SortedIndices.Append(&Indices[3 * Cluster.Start], 3 * (Cluster.End - Cluster.Start));
+	}
+	check(SortedIndices.Num() == Indices.Num());
+	Indices = MoveTemp(SortedIndices);
+}
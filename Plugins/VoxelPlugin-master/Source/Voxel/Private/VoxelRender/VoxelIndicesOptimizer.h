@@ -0,0 +1,22 @@
+// Copyright 2020 Phyronnaz
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Self contained index buffer optimizers, available on all platforms
+namespace FVoxelIndicesOptimizer
+{
+	/**
+	 * Tipsify: Sander, Nehab & Barczak, Fast Triangle Reordering for Vertex Locality and Reduced Overdraw, 2007
+	 * Linear time in the number of indices. Triangles are fanned around vertices, picking the next vertex still in the cache
+	 * OutClusters: first triangle of each run, split where the optimization had to jump to a new region
+	 */
+	void OptimizeVertexCache(TArray<uint32>& Indices, int32 NumVertices, int32 CacheSize, TArray<int32>& OutClusters);
+
+	/**
+	 * Sorts the clusters output by OptimizeVertexCache so that clusters facing away from the mesh center are drawn first, as they are likely to occlude the others
+	 * Cache efficiency is mostly kept as clusters are not split further
+	 */
+	void OptimizeOverdraw(TArray<uint32>& Indices, const TArray<FVector>& Positions, const TArray<int32>& Clusters);
+}
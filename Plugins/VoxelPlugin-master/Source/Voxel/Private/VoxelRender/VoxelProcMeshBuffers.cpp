@@ -1,6 +1,7 @@
 // Copyright 2020 Phyronnaz
 
 #include "VoxelRender/VoxelProcMeshBuffers.h"
+#include "VoxelRender/VoxelProceduralMeshSceneProxy.h"
 
 DEFINE_VOXEL_MEMORY_STAT(STAT_VoxelProcMeshMemory);
 DEFINE_VOXEL_MEMORY_STAT(STAT_VoxelProcMeshMemory_Indices);
@@ -8,9 +9,51 @@ DEFINE_VOXEL_MEMORY_STAT(STAT_VoxelProcMeshMemory_Positions);
 DEFINE_VOXEL_MEMORY_STAT(STAT_VoxelProcMeshMemory_Colors);
 DEFINE_VOXEL_MEMORY_STAT(STAT_VoxelProcMeshMemory_Adjacency);
 DEFINE_VOXEL_MEMORY_STAT(STAT_VoxelProcMeshMemory_UVs_Tangents);
+DEFINE_VOXEL_MEMORY_STAT(STAT_VoxelProcMeshMemory_Released);
+DEFINE_VOXEL_MEMORY_STAT(STAT_VoxelProcMeshGPUMemory_FullLayout);
+DEFINE_VOXEL_MEMORY_STAT(STAT_VoxelProcMeshGPUMemory_ActualLayout);
 
 DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Num Voxel Proc Mesh Buffers"), STAT_NumVoxelProcMeshBuffers, STATGROUP_VoxelCounters);
 
+void FVoxelHalfPositionVertexBuffer::InitRHI()
+{
+	VOXEL_RENDER_FUNCTION_COUNTER();
+	
+	const uint32 SizeInBytes = NumVertices * GetStride();
+	if (SizeInBytes == 0 || !ensure(Source))
+	{
+		return;
+	}
+
+	FRHIResourceCreateInfo CreateInfo;
+	VertexBufferRHI = RHICreateVertexBuffer(SizeInBytes, BUF_Static, CreateInfo);
+
+	FHalfPosition* RESTRICT Data = static_cast<FHalfPosition*>(RHILockVertexBuffer(VertexBufferRHI, 0, SizeInBytes, RLM_WriteOnly));
+	for (int32 Index = 0; Index < NumVertices; Index++)
+	{
+		const FVector& Position = Source->VertexPosition(Index);
+		FHalfPosition HalfPosition;
+		HalfPosition.X = Position.X;
+		HalfPosition.Y = Position.Y;
+		HalfPosition.Z = Position.Z;
+		HalfPosition.W = 1.f;
+		Data[Index] = HalfPosition;
+	}
+	RHIUnlockVertexBuffer(VertexBufferRHI);
+}
+
+void FVoxelHalfPositionVertexBuffer::BindPositionVertexBuffer(FLocalVertexFactory::FDataType& OutData) const
+{
+	OutData.PositionComponent = FVertexStreamComponent(this, 0, GetStride(), VET_Half4);
+	// The local vertex factory reads the positions through the input assembler. The position SRV is only used by the GPU skin cache
+	// and by ray tracing, neither of which applies to these buffers: a float SRV over half data would be misread, so don't create one
+	OutData.PositionComponentSRV = nullptr;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
 FVoxelProcMeshBuffers::FVoxelProcMeshBuffers()
 {
 	INC_DWORD_STAT(STAT_NumVoxelProcMeshBuffers);
@@ -24,12 +67,19 @@ FVoxelProcMeshBuffers::~FVoxelProcMeshBuffers()
 	DEC_VOXEL_MEMORY_STAT_BY(STAT_VoxelProcMeshMemory_Colors, LastAllocatedSize_Colors);
 	DEC_VOXEL_MEMORY_STAT_BY(STAT_VoxelProcMeshMemory_Adjacency, LastAllocatedSize_Adjacency);
 	DEC_VOXEL_MEMORY_STAT_BY(STAT_VoxelProcMeshMemory_UVs_Tangents, LastAllocatedSize_UVs_Tangents);
+	DEC_VOXEL_MEMORY_STAT_BY(STAT_VoxelProcMeshGPUMemory_FullLayout, LastGPUSize_FullLayout);
+	DEC_VOXEL_MEMORY_STAT_BY(STAT_VoxelProcMeshGPUMemory_ActualLayout, LastGPUSize_ActualLayout);
+	DEC_VOXEL_MEMORY_STAT_BY(STAT_VoxelProcMeshMemory_Released, LastReleasedSize);
 
 	DEC_DWORD_STAT(STAT_NumVoxelProcMeshBuffers);
 }
 
 uint32 FVoxelProcMeshBuffers::GetAllocatedSize() const
 {
+	if (bCPUDataReleased)
+	{
+		return 0;
+	}
 	return
 			VertexBuffers.StaticMeshVertexBuffer.GetResourceSize() +
 			VertexBuffers.PositionVertexBuffer.GetNumVertices() * VertexBuffers.PositionVertexBuffer.GetStride() +
@@ -51,12 +101,12 @@ void FVoxelProcMeshBuffers::UpdateStats()
 
 	
 	DEC_VOXEL_MEMORY_STAT_BY(STAT_VoxelProcMeshMemory_Positions, LastAllocatedSize_Positions);
-	LastAllocatedSize_Positions = VertexBuffers.PositionVertexBuffer.GetNumVertices() * VertexBuffers.PositionVertexBuffer.GetStride();
+	LastAllocatedSize_Positions = bCPUDataReleased ? 0 : VertexBuffers.PositionVertexBuffer.GetNumVertices() * VertexBuffers.PositionVertexBuffer.GetStride();
 	INC_VOXEL_MEMORY_STAT_BY(STAT_VoxelProcMeshMemory_Positions, LastAllocatedSize_Positions);
 
 	
 	DEC_VOXEL_MEMORY_STAT_BY(STAT_VoxelProcMeshMemory_Colors, LastAllocatedSize_Colors);
-	LastAllocatedSize_Colors = VertexBuffers.ColorVertexBuffer.GetNumVertices() * VertexBuffers.ColorVertexBuffer.GetStride();
+	LastAllocatedSize_Colors = bCPUDataReleased ? 0 : VertexBuffers.ColorVertexBuffer.GetNumVertices() * VertexBuffers.ColorVertexBuffer.GetStride();
 	INC_VOXEL_MEMORY_STAT_BY(STAT_VoxelProcMeshMemory_Colors, LastAllocatedSize_Colors);
 
 	
@@ -66,6 +116,77 @@ void FVoxelProcMeshBuffers::UpdateStats()
 
 	
 	DEC_VOXEL_MEMORY_STAT_BY(STAT_VoxelProcMeshMemory_UVs_Tangents, LastAllocatedSize_UVs_Tangents);
-	LastAllocatedSize_UVs_Tangents = VertexBuffers.StaticMeshVertexBuffer.GetResourceSize();
+	LastAllocatedSize_UVs_Tangents = bCPUDataReleased ? 0 : VertexBuffers.StaticMeshVertexBuffer.GetResourceSize();
 	INC_VOXEL_MEMORY_STAT_BY(STAT_VoxelProcMeshMemory_UVs_Tangents, LastAllocatedSize_UVs_Tangents);
-}
\ No newline at end of file
+
+	
+	if (bCPUDataReleased)
+	{
+		// The GPU buffers are unchanged
+		return;
+	}
+
+
+	// Only one of the position buffers is uploaded
+	const int32 GPUSizeWithoutPositions =
+		VertexBuffers.StaticMeshVertexBuffer.GetResourceSize() +
+		VertexBuffers.ColorVertexBuffer.GetNumVertices() * VertexBuffers.ColorVertexBuffer.GetStride() +
+		IndexBuffer.GetAllocatedSize() +
+		AdjacencyIndexBuffer.GetAllocatedSize();
+	
+	DEC_VOXEL_MEMORY_STAT_BY(STAT_VoxelProcMeshGPUMemory_FullLayout, LastGPUSize_FullLayout);
+	LastGPUSize_FullLayout = GPUSizeWithoutPositions + LastAllocatedSize_Positions;
+	INC_VOXEL_MEMORY_STAT_BY(STAT_VoxelProcMeshGPUMemory_FullLayout, LastGPUSize_FullLayout);
+	
+	DEC_VOXEL_MEMORY_STAT_BY(STAT_VoxelProcMeshGPUMemory_ActualLayout, LastGPUSize_ActualLayout);
+	LastGPUSize_ActualLayout = GPUSizeWithoutPositions + (UseHalfPositions() ? HalfPositionVertexBuffer.GetNumVertices() * HalfPositionVertexBuffer.GetStride() : LastAllocatedSize_Positions);
+	INC_VOXEL_MEMORY_STAT_BY(STAT_VoxelProcMeshGPUMemory_ActualLayout, LastGPUSize_ActualLayout);
+}
+void FVoxelProcMeshBuffers::ReleaseRenderData_GameThread(const TVoxelSharedPtr<const FVoxelProcMeshBuffers>& Buffers)
+{
+	check(IsInGameThread());
+	
+	if (!Buffers.IsValid() || !Buffers->bReleaseCPUDataOnUpload)
+	{
+		return;
+	}
+
+	ENQUEUE_RENDER_COMMAND(ReleaseVoxelProcMeshRenderData)([Buffers](FRHICommandListImmediate& RHICmdList)
+	{
+		auto& MutableBuffers = const_cast<FVoxelProcMeshBuffers&>(*Buffers);
+		// Proxies created after this won't pin the render data
+		MutableBuffers.bRenderDataReleased = true;
+		MutableBuffers.PinnedRenderData.Reset();
+	});
+}
+
+void FVoxelProcMeshBuffers::ReleaseCPUData_RenderThread(const TVoxelSharedRef<FVoxelProcMeshBuffersRenderData>& InRenderData)
+{
+	VOXEL_RENDER_FUNCTION_COUNTER();
+	check(IsInRenderingThread());
+	check(bReleaseCPUDataOnUpload);
+
+	if (bCPUDataReleased || bRenderDataReleased)
+	{
+		return;
+	}
+
+	// Keep the GPU buffers alive for the next proxies, as they cannot be initialized again
+	PinnedRenderData = InRenderData;
+
+	const int32 ReleasedSize = GetAllocatedSize();
+
+	VertexBuffers.PositionVertexBuffer.CleanUp();
+	VertexBuffers.StaticMeshVertexBuffer.CleanUp();
+	VertexBuffers.ColorVertexBuffer.CleanUp();
+	IndexBuffer.ReleaseData();
+	AdjacencyIndexBuffer.ReleaseData();
+	HalfPositionVertexBuffer.ReleaseData();
+	bCPUDataReleased = true;
+
+	UpdateStats();
+
+	DEC_VOXEL_MEMORY_STAT_BY(STAT_VoxelProcMeshMemory_Released, LastReleasedSize);
+	LastReleasedSize = ReleasedSize;
+	INC_VOXEL_MEMORY_STAT_BY(STAT_VoxelProcMeshMemory_Released, LastReleasedSize);
+}
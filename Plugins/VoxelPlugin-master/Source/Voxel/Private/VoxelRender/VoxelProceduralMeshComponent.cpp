@@ -30,6 +30,12 @@ static TAutoConsoleVariable<int32> CVarShowCollisionsUpdates(
 	TEXT("If true, will show the chunks that finished updating collisions"),
 	ECVF_Default);
 
+static TAutoConsoleVariable<int32> CVarReleaseRenderOnlyCPUData(
+	TEXT("voxel.renderer.ReleaseRenderOnlyCPUData"),
+	1,
+	TEXT("If true, the CPU copies of the mesh sections without collisions nor navmesh will be freed once uploaded to the GPU. Takes effect on the next mesh updates"),
+	ECVF_Default);
+
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
@@ -86,6 +92,7 @@ void UVoxelProceduralMeshComponent::Init(
 	NumConvexHullsPerAxis = RendererSettings.NumConvexHullsPerAxis;
 	bCleanCollisionMesh = RendererSettings.bCleanCollisionMeshes;
 	bClearProcMeshBuffersOnFinishUpdate = RendererSettings.bStaticWorld && !RendererSettings.bRenderWorld; // We still need the buffers if we are rendering!
+	bReleaseRenderOnlyCPUData = RendererSettings.bRenderWorld;
 	DistanceFieldSelfShadowBias = RendererSettings.DistanceFieldSelfShadowBias;
 }
 
@@ -121,6 +128,8 @@ UVoxelProceduralMeshComponent::~UVoxelProceduralMeshComponent()
 		AsyncCooker = nullptr;
 	}
 
+	ReleaseProcMeshSectionsRenderData();
+
 	DEC_VOXEL_MEMORY_STAT_BY(STAT_VoxelPhysXTriangleMeshesMemory, TriangleMeshesMemory);
 }
 
@@ -200,6 +209,16 @@ void UVoxelProceduralMeshComponent::SetProcMeshSection(int32 Index, FVoxelProcMe
 
 	ProcMeshSections[Index].Settings = Settings;
 
+	// Collisions & navmesh are built from the CPU copies. Proc mesh buffers are never merged again, so rendering is the only other user
+	Buffers->bReleaseCPUDataOnUpload =
+		bReleaseRenderOnlyCPUData &&
+		CVarReleaseRenderOnlyCPUData.GetValueOnGameThread() != 0 &&
+		Settings.bSectionVisible &&
+		!Settings.bEnableCollisions &&
+		!Settings.bEnableNavmesh;
+
+	FVoxelProcMeshBuffers::ReleaseRenderData_GameThread(ProcMeshSections[Index].Buffers);
+
 	// Due to InitResources etc, we must make sure we are the only component using this buffers, hence the TUniquePtr
 	// However the buffer is shared between the component and the proxy
 	ProcMeshSections[Index].Buffers = MakeShareable(Buffers.Release());
@@ -257,6 +276,7 @@ void UVoxelProceduralMeshComponent::ReplaceProcMeshSection(FVoxelProcMeshSection
 void UVoxelProceduralMeshComponent::ClearSections(EVoxelProcMeshSectionUpdate Update)
 {
 	VOXEL_FUNCTION_COUNTER();
+	ReleaseProcMeshSectionsRenderData();
 	ProcMeshSections.Empty();
 
 	if (Update == EVoxelProcMeshSectionUpdate::UpdateNow)
@@ -329,6 +349,7 @@ void UVoxelProceduralMeshComponent::FinishSectionsUpdates()
 
 	if (bClearProcMeshBuffersOnFinishUpdate)
 	{
+		ReleaseProcMeshSectionsRenderData();
 		ProcMeshSections.Reset();
 	}
 
@@ -556,6 +577,7 @@ void UVoxelProceduralMeshComponent::OnComponentDestroyed(bool bDestroyingHierarc
 	}
 	
 	// Clear memory
+	ReleaseProcMeshSectionsRenderData();
 	ProcMeshSections.Reset();
 }
 
@@ -593,6 +615,14 @@ void UVoxelProceduralMeshComponent::UpdateLocalBounds()
 	MarkRenderTransformDirty();
 }
 
+void UVoxelProceduralMeshComponent::ReleaseProcMeshSectionsRenderData()
+{
+	for (auto& Section : ProcMeshSections)
+	{
+		FVoxelProcMeshBuffers::ReleaseRenderData_GameThread(Section.Buffers);
+	}
+}
+
 void UVoxelProceduralMeshComponent::UpdateNavigation()
 {
 	VOXEL_FUNCTION_COUNTER();
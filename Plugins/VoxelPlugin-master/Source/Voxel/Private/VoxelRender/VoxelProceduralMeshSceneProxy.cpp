@@ -61,7 +61,15 @@ FVoxelProcMeshBuffersRenderData::FVoxelProcMeshBuffersRenderData(
 
 	{
 		auto& InitBuffers = const_cast<FVoxelProcMeshBuffers&>(*Buffers);
-		BeginInitResource(&InitBuffers.VertexBuffers.PositionVertexBuffer);
+		if (Buffers->UseHalfPositions())
+		{
+			InitBuffers.HalfPositionVertexBuffer.SetSource(InitBuffers.VertexBuffers.PositionVertexBuffer);
+			BeginInitResource(&InitBuffers.HalfPositionVertexBuffer);
+		}
+		else
+		{
+			BeginInitResource(&InitBuffers.VertexBuffers.PositionVertexBuffer);
+		}
 		BeginInitResource(&InitBuffers.VertexBuffers.StaticMeshVertexBuffer);
 		BeginInitResource(&InitBuffers.VertexBuffers.ColorVertexBuffer);
 		BeginInitResource(&InitBuffers.IndexBuffer);
@@ -72,7 +80,14 @@ FVoxelProcMeshBuffersRenderData::FVoxelProcMeshBuffersRenderData(
 	auto& IndexBuffer = Buffers->IndexBuffer;
 	
 	FLocalVertexFactory::FDataType Data;
-	VertexBuffers.PositionVertexBuffer.BindPositionVertexBuffer(&VertexFactory, Data);
+	if (Buffers->UseHalfPositions())
+	{
+		Buffers->HalfPositionVertexBuffer.BindPositionVertexBuffer(Data);
+	}
+	else
+	{
+		VertexBuffers.PositionVertexBuffer.BindPositionVertexBuffer(&VertexFactory, Data);
+	}
 	VertexBuffers.StaticMeshVertexBuffer.BindTangentVertexBuffer(&VertexFactory, Data);
 	VertexBuffers.StaticMeshVertexBuffer.BindPackedTexCoordVertexBuffer(&VertexFactory, Data);
 	VertexBuffers.ColorVertexBuffer.BindColorVertexBuffer(&VertexFactory, Data);
@@ -80,7 +95,8 @@ FVoxelProcMeshBuffersRenderData::FVoxelProcMeshBuffersRenderData(
 	VertexFactory.InitResource();
 
 #if RHI_RAYTRACING
-	if (IsRayTracingEnabled())
+	// The ray tracing geometry needs the full precision positions on the GPU
+	if (IsRayTracingEnabled() && !Buffers->UseHalfPositions())
 	{
 		FRayTracingGeometryInitializer Initializer;
 		Initializer.IndexBuffer = IndexBuffer.IndexBufferRHI;
@@ -112,15 +128,25 @@ FVoxelProcMeshBuffersRenderData::FVoxelProcMeshBuffersRenderData(
 #endif
 }
 
-TVoxelSharedRef<FVoxelProcMeshBuffersRenderData> FVoxelProcMeshBuffersRenderData::GetRenderData(
+TVoxelSharedPtr<FVoxelProcMeshBuffersRenderData> FVoxelProcMeshBuffersRenderData::GetRenderData(
 	const TVoxelSharedRef<const FVoxelProcMeshBuffers>& Buffers,
 	ERHIFeatureLevel::Type FeatureLevel)
 {
 	check(IsInRenderingThread());
 	if (!Buffers->RenderData.IsValid())
 	{
+		if (Buffers->bCPUDataReleased)
+		{
+			// Proxy created before the component released these buffers, but rendered after: nothing left to upload
+			return nullptr;
+		}
+		
 		auto Result = TVoxelSharedRef<FVoxelProcMeshBuffersRenderData>(new FVoxelProcMeshBuffersRenderData(Buffers, FeatureLevel));
 		Buffers->RenderData = Result;
+		if (Buffers->bReleaseCPUDataOnUpload)
+		{
+			const_cast<FVoxelProcMeshBuffers&>(*Buffers).ReleaseCPUData_RenderThread(Result);
+		}
 		return Result;
 	}
 	else
@@ -134,7 +160,14 @@ FVoxelProcMeshBuffersRenderData::~FVoxelProcMeshBuffersRenderData()
 	check(IsInRenderingThread());
 
 	auto& InitBuffers = const_cast<FVoxelProcMeshBuffers&>(*Buffers);
-	InitBuffers.VertexBuffers.PositionVertexBuffer.ReleaseResource();
+	if (Buffers->UseHalfPositions())
+	{
+		InitBuffers.HalfPositionVertexBuffer.ReleaseResource();
+	}
+	else
+	{
+		InitBuffers.VertexBuffers.PositionVertexBuffer.ReleaseResource();
+	}
 	InitBuffers.VertexBuffers.StaticMeshVertexBuffer.ReleaseResource();
 	InitBuffers.VertexBuffers.ColorVertexBuffer.ReleaseResource();
 	InitBuffers.IndexBuffer.ReleaseResource();
@@ -142,7 +175,7 @@ FVoxelProcMeshBuffersRenderData::~FVoxelProcMeshBuffersRenderData()
 	VertexFactory.ReleaseResource();
 		
 #if RHI_RAYTRACING
-	if (IsRayTracingEnabled())
+	if (IsRayTracingEnabled() && !Buffers->UseHalfPositions())
 	{
 		RayTracingGeometry.ReleaseResource();
 	}
@@ -276,6 +309,10 @@ void FVoxelProceduralMeshSceneProxy::CreateRenderThreadResources()
 		if (Section.bSectionVisible || NOT_SHIPPING_NOR_TEST) // Need to init for debug
 		{
 			Section.RenderData = FVoxelProcMeshBuffersRenderData::GetRenderData(Section.Buffers.ToSharedRef(), GetScene().GetFeatureLevel());
+			if (!Section.RenderData.IsValid())
+			{
+				Section.bSectionVisible = false;
+			}
 		}
 	}
 	
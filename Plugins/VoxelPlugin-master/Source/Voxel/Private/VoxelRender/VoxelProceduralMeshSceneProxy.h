@@ -28,7 +28,8 @@ public:
 	FRayTracingGeometry RayTracingGeometry;
 #endif
 
-	static TVoxelSharedRef<FVoxelProcMeshBuffersRenderData> GetRenderData(
+	// Null if the buffers released their CPU data and their render data is gone
+	static TVoxelSharedPtr<FVoxelProcMeshBuffersRenderData> GetRenderData(
 		const TVoxelSharedRef<const FVoxelProcMeshBuffers>& Buffers,
 		ERHIFeatureLevel::Type FeatureLevel);
 	~FVoxelProcMeshBuffersRenderData();
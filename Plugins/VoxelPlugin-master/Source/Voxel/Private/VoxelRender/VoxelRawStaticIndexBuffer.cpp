@@ -163,7 +163,10 @@ void FVoxelRawStaticIndexBuffer::InitRHI()
 {
 	const uint32 IndexStride = b32Bit ? sizeof(uint32) : sizeof(uint16);
 	const uint32 SizeInBytes = IndexStorage.Num();
-	check(NumIndices == (b32Bit ? (IndexStorage.Num() / 4) : (IndexStorage.Num() / 2)));
+	if (!ensureMsgf(NumIndices == (b32Bit ? (IndexStorage.Num() / 4) : (IndexStorage.Num() / 2)), TEXT("Index buffer initialized again after its data was released")))
+	{
+		return;
+	}
 
 	if (SizeInBytes > 0)
 	{
@@ -202,4 +205,9 @@ void FVoxelRawStaticIndexBuffer::Discard()
     IndexStorage.Discard();
 
 	UpdateCachedNumIndices();
+}
+
+void FVoxelRawStaticIndexBuffer::ReleaseData()
+{
+	IndexStorage.Empty();
 }
\ No newline at end of file
@@ -9,6 +9,7 @@
 #include "VoxelRender/VoxelChunkToUpdate.h"
 #include "VoxelRender/IVoxelRenderer.h"
 #include "VoxelRender/Meshers/VoxelMesherUtilities.h"
+#include "VoxelRender/Meshers/VoxelMesherScratch.h"
 #include "VoxelUtilities/VoxelMaterialUtilities.h"
 #include "VoxelMessages.h"
 
@@ -26,6 +27,12 @@ static TAutoConsoleVariable<int32> CVarShowTransitions(
 	TEXT("If true, will only show the transition meshes"),
 	ECVF_Default);
 
+static TAutoConsoleVariable<float> CVarHalfPositionsMaxError(
+	TEXT("voxel.renderer.HalfPositionsMaxError"),
+	0.01f,
+	TEXT("With bHalfPrecisionPositions, max rounding error allowed on the positions, in voxels of the lowest LOD of the merged chunks. Buffers that are too big for it keep full precision positions"),
+	ECVF_Default);
+
 float FVoxelRenderUtilities::GetWorldCurrentTime(UWorld* World)
 {
 	if (!ensure(World)) return 0;
@@ -73,7 +80,7 @@ inline void SetMaterialDithering(
 	const FVoxelRendererSettingsBase& Settings,
 	const FVoxelRenderUtilities::FDitheringInfo& DitheringInfo)
 {
-	if (Settings.RenderType == EVoxelRenderType::SurfaceNets)
+	if (Settings.IsDualRenderType())
 	{
 		check(DitheringInfo.DitheringType == EDitheringType::SurfaceNets_LowResToHighRes || DitheringInfo.DitheringType == EDitheringType::SurfaceNets_HighResToLowRes);
 		Material.SetScalarParameterValue(STATIC_FNAME("StartTime"), DitheringInfo.Time);
@@ -116,7 +123,7 @@ void FVoxelRenderUtilities::ResetDithering(UVoxelProceduralMeshComponent& Mesh,
 	VOXEL_FUNCTION_COUNTER();
 	IterateDynamicMaterials(Mesh, [&](UMaterialInstanceDynamic& Material)
 	{
-		if (Settings.RenderType == EVoxelRenderType::SurfaceNets)
+		if (Settings.IsDualRenderType())
 		{
 			Material.SetScalarParameterValue(STATIC_FNAME("StartTime"), 0);
 			Material.SetScalarParameterValue(STATIC_FNAME("InversedFade"), 0);
@@ -171,6 +178,89 @@ void FVoxelRenderUtilities::ShowMesh(UVoxelProceduralMeshComponent& Mesh)
 
 #define CHECK_CANCEL() if (CancelCounter.GetValue() > CancelThreshold) return {};
 
+void FVoxelRenderUtilities::CopyChunkVertices_AnyThread(
+	const FVoxelRendererSettingsBase& RendererSettings,
+	const FVoxelChunkMeshSection& Section,
+	const FVoxelChunkMeshBuffers& Chunk,
+	bool bIsTransitionChunk,
+	const FIntVector& CenterPosition,
+	int32 NumTextureCoordinates,
+	FStaticMeshVertexBuffers& VertexBuffers,
+	int32 VerticesOffset)
+{
+	auto& PositionBuffer = VertexBuffers.PositionVertexBuffer;
+	auto& StaticMeshBuffer = VertexBuffers.StaticMeshVertexBuffer;
+	auto& ColorBuffer = VertexBuffers.ColorVertexBuffer;
+
+	const auto Get = [](auto& Array, int32 Index) -> const auto&
+	{
+#if VOXEL_DEBUG
+		return Array[Index];
+#else
+		return Array.GetData()[Index];
+#endif
+	};
+
+	const FVector PositionOffset(Section.ChunkPosition - CenterPosition);
+	const int32 ChunkNumVertices = Chunk.GetNumVertices();
+
+	if (!bIsTransitionChunk && Section.bTranslateVertices && Section.TransitionsMask)
+	{
+		VOXEL_ASYNC_SCOPE_COUNTER("TranslateVertices");
+		for (int32 Index = 0; Index < ChunkNumVertices; Index++)
+		{
+			PositionBuffer.VertexPosition(VerticesOffset + Index) = FVoxelMesherUtilities::GetTranslatedTransvoxel(
+				Get(Chunk.Positions, Index),
+				Get(Chunk.Normals, Index),
+				Section.TransitionsMask,
+				Section.LOD) + PositionOffset;
+		}
+	}
+	else
+	{
+		VOXEL_ASYNC_SCOPE_COUNTER("CopyPositions");
+		for (int32 Index = 0; Index < ChunkNumVertices; Index++)
+		{
+			PositionBuffer.VertexPosition(VerticesOffset + Index) = Get(Chunk.Positions, Index) + PositionOffset;
+		}
+	}
+
+	if (!RendererSettings.bRenderWorld)
+	{
+		ensure(Chunk.Colors.Num() == 0);
+		ensure(Chunk.Tangents.Num() == 0);
+		ensure(Chunk.Normals.Num() == 0);
+		for (auto& T : Chunk.TextureCoordinates) ensure(T.Num() == 0);
+		return;
+	}
+
+	{
+		VOXEL_ASYNC_SCOPE_COUNTER("CopyColors");
+		for (int32 Index = 0; Index < ChunkNumVertices; Index++)
+		{
+			ColorBuffer.VertexColor(VerticesOffset + Index) = Get(Chunk.Colors, Index);
+		}
+	}
+
+	{
+		VOXEL_ASYNC_SCOPE_COUNTER("CopyStaticMesh");
+		for (int32 Index = 0; Index < ChunkNumVertices; Index++)
+		{
+			{
+				auto& Tangent = Get(Chunk.Tangents, Index);
+				auto& Normal = Get(Chunk.Normals, Index);
+				StaticMeshBuffer.SetVertexTangents(VerticesOffset + Index, Tangent.TangentX, Tangent.GetY(Normal), Normal);
+			}
+			check(Chunk.TextureCoordinates.Num() == NumTextureCoordinates);
+			for (int32 Tex = 0; Tex < NumTextureCoordinates; Tex++)
+			{
+				auto& TextureCoordinate = Get(Chunk.TextureCoordinates[Tex], Index);
+				StaticMeshBuffer.SetVertexUV(VerticesOffset + Index, Tex, TextureCoordinate);
+			}
+		}
+	}
+}
+
 TUniquePtr<FVoxelProcMeshBuffers> FVoxelRenderUtilities::MergeSections_AnyThread(
 	const FVoxelRendererSettingsBase& RendererSettings,
 	const TArray<FVoxelChunkMeshSection>& Sections,
@@ -267,57 +357,6 @@ TUniquePtr<FVoxelProcMeshBuffers> FVoxelRenderUtilities::MergeSections_AnyThread
 #endif
 	};
 
-	const auto CopyPositions = [&](const FVoxelChunkMeshBuffers& Chunk, const FVector& Offset)
-	{
-		VOXEL_ASYNC_SCOPE_COUNTER("CopyPositions");
-		const int32 ChunkNumVertices = Chunk.GetNumVertices();
-		for (int32 Index = 0; Index < ChunkNumVertices; Index++)
-		{
-			PositionBuffer.VertexPosition(VerticesOffset + Index) = Get(Chunk.Positions, Index) + Offset;
-		}
-	};
-	const auto CopyColors = [&](const FVoxelChunkMeshBuffers& Chunk)
-	{
-		if (!RendererSettings.bRenderWorld)
-		{
-			ensure(Chunk.Colors.Num() == 0);
-			return;
-		}
-		
-		VOXEL_ASYNC_SCOPE_COUNTER("CopyColors");
-		const int32 ChunkNumVertices = Chunk.GetNumVertices();
-		for (int32 Index = 0; Index < ChunkNumVertices; Index++)
-		{
-			ColorBuffer.VertexColor(VerticesOffset + Index) = Get(Chunk.Colors, Index);
-		}
-	};
-	const auto CopyStaticMesh = [&](const FVoxelChunkMeshBuffers& Chunk)
-	{
-		if (!RendererSettings.bRenderWorld)
-		{
-			ensure(Chunk.Tangents.Num() == 0);
-			ensure(Chunk.Normals.Num() == 0);
-			for (auto& T : Chunk.TextureCoordinates) ensure(T.Num() == 0);
-			return;
-		}
-
-		VOXEL_ASYNC_SCOPE_COUNTER("CopyStaticMesh");
-		const int32 ChunkNumVertices = Chunk.GetNumVertices();
-		for (int32 Index = 0; Index < ChunkNumVertices; Index++)
-		{
-			{
-				auto& Tangent = Get(Chunk.Tangents, Index);
-				auto& Normal = Get(Chunk.Normals, Index);
-				StaticMeshBuffer.SetVertexTangents(VerticesOffset + Index, Tangent.TangentX, Tangent.GetY(Normal), Normal);
-			}
-			check(Chunk.TextureCoordinates.Num() == NumTextureCoordinates);
-			for (int32 Tex = 0; Tex < NumTextureCoordinates; Tex++)
-			{
-				auto& TextureCoordinate = Get(Chunk.TextureCoordinates[Tex], Index);
-				StaticMeshBuffer.SetVertexUV(VerticesOffset + Index, Tex, TextureCoordinate);
-			}
-		}
-	};
 	const auto CopyIndices = [&](const FVoxelChunkMeshBuffers& Chunk)
 	{
 		VOXEL_ASYNC_SCOPE_COUNTER("CopyIndices");
@@ -328,7 +367,8 @@ TUniquePtr<FVoxelProcMeshBuffers> FVoxelRenderUtilities::MergeSections_AnyThread
 	};
 	const auto CopyAdjacencyIndices = [&](const FVoxelChunkMeshBuffers& Chunk)
 	{
-		TArray<uint32> AdjacencyIndices;
+		TVoxelMesherScratchArray<uint32> AdjacencyIndicesScratch;
+		TArray<uint32>& AdjacencyIndices = *AdjacencyIndicesScratch;
 		Chunk.BuildAdjacency(AdjacencyIndices);
 		ensure(AdjacencyIndices.Num() == 4 * Chunk.Indices.Num());
 		
@@ -354,26 +394,7 @@ TUniquePtr<FVoxelProcMeshBuffers> FVoxelRenderUtilities::MergeSections_AnyThread
 			// Copy bounds
 			ProcMeshBuffers.LocalBounds += MainChunk.Bounds.ShiftBy(PositionOffset);
 
-			if (Chunk.bTranslateVertices && Chunk.TransitionsMask)
-			{
-				VOXEL_ASYNC_SCOPE_COUNTER("TranslateVertices");
-				for (int32 Index = 0; Index < MainChunk.GetNumVertices(); Index++)
-				{
-					PositionBuffer.VertexPosition(VerticesOffset + Index) = FVoxelMesherUtilities::GetTranslatedTransvoxel(
-						Get(MainChunk.Positions, Index),
-						Get(MainChunk.Normals, Index),
-						Chunk.TransitionsMask,
-						Chunk.LOD) + PositionOffset;
-				}
-			}
-			else
-			{
-				CopyPositions(MainChunk, PositionOffset);
-			}
-			CHECK_CANCEL();
-			CopyColors(MainChunk);
-			CHECK_CANCEL();
-			CopyStaticMesh(MainChunk);
+			CopyChunkVertices_AnyThread(RendererSettings, Chunk, MainChunk, false, CenterPosition, NumTextureCoordinates, ProcMeshBuffers.VertexBuffers, VerticesOffset);
 			CHECK_CANCEL();
 			CopyIndices(MainChunk);
 			CHECK_CANCEL();
@@ -396,11 +417,7 @@ TUniquePtr<FVoxelProcMeshBuffers> FVoxelRenderUtilities::MergeSections_AnyThread
 			ProcMeshBuffers.LocalBounds += TransitionChunk.Bounds.ShiftBy(PositionOffset);
 			
 			CHECK_CANCEL();
-			CopyPositions(TransitionChunk, PositionOffset);
-			CHECK_CANCEL();
-			CopyColors(TransitionChunk);
-			CHECK_CANCEL();
-			CopyStaticMesh(TransitionChunk);
+			CopyChunkVertices_AnyThread(RendererSettings, Chunk, TransitionChunk, true, CenterPosition, NumTextureCoordinates, ProcMeshBuffers.VertexBuffers, VerticesOffset);
 			CHECK_CANCEL();
 			CopyIndices(TransitionChunk);
 			CHECK_CANCEL();
@@ -422,6 +439,33 @@ TUniquePtr<FVoxelProcMeshBuffers> FVoxelRenderUtilities::MergeSections_AnyThread
 	
 	CHECK_CANCEL();
 
+	if (RendererSettings.bHalfPrecisionPositions)
+	{
+		VOXEL_ASYNC_SCOPE_COUNTER("HalfPositions");
+		
+		int32 MinLOD = MAX_int32;
+		for (auto& Section : Sections)
+		{
+			MinLOD = FMath::Min(MinLOD, Section.LOD);
+		}
+		float MaxCoordinate = 0;
+		for (int32 Index = 0; Index < NumVertices; Index++)
+		{
+			MaxCoordinate = FMath::Max(MaxCoordinate, PositionBuffer.VertexPosition(Index).GetAbsMax());
+		}
+
+		// Positions are relative to CenterPosition. Half floats have 11 bits of precision: the rounding error is at most 2^-11 relative
+		// Chunks of the same size have their shared vertices at the same distance from their centers, so they round the same way
+		const float MaxError = FMath::Max(0.f, CVarHalfPositionsMaxError.GetValueOnAnyThread()) * (1 << FMath::Max(MinLOD, 0));
+		if (MaxCoordinate / 2048.f <= MaxError)
+		{
+			// Converted when uploading
+			ProcMeshBuffers.HalfPositionVertexBuffer.Init(NumVertices);
+		}
+	}
+
+	CHECK_CANCEL();
+
 	// Bounds extension is in world space, and we're in local (voxel) space
 	ProcMeshBuffers.LocalBounds = ProcMeshBuffers.LocalBounds.ExpandBy(RendererSettings.BoundsExtension / RendererSettings.VoxelSize);
 
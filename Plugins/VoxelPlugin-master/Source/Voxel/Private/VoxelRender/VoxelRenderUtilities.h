@@ -13,6 +13,7 @@ struct FVoxelChunkMeshBuffers;
 struct FVoxelChunkMaterials;
 struct FVoxelChunkSettings;
 struct FVoxelProcMeshBuffers;
+struct FStaticMeshVertexBuffers;
 struct FVoxelRendererSettingsBase;
 class UMaterialInstanceDynamic;
 class UVoxelProceduralMeshComponent;
@@ -87,6 +88,17 @@ namespace FVoxelRenderUtilities
 	void HideMesh(UVoxelProceduralMeshComponent& Mesh);
 	void ShowMesh(UVoxelProceduralMeshComponent& Mesh);
 
+	// Copies the positions, colors, tangents & UVs of a chunk of Section to VertexBuffers, starting at VerticesOffset
+	// Positions are made relative to CenterPosition
+	void CopyChunkVertices_AnyThread(
+		const FVoxelRendererSettingsBase& RendererSettings,
+		const FVoxelChunkMeshSection& Section,
+		const FVoxelChunkMeshBuffers& Chunk,
+		bool bIsTransitionChunk,
+		const FIntVector& CenterPosition,
+		int32 NumTextureCoordinates,
+		FStaticMeshVertexBuffers& VertexBuffers,
+		int32 VerticesOffset);
 	TUniquePtr<FVoxelProcMeshBuffers> MergeSections_AnyThread(
 		const FVoxelRendererSettingsBase& RendererSettings,
 		const TArray<FVoxelChunkMeshSection>& Sections, 
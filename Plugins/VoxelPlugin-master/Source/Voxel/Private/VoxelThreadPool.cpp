@@ -10,9 +10,15 @@
 #include "HAL/RunnableThread.h"
 #include "Misc/ScopeLock.h"
 #include "Async/TaskGraphInterfaces.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/ThreadSafeCounter64.h"
 
 DECLARE_DWORD_COUNTER_STAT(TEXT("VoxelThreadPoolDummyCounter"), STAT_VoxelThreadPoolDummyCounter, STATGROUP_ThreadPoolAsyncTasks);
 DECLARE_DWORD_COUNTER_STAT(TEXT("Recomputed Voxel Tasks Priorities"), STAT_RecomputedVoxelTasksPriorities, STATGROUP_VoxelCounters);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Voxel Tasks Early Exits"), STAT_VoxelTasksEarlyExits, STATGROUP_VoxelCounters);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Voxel Tasks Time Saved By Early Exits (ms)"), STAT_VoxelTasksTimeSavedByEarlyExits, STATGROUP_VoxelCounters);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Voxel Tasks Run On Their Worker Group"), STAT_VoxelTasksRunOnAffinityGroup, STATGROUP_VoxelCounters);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Voxel Tasks Stolen By Another Worker Group"), STAT_VoxelTasksStolenByOtherGroup, STATGROUP_VoxelCounters);
 
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
@@ -27,7 +33,32 @@ FVoxelQueuedThreadPoolStats& FVoxelQueuedThreadPoolStats::Get()
 void FVoxelQueuedThreadPoolStats::Report(FName Name, double Time)
 {
 	FScopeLock Lock(&Section);
-	Times.FindOrAdd(Name) += Time;
+	auto& TaskTimes = Times.FindOrAdd(Name);
+	TaskTimes.Time += Time;
+	TaskTimes.Count++;
+}
+
+void FVoxelQueuedThreadPoolStats::ReportEarlyExit(FName Name, double ElapsedTime)
+{
+	FScopeLock Lock(&Section);
+	
+	// We can't know how long the task would have taken: use the average time of this task type as an estimate
+	double SavedTime = 0;
+	if (const auto* TaskTimes = Times.Find(Name))
+	{
+		if (TaskTimes->Count > 0)
+		{
+			SavedTime = FMath::Max(0., TaskTimes->Time / TaskTimes->Count - ElapsedTime);
+		}
+	}
+
+	auto& EarlyExit = EarlyExitTimes.FindOrAdd(Name);
+	EarlyExit.ElapsedTime += ElapsedTime;
+	EarlyExit.SavedTime += SavedTime;
+	EarlyExit.Count++;
+
+	INC_DWORD_STAT(STAT_VoxelTasksEarlyExits);
+	INC_FLOAT_STAT_BY(STAT_VoxelTasksTimeSavedByEarlyExits, SavedTime * 1000);
 }
 
 void FVoxelQueuedThreadPoolStats::LogTimes() const
@@ -38,8 +69,27 @@ void FVoxelQueuedThreadPoolStats::LogTimes() const
 	LOG_VOXEL(Log, TEXT("#############################################"));
 	for (const auto& It : Times)
 	{
-		LOG_VOXEL(Log, TEXT("%s: %fs"), *It.Key.ToString(), It.Value);
+		LOG_VOXEL(Log, TEXT("%s: %fs (%lld tasks, %fms/task)"), *It.Key.ToString(), It.Value.Time, It.Value.Count, It.Value.Count > 0 ? It.Value.Time * 1000 / It.Value.Count : 0.);
 	}
+	if (EarlyExitTimes.Num() > 0)
+	{
+		LOG_VOXEL(Log, TEXT("Early exits:"));
+		for (const auto& It : EarlyExitTimes)
+		{
+			LOG_VOXEL(Log, TEXT("%s: %lld tasks exited early after %fs, saving an estimated %fs"),
+				*It.Key.ToString(),
+				It.Value.Count,
+				It.Value.ElapsedTime,
+				It.Value.SavedTime);
+		}
+	}
+}
+
+void FVoxelQueuedThreadPoolStats::Reset()
+{
+	FScopeLock Lock(&Section);
+	Times.Reset();
+	EarlyExitTimes.Reset();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -74,10 +124,18 @@ class VOXEL_API FVoxelQueuedThread : public FRunnable
 public:
 	const FString ThreadName;
 	FVoxelQueuedThreadPool* const ThreadPool;
+	/** -1 if the pool doesn't use affinity */
+	const int32 AffinityGroup;
 	/** The event that tells the thread there is work to do. */
 	FEvent* const DoWorkEvent;
 
-	FVoxelQueuedThread(FVoxelQueuedThreadPool* Pool, const FString& ThreadName, uint32 StackSize, EThreadPriority ThreadPriority);
+	FVoxelQueuedThread(
+		FVoxelQueuedThreadPool* Pool,
+		const FString& ThreadName,
+		uint32 StackSize,
+		EThreadPriority ThreadPriority,
+		int32 AffinityGroup,
+		uint64 AffinityMask);
 	~FVoxelQueuedThread();
 
 	//~ Begin FRunnable Interface
@@ -97,13 +155,20 @@ private:
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
-FVoxelQueuedThread::FVoxelQueuedThread(FVoxelQueuedThreadPool* Pool, const FString& ThreadName, uint32 StackSize, EThreadPriority ThreadPriority)
+FVoxelQueuedThread::FVoxelQueuedThread(
+	FVoxelQueuedThreadPool* Pool,
+	const FString& ThreadName,
+	uint32 StackSize,
+	EThreadPriority ThreadPriority,
+	int32 AffinityGroup,
+	uint64 AffinityMask)
 	: ThreadName(ThreadName)
 	, ThreadPool(Pool)
+	, AffinityGroup(AffinityGroup)
 	, DoWorkEvent(FPlatformProcess::GetSynchEventFromPool()) // Create event BEFORE thread
 	, TimeToDie(false) // BEFORE creating thread
 	, QueuedWork(nullptr)
-	, Thread(FRunnableThread::Create(this, *ThreadName, StackSize, ThreadPriority, FPlatformAffinity::GetPoolThreadMask()))
+	, Thread(FRunnableThread::Create(this, *ThreadName, StackSize, ThreadPriority, AffinityMask))
 {
 	check(Thread.IsValid());
 }
@@ -171,12 +236,14 @@ FVoxelQueuedThreadPoolSettings::FVoxelQueuedThreadPoolSettings(
 	uint32 NumThreads, 
 	uint32 StackSize, 
 	EThreadPriority ThreadPriority, 
-	bool bConstantPriorities)
+	bool bConstantPriorities,
+	int32 NumAffinityGroups)
 	: PoolName(PoolName)
 	, NumThreads(NumThreads)
 	, StackSize(StackSize)
 	, ThreadPriority(ThreadPriority)
 	, bConstantPriorities(bConstantPriorities)
+	, NumAffinityGroups(NumAffinityGroups)
 {
 }
 
@@ -186,21 +253,40 @@ inline TArray<TUniquePtr<FVoxelQueuedThread>> CreateThreads(FVoxelQueuedThreadPo
 
 	auto& Settings = Pool->Settings;
 	const uint32 NumThreads = Settings.NumThreads;
+	const int32 NumAffinityGroups = Pool->GetNumAffinityGroups();
+
+	// Assume cores are numbered contiguously per socket/CCX, which is the case on Windows and on most Linux setups
+	const int32 NumCores = FMath::Clamp(FPlatformMisc::NumberOfCoresIncludingHyperthreads(), 1, 64);
+	const int32 NumCoresPerGroup = FMath::Max(1, NumCores / FMath::Max(1, NumAffinityGroups));
 	
 	TArray<TUniquePtr<FVoxelQueuedThread>> Threads;
 	Threads.Reserve(NumThreads);
 	for (uint32 ThreadIndex = 0; ThreadIndex < NumThreads; ThreadIndex++)
 	{
 		const FString Name = FString::Printf(TEXT("%s Thread %d"), *Settings.PoolName, ThreadIndex);
-		Threads.Add(MakeUnique<FVoxelQueuedThread>(Pool, Name, Settings.StackSize, Settings.ThreadPriority));
+
+		int32 AffinityGroup = -1;
+		uint64 AffinityMask = FPlatformAffinity::GetPoolThreadMask();
+		if (NumAffinityGroups > 0)
+		{
+			// Spread the threads evenly across the groups, and pin each one to a core of its group
+			AffinityGroup = ThreadIndex * NumAffinityGroups / NumThreads;
+			const int32 FirstThreadInGroup = (AffinityGroup * NumThreads + NumAffinityGroups - 1) / NumAffinityGroups;
+			const int32 Core = (AffinityGroup * NumCoresPerGroup + (ThreadIndex - FirstThreadInGroup) % NumCoresPerGroup) % NumCores;
+			AffinityMask = uint64(1) << Core;
+		}
+		
+		Threads.Add(MakeUnique<FVoxelQueuedThread>(Pool, Name, Settings.StackSize, Settings.ThreadPriority, AffinityGroup, AffinityMask));
 	}
 	return Threads;
 }
 
 FVoxelQueuedThreadPool::FVoxelQueuedThreadPool(const FVoxelQueuedThreadPoolSettings& Settings)
 	: Settings(Settings)
+	, NumAffinityGroups(FMath::Clamp<int32>(Settings.NumAffinityGroups, 0, Settings.NumThreads))
 	, AllThreads(CreateThreads(this))
 {
+	StaticQueuedWorks.SetNum(1 + NumAffinityGroups);
 	QueuedThreads.Reserve(Settings.NumThreads);
 	for (auto& Thread : AllThreads) 
 	{
@@ -244,6 +330,77 @@ FORCEINLINE void FVoxelQueuedThreadPool::FQueuedWorkInfo::RecomputePriority(doub
 	NextPriorityUpdateTime = Time + Work->PriorityDuration;
 }
 
+int32 FVoxelQueuedThreadPool::GetAffinityGroup(IVoxelQueuedWork* Work) const
+{
+	if (NumAffinityGroups == 0)
+	{
+		return -1;
+	}
+	const uint32 Hash = Work->GetAffinityHash();
+	if (Hash == 0)
+	{
+		return -1;
+	}
+	return Hash % NumAffinityGroups;
+}
+
+void FVoxelQueuedThreadPool::AddQueuedWorkInfo(const FQueuedWorkInfo& WorkInfo)
+{
+	if (Settings.bConstantPriorities)
+	{
+		FQueuedWorkInfo WorkInfoCopy = WorkInfo;
+		WorkInfoCopy.RecomputePriority(FPlatformTime::Seconds());
+		StaticQueuedWorks[1 + WorkInfo.AffinityGroup].push(WorkInfoCopy);
+	}
+	else
+	{
+		QueuedWorks.Add(WorkInfo);
+	}
+}
+
+void FVoxelQueuedThreadPool::WakeUpThreads(const TArray<int32, TInlineAllocator<16>>& NumWorksPerGroup)
+{
+	VOXEL_SCOPE_COUNTER("Wake up threads");
+
+	if (NumAffinityGroups == 0)
+	{
+		for (auto* QueuedThread : QueuedThreads)
+		{
+			QueuedThread->DoWorkEvent->Trigger();
+		}
+		QueuedThreads.Reset();
+		return;
+	}
+
+	check(NumWorksPerGroup.Num() == 1 + NumAffinityGroups);
+
+	// First wake up the threads of the groups the works were routed to
+	int32 NumWorksLeft = NumWorksPerGroup[0];
+	for (int32 Group = 0; Group < NumAffinityGroups; Group++)
+	{
+		int32 NumToWakeUp = NumWorksPerGroup[1 + Group];
+		for (int32 Index = 0; Index < QueuedThreads.Num() && NumToWakeUp > 0; Index++)
+		{
+			auto* QueuedThread = QueuedThreads[Index];
+			if (QueuedThread->AffinityGroup == Group)
+			{
+				QueuedThread->DoWorkEvent->Trigger();
+				QueuedThreads.RemoveAtSwap(Index, 1, false);
+				Index--;
+				NumToWakeUp--;
+			}
+		}
+		NumWorksLeft += NumToWakeUp;
+	}
+
+	// Then let other idle groups steal what's left
+	while (NumWorksLeft > 0 && QueuedThreads.Num() > 0)
+	{
+		QueuedThreads.Pop(false)->DoWorkEvent->Trigger();
+		NumWorksLeft--;
+	}
+}
+
 void FVoxelQueuedThreadPool::AddQueuedWork(IVoxelQueuedWork* InQueuedWork, uint32 PriorityCategory, int32 PriorityOffset)
 {
 	VOXEL_FUNCTION_COUNTER();
@@ -260,34 +417,23 @@ void FVoxelQueuedThreadPool::AddQueuedWork(IVoxelQueuedWork* InQueuedWork, uint3
 	FQueuedWorkInfo WorkInfo;
 	{
 		VOXEL_SCOPE_COUNTER("Compute Priority");
-		WorkInfo = FQueuedWorkInfo(InQueuedWork, PriorityCategory, PriorityOffset);
+		WorkInfo = FQueuedWorkInfo(InQueuedWork, PriorityCategory, PriorityOffset, GetAffinityGroup(InQueuedWork));
 	}
 
+	TArray<int32, TInlineAllocator<16>> NumWorksPerGroup;
+	NumWorksPerGroup.SetNumZeroed(1 + NumAffinityGroups);
+	NumWorksPerGroup[1 + WorkInfo.AffinityGroup]++;
+
 	{
 		VOXEL_SCOPE_COUNTER("Lock");
 		Section.Lock();
 	}
 	{
 		VOXEL_SCOPE_COUNTER("Add Work");
-		if (Settings.bConstantPriorities)
-		{
-			WorkInfo.RecomputePriority(FPlatformTime::Seconds());
-			StaticQueuedWorks.push(WorkInfo);
-		}
-		else
-		{
-			QueuedWorks.Add(WorkInfo);
-		}
+		AddQueuedWorkInfo(WorkInfo);
 	}
 
-	{
-		VOXEL_SCOPE_COUNTER("Wake up threads");
-		for (auto* QueuedThread : QueuedThreads)
-		{
-			QueuedThread->DoWorkEvent->Trigger();
-		}
-		QueuedThreads.Reset();
-	}
+	WakeUpThreads(NumWorksPerGroup);
 	
 	{
 		VOXEL_SCOPE_COUNTER("Unlock");
@@ -310,6 +456,9 @@ void FVoxelQueuedThreadPool::AddQueuedWorks(const TArray<IVoxelQueuedWork*>& InQ
 		return;
 	}
 
+	TArray<int32, TInlineAllocator<16>> NumWorksPerGroup;
+	NumWorksPerGroup.SetNumZeroed(1 + NumAffinityGroups);
+
 	{
 		VOXEL_SCOPE_COUNTER("Lock");
 		Section.Lock();
@@ -324,33 +473,72 @@ void FVoxelQueuedThreadPool::AddQueuedWorks(const TArray<IVoxelQueuedWork*>& InQ
 		VOXEL_SCOPE_COUNTER("Add Works");
 		for (auto* InQueuedWork : InQueuedWorks)
 		{
-			FQueuedWorkInfo WorkInfo(InQueuedWork, PriorityCategory, PriorityOffset);
+			const FQueuedWorkInfo WorkInfo(InQueuedWork, PriorityCategory, PriorityOffset, GetAffinityGroup(InQueuedWork));
+			NumWorksPerGroup[1 + WorkInfo.AffinityGroup]++;
+			AddQueuedWorkInfo(WorkInfo);
+		}
+	}
 
-			if (Settings.bConstantPriorities)
-			{
-				WorkInfo.RecomputePriority(FPlatformTime::Seconds());
-				StaticQueuedWorks.push(WorkInfo);
-			}
-			else
-			{
-				QueuedWorks.Add(WorkInfo);
-			}
+	WakeUpThreads(NumWorksPerGroup);
+
+	{
+		VOXEL_SCOPE_COUNTER("Unlock");
+		Section.Unlock();
+	}
+}
+
+IVoxelQueuedWork* FVoxelQueuedThreadPool::GetNextStaticJob(int32 ThreadAffinityGroup)
+{
+	check(Settings.bConstantPriorities);
+
+	// Works without affinity and works of our group come first
+	std::priority_queue<FQueuedWorkInfo>* BestQueue = nullptr;
+	const auto ConsiderQueue = [&](std::priority_queue<FQueuedWorkInfo>& Queue)
+	{
+		if (!Queue.empty() && (!BestQueue || BestQueue->top() < Queue.top()))
+		{
+			BestQueue = &Queue;
 		}
+	};
+	
+	ConsiderQueue(StaticQueuedWorks[0]);
+	if (ThreadAffinityGroup != -1)
+	{
+		ConsiderQueue(StaticQueuedWorks[1 + ThreadAffinityGroup]);
 	}
 
+	bool bStolen = false;
+	if (!BestQueue)
 	{
-		VOXEL_SCOPE_COUNTER("Wake up threads");
-		for (auto* QueuedThread : QueuedThreads)
+		// Nothing to do in our group: steal from the others
+		for (int32 Group = 0; Group < NumAffinityGroups; Group++)
 		{
-			QueuedThread->DoWorkEvent->Trigger();
+			ConsiderQueue(StaticQueuedWorks[1 + Group]);
 		}
-		QueuedThreads.Reset();
+		bStolen = true;
 	}
 
+	if (!BestQueue)
 	{
-		VOXEL_SCOPE_COUNTER("Unlock");
-		Section.Unlock();
+		return nullptr;
+	}
+
+	if (BestQueue->top().AffinityGroup != -1)
+	{
+		if (bStolen)
+		{
+			INC_DWORD_STAT(STAT_VoxelTasksStolenByOtherGroup);
+		}
+		else
+		{
+			INC_DWORD_STAT(STAT_VoxelTasksRunOnAffinityGroup);
+		}
 	}
+
+	auto* Work = BestQueue->top().Work;
+	BestQueue->pop();
+	check(Work);
+	return Work;
 }
 
 IVoxelQueuedWork* FVoxelQueuedThreadPool::ReturnToPoolOrGetNextJob(FVoxelQueuedThread* InQueuedThread)
@@ -369,8 +557,11 @@ IVoxelQueuedWork* FVoxelQueuedThreadPool::ReturnToPoolOrGetNextJob(FVoxelQueuedT
 		VOXEL_ASYNC_SCOPE_COUNTER("Voxel Thread Pool Recompute Priorities");
 
 		// Find best work. We recompute every priorities as the priorities can change (eg, the camera might have moved)
+		// If we have a group, prefer the works of our group and only steal the best other one if there are none
 		int32 BestIndex = -1;
 		uint64 BestPriority = 0;
+		int32 BestStolenIndex = -1;
+		uint64 BestStolenPriority = 0;
 		int32 NumRecomputed = 0;
 		const double Time = FPlatformTime::Seconds();
 		for (int32 Index = 0; Index < QueuedWorks.Num(); Index++)
@@ -382,26 +573,44 @@ IVoxelQueuedWork* FVoxelQueuedThreadPool::ReturnToPoolOrGetNextJob(FVoxelQueuedT
 				WorkInfo.RecomputePriority(Time);
 			}
 			const uint64 Priority = WorkInfo.GetPriority();
-			if (Priority >= BestPriority)
+			if (WorkInfo.AffinityGroup == -1 || WorkInfo.AffinityGroup == InQueuedThread->AffinityGroup)
 			{
-				BestPriority = Priority;
-				BestIndex = Index;
+				if (Priority >= BestPriority)
+				{
+					BestPriority = Priority;
+					BestIndex = Index;
+				}
+			}
+			else
+			{
+				if (Priority >= BestStolenPriority)
+				{
+					BestStolenPriority = Priority;
+					BestStolenIndex = Index;
+				}
 			}
 		}
 
 		INC_DWORD_STAT_BY(STAT_RecomputedVoxelTasksPriorities, NumRecomputed);
 
+		if (BestIndex == -1)
+		{
+			check(BestStolenIndex != -1);
+			BestIndex = BestStolenIndex;
+			INC_DWORD_STAT(STAT_VoxelTasksStolenByOtherGroup);
+		}
+		else if (QueuedWorks[BestIndex].AffinityGroup != -1)
+		{
+			INC_DWORD_STAT(STAT_VoxelTasksRunOnAffinityGroup);
+		}
+
 		auto* Work = QueuedWorks[BestIndex].Work;
 		QueuedWorks.RemoveAtSwap(BestIndex);
 		check(Work);
 		return Work;
 	}
-	else if (!StaticQueuedWorks.empty())
+	else if (IVoxelQueuedWork* Work = Settings.bConstantPriorities ? GetNextStaticJob(InQueuedThread->AffinityGroup) : nullptr)
 	{
-		check(Settings.bConstantPriorities);
-		auto* Work = StaticQueuedWorks.top().Work;
-		StaticQueuedWorks.pop();
-		check(Work);
 		return Work;
 	}
 	else
@@ -426,10 +635,13 @@ void FVoxelQueuedThreadPool::AbandonAllTasks()
 			WorkInfo.Work->Abandon();
 		}
 		QueuedWorks.Reset();
-		while (!StaticQueuedWorks.empty())
+		for (auto& Queue : StaticQueuedWorks)
 		{
-			StaticQueuedWorks.top().Work->Abandon();
-			StaticQueuedWorks.pop();
+			while (!Queue.empty())
+			{
+				Queue.top().Work->Abandon();
+				Queue.pop();
+			}
 		}
 	}
 	// Wait for all threads to finish up
@@ -445,3 +657,123 @@ void FVoxelQueuedThreadPool::AbandonAllTasks()
 		FPlatformProcess::Sleep(0.0f);
 	}
 }
+
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+
+// Synthetic mesher-like work: reads a region buffer a few times, the same way meshers read the data octree leaves of their region
+class FVoxelAffinityBenchmarkWork : public IVoxelQueuedWork
+{
+public:
+	FVoxelAffinityBenchmarkWork(const TArray<uint32>& RegionData, uint32 RegionIndex, FThreadSafeCounter& NumDone, FThreadSafeCounter64& Checksum)
+		: IVoxelQueuedWork(STATIC_FNAME("FVoxelAffinityBenchmarkWork"), 1e9)
+		, RegionData(RegionData)
+		, RegionIndex(RegionIndex)
+		, NumDone(NumDone)
+		, Checksum(Checksum)
+	{
+	}
+
+	virtual void DoThreadedWork() override
+	{
+		uint64 Sum = 0;
+		for (int32 Pass = 0; Pass < 4; Pass++)
+		{
+			for (uint32 Value : RegionData)
+			{
+				Sum += Value;
+			}
+		}
+		Checksum.Add(Sum);
+		NumDone.Increment();
+		delete this;
+	}
+	virtual void Abandon() override
+	{
+		NumDone.Increment();
+		delete this;
+	}
+	virtual uint32 GetPriority() const override
+	{
+		return 0;
+	}
+	virtual uint32 GetAffinityHash() const override
+	{
+		return RegionIndex + 1;
+	}
+
+private:
+	const TArray<uint32>& RegionData;
+	const uint32 RegionIndex;
+	FThreadSafeCounter& NumDone;
+	FThreadSafeCounter64& Checksum;
+};
+
+static double RunAffinityBenchmark(int32 NumThreads, int32 NumAffinityGroups, const TArray<TArray<uint32>>& Regions, int32 NumTasksPerRegion)
+{
+	const auto Pool = FVoxelQueuedThreadPool::Create(FVoxelQueuedThreadPoolSettings(
+		TEXT("Voxel Affinity Benchmark"),
+		NumThreads,
+		1024 * 1024,
+		EThreadPriority::TPri_Normal,
+		false,
+		NumAffinityGroups));
+
+	FThreadSafeCounter NumDone;
+	FThreadSafeCounter64 Checksum;
+
+	// Interleave the regions, the way the renderer queues chunks from all over the world
+	TArray<IVoxelQueuedWork*> Works;
+	for (int32 Index = 0; Index < NumTasksPerRegion; Index++)
+	{
+		for (int32 RegionIndex = 0; RegionIndex < Regions.Num(); RegionIndex++)
+		{
+			Works.Add(new FVoxelAffinityBenchmarkWork(Regions[RegionIndex], RegionIndex, NumDone, Checksum));
+		}
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	Pool->AddQueuedWorks(Works, 0, 0);
+	while (NumDone.GetValue() < Works.Num())
+	{
+		FPlatformProcess::Sleep(0.001f);
+	}
+	return FPlatformTime::Seconds() - StartTime;
+}
+
+static FAutoConsoleCommand CmdBenchmarkAffinity(
+	TEXT("voxel.threading.BenchmarkAffinity"),
+	TEXT("Compare the throughput of a voxel pool with and without worker affinity. Args: NumAffinityGroups (default 2), NumRegions (default 64), RegionSizeInKB (default 1024), NumTasksPerRegion (default 16)"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		const auto GetArg = [&](int32 Index, int32 Default)
+		{
+			return Args.IsValidIndex(Index) ? FMath::Max(1, FCString::Atoi(*Args[Index])) : Default;
+		};
+		const int32 NumAffinityGroups = GetArg(0, 2);
+		const int32 NumRegions = GetArg(1, 64);
+		const int32 RegionSizeInKB = GetArg(2, 1024);
+		const int32 NumTasksPerRegion = GetArg(3, 16);
+		const int32 NumThreads = FMath::Max(1, FPlatformMisc::NumberOfCoresIncludingHyperthreads() - 1);
+
+		TArray<TArray<uint32>> Regions;
+		Regions.SetNum(NumRegions);
+		for (int32 RegionIndex = 0; RegionIndex < NumRegions; RegionIndex++)
+		{
+			auto& Region = Regions[RegionIndex];
+			Region.SetNumUninitialized(RegionSizeInKB * 1024 / sizeof(uint32));
+			for (int32 Index = 0; Index < Region.Num(); Index++)
+			{
+				Region[Index] = RegionIndex + Index;
+			}
+		}
+
+		const int32 NumTasks = NumRegions * NumTasksPerRegion;
+		const double TimeWithout = RunAffinityBenchmark(NumThreads, 0, Regions, NumTasksPerRegion);
+		const double TimeWith = RunAffinityBenchmark(NumThreads, NumAffinityGroups, Regions, NumTasksPerRegion);
+
+		LOG_VOXEL(Log, TEXT("Affinity benchmark: %d threads, %d tasks over %d regions of %dKB"), NumThreads, NumTasks, NumRegions, RegionSizeInKB);
+		LOG_VOXEL(Log, TEXT("Without affinity: %fs (%.1f tasks/s)"), TimeWithout, NumTasks / TimeWithout);
+		LOG_VOXEL(Log, TEXT("With %d groups: %fs (%.1f tasks/s, %.1f%%)"), NumAffinityGroups, TimeWith, NumTasks / TimeWith, 100. * (TimeWithout / TimeWith - 1.));
+	}));
@@ -210,6 +210,11 @@ float UVoxelBlueprintLibrary::GetEstimatedCollisionsMemoryUsageInMB(AVoxelWorld*
 		if (!ProcMeshComponent) continue;
 		ProcMeshComponent->IterateSections([&](auto& Settings, const FVoxelProcMeshBuffers& Buffers)
 		{
+			if (Buffers.bReleaseCPUDataOnUpload)
+			{
+				// Render only: no collisions, and the CPU copies are freed once uploaded
+				return;
+			}
 			MemoryUsage += Buffers.IndexBuffer.GetAllocatedSize();
 			MemoryUsage += Buffers.VertexBuffers.PositionVertexBuffer.GetNumVertices() * Buffers.VertexBuffers.PositionVertexBuffer.GetStride();
 		});
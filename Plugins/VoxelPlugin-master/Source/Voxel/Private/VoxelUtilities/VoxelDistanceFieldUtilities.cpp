@@ -81,11 +81,11 @@ void FVoxelDistanceFieldUtilities::GetDistancesFromSurfacePositions(const FIntVe
 	check(SurfacePositions.Num() == InOutDistances.Num());
 	check(SurfacePositions.Num() == Size.X * Size.Y * Size.Z);
 	
-	for (int32 X = 0; X < Size.X; X++)
+	for (int32 Z = 0; Z < Size.Z; Z++)
 	{
 		for (int32 Y = 0; Y < Size.Y; Y++)
 		{
-			for (int32 Z = 0; Z < Size.Z; Z++)
+			for (int32 X = 0; X < Size.X; X++)
 			{
 				float& Distance = FVoxelUtilities::Get3D(InOutDistances, Size, X, Y, Z);
 
@@ -227,64 +227,74 @@ void FVoxelDistanceFieldUtilities::JumpFloodStep_CPU(const FIntVector& Size, TAr
 
 	check(InData.Num() == OutData.Num());
 	check(InData.Num() == Size.X * Size.Y * Size.Z);
+
+	// Invalid positions are at 1e9: their squared distance is always above this, and the valid ones always below
+	// This removes the IsSurfacePositionValid branch from the inner loop
+	constexpr float MaxValidDistance = 1e17f;
 	
-	const auto DoWork = [&](int32 X)
+	// Rows are processed along X, which is contiguous in memory, with the neighbors bounds checks hoisted out
+	// of the inner loop so that it can be vectorized
+	const auto DoWork = [&](int32 Z)
 	{
+		TArray<float, TInlineAllocator<128>> BestDistances;
+		BestDistances.SetNumUninitialized(Size.X);
+
 		for (int32 Y = 0; Y < Size.Y; Y++)
 		{
-			for (int32 Z = 0; Z < Size.Z; Z++)
+			FVector* RESTRICT const OutRow = &OutData[Size.X * Y + Size.X * Size.Y * Z];
+			float* RESTRICT const BestRow = BestDistances.GetData();
+			
+			for (int32 X = 0; X < Size.X; X++)
 			{
-				const FIntVector Position(X, Y, Z);
-
-				float BestDistance = MAX_flt;
-				FVector BestSurfacePosition = MakeInvalidSurfacePosition();
+				OutRow[X] = MakeInvalidSurfacePosition();
+				BestRow[X] = MaxValidDistance;
+			}
 
-				for (int32 DX = -1; DX <= 1; ++DX)
+			for (int32 DZ = -1; DZ <= 1; ++DZ)
+			{
+				const int32 NeighborZ = Z + DZ * Step;
+				if (NeighborZ < 0 || NeighborZ >= Size.Z) continue;
+				
+				for (int32 DY = -1; DY <= 1; ++DY)
 				{
-					for (int32 DY = -1; DY <= 1; ++DY)
+					const int32 NeighborY = Y + DY * Step;
+					if (NeighborY < 0 || NeighborY >= Size.Y) continue;
+
+					const FVector* RESTRICT const InRow = &InData[Size.X * NeighborY + Size.X * Size.Y * NeighborZ];
+					
+					for (int32 DX = -1; DX <= 1; ++DX)
 					{
-						for (int32 DZ = -1; DZ <= 1; ++DZ)
+						const int32 Offset = DX * Step;
+						const int32 MinX = FMath::Max(0, -Offset);
+						const int32 MaxX = FMath::Min(Size.X, Size.X - Offset);
+						
+						for (int32 X = MinX; X < MaxX; X++)
 						{
-							const FIntVector NeighborPosition = Position + FIntVector(DX, DY, DZ) * Step;
-
-							if (NeighborPosition.X < 0 ||
-								NeighborPosition.Y < 0 ||
-								NeighborPosition.Z < 0 ||
-								NeighborPosition.X >= Size.X ||
-								NeighborPosition.Y >= Size.Y ||
-								NeighborPosition.Z >= Size.Z)
-							{
-								continue;
-							}
-
-							const FVector NeighborSurfacePosition = FVoxelUtilities::Get3D(InData, Size, NeighborPosition);
-
-							if (IsSurfacePositionValid(NeighborSurfacePosition))
-							{
-								const float Distance = (NeighborSurfacePosition - FVector(Position)).SizeSquared();
-								if (Distance < BestDistance)
-								{
-									BestDistance = Distance;
-									BestSurfacePosition = NeighborSurfacePosition;
-								}
-							}
+							const FVector NeighborSurfacePosition = InRow[X + Offset];
+							const float Distance = FVector(
+								NeighborSurfacePosition.X - X,
+								NeighborSurfacePosition.Y - Y,
+								NeighborSurfacePosition.Z - Z).SizeSquared();
+							
+							const bool bBetter = Distance < BestRow[X];
+							BestRow[X] = bBetter ? Distance : BestRow[X];
+							OutRow[X] = bBetter ? NeighborSurfacePosition : OutRow[X];
 						}
 					}
 				}
-				FVoxelUtilities::Get3D(OutData, Size, Position) = BestSurfacePosition;
 			}
 		}
 	};
 
 	if (bMultiThreaded)
 	{
-		ParallelFor(Size.X, DoWork);
+		ParallelFor(Size.Z, DoWork);
 	}
 	else
 	{
-		for (int32 X = 0; X < Size.X; X++)
+		for (int32 Z = 0; Z < Size.Z; Z++)
 		{
-			DoWork(X);
+			DoWork(Z);
 		}
 	}
 }
\ No newline at end of file
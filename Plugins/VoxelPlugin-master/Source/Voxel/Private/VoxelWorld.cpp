@@ -15,6 +15,7 @@
 #include "VoxelRender/MaterialCollections/VoxelMaterialCollectionBase.h"
 #include "VoxelRender/MaterialCollections/VoxelInstancedMaterialCollection.h"
 #include "VoxelRender/Renderers/VoxelDefaultRenderer.h"
+#include "VoxelRender/Renderers/VoxelHeadlessRenderer.h"
 #include "VoxelData/VoxelData.h"
 #include "VoxelData/VoxelSaveUtilities.h"
 #include "VoxelMultiplayer/VoxelMultiplayerTcp.h"
@@ -872,7 +873,7 @@ TVoxelSharedRef<IVoxelPool> AVoxelWorld::CreatePool() const
 TVoxelSharedRef<IVoxelRenderer> AVoxelWorld::CreateRenderer() const
 {
 	VOXEL_FUNCTION_COUNTER();
-	return FVoxelDefaultRenderer::Create(FVoxelRendererSettings(
+	const FVoxelRendererSettings RendererSettings(
 		this,
 		PlayType,
 		WorldRoot,
@@ -880,7 +881,13 @@ TVoxelSharedRef<IVoxelRenderer> AVoxelWorld::CreateRenderer() const
 		Pool.ToSharedRef(),
 		ToolRenderingManager.ToSharedRef(),
 		DebugManager.ToSharedRef(),
-		false));
+		false);
+	
+	if (FVoxelHeadlessRenderer::ShouldUseHeadlessRenderer(GetWorld()))
+	{
+		return FVoxelHeadlessRenderer::Create(RendererSettings);
+	}
+	return FVoxelDefaultRenderer::Create(RendererSettings);
 }
 
 TVoxelSharedRef<IVoxelLODManager> AVoxelWorld::CreateLODManager() const
@@ -1319,7 +1326,8 @@ void AVoxelWorld::UpdateDynamicLODSettings() const
 	
 	LODDynamicSettings->InvokerDistanceThreshold = InvokerDistanceThreshold;
 	
-	LODDynamicSettings->ChunksCullingLOD = FVoxelUtilities::ClampDepth<RENDER_CHUNK_SIZE>(ChunksCullingLOD);
+	// Dual contouring has no transitions meshes: only render LOD 0 to not have holes between LODs
+	LODDynamicSettings->ChunksCullingLOD = RenderType == EVoxelRenderType::DualContouring ? 0 : FVoxelUtilities::ClampDepth<RENDER_CHUNK_SIZE>(ChunksCullingLOD);
 
 	LODDynamicSettings->bEnableRender = bRenderWorld;
 	
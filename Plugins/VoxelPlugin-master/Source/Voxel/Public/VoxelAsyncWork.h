@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "VoxelQueuedWork.h"
+#include "VoxelCancelCounter.h"
 
 class VOXEL_API FVoxelAsyncWork : public IVoxelQueuedWork
 {
@@ -42,7 +43,13 @@ protected:
 	
 	bool IsCanceled() const
 	{
-		return CanceledCounter.GetValue() > 0;
+		return CanceledCounter->GetValue() > 0;
+	}
+	// Use this to check for cancellation inside DoWork, eg to exit long tasks early
+	// Create it before checking IsCanceled, else a cancel happening in between would be missed
+	FVoxelCancelCounter GetCancelCounter() const
+	{
+		return FVoxelCancelCounter(CanceledCounter);
 	}
 	void SetIsDone(bool bIsDone)
 	{
@@ -73,7 +80,8 @@ private:
 	FThreadSafeCounter IsDoneCounter;
 	FSafeCriticalSection DoneSection;
 	
-	FThreadSafeCounter CanceledCounter;
+	// Shared so that FVoxelCancelCounter can be handed to objects outliving this work
+	const TVoxelSharedRef<FThreadSafeCounter64> CanceledCounter = MakeVoxelShared<FThreadSafeCounter64>();
 	bool bAutodelete = false;
 
 	FThreadSafeCounter WasAbandonedCounter;
@@ -31,6 +31,12 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Voxel Invoker|Priority")
 	bool bUseForPriorities = true;
 
+	// If true, the rendered chunks in the view direction of this invoker will be meshed before the ones behind it
+	// Collisions and navmesh chunks are still sorted by distance only
+	// See GetInvokerViewDirection
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Voxel Invoker|Priority", meta = (EditCondition = bUseForPriorities))
+	bool bUseViewDirectionForPriorities = false;
+
 protected:
 	// Whether to enable the invoker when spawned
 	// If not, you'll need to call EnableInvoker
@@ -56,11 +62,17 @@ public:
 	FVoxelInvokerSettings GetInvokerSettings(AVoxelWorldInterface* VoxelWorld) const;
 	FVoxelInvokerSettings GetInvokerSettings(const AVoxelWorldInterface* VoxelWorld) const;
 
+	// Used for the priorities if bUseViewDirectionForPriorities is true. In world space
+	// Defaults to the owner pawn view rotation, or to the component forward vector
+	UFUNCTION(BlueprintNativeEvent, Category = "Voxel|Invoker")
+	FVector GetInvokerViewDirection() const;
+
 public:
 	//~ Begin UVoxelInvokerComponentBase Interface
 	virtual bool IsLocalInvoker_Implementation() const;
 	virtual FIntVector GetInvokerVoxelPosition_Implementation(AVoxelWorldInterface* VoxelWorld) const;
 	virtual FVoxelInvokerSettings GetInvokerSettings_Implementation(AVoxelWorldInterface* VoxelWorld) const;
+	virtual FVector GetInvokerViewDirection_Implementation() const;
 	//~ End UVoxelInvokerComponentBase Interface
 
 public:
@@ -162,10 +174,32 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Voxel Invoker|Prediction", meta = (EditCondition = bEnablePrediction, ClampMin = 0))
 	float PredictionTime = 1;
 
+	// In seconds. The velocity used for the prediction is smoothed over this time, so that the predicted position
+	// doesn't jump around with the velocity noise. 0 to use the raw velocity
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Voxel Invoker|Prediction", meta = (EditCondition = bEnablePrediction, ClampMin = 0))
+	float VelocitySmoothingTime = 0;
+
+	// If true, the invoker will cover the whole path from its current position to the predicted one, instead of only the predicted position
+	// The LOD/collisions/navmesh ranges are applied all along the path, and the chunks closer to the current position are computed first
+	// Useful for fast moving invokers like vehicles
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Voxel Invoker|Prediction", meta = (EditCondition = bEnablePrediction))
+	bool bUseSweptPath = false;
+
+public:
+	//~ Begin UVoxelInvokerComponentBase Interface
+	virtual FVoxelInvokerSettings GetInvokerSettings_Implementation(AVoxelWorldInterface* VoxelWorld) const override;
+	//~ End UVoxelInvokerComponentBase Interface
+
 protected:
 	//~ Begin UVoxelSimpleInvokerComponent Interface
 	virtual FVector GetInvokerGlobalPosition_Implementation() const override;
 	//~ End UVoxelSimpleInvokerComponent Interface
+
+private:
+	mutable FVector SmoothedVelocity = FVector::ZeroVector;
+	mutable float LastVelocitySmoothingTime = -1;
+
+	FVector GetSmoothedVelocity() const;
 };
 
 // Voxel Invokers are used to configure the voxel world LOD, collisions and navmesh
@@ -175,6 +209,11 @@ class VOXEL_API UVoxelInvokerAutoCameraComponent : public UVoxelSimpleInvokerCom
 {
 	GENERATED_BODY()
 
+public:
+	//~ Begin UVoxelInvokerComponentBase Interface
+	virtual FVector GetInvokerViewDirection_Implementation() const override;
+	//~ End UVoxelInvokerComponentBase Interface
+
 protected:
 	//~ Begin UVoxelSimpleInvokerComponent Interface
 	virtual FVector GetInvokerGlobalPosition_Implementation() const override;
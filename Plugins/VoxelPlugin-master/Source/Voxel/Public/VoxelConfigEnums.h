@@ -11,7 +11,10 @@ enum class EVoxelRenderType : uint8
 	MarchingCubes,
 	Cubic,
 	// Surface nets only work well at LOD 0. They will have holes between higher LODs, and the material won't be picked correctly.
-	SurfaceNets
+	SurfaceNets,
+	// Dual contouring keeps the sharp features of the surface. There are no transitions meshes, so only LOD 0 is rendered:
+	// Chunks Culling LOD is ignored and chunks further than the LOD 0 invokers range are not rendered
+	DualContouring
 };
 
 UENUM(BlueprintType)
@@ -47,6 +50,15 @@ enum class EVoxelUVConfig : uint8
 	Max					UMETA(Hidden)
 };
 
+UENUM(BlueprintType)
+enum class EVoxelIndicesOptimizer : uint8
+{
+	// Forsyth's algorithm. Only available on Windows: other platforms use Portable instead
+	Forsyth,
+	// Linear time vertex cache (Tipsify) & overdraw optimizer. Available on all platforms
+	Portable
+};
+
 UENUM(BlueprintType)
 enum class EVoxelRGBA : uint8
 {
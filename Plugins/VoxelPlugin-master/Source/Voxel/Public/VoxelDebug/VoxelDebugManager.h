@@ -57,6 +57,7 @@ protected:
 	//~ Begin FVoxelTickable Interface
 	virtual void Tick(float DeltaTime) override;
 	virtual bool IsTickableInEditor() const override { return true; }
+	virtual EVoxelGameThreadWork GetGameThreadWork() const override { return EVoxelGameThreadWork::Debug; }
 	//~ End FVoxelTickable Interface
 
 private:
@@ -103,6 +103,7 @@ protected:
 	//~ Begin FVoxelTickable Interface
 	virtual void Tick(float DeltaTime) override;
 	virtual bool IsTickableInEditor() const override { return true; }
+	virtual EVoxelGameThreadWork GetGameThreadWork() const override { return EVoxelGameThreadWork::Events; }
 	//~ End FVoxelTickable Interface
 	
 private:
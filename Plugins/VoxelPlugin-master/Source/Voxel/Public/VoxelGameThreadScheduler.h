@@ -0,0 +1,51 @@
+// Copyright 2020 Phyronnaz
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+
+class FVoxelTickable;
+
+// Sorted by priority: higher priority consumers are ticked first
+enum class EVoxelGameThreadWork : uint8
+{
+	LODManager,
+	Renderer,
+	// Not a tickable: part of the renderer tick, reported separately
+	MeshHandler,
+	Events,
+	Debug,
+	Other
+};
+
+/**
+ * Single game thread entry point for all the voxel tickables
+ * When voxel.scheduler.FrameBudget is > 0, the tickables stop ticking themselves and are ticked here instead,
+ * sharing that budget by priority. Work that doesn't fit stays queued in the consumers and is continued next frame.
+ */
+class VOXEL_API FVoxelGameThreadScheduler : public FTickableGameObject
+{
+public:
+	static bool IsEnabled();
+	static void Shutdown();
+
+	static void RegisterTickable(FVoxelTickable& Tickable);
+	static void UnregisterTickable(FVoxelTickable& Tickable);
+
+	// Report time spent outside of a scheduled tick, eg by the mesh handler inside the renderer tick
+	static void ReportTime(EVoxelGameThreadWork Work, double Time);
+
+public:
+	//~ Begin FTickableGameObject Interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual bool IsTickableInEditor() const override { return true; }
+	virtual TStatId GetStatId() const override;
+	//~ End FTickableGameObject Interface
+
+private:
+	TArray<FVoxelTickable*> Tickables;
+
+	static FVoxelGameThreadScheduler* Singleton;
+};
@@ -27,4 +27,79 @@ struct FVoxelInvokerSettings
 	bool bUseForNavmesh = false;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Voxel")
 	FVoxelIntBox NavmeshBounds;
+
+	// If true, the invoker shape is the volume swept by a box moving from SweptPathStart to SweptPathEnd,
+	// with a half size of SweptPathLODRange/SweptPathCollisionsRange/SweptPathNavmeshRange
+	// The bounds above must contain these shapes: they are still used as a fast rejection test
+	// A zero length path is the same shape as the bounds of a simple invoker
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Voxel")
+	bool bUseSweptPath = false;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Voxel", meta = (EditCondition = bUseSweptPath))
+	FIntVector SweptPathStart = FIntVector::ZeroValue;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Voxel", meta = (EditCondition = bUseSweptPath))
+	FIntVector SweptPathEnd = FIntVector::ZeroValue;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Voxel", meta = (EditCondition = bUseSweptPath))
+	int32 SweptPathLODRange = 0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Voxel", meta = (EditCondition = bUseSweptPath))
+	int32 SweptPathCollisionsRange = 0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Voxel", meta = (EditCondition = bUseSweptPath))
+	int32 SweptPathNavmeshRange = 0;
+
+public:
+	FORCEINLINE bool IsLODShapeIntersecting(const FVoxelIntBox& Bounds) const
+	{
+		return Bounds.Intersect(LODBounds) && IsSweptPathInRange(Bounds, SweptPathLODRange);
+	}
+	FORCEINLINE bool IsCollisionsShapeIntersecting(const FVoxelIntBox& Bounds) const
+	{
+		return Bounds.Intersect(CollisionsBounds) && IsSweptPathInRange(Bounds, SweptPathCollisionsRange);
+	}
+	FORCEINLINE bool IsNavmeshShapeIntersecting(const FVoxelIntBox& Bounds) const
+	{
+		return Bounds.Intersect(NavmeshBounds) && IsSweptPathInRange(Bounds, SweptPathNavmeshRange);
+	}
+
+	// Whether the swept path is at most Range away from Bounds, on all axis. Always true if bUseSweptPath is false
+	// Clips the path segment against the slabs of Bounds extended by Range
+	bool IsSweptPathInRange(const FVoxelIntBox& Bounds, int32 Range) const
+	{
+		if (!bUseSweptPath)
+		{
+			return true;
+		}
+
+		const FVector Start(SweptPathStart);
+		const FVector Direction(SweptPathEnd - SweptPathStart);
+		const FVector Min = FVector(Bounds.Min - FIntVector(Range));
+		const FVector Max = FVector(Bounds.Max + FIntVector(Range));
+
+		float TMin = 0.f;
+		float TMax = 1.f;
+		for (int32 Axis = 0; Axis < 3; Axis++)
+		{
+			if (Direction[Axis] == 0)
+			{
+				if (Start[Axis] < Min[Axis] || Start[Axis] > Max[Axis])
+				{
+					return false;
+				}
+				continue;
+			}
+
+			const float OneOverDirection = 1.f / Direction[Axis];
+			float T0 = (Min[Axis] - Start[Axis]) * OneOverDirection;
+			float T1 = (Max[Axis] - Start[Axis]) * OneOverDirection;
+			if (T0 > T1)
+			{
+				Swap(T0, T1);
+			}
+			TMin = FMath::Max(TMin, T0);
+			TMax = FMath::Min(TMax, T1);
+			if (TMin > TMax)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
 };
\ No newline at end of file
@@ -5,6 +5,31 @@
 #include "CoreMinimal.h"
 #include "VoxelIntBox.h"
 
+// Shape of an invoker for the priorities: the path from its current position to its predicted one
+// Start == End for invokers without a swept path
+struct FVoxelInvokerPriorityPath
+{
+	FIntVector Start = FIntVector::ZeroValue;
+	FIntVector End = FIntVector::ZeroValue;
+
+	// Normalized, in voxel space. Zero if the invoker has no view direction
+	FVector ViewDirection = FVector::ZeroVector;
+	// Chunks right behind the invoker are considered 1 + ViewDirectionWeight times further away
+	float ViewDirectionWeight = 0.f;
+
+	FVoxelInvokerPriorityPath() = default;
+	explicit FVoxelInvokerPriorityPath(const FIntVector& Position)
+		: Start(Position)
+		, End(Position)
+	{
+	}
+	FVoxelInvokerPriorityPath(const FIntVector& Start, const FIntVector& End)
+		: Start(Start)
+		, End(End)
+	{
+	}
+};
+
 // Somewhat thread safe array
 class FInvokerPositionsArray
 {
@@ -12,7 +37,7 @@ public:
 	FInvokerPositionsArray() = default;
 	explicit FInvokerPositionsArray(int32 NewMax)
 		: Max(NewMax)
-		, Data(reinterpret_cast<FIntVector*>(FMemory::Malloc(sizeof(FIntVector) * NewMax, alignof(FIntVector))))
+		, Data(reinterpret_cast<FVoxelInvokerPriorityPath*>(FMemory::Malloc(sizeof(FVoxelInvokerPriorityPath) * NewMax, alignof(FVoxelInvokerPriorityPath))))
 	{
 	}
 	~FInvokerPositionsArray()
@@ -20,7 +45,7 @@ public:
 		FMemory::Free(Data);
 	}
 
-	void Set(const TArray<FIntVector>& Array)
+	void Set(const TArray<FVoxelInvokerPriorityPath>& Array)
 	{
 		check(Array.Num() <= Max);
 		for (int32 Index = 0; Index < Array.Num(); Index++)
@@ -41,7 +66,7 @@ public:
 	{
 		return Num;
 	}
-	FORCEINLINE FIntVector Get(int32 Index) const
+	FORCEINLINE FVoxelInvokerPriorityPath Get(int32 Index) const
 	{
 		checkVoxelSlow(Index < Num);
 		return Data[Index];
@@ -50,29 +75,69 @@ public:
 private:
 	int32 Num = 0;
 	const int32 Max = 0;
-	FIntVector* RESTRICT const Data = nullptr;
+	FVoxelInvokerPriorityPath* RESTRICT const Data = nullptr;
 };
 
 struct FVoxelPriorityHandler
 {
 	FVoxelIntBox Bounds;
 	TVoxelSharedPtr<FInvokerPositionsArray> InvokersPositions;
+	// Should be false for chunks that are not rendered: collisions and navmesh don't depend on the view
+	bool bUseViewDirection = false;
 
 	FVoxelPriorityHandler() = default;
-	FVoxelPriorityHandler(const FVoxelIntBox& Bounds, const TVoxelSharedRef<FInvokerPositionsArray>& InvokersPositions)
+	FVoxelPriorityHandler(const FVoxelIntBox& Bounds, const TVoxelSharedRef<FInvokerPositionsArray>& InvokersPositions, bool bUseViewDirection = false)
 		: Bounds(Bounds)
 		, InvokersPositions(InvokersPositions)
+		, bUseViewDirection(bUseViewDirection)
 	{
 	}
 
+	// Chunks along a swept path are further away by this fraction of the distance from the path start,
+	// so that the chunks the invoker will reach first are processed first
+	static constexpr float SweptPathDistanceWeight = 0.5f;
+
 	inline uint32 GetPriority() const
 	{
 		uint64 Distance = MAX_uint64;
 		for (int32 Index = 0; Index < InvokersPositions->GetNum(); Index++)
 		{
-			const FIntVector Position = InvokersPositions->Get(Index);
-			Distance = FMath::Min(Distance, Bounds.ComputeSquaredDistanceFromBoxToPoint(Position));
+			const FVoxelInvokerPriorityPath Path = InvokersPositions->Get(Index);
+			uint64 PathDistance = Path.Start == Path.End
+				? Bounds.ComputeSquaredDistanceFromBoxToPoint(Path.Start)
+				: GetSquaredDistanceToPath(Path);
+			if (bUseViewDirection && Path.ViewDirectionWeight > 0 && PathDistance > 0)
+			{
+				PathDistance = uint64(PathDistance * FMath::Square(GetViewDirectionFactor(Path)));
+			}
+			Distance = FMath::Min(Distance, PathDistance);
 		}
 		return MAX_uint32 - uint32(FMath::Sqrt(Distance));
 	}
+
+	// 1 for chunks in the view direction, 1 + ViewDirectionWeight for chunks right behind
+	float GetViewDirectionFactor(const FVoxelInvokerPriorityPath& Path) const
+	{
+		const FVector Center = FVector(Bounds.Min + Bounds.Max) / 2.f;
+		const FVector Direction = (Center - FVector(Path.Start)).GetSafeNormal();
+		const float Cos = FVector::DotProduct(Direction, Path.ViewDirection);
+		return 1.f + Path.ViewDirectionWeight * FMath::Clamp((1.f - Cos) / 2.f, 0.f, 1.f);
+	}
+
+private:
+	uint64 GetSquaredDistanceToPath(const FVoxelInvokerPriorityPath& Path) const
+	{
+		const FVector Start(Path.Start);
+		const FVector Direction(Path.End - Path.Start);
+		const FVector Center = FVector(Bounds.Min + Bounds.Max) / 2.f;
+
+		// Point of the path closest to the chunk center
+		const float Alpha = FMath::Clamp(FVector::DotProduct(Center - Start, Direction) / Direction.SizeSquared(), 0.f, 1.f);
+		const FVector Point = Start + Alpha * Direction;
+		const FIntVector IntPoint(FMath::RoundToInt(Point.X), FMath::RoundToInt(Point.Y), FMath::RoundToInt(Point.Z));
+
+		const double DistanceToPath = FMath::Sqrt(double(Bounds.ComputeSquaredDistanceFromBoxToPoint(IntPoint)));
+		const double DistanceAlongPath = Alpha * Direction.Size();
+		return uint64(FMath::Square(DistanceToPath + SweptPathDistanceWeight * DistanceAlongPath));
+	}
 };
\ No newline at end of file
@@ -26,4 +26,9 @@ public:
 	// Voxel works are usually quite long, so it's worth it to compute all the priorities
 	// Must be thread safe
 	virtual uint32 GetPriority() const = 0;
+
+	// Works touching the same data should return the same hash, so that pools with worker groups
+	// run them on the same group and keep that data in the same caches
+	// 0 = no affinity, can run on any worker. Called once when queued
+	virtual uint32 GetAffinityHash() const { return 0; }
 };
\ No newline at end of file
@@ -12,6 +12,7 @@
 
 struct FVoxelMaterialIndices;
 class FInvokerPositionsArray;
+struct FVoxelInvokerPriorityPath;
 class IVoxelPool;
 class FVoxelData;
 class FVoxelDebugManager;
@@ -73,6 +74,8 @@ struct FVoxelRendererSettingsBase
 	const bool bDitherChunks;
 	const float ChunksDitheringDuration;
 	const bool bOptimizeIndices;
+	const EVoxelIndicesOptimizer IndicesOptimizer;
+	const bool bOptimizeVertexFetch;
 
 	const int32 MaxDistanceFieldLOD;
 	const int32 DistanceFieldBoundsExtension;
@@ -81,6 +84,7 @@ struct FVoxelRendererSettingsBase
 	
 	const bool bOneMaterialPerCubeSide;
 	const bool bHalfPrecisionCoordinates;
+	const bool bHalfPrecisionPositions;
 	const bool bInterpolateColors;
 	const bool bInterpolateUVs;
 	const bool bSRGBColors;
@@ -109,6 +113,16 @@ struct FVoxelRendererSettingsBase
 		const FVoxelData* Data = nullptr);
 
 public:
+	// Dual meshers place their vertices within cells: they don't have transitions meshes, and blend LODs using the vertices parent positions instead
+	static bool IsDualRenderType(EVoxelRenderType InRenderType)
+	{
+		return InRenderType == EVoxelRenderType::SurfaceNets || InRenderType == EVoxelRenderType::DualContouring;
+	}
+	inline bool IsDualRenderType() const
+	{
+		return IsDualRenderType(RenderType);
+	}
+
 	inline FVector GetChunkRelativePosition(const FIntVector& Position) const
 	{
 		return FVector(Position + *WorldOffset) * VoxelSize;
@@ -175,7 +189,7 @@ public:
 	//~ End IVoxelRenderer Interface
 
 	// Called by LOD manager
-	void SetInvokersPositionsForPriorities(const TArray<FIntVector>& NewInvokersPositionsForPriorities);
+	void SetInvokersPositionsForPriorities(const TArray<FVoxelInvokerPriorityPath>& NewInvokersPositionsForPriorities);
 	
 	// Used by render chunks to compute the priorities
 	inline const TVoxelSharedRef<FInvokerPositionsArray>& GetInvokersPositionsForPriorities() const
@@ -4,8 +4,11 @@
 
 #include "CoreMinimal.h"
 #include "VoxelMinimal.h"
+#include "VoxelIntBox.h"
+#include "VoxelValue.h"
 #include "VoxelRender/VoxelProcMeshTangent.h"
 #include "VoxelRender/VoxelMaterialIndices.h"
+#include "VoxelConfigEnums.h"
 
 class FVoxelData;
 class FDistanceFieldVolumeData;
@@ -39,7 +42,9 @@ struct VOXEL_API FVoxelChunkMeshBuffers
 	}
 
 	void BuildAdjacency(TArray<uint32>& OutAdjacencyIndices) const;
-	void OptimizeIndices();
+	void OptimizeIndices(EVoxelIndicesOptimizer Optimizer);
+	// Sorts the vertices in the order the indices first use them
+	void OptimizeVertexFetch();
 	void Shrink();
 	void ComputeBounds();
 
@@ -102,7 +107,10 @@ public:
 	}
 	
 public:
-	void BuildDistanceField(int32 LOD, const FIntVector& Position, const FVoxelData& Data, const FVoxelRendererSettingsBase& Settings);
+	// Values needed by BuildDistanceField, on the LOD grid
+	static FVoxelIntBox GetDistanceFieldValuesBounds(int32 LOD, const FIntVector& Position, const FVoxelRendererSettingsBase& Settings);
+	// If Values is empty, will lock the data and query them. Else they must match GetDistanceFieldValuesBounds
+	void BuildDistanceField(int32 LOD, const FIntVector& Position, const FVoxelData& Data, const FVoxelRendererSettingsBase& Settings, TArrayView<const FVoxelValue> Values = {});
 	
 	template<typename T>
 	inline void IterateBuffers(T Lambda)
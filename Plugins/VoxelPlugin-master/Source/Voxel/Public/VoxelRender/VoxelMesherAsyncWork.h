@@ -12,6 +12,7 @@ struct FVoxelRendererSettings;
 struct FVoxelChunkMesh;
 class FVoxelDefaultRenderer;
 class FVoxelMesherBase;
+class FVoxelMarchingCubeMesherBatch;
 
 class VOXEL_API FVoxelMesherAsyncWork : public FVoxelAsyncWork
 {
@@ -23,10 +24,22 @@ public:
 	const FIntVector ChunkPosition;
 	const bool bIsTransitionTask;
 	const uint8 TransitionsMask; // If bIsTransitionTask is true
+	
+	// If PreviousChunk is set, only the part of the chunk around DirtyBounds is remeshed and spliced into PreviousChunk
+	// Can grow until the task is started, see TryAddDirtyBounds
+	FVoxelIntBox DirtyBounds;
+	const TVoxelSharedPtr<const FVoxelChunkMesh> PreviousChunk;
+
+	// If set, DoWork does nothing and outputs this chunk. Set by the renderer when the mesh is in its cache
+	TVoxelSharedPtr<const FVoxelChunkMesh> CachedChunk;
+	double CachedChunkCreationTime = 0;
 
 	// Output
-	TVoxelSharedPtr<FVoxelChunkMesh> Chunk;
+	TVoxelSharedPtr<const FVoxelChunkMesh> Chunk;
+	// Time at which the task started reading the data
 	double CreationTime = 0;
+	// Time spent meshing, 0 for cached chunks
+	double MeshingTime = 0;
 
 	FVoxelMesherAsyncWork(
 		FVoxelDefaultRenderer& Renderer,
@@ -34,14 +47,25 @@ public:
 		int32 LOD,
 		const FVoxelIntBox& Bounds,
 		bool bIsTransitionTask,
-		uint8 TransitionsMask);
+		uint8 TransitionsMask,
+		const FVoxelIntBox& DirtyBounds = {},
+		const TVoxelSharedPtr<const FVoxelChunkMesh>& PreviousChunk = {},
+		bool bIsVisible = false);
 
-	static void CreateGeometry_AnyThread(
-		const FVoxelDefaultRenderer& Renderer,
+	static bool CanUpdateIncrementally(const FVoxelRendererSettings& Settings);
+
+	// Game thread. If the task hasn't started reading the data yet, makes it include the edit in Bounds and returns true
+	// Else returns false, and the edit needs another task
+	bool TryAddDirtyBounds(const FVoxelIntBox& Bounds);
+
+	// Positions & indices only. Returns false if canceled
+	static bool CreateGeometry_AnyThread(
+		const FVoxelRendererSettings& Settings,
 		int32 LOD,
 		const FIntVector& ChunkPosition,
 		TArray<uint32>& OutIndices,
-		TArray<FVector>& OutVertices);
+		TArray<FVector>& OutVertices,
+		const FVoxelCancelCounter* CancelCounter = nullptr);
 
 private:
 	// Important: do not allow public delete
@@ -51,8 +75,12 @@ private:
 	virtual void DoWork() override final;
 	virtual void PostDoWork() override final;
 	virtual uint32 GetPriority() const override final;
+	virtual uint32 GetAffinityHash() const override final;
 	//~ End FVoxelAsyncWork Interface
 
+	// Sets CreationTime. After this, the edits can't be added to the task anymore
+	void MarkStarted();
+
 	static TUniquePtr<FVoxelMesherBase> GetMesher(
 		const FVoxelRendererSettings& Settings,
 		int32 LOD,
@@ -64,6 +92,45 @@ private:
 	const TVoxelWeakPtr<FVoxelDefaultRenderer> Renderer;
 	const FVoxelPriorityHandler PriorityHandler;
 
+	// Set by FVoxelMesherBatchAsyncWork right before running us
+	const FVoxelMarchingCubeMesherBatch* Batch = nullptr;
+
+	FCriticalSection StartSection;
+	bool bStarted = false;
+
 	template<typename T>
 	friend struct TVoxelAsyncWorkDelete;
+	friend class FVoxelMesherBatchAsyncWork;
+};
+
+// Meshes adjacent main chunks of the same LOD in a single task, sharing one data lock and one value query
+// The tasks are not queued themselves: they are run here one after the other, and still report to the renderer individually
+class VOXEL_API FVoxelMesherBatchAsyncWork : public IVoxelQueuedWork
+{
+public:
+	const int32 LOD;
+	const FVoxelIntBox ChunksBounds;
+
+	FVoxelMesherBatchAsyncWork(
+		FVoxelDefaultRenderer& Renderer,
+		int32 LOD,
+		const FVoxelIntBox& ChunksBounds,
+		TArray<FVoxelMesherAsyncWork*>&& Tasks);
+
+	static bool CanBatch(const FVoxelRendererSettings& Settings);
+
+private:
+	// Important: autodeleted
+	virtual ~FVoxelMesherBatchAsyncWork() override;
+	
+	//~ Begin IVoxelQueuedWork Interface
+	virtual void DoThreadedWork() override;
+	virtual void Abandon() override;
+	virtual uint32 GetPriority() const override;
+	virtual uint32 GetAffinityHash() const override;
+	//~ End IVoxelQueuedWork Interface
+
+	const TVoxelWeakPtr<FVoxelDefaultRenderer> Renderer;
+	// Raw ptrs are safe: tasks are only deleted once we ran or abandoned them, even if they're canceled
+	const TArray<FVoxelMesherAsyncWork*> Tasks;
 };
\ No newline at end of file
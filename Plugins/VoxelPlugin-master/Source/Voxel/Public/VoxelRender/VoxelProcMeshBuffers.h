@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "VoxelMinimal.h"
 #include "StaticMeshResources.h"
+#include "Math/Float16.h"
 #include "VoxelRawStaticIndexBuffer.h"
 
 class FVoxelProcMeshBuffersRenderData;
@@ -16,10 +17,67 @@ DECLARE_VOXEL_MEMORY_STAT(TEXT("Positions"), STAT_VoxelProcMeshMemory_Positions,
 DECLARE_VOXEL_MEMORY_STAT(TEXT("Colors"), STAT_VoxelProcMeshMemory_Colors, STATGROUP_VoxelProcMeshMemory, VOXEL_API);
 DECLARE_VOXEL_MEMORY_STAT(TEXT("Adjacency"), STAT_VoxelProcMeshMemory_Adjacency, STATGROUP_VoxelProcMeshMemory, VOXEL_API);
 DECLARE_VOXEL_MEMORY_STAT(TEXT("UVs & Tangents"), STAT_VoxelProcMeshMemory_UVs_Tangents, STATGROUP_VoxelProcMeshMemory, VOXEL_API);
+// CPU copies freed once uploaded, to compare with the memory still retained above
+DECLARE_VOXEL_MEMORY_STAT(TEXT("Released CPU Copies"), STAT_VoxelProcMeshMemory_Released, STATGROUP_VoxelProcMeshMemory, VOXEL_API);
+// What the GPU would use with full precision positions, to compare the two layouts
+DECLARE_VOXEL_MEMORY_STAT(TEXT("GPU Memory (Full Precision Layout)"), STAT_VoxelProcMeshGPUMemory_FullLayout, STATGROUP_VoxelProcMeshMemory, VOXEL_API);
+DECLARE_VOXEL_MEMORY_STAT(TEXT("GPU Memory (Actual Layout)"), STAT_VoxelProcMeshGPUMemory_ActualLayout, STATGROUP_VoxelProcMeshMemory, VOXEL_API);
+
+// Positions in half precision: 8 bytes per vertex instead of 12 on the GPU
+// Decoded to floats by the input assembler, so the local vertex factory can read them as is
+// Has no CPU copy: the halves are converted from the float positions when uploading
+class VOXEL_API FVoxelHalfPositionVertexBuffer : public FVertexBuffer
+{
+public:
+	struct FHalfPosition
+	{
+		FFloat16 X;
+		FFloat16 Y;
+		FFloat16 Z;
+		FFloat16 W;
+	};
+
+	void Init(int32 InNumVertices)
+	{
+		NumVertices = InNumVertices;
+	}
+	// Render thread. Must be called before initializing the resource. Source must be kept alive until ReleaseData
+	void SetSource(const FPositionVertexBuffer& InSource)
+	{
+		check(InSource.GetNumVertices() == NumVertices);
+		Source = &InSource;
+	}
+	// Once the source CPU data is freed. NumVertices is kept
+	void ReleaseData()
+	{
+		Source = nullptr;
+	}
+
+	inline int32 GetNumVertices() const
+	{
+		return NumVertices;
+	}
+	inline uint32 GetStride() const
+	{
+		return sizeof(FHalfPosition);
+	}
+
+	//~ Begin FRenderResource Interface
+	virtual void InitRHI() override;
+	virtual FString GetFriendlyName() const override { return TEXT("FVoxelHalfPositionVertexBuffer"); }
+	//~ End FRenderResource Interface
+
+	void BindPositionVertexBuffer(FLocalVertexFactory::FDataType& OutData) const;
+
+private:
+	int32 NumVertices = 0;
+	const FPositionVertexBuffer* Source = nullptr;
+};
 
 struct VOXEL_API FVoxelProcMeshBuffers
 {
-	// We'll be initializing/releasing a single buffer multiple times, so need to keep the data on the CPU!
+	// Each new scene proxy initializes the buffers again from the CPU data, so it's kept unless bReleaseCPUDataOnUpload is set
+	// In that case, the CPU data is freed once uploaded, and the new proxies reuse the render data instead
 	static constexpr bool bNeedsCPUAccess = true;
 
 	// GUIDs of the meshes merged into these buffers, used to avoid rebuilding collisions & navmesh
@@ -33,6 +91,24 @@ struct VOXEL_API FVoxelProcMeshBuffers
 	FVoxelRawStaticIndexBuffer AdjacencyIndexBuffer{ bNeedsCPUAccess };
 	/** Local bounds of this section */
 	FBox LocalBounds = FBox(ForceInit);
+	/**
+	 * If not empty, used for rendering instead of VertexBuffers.PositionVertexBuffer, which is then not uploaded and only used on the CPU (collisions, navmesh)
+	 * If bReleaseCPUDataOnUpload, both are freed once the halves are uploaded
+	 */
+	FVoxelHalfPositionVertexBuffer HalfPositionVertexBuffer;
+	
+	// Set before sharing the buffers with the render thread, for sections that are only rendered (no collisions, no navmesh)
+	// If true, the CPU copies are freed once uploaded to the GPU, and the render data is kept alive so that new scene proxies can reuse it
+	// ReleaseRenderData_GameThread must then be called when the buffers are not used anymore
+	bool bReleaseCPUDataOnUpload = false;
+
+	// Breaks the render data <-> buffers reference of buffers that released their CPU data
+	static void ReleaseRenderData_GameThread(const TVoxelSharedPtr<const FVoxelProcMeshBuffers>& Buffers);
+
+	inline bool UseHalfPositions() const
+	{
+		return HalfPositionVertexBuffer.GetNumVertices() > 0;
+	}
 
 	inline int32 GetNumVertices() const
 	{
@@ -56,7 +132,18 @@ private:
 	int32 LastAllocatedSize_Colors = 0;
 	int32 LastAllocatedSize_Adjacency = 0;
 	int32 LastAllocatedSize_UVs_Tangents = 0;
+	int32 LastGPUSize_FullLayout = 0;
+	int32 LastGPUSize_ActualLayout = 0;
+	int32 LastReleasedSize = 0;
 	mutable TVoxelWeakPtr<FVoxelProcMeshBuffersRenderData> RenderData;
 
+	// Render thread only
+	// NumVertices & NumIndices are kept when releasing the CPU data, as the proxies need them
+	bool bCPUDataReleased = false;
+	bool bRenderDataReleased = false;
+	TVoxelSharedPtr<FVoxelProcMeshBuffersRenderData> PinnedRenderData;
+
+	void ReleaseCPUData_RenderThread(const TVoxelSharedRef<FVoxelProcMeshBuffersRenderData>& InRenderData);
+
 	friend class FVoxelProcMeshBuffersRenderData;
 };
\ No newline at end of file
@@ -76,6 +76,8 @@ private:
 	bool bCleanCollisionMesh = false;
 	// Will clear the proc mesh buffers once navmesh + collisions have been built
 	bool bClearProcMeshBuffersOnFinishUpdate = false;
+	// Will free the CPU copies of the sections without collisions nor navmesh once uploaded to the GPU
+	bool bReleaseRenderOnlyCPUData = false;
 	// Distance field bias
 	float DistanceFieldSelfShadowBias = 0.f;
 	
@@ -146,6 +148,7 @@ private:
 	void UpdateNavigation();
 	void UpdateCollision();
 	void FinishCollisionUpdate();
+	void ReleaseProcMeshSectionsRenderData();
 	void UpdateConvexMeshes(
 		const FBox& ConvexBounds,
 		TArray<FKConvexElem>&& ConvexElements,
@@ -154,6 +154,12 @@ public:
      * discards the serialized data when it is not needed
      */
     void Discard();
+
+	/**
+	 * Frees the indices once uploaded. Unlike Discard, GetNumIndices is unchanged
+	 * The resource cannot be initialized again after this
+	 */
+	void ReleaseData();
     
 	// FRenderResource interface.
 	virtual void InitRHI() override;
@@ -17,13 +17,30 @@ public:
 	static FVoxelQueuedThreadPoolStats& Get();
 
 	void Report(FName Name, double Time);
+	// Call when a task exited early because it was canceled while running
+	// ElapsedTime is the time spent in the task before exiting
+	void ReportEarlyExit(FName Name, double ElapsedTime);
 	void LogTimes() const;
+	void Reset();
 
 private:
 	FVoxelQueuedThreadPoolStats() = default;
 	
+	struct FTaskTimes
+	{
+		double Time = 0;
+		int64 Count = 0;
+	};
+	struct FEarlyExitTimes
+	{
+		double ElapsedTime = 0;
+		double SavedTime = 0;
+		int64 Count = 0;
+	};
+	
 	mutable FCriticalSection Section;
-	TMap<FName, double> Times;
+	TMap<FName, FTaskTimes> Times;
+	TMap<FName, FEarlyExitTimes> EarlyExitTimes;
 };
 
 struct VOXEL_API FVoxelQueuedThreadPoolSettings
@@ -33,13 +50,17 @@ struct VOXEL_API FVoxelQueuedThreadPoolSettings
 	const uint32 StackSize;
 	const EThreadPriority ThreadPriority;
 	const bool bConstantPriorities;
+	// If > 0, each worker is pinned to a core and the workers are split into that many groups of contiguous cores (eg one per socket)
+	// Works are routed to a group by their affinity hash, and only run elsewhere when their group has nothing else to do
+	const int32 NumAffinityGroups;
 
 	FVoxelQueuedThreadPoolSettings(
 		const FString& PoolName, 
 		uint32 NumThreads, 
 		uint32 StackSize, 
 		EThreadPriority ThreadPriority, 
-		bool bConstantPriorities);
+		bool bConstantPriorities,
+		int32 NumAffinityGroups = 0);
 };
 
 class VOXEL_API FVoxelQueuedThreadPool : public TVoxelSharedFromThis<FVoxelQueuedThreadPool>
@@ -54,7 +75,16 @@ public:
 	{
 		// Not really thread safe, only use this for debug
 		// Also count active threads
-		return (Settings.bConstantPriorities ? StaticQueuedWorks.size() : QueuedWorks.Num()) + GetNumThreads() - QueuedThreads.Num();
+		int32 NumStaticQueuedWorks = 0;
+		for (auto& Queue : StaticQueuedWorks)
+		{
+			NumStaticQueuedWorks += Queue.size();
+		}
+		return (Settings.bConstantPriorities ? NumStaticQueuedWorks : QueuedWorks.Num()) + GetNumThreads() - QueuedThreads.Num();
+	}
+	int32 GetNumAffinityGroups() const
+	{
+		return NumAffinityGroups;
 	}
 	int32 GetNumThreads() const
 	{
@@ -73,6 +103,8 @@ public:
 private:
 	explicit FVoxelQueuedThreadPool(const FVoxelQueuedThreadPoolSettings& Settings);
 
+	// Clamped to the number of threads. 0 if affinity is disabled
+	const int32 NumAffinityGroups;
 	const TArray<TUniquePtr<FVoxelQueuedThread>> AllThreads;
 
 	FCriticalSection Section;
@@ -85,17 +117,21 @@ private:
 		uint32 PriorityCategory;
 		uint32 Priority;
 		int32 PriorityOffset;
+		// -1 if it can run on any group
+		int32 AffinityGroup;
 
 		FQueuedWorkInfo() = default;
 		FQueuedWorkInfo(
 			IVoxelQueuedWork* Work,
 			uint32 PriorityCategory,
-			int32 PriorityOffset)
+			int32 PriorityOffset,
+			int32 AffinityGroup)
 			: Work(Work)
 			, NextPriorityUpdateTime(0)
 			, PriorityCategory(PriorityCategory)
 			, Priority(0)
 			, PriorityOffset(PriorityOffset)
+			, AffinityGroup(AffinityGroup)
 		{
 		}
 
@@ -111,7 +147,14 @@ private:
 		}
 	};
 	TArray<FQueuedWorkInfo> QueuedWorks;
-	std::priority_queue<FQueuedWorkInfo> StaticQueuedWorks;
+	// One queue per affinity group, the first one being for works without affinity
+	TArray<std::priority_queue<FQueuedWorkInfo>> StaticQueuedWorks;
+
+	int32 GetAffinityGroup(IVoxelQueuedWork* Work) const;
+	void AddQueuedWorkInfo(const FQueuedWorkInfo& WorkInfo);
+	// NumWorksPerGroup: number of works added per affinity group, the first one being for works without affinity
+	void WakeUpThreads(const TArray<int32, TInlineAllocator<16>>& NumWorksPerGroup);
+	IVoxelQueuedWork* GetNextStaticJob(int32 ThreadAffinityGroup);
 	
 	FThreadSafeBool TimeToDie = false;
 };
\ No newline at end of file
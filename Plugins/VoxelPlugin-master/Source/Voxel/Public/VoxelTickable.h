@@ -4,24 +4,43 @@
 
 #include "CoreMinimal.h"
 #include "Tickable.h"
+#include "VoxelGameThreadScheduler.h"
 
 class FVoxelTickable : public FTickableGameObject
 {
 public:
+	FVoxelTickable()
+	{
+		FVoxelGameThreadScheduler::RegisterTickable(*this);
+	}
 	virtual ~FVoxelTickable()
 	{
 		ensure(!bShouldTick);
+		FVoxelGameThreadScheduler::UnregisterTickable(*this);
 	}
-	
+
 	virtual bool IsTickable() const final override
 	{
-		return bShouldTick;
+		// When the scheduler is enabled, it's the one ticking us
+		return bShouldTick && !FVoxelGameThreadScheduler::IsEnabled();
 	}
 	virtual TStatId GetStatId() const final override
 	{
 		RETURN_QUICK_DECLARE_CYCLE_STAT(FVoxelTickable, STATGROUP_Tickables);
 	}
 
+	// Used by the scheduler to order the tickables and to report their time
+	virtual EVoxelGameThreadWork GetGameThreadWork() const
+	{
+		return EVoxelGameThreadWork::Other;
+	}
+	// Called by the scheduler instead of Tick
+	// MaxTime: FPlatformTime::Seconds() deadline. Tickables that can't split their work can ignore it
+	virtual void TickWithBudget(float DeltaTime, double MaxTime)
+	{
+		Tick(DeltaTime);
+	}
+
 	void StopTicking()
 	{
 		ensure(IsInGameThread());
@@ -39,7 +58,11 @@ public:
 		ensure(IsInGameThread());
 		return bShouldTick;
 	}
-	
+
 private:
 	bool bShouldTick = true;
-};
\ No newline at end of file
+	// Number of consecutive frames the scheduler skipped us because the budget was exhausted
+	int32 SchedulerSkippedFrames = 0;
+
+	friend class FVoxelGameThreadScheduler;
+};
@@ -23,11 +23,12 @@ void FVoxelDistanceFieldUtilities::GetSurfacePositionsFromDensities(
 	check(OutDistances.Num() == Size.X * Size.Y * Size.Z);
 	check(OutSurfacePositions.Num() == Size.X * Size.Y * Size.Z);
 
-	for (int32 X = 0; X < Size.X; X++)
+	// Iterate in memory order: X is the contiguous axis
+	for (int32 Z = 0; Z < Size.Z; Z++)
 	{
 		for (int32 Y = 0; Y < Size.Y; Y++)
 		{
-			for (int32 Z = 0; Z < Size.Z; Z++)
+			for (int32 X = 0; X < Size.X; X++)
 			{
 				const FIntVector Position(X, Y, Z);
 
@@ -358,6 +358,7 @@ public:
 	TSubclassOf<UVoxelProceduralMeshComponent> ProcMeshClass;
 
 	// Chunks with a LOD strictly higher than this won't be rendered
+	// Ignored in Dual Contouring, which only renders LOD 0
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, AdvancedDisplay, Category = "Voxel - Rendering", meta = (UpdateLODs, ClampMin = 0, ClampMax = 26, UIMin = 0, UIMax = 26))
 	int32 ChunksCullingLOD = FVoxelUtilities::ClampDepth<RENDER_CHUNK_SIZE>(32);
 
@@ -375,6 +376,19 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, AdvancedDisplay, Category = "Voxel - Rendering", meta = (RecreateRender))
 	bool bOptimizeIndices = false;
 
+	// If true, the GPU positions will be stored as 16 bits floats relative to the chunk/cluster center, if precise enough (see voxel.renderer.HalfPositionsMaxError)
+	// Saves 4 bytes per vertex on the GPU. Ray tracing isn't supported on these meshes
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, AdvancedDisplay, Category = "Voxel - Rendering", meta = (RecreateRender))
+	bool bHalfPrecisionPositions = false;
+
+	// Algorithm used to sort the indices if bOptimizeIndices is true
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, AdvancedDisplay, Category = "Voxel - Rendering", meta = (RecreateRender, EditCondition = "bOptimizeIndices"))
+	EVoxelIndicesOptimizer IndicesOptimizer = EVoxelIndicesOptimizer::Forsyth;
+
+	// If true, the vertices will also be sorted in the order the optimized indices first use them, to improve vertex fetch
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, AdvancedDisplay, Category = "Voxel - Rendering", meta = (RecreateRender, EditCondition = "bOptimizeIndices"))
+	bool bOptimizeVertexFetch = false;
+
 	// Will generate distance fields on LOD 0 chunks
 	// Has a cost of around 1 ms per chunk (on async thread)
 	// Doesn't work with chunks merging or single/double index material config with different materials per chunk